@@ -5,7 +5,7 @@
 // other MIME processing functionality.
 //
 // Dependencies:   C20++     - Language standard features used.
-//                 CMailSMTP - Base64 decoding.
+//                 iconv     - Encoded word character set to UTF-8 conversion.
 //
 // =================
 // CLASS DEFINITIONS
@@ -18,6 +18,16 @@
 // C++ STL
 //
 #include <cstring>
+#include <cerrno>
+#include <cctype>
+#include <algorithm>
+#include <iterator>
+#include <fstream>
+//
+// iconv / strncasecmp
+//
+#include <iconv.h>
+#include <strings.h>
 // =========
 // NAMESPACE
 // =========
@@ -32,19 +42,66 @@ namespace Antik::File
     const char *CMIME::kEncodedWordPrefix{"=?"};
     const char *CMIME::kEncodedWordPostfix{"?="};
     const char *CMIME::kEncodedWordSeparator{"?"};
-    const char *CMIME::kEncodedWordASCII{"ASCII"};
     const char CMIME::kEncodedWordTypeBase64{'B'};
     const char CMIME::kEncodedWordTypeQuoted{'Q'};
-    const char CMIME::kEncodedWordTypeNone{' '};
     const char CMIME::kQuotedPrintPrefix{'='};
+    const char CMIME::kQuotedPrintSpace{'_'};
+    //
+    // Build base64 character to 6 bit value decode table.
+    //
+    constexpr std::array<std::int8_t, 256> CMIME::makeBase64DecodeTable(void)
+    {
+        std::array<std::int8_t, 256> decodeTable{};
+        const char *base64Characters{"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"};
+        for (auto &entry : decodeTable)
+        {
+            entry = -1;
+        }
+        for (std::int8_t value = 0; value < 64; value++)
+        {
+            decodeTable[static_cast<unsigned char>(base64Characters[value])] = value;
+        }
+        return (decodeTable);
+    }
+    //
+    // Build hex digit to 4 bit value decode table (upper and lower case).
+    //
+    constexpr std::array<std::int8_t, 256> CMIME::makeHexDecodeTable(void)
+    {
+        std::array<std::int8_t, 256> decodeTable{};
+        for (auto &entry : decodeTable)
+        {
+            entry = -1;
+        }
+        for (std::int8_t value = 0; value < 10; value++)
+        {
+            decodeTable['0' + value] = value;
+        }
+        for (std::int8_t value = 0; value < 6; value++)
+        {
+            decodeTable['A' + value] = value + 10;
+            decodeTable['a' + value] = value + 10;
+        }
+        return (decodeTable);
+    }
+    const std::array<std::int8_t, 256> CMIME::kBase64DecodeTable{makeBase64DecodeTable()};
+    const std::array<std::int8_t, 256> CMIME::kHexDecodeTable{makeHexDecodeTable()};
     // ==========================
     // PUBLIC TYPES AND CONSTANTS
     // ==========================
+    const char *CMIME::kUnknownMIMEType{"application/unknown"};
     // ========================
     // PRIVATE STATIC VARIABLES
     // ========================
-    // File extension to MIME type mapping table
-    std::unordered_map<std::string, std::string> CMIME::m_extToMimeType{
+    //
+    // File extension to MIME type mapping table.
+    //
+    struct ExtensionMapping
+    {
+        std::string_view extension; // File extension (lower case)
+        std::string_view mimeType;  // MIME type
+    };
+    static constexpr ExtensionMapping kExtensionMappings[]{
         {"ez", "application/andrew-inset"},
         {"anx", "application/annodex"},
         {"atom", "application/atom+xml"},
@@ -209,8 +266,6 @@ namespace Antik::File
         {"mph", "application/x-comsol"},
         {"cpio", "application/x-cpio"},
         {"csh", "application/x-csh"},
-        {"deb", "application/x-debian-package"},
-        {"udeb", "application/x-debian-package"},
         {"dcr", "application/x-director"},
         {"dir", "application/x-director"},
         {"dxr", "application/x-director"},
@@ -223,7 +278,6 @@ namespace Antik::File
         {"pcf", "application/x-font-pcf"},
         {"pcf.Z", "application/x-font-pcf"},
         {"mm", "application/x-freemind"},
-        {"spl", "application/x-futuresplash"},
         {"gan", "application/x-ganttproject"},
         {"gnumeric", "application/x-gnumeric"},
         {"sgf", "application/x-go-sgf"},
@@ -356,13 +410,11 @@ namespace Antik::File
         {"aiff", "audio/x-aiff"},
         {"aifc", "audio/x-aiff"},
         {"gsm", "audio/x-gsm"},
-        {"m3u", "audio/x-mpegurl"},
         {"wma", "audio/x-ms-wma"},
         {"wax", "audio/x-ms-wax"},
         {"ra", "audio/x-pn-realaudio"},
         {"rm", "audio/x-pn-realaudio"},
         {"ram", "audio/x-pn-realaudio"},
-        {"ra", "audio/x-realaudio"},
         {"pls", "audio/x-scpls"},
         {"sd2", "audio/x-sd2"},
         {"wav", "audio/x-wav"},
@@ -415,7 +467,6 @@ namespace Antik::File
         {"rd", "chemical/x-mdl-rdfile"},
         {"rxn", "chemical/x-mdl-rxnfile"},
         {"sd", "chemical/x-mdl-sdfile"},
-        {"sdf", "chemical/x-mdl-sdfile"},
         {"tgf", "chemical/x-mdl-tgf"},
         {"mcif", "chemical/x-mmcif"},
         {"mol2", "chemical/x-mol2"},
@@ -432,9 +483,7 @@ namespace Antik::File
         {"ent", "chemical/x-ncbi-asn1-ascii"},
         {"val", "chemical/x-ncbi-asn1-binary"},
         {"aso", "chemical/x-ncbi-asn1-binary"},
-        {"asn", "chemical/x-ncbi-asn1-spec"},
         {"pdb", "chemical/x-pdb"},
-        {"ent", "chemical/x-pdb"},
         {"ros", "chemical/x-rosdal"},
         {"sw", "chemical/x-swissprot"},
         {"vms", "chemical/x-vamas-iso14976"},
@@ -467,7 +516,6 @@ namespace Antik::File
         {"cdr", "image/x-coreldraw"},
         {"pat", "image/x-coreldrawpattern"},
         {"cdt", "image/x-coreldrawtemplate"},
-        {"cpt", "image/x-corelphotopaint"},
         {"erf", "image/x-epson-erf"},
         {"art", "image/x-jg"},
         {"jng", "image/x-jng"},
@@ -534,7 +582,6 @@ namespace Antik::File
         {"cc", "text/x-c++src"},
         {"h", "text/x-chdr"},
         {"htc", "text/x-component"},
-        {"csh", "text/x-csh"},
         {"c", "text/x-csrc"},
         {"d", "text/x-dsrc"},
         {"diff", "text/x-diff"},
@@ -553,8 +600,6 @@ namespace Antik::File
         {"scala", "text/x-scala"},
         {"etx", "text/x-setext"},
         {"sfv", "text/x-sfv"},
-        {"sh", "text/x-sh"},
-        {"tcl", "text/x-tcl"},
         {"tk", "text/x-tcl"},
         {"tex", "text/x-tex"},
         {"ltx", "text/x-tex"},
@@ -595,123 +640,471 @@ namespace Antik::File
         {"ice", "x-conference/x-cooltalk"},
         {"sisx", "x-epoc/x-sisx-app"},
         {"vrm", "x-world/x-vrml"},
-        {"vrml", "x-world/x-vrml"},
-        {"wrl", "x-world/x-vrml"}};
+    };
+    //
+    // Perfect hash (hash and displace) of extension table built at compile time. An extension
+    // is hashed to a bucket whose displacement is used to rehash it to a unique slot that
+    // holds its index into kExtensionMappings (-1 == empty slot).
+    //
+    static constexpr std::size_t kExtensionCount{std::size(kExtensionMappings)};
+    static constexpr std::size_t kExtensionBuckets{256};
+    static constexpr std::size_t kExtensionSlots{2048};
+    static constexpr std::size_t kMaxBucketSize{32};
+    struct ExtensionHashTable
+    {
+        std::array<std::uint16_t, kExtensionBuckets> displacement{};
+        std::array<std::int16_t, kExtensionSlots> slot{};
+        std::size_t maxExtensionLength{0};
+    };
+    static constexpr std::uint32_t extensionHash(std::string_view extension, std::uint32_t seed)
+    {
+        std::uint32_t hash{2166136261u ^ (seed * 16777619u)};
+        for (auto character : extension)
+        {
+            hash = (hash ^ static_cast<unsigned char>(character)) * 16777619u;
+        }
+        hash ^= hash >> 16;
+        hash *= 0x7feb352du;
+        hash ^= hash >> 15;
+        return (hash);
+    }
+    static constexpr ExtensionHashTable makeExtensionHashTable(void)
+    {
+        ExtensionHashTable hashTable{};
+        std::array<std::uint16_t, kExtensionCount> bucket{};
+        std::array<std::size_t, kExtensionBuckets> bucketSize{};
+        std::size_t maxBucketSize{0};
+        for (auto &slot : hashTable.slot)
+        {
+            slot = -1;
+        }
+        for (std::size_t entry = 0; entry < kExtensionCount; entry++)
+        {
+            bucket[entry] = extensionHash(kExtensionMappings[entry].extension, 0) % kExtensionBuckets;
+            maxBucketSize = std::max(maxBucketSize, ++bucketSize[bucket[entry]]);
+            hashTable.maxExtensionLength = std::max(hashTable.maxExtensionLength, kExtensionMappings[entry].extension.size());
+        }
+        if (maxBucketSize > kMaxBucketSize)
+        {
+            throw std::logic_error("Extension hash bucket too large.");
+        }
+        // Place largest buckets first
+        for (std::size_t size = maxBucketSize; size > 0; size--)
+        {
+            for (std::size_t current = 0; current < kExtensionBuckets; current++)
+            {
+                if (bucketSize[current] != size)
+                {
+                    continue;
+                }
+                for (std::uint32_t displacement = 1;; displacement++)
+                {
+                    std::array<std::size_t, kMaxBucketSize> slots{}, entries{};
+                    std::size_t placed{0};
+                    if (displacement > UINT16_MAX)
+                    {
+                        throw std::logic_error("Duplicate extension in mapping table.");
+                    }
+                    for (std::size_t entry = 0; entry < kExtensionCount; entry++)
+                    {
+                        if (bucket[entry] == current)
+                        {
+                            std::size_t slot{extensionHash(kExtensionMappings[entry].extension, displacement) % kExtensionSlots};
+                            bool collision{hashTable.slot[slot] != -1};
+                            for (std::size_t previous = 0; previous < placed; previous++)
+                            {
+                                collision |= (slots[previous] == slot);
+                            }
+                            if (collision)
+                            {
+                                break;
+                            }
+                            slots[placed] = slot;
+                            entries[placed++] = entry;
+                        }
+                    }
+                    if (placed == size)
+                    {
+                        for (std::size_t entry = 0; entry < placed; entry++)
+                        {
+                            hashTable.slot[slots[entry]] = static_cast<std::int16_t>(entries[entry]);
+                        }
+                        hashTable.displacement[current] = static_cast<std::uint16_t>(displacement);
+                        break;
+                    }
+                }
+            }
+        }
+        return (hashTable);
+    }
+    static constexpr ExtensionHashTable kExtensionHashTable{makeExtensionHashTable()};
+    //
+    // File signature (magic number) table; longer/more specific signatures first.
+    //
+    struct FileSignature
+    {
+        std::size_t offset;         // Offset of signature in file
+        std::string_view signature; // Signature bytes
+        std::string_view mimeType;  // MIME type
+    };
+    static constexpr FileSignature kFileSignatures[]{
+        {0, {"\x89PNG\r\n\x1a\n", 8}, "image/png"},
+        {0, {"\xd0\xcf\x11\xe0\xa1\xb1\x1a\xe1", 8}, "application/x-ole-storage"},
+        {0, {"7z\xbc\xaf\x27\x1c", 6}, "application/x-7z-compressed"},
+        {0, {"\xfd" "7zXZ\x00", 6}, "application/x-xz"},
+        {0, {"Rar!\x1a\x07", 6}, "application/rar"},
+        {0, {"GIF87a", 6}, "image/gif"},
+        {0, {"GIF89a", 6}, "image/gif"},
+        {0, {"%PDF-", 5}, "application/pdf"},
+        {0, {"<?xml", 5}, "application/xml"},
+        {0, {"{\\rtf", 5}, "application/rtf"},
+        {257, {"ustar", 5}, "application/x-tar"},
+        {8, {"WEBP", 4}, "image/webp"},
+        {8, {"WAVE", 4}, "audio/x-wav"},
+        {8, {"AVI ", 4}, "video/x-msvideo"},
+        {4, {"ftyp", 4}, "video/mp4"},
+        {0, {"PK\x03\x04", 4}, "application/zip"},
+        {0, {"PK\x05\x06", 4}, "application/zip"},
+        {0, {"\x28\xb5\x2f\xfd", 4}, "application/zstd"},
+        {0, {"\x7f" "ELF", 4}, "application/x-executable"},
+        {0, {"II*\x00", 4}, "image/tiff"},
+        {0, {"MM\x00*", 4}, "image/tiff"},
+        {0, {"OggS", 4}, "audio/ogg"},
+        {0, {"fLaC", 4}, "audio/flac"},
+        {0, {"\xca\xfe\xba\xbe", 4}, "application/java-vm"},
+        {0, {"\x00\x00\x01\x00", 4}, "image/vnd.microsoft.icon"},
+        {0, {"8BPS", 4}, "image/x-photoshop"},
+        {0, {"%!PS", 4}, "application/postscript"},
+        {0, {"\xff\xd8\xff", 3}, "image/jpeg"},
+        {0, {"ID3", 3}, "audio/mpeg"},
+        {0, {"BZh", 3}, "application/x-bzip2"},
+        {0, {"\x1f\x8b", 2}, "application/gzip"},
+        {0, {"MZ", 2}, "application/x-msdos-program"},
+        {0, {"BM", 2}, "image/x-ms-bmp"}};
     // =======================
     // PUBLIC STATIC VARIABLES
     // =======================
     // ===============
     // PRIVATE METHODS
     // ===============
-    // ==============
-    // PUBLIC METHODS
-    // ==============
     //
-    // Return MIME type for files extension using internal mapping table.
-    // If none found then return "application/unknown".
+    // Parse encoded word (=?charset?type?text?=) at start of string. Returns false
+    // if it is not a well formed encoded word.
     //
-    std::string CMIME::getFileMIMEType(const std::string &fileName)
+    bool CMIME::parseEncodedWord(std::string_view mime, EncodedWord &word)
     {
-        std::string baseFileName{fileName.substr(fileName.find_last_of(R"(/\)") + 1)};
-        std::size_t fullStop{baseFileName.find_last_of('.')};
-        if (fullStop != std::string::npos)
+        if (mime.compare(0, std::strlen(kEncodedWordPrefix), kEncodedWordPrefix) != 0)
+        {
+            return (false);
+        }
+        std::size_t charsetEnd{mime.find_first_of("? \t\r\n", std::strlen(kEncodedWordPrefix))};
+        if ((charsetEnd == std::string_view::npos) || (mime[charsetEnd] != '?') ||
+            (charsetEnd == std::strlen(kEncodedWordPrefix)) || (mime.size() < charsetEnd + 3) || (mime[charsetEnd + 2] != '?'))
+        {
+            return (false);
+        }
+        word.type = static_cast<char>(std::toupper(static_cast<unsigned char>(mime[charsetEnd + 1])));
+        if ((word.type != kEncodedWordTypeBase64) && (word.type != kEncodedWordTypeQuoted))
+        {
+            return (false);
+        }
+        std::size_t textEnd{mime.find(kEncodedWordPostfix, charsetEnd + 3)};
+        if ((textEnd == std::string_view::npos) || (mime.find_first_of(" \t\r\n", charsetEnd + 3) < textEnd))
         {
-            auto foundMapping = m_extToMimeType.find(baseFileName.substr(fullStop + 1));
-            if (foundMapping != m_extToMimeType.end())
+            return (false);
+        }
+        word.charset = mime.substr(std::strlen(kEncodedWordPrefix), charsetEnd - std::strlen(kEncodedWordPrefix));
+        word.charset = word.charset.substr(0, word.charset.find('*'));
+        word.text = mime.substr(charsetEnd + 3, textEnd - (charsetEnd + 3));
+        word.length = textEnd + std::strlen(kEncodedWordPostfix);
+        word.bitBuffer = 0;
+        word.bitCount = 0;
+        return (true);
+    }
+    //
+    // Decode as much of an encoded words text as will fit into the passed buffer; the
+    // decoded text is removed from the word. Returns number of bytes decoded.
+    //
+    std::size_t CMIME::decodeEncodedText(EncodedWord &word, char *decoded, std::size_t decodedSize)
+    {
+        std::size_t decodedLength{0};
+        while (!word.text.empty())
+        {
+            unsigned char current{static_cast<unsigned char>(word.text.front())};
+            std::size_t consumed{1};
+            if (word.type == kEncodedWordTypeBase64)
             {
-                return (foundMapping->second);
+                // Padding and any invalid characters ignored
+                if (kBase64DecodeTable[current] >= 0)
+                {
+                    if ((word.bitCount >= 2) && (decodedLength == decodedSize))
+                    {
+                        break;
+                    }
+                    word.bitBuffer = ((word.bitBuffer << 6) | kBase64DecodeTable[current]) & 0xfff;
+                    word.bitCount += 6;
+                    if (word.bitCount >= 8)
+                    {
+                        word.bitCount -= 8;
+                        decoded[decodedLength++] = static_cast<char>(word.bitBuffer >> word.bitCount);
+                    }
+                }
+            }
+            else
+            {
+                if (decodedLength == decodedSize)
+                {
+                    break;
+                }
+                if (current == kQuotedPrintSpace)
+                {
+                    current = ' ';
+                }
+                else if ((current == kQuotedPrintPrefix) && (word.text.size() > 2) &&
+                         (kHexDecodeTable[static_cast<unsigned char>(word.text[1])] >= 0) &&
+                         (kHexDecodeTable[static_cast<unsigned char>(word.text[2])] >= 0))
+                {
+                    current = (kHexDecodeTable[static_cast<unsigned char>(word.text[1])] << 4) |
+                              kHexDecodeTable[static_cast<unsigned char>(word.text[2])];
+                    consumed = 3;
+                }
+                decoded[decodedLength++] = static_cast<char>(current);
+            }
+            word.text.remove_prefix(consumed);
+        }
+        return (decodedLength);
+    }
+    //
+    // Return true if character set needs no conversion to be UTF-8.
+    //
+    bool CMIME::isUTF8Compatible(std::string_view charset)
+    {
+        for (const char *compatible : {"UTF-8", "UTF8", "US-ASCII", "ASCII"})
+        {
+            if ((charset.size() == std::strlen(compatible)) && (strncasecmp(charset.data(), compatible, charset.size()) == 0))
+            {
+                return (true);
             }
         }
-        return ("application/unknown");
+        return (false);
     }
     //
-    // Parse MIME string into normal ASCII and MIME word encoded pieces.
+    // Decode encoded word into buffer, converting it to UTF-8 if requested. The iconv
+    // descriptor for the last character set seen is kept (per thread) for reuse; any
+    // character set iconv does not know is copied through unconverted.
     //
-    std::vector<CMIME::ParsedMIMEString> CMIME::parseMIMEString(const std::string &mime)
+    std::size_t CMIME::decodeEncodedWord(EncodedWord &word, char *decoded, std::size_t decodedSize, bool toUTF8)
     {
-        std::istringstream subjectStream(mime);
-        ParsedMIMEString parsedEntry;
-        std::vector<ParsedMIMEString> parsedString;
-        for (std::string line; std::getline(subjectStream, line, '\n');)
+        struct Transcoder
         {
-            line.pop_back();
-            if (line.find_first_not_of(' ') != std::string::npos)
+            char charset[kMaxCharsetLength + 1]{};
+            iconv_t descriptor{reinterpret_cast<iconv_t>(-1)};
+            ~Transcoder()
             {
-                line = line.substr(line.find_first_not_of(' '));
+                if (descriptor != reinterpret_cast<iconv_t>(-1))
+                {
+                    iconv_close(descriptor);
+                }
             }
-            while (!line.empty())
+        };
+        thread_local Transcoder transcoder;
+        std::size_t decodedLength{0};
+        if (toUTF8 && !isUTF8Compatible(word.charset) && (word.charset.size() <= kMaxCharsetLength))
+        {
+            if ((word.charset.size() != std::strlen(transcoder.charset)) ||
+                (strncasecmp(word.charset.data(), transcoder.charset, word.charset.size()) != 0))
             {
-                parsedEntry.type = kEncodedWordTypeNone;
-                parsedEntry.encoding = kEncodedWordASCII;
-                if (line.find(kEncodedWordPrefix) == 0)
+                if (transcoder.descriptor != reinterpret_cast<iconv_t>(-1))
                 {
-                    line = line.substr(std::strlen(kEncodedWordPrefix));
-                    parsedEntry.encoding = line.substr(0, line.find(kEncodedWordSeparator));
-                    line = line.substr(line.find(kEncodedWordSeparator) + 1);
-                    parsedEntry.type = line[0];
-                    line = line.substr(std::strlen(kEncodedWordPrefix));
-                    parsedEntry.contents = line.substr(0, line.find(kEncodedWordPostfix));
-                    line = line.substr(line.find(kEncodedWordPostfix) + 2);
+                    iconv_close(transcoder.descriptor);
                 }
-                else
+                word.charset.copy(transcoder.charset, word.charset.size());
+                transcoder.charset[word.charset.size()] = '\0';
+                transcoder.descriptor = iconv_open("UTF-8", transcoder.charset);
+            }
+            if (transcoder.descriptor != reinterpret_cast<iconv_t>(-1))
+            {
+                char transcodeBuffer[kTranscodeBufferSize];
+                std::size_t pending{0};
+                char *output{decoded};
+                std::size_t outputLeft{decodedSize};
+                iconv(transcoder.descriptor, nullptr, nullptr, nullptr, nullptr);
+                do
                 {
-                    if (line.find(kEncodedWordPostfix) == std::string::npos)
+                    pending += decodeEncodedText(word, &transcodeBuffer[pending], sizeof(transcodeBuffer) - pending);
+                    char *input{transcodeBuffer};
+                    std::size_t inputLeft{pending};
+                    while ((inputLeft > 0) && (iconv(transcoder.descriptor, &input, &inputLeft, &output, &outputLeft) == static_cast<std::size_t>(-1)))
                     {
-                        parsedEntry.contents = line;
-                        line = "";
-                    }
-                    else
-                    {
-                        parsedEntry.contents = line.substr(0, line.find(kEncodedWordPrefix));
-                        line = line.substr(line.find(kEncodedWordPrefix));
+                        if (errno == E2BIG)
+                        {
+                            throw Exception("Decode buffer too small.");
+                        }
+                        // Incomplete sequence so wait for more input (if there is any)
+                        if ((errno == EINVAL) && !word.text.empty())
+                        {
+                            break;
+                        }
+                        // Invalid or truncated sequence replaced with a '?'
+                        if (outputLeft == 0)
+                        {
+                            throw Exception("Decode buffer too small.");
+                        }
+                        *output++ = '?';
+                        outputLeft--;
+                        input++;
+                        inputLeft--;
                     }
+                    std::memmove(transcodeBuffer, input, inputLeft);
+                    pending = inputLeft;
+                } while (!word.text.empty());
+                if (iconv(transcoder.descriptor, nullptr, nullptr, &output, &outputLeft) == static_cast<std::size_t>(-1))
+                {
+                    throw Exception("Decode buffer too small.");
                 }
-                parsedString.push_back(parsedEntry);
+                return (output - decoded);
             }
         }
-        return (parsedString);
+        decodedLength = decodeEncodedText(word, decoded, decodedSize);
+        if (!word.text.empty())
+        {
+            throw Exception("Decode buffer too small.");
+        }
+        return (decodedLength);
     }
+    // ==============
+    // PUBLIC METHODS
+    // ==============
     //
-    // Parse MIME string passed in and convert it to ASCII as best can.
+    // Return MIME type for file extension (case insensitive) using the perfect hash
+    // of the internal mapping table. If none found then return kUnknownMIMEType.
     //
-    std::string CMIME::convertMIMEStringToASCII(const std::string &mime)
+    std::string_view CMIME::getExtensionMIMEType(std::string_view extension)
+    {
+        char lowerCaseExtension[kExtensionHashTable.maxExtensionLength];
+        if (extension.empty() || (extension.size() > kExtensionHashTable.maxExtensionLength))
+        {
+            return (kUnknownMIMEType);
+        }
+        for (std::size_t index = 0; index < extension.size(); index++)
+        {
+            lowerCaseExtension[index] = static_cast<char>(std::tolower(static_cast<unsigned char>(extension[index])));
+        }
+        std::string_view key{lowerCaseExtension, extension.size()};
+        std::uint16_t displacement{kExtensionHashTable.displacement[extensionHash(key, 0) % kExtensionBuckets]};
+        std::int16_t entry{kExtensionHashTable.slot[extensionHash(key, displacement) % kExtensionSlots]};
+        if ((entry != -1) && (kExtensionMappings[entry].extension == key))
+        {
+            return (kExtensionMappings[entry].mimeType);
+        }
+        return (kUnknownMIMEType);
+    }
+    //
+    // Return MIME type for files extension using internal mapping table.
+    // If none found then return "application/unknown".
+    //
+    std::string CMIME::getFileMIMEType(const std::string &fileName)
     {
-        std::vector<ParsedMIMEString> parsedString{parseMIMEString(mime)};
-        std::string convertedMIME;
-        for (auto &parsedEntry : parsedString)
+        std::string_view baseFileName{fileName};
+        baseFileName.remove_prefix(std::min(baseFileName.find_last_of(R"(/\)") + 1, baseFileName.size()));
+        std::size_t fullStop{baseFileName.find_last_of('.')};
+        if (fullStop != std::string_view::npos)
         {
-            if (parsedEntry.type == kEncodedWordTypeNone)
+            return (std::string(getExtensionMIMEType(baseFileName.substr(fullStop + 1))));
+        }
+        return (kUnknownMIMEType);
+    }
+    //
+    // Return MIME type for file contents by checking its first bytes (up to kSniffLength)
+    // against known file signatures. If none match then return kUnknownMIMEType.
+    //
+    std::string_view CMIME::sniffMIMEType(std::string_view contents)
+    {
+        for (auto &fileSignature : kFileSignatures)
+        {
+            if ((contents.size() >= fileSignature.offset + fileSignature.signature.size()) &&
+                (contents.compare(fileSignature.offset, fileSignature.signature.size(), fileSignature.signature) == 0))
+            {
+                return (fileSignature.mimeType);
+            }
+        }
+        return (kUnknownMIMEType);
+    }
+    //
+    // Return MIME type of a file from its signature (magic number) rather than its
+    // extension. If none match (or the file cannot be read) then return kUnknownMIMEType.
+    //
+    std::string_view CMIME::sniffFileMIMEType(const std::string &fileName)
+    {
+        char contents[kSniffLength];
+        std::ifstream fileStream{fileName, std::ios::binary};
+        fileStream.read(contents, sizeof(contents));
+        return (sniffMIMEType(std::string_view(contents, fileStream.gcount())));
+    }
+    //
+    // Decode MIME string (RFC 2047 encoded words and plain text) into the passed buffer
+    // in a single pass without any memory allocation. Folded lines are unfolded and
+    // whitespace between adjacent encoded words dropped. Encoded words are left in their
+    // original character set unless toUTF8 is set when they are converted to UTF-8 using
+    // iconv. Returns the decoded length; throws if the buffer is too small (decoded text
+    // is never longer than the MIME string unless converting to UTF-8).
+    //
+    std::size_t CMIME::decodeMIMEString(std::string_view mime, char *decoded, std::size_t decodedSize, bool toUTF8)
+    {
+        std::size_t decodedLength{0};
+        std::size_t position{0};
+        bool lastWordEncoded{false};
+        EncodedWord word;
+        auto append = [&](std::string_view text) {
+            if (text.size() > (decodedSize - decodedLength))
             {
-                convertedMIME += parsedEntry.contents;
+                throw Exception("Decode buffer too small.");
             }
-            else if (parsedEntry.type == kEncodedWordTypeQuoted)
+            text.copy(&decoded[decodedLength], text.size());
+            decodedLength += text.size();
+        };
+        while (position < mime.size())
+        {
+            if ((mime[position] == ' ') || (mime[position] == '\t') || (mime[position] == '\r') || (mime[position] == '\n'))
             {
-                unsigned long cnt01 = 0;
-                while (cnt01 < parsedEntry.contents.length())
+                std::size_t whitespaceEnd{std::min(mime.find_first_not_of(" \t\r\n", position), mime.size())};
+                if (!lastWordEncoded || !parseEncodedWord(mime.substr(whitespaceEnd), word))
                 {
-                    if (parsedEntry.contents[cnt01] != kQuotedPrintPrefix)
+                    for (; position < whitespaceEnd; position++)
                     {
-                        convertedMIME.append(1, parsedEntry.contents[cnt01++]);
-                    }
-                    else
-                    {
-                        unsigned char byte1, byte2;
-                        cnt01++;
-                        byte2 = parsedEntry.contents[cnt01++];
-                        byte1 = ((byte2 <= '9') ? (byte2 - '0') : ((byte2 - 'A') + 10)) << 4;
-                        byte2 = parsedEntry.contents[cnt01++];
-                        byte1 |= ((byte2 <= '9') ? (byte2 - '0') : ((byte2 - 'A') + 10));
-                        convertedMIME.append(1, byte1);
+                        if ((mime[position] == ' ') || (mime[position] == '\t'))
+                        {
+                            append(mime.substr(position, 1));
+                        }
                     }
                 }
+                position = whitespaceEnd;
+            }
+            else if (parseEncodedWord(mime.substr(position), word))
+            {
+                decodedLength += decodeEncodedWord(word, &decoded[decodedLength], decodedSize - decodedLength, toUTF8);
+                position += word.length;
+                lastWordEncoded = true;
             }
-            else if (parsedEntry.type == kEncodedWordTypeBase64)
+            else
             {
-                std::string decoded;
-                Antik::SMTP::CSMTP::decodeFromBase64(parsedEntry.contents, decoded, parsedEntry.contents.length());
-                convertedMIME += decoded;
+                std::size_t textEnd{std::min({mime.find_first_of(" \t\r\n", position),
+                                              mime.find(kEncodedWordPrefix, position + 1),
+                                              mime.size()})};
+                append(mime.substr(position, textEnd - position));
+                position = textEnd;
+                lastWordEncoded = false;
             }
         }
+        return (decodedLength);
+    }
+    //
+    // Parse MIME string passed in and convert it to ASCII as best can.
+    //
+    std::string CMIME::convertMIMEStringToASCII(const std::string &mime)
+    {
+        std::string convertedMIME(mime.size(), ' ');
+        convertedMIME.resize(decodeMIMEString(mime, convertedMIME.data(), convertedMIME.size()));
         return (convertedMIME);
     }
 } // namespace Antik::File
@@ -23,6 +23,7 @@
 //
 // C++ STL
 //
+#include <new>
 // =========
 // NAMESPACE
 // =========
@@ -239,10 +240,14 @@ namespace Antik::SSH
         }
         return m_ioBuffer;
     }
+    //
+    // Set IO buffer size; the buffer is page aligned so that it suits large local file IO.
+    //
     void CSCP::setIoBufferSize(std::uint32_t ioBufferSize)
     {
         m_ioBufferSize = ioBufferSize;
-        m_ioBuffer = std::make_unique<char[]>(m_ioBufferSize);
+        m_ioBuffer.reset(new (std::align_val_t(kIoBufferAlignment)) char[m_ioBufferSize],
+                         [](char *ioBuffer) { ::operator delete[](ioBuffer, std::align_val_t(kIoBufferAlignment)); });
     }
     std::uint32_t CSCP::getIoBufferSize() const
     {
@@ -11,19 +11,26 @@
 // Dependencies:
 //
 // C20++        - Language standard features used.
-// libssh       - Used to talk to SSH server (https://www.libssh.org/) (0.7.5)
+// libssh       - Used to talk to SSH server (https://www.libssh.org/) (0.7.5, aio API
+//                used for pipelined IO if 0.11.0 or later)
 //
 //
 // =================
 // CLASS DEFINITIONS
 // =================
 #include "CSFTP.hpp"
+#include "CSSHChannel.hpp"
+#include "CSFTPExtended.hpp"
 // ====================
 // CLASS IMPLEMENTATION
 // ====================
 //
 // C++ STL
 //
+#include <algorithm>
+#include <limits>
+#include <cstdlib>
+#include <new>
 // =========
 // NAMESPACE
 // =========
@@ -44,6 +51,315 @@ namespace Antik::SSH
     // ===============
     // PRIVATE METHODS
     // ===============
+    //
+    // Issue an asynchronous read request for the next length bytes of a file (at offset).
+    // libssh 0.11 onwards uses the aio API, earlier versions sftp_async_read_begin().
+    //
+    CSFTP::AsyncRequest CSFTP::beginAsyncRead(const File &fileHandle, std::uint64_t offset, std::uint32_t length)
+    {
+        AsyncRequest request;
+        request.offset = offset;
+        request.length = length;
+#if LIBSSH_VERSION_INT >= SSH_VERSION_INT(0, 11, 0)
+        if (sftp_aio_begin_read(fileHandle.get(), length, &request.aio) == SSH_ERROR)
+        {
+            throw Exception(*this, __func__);
+        }
+#else
+        int id = sftp_async_read_begin(fileHandle.get(), length);
+        if (id < 0)
+        {
+            throw Exception(*this, __func__);
+        }
+        request.id = static_cast<std::uint32_t>(id);
+#endif
+        return (request);
+    }
+    //
+    // Wait for an asynchronous read request to complete and return the number of bytes
+    // read (0 on end of file).
+    //
+    int CSFTP::waitAsyncRead(const File &fileHandle, AsyncRequest &request, void *readBuffer)
+    {
+#if LIBSSH_VERSION_INT >= SSH_VERSION_INT(0, 11, 0)
+        (void)fileHandle;
+        ssize_t bytesRead = sftp_aio_wait_read(&request.aio, readBuffer, request.length);
+#else
+        int bytesRead = sftp_async_read(fileHandle.get(), readBuffer, request.length, request.id);
+#endif
+        if (bytesRead < 0)
+        {
+            throw Exception(*this, __func__, request.offset);
+        }
+        return (static_cast<int>(bytesRead));
+    }
+    //
+    // Issue an asynchronous write request for length bytes at offset. The data is copied
+    // into the request so the buffer may be reused as soon as this returns. Before libssh
+    // 0.11 there is no asynchronous write so the write is performed synchronously.
+    //
+    CSFTP::AsyncRequest CSFTP::beginAsyncWrite(const File &fileHandle, std::uint64_t offset, const void *writeBuffer, std::uint32_t length)
+    {
+        AsyncRequest request;
+        request.write = true;
+        request.offset = offset;
+        request.length = length;
+#if LIBSSH_VERSION_INT >= SSH_VERSION_INT(0, 11, 0)
+        if (sftp_aio_begin_write(fileHandle.get(), writeBuffer, length, &request.aio) == SSH_ERROR)
+        {
+            throw Exception(*this, __func__, offset);
+        }
+#else
+        if (sftp_write(fileHandle.get(), writeBuffer, length) != static_cast<ssize_t>(length))
+        {
+            throw Exception(*this, __func__, offset);
+        }
+#endif
+        return (request);
+    }
+    //
+    // Wait for an asynchronous write request to be acknowledged.
+    //
+    void CSFTP::waitAsyncWrite(AsyncRequest &request)
+    {
+#if LIBSSH_VERSION_INT >= SSH_VERSION_INT(0, 11, 0)
+        if (sftp_aio_wait_write(&request.aio) != static_cast<ssize_t>(request.length))
+        {
+            throw Exception(*this, __func__, request.offset);
+        }
+#else
+        (void)request;
+#endif
+    }
+    //
+    // Wait for and discard the results of any outstanding asynchronous requests (after
+    // an error) so that their replies are not left queued on the session.
+    //
+    void CSFTP::cancelAsyncRequests(const File &fileHandle, std::deque<AsyncRequest> &requests)
+    {
+        for (auto &request : requests)
+        {
+#if LIBSSH_VERSION_INT >= SSH_VERSION_INT(0, 11, 0)
+            (void)fileHandle;
+            if (request.write)
+            {
+                sftp_aio_wait_write(&request.aio);
+            }
+            else
+            {
+                sftp_aio_wait_read(&request.aio, m_ioBuffer.get(), request.length);
+            }
+            sftp_aio_free(request.aio);
+#else
+            if (!request.write)
+            {
+                sftp_async_read(fileHandle.get(), m_ioBuffer.get(), request.length, request.id);
+            }
+#endif
+        }
+        requests.clear();
+    }
+    //
+    // Get the servers limits (limits@openssh.com) and, unless set by the caller, size the
+    // IO buffer to the largest read/write request the server accepts and the IO pipeline
+    // depth to keep kIoPipelineBytes in flight. libssh only exposes the extension from 0.11
+    // on (sftp_limits()); before that the defaults are kept.
+    //
+    void CSFTP::negotiateLimits()
+    {
+        m_limits = Limits();
+#if LIBSSH_VERSION_INT >= SSH_VERSION_INT(0, 11, 0)
+        if (extensionSupported("limits@openssh.com", "1"))
+        {
+            sftp_limits_t limits{sftp_limits(m_sftp)};
+            if (limits != NULL)
+            {
+                m_limits.negotiated = true;
+                m_limits.maxPacketLength = limits->max_packet_length;
+                m_limits.maxReadLength = limits->max_read_length;
+                m_limits.maxWriteLength = limits->max_write_length;
+                sftp_limits_free(limits);
+            }
+        }
+#endif
+        if (m_limits.negotiated)
+        {
+            if (!m_ioBufferSizeSet)
+            {
+                std::uint64_t ioBufferSize{kMaximumIoBufferSize};
+                for (auto maxLength : {m_limits.maxReadLength, m_limits.maxWriteLength})
+                {
+                    if (maxLength != 0)
+                    {
+                        ioBufferSize = std::min(ioBufferSize, maxLength);
+                    }
+                }
+                m_ioBufferSize = static_cast<std::uint32_t>(ioBufferSize);
+                m_ioBuffer.reset();
+            }
+            if (!m_ioPipelineDepthSet)
+            {
+                m_ioPipelineDepth = std::clamp(kIoPipelineBytes / m_ioBufferSize, 1U, kMaximumIoPipelineDepth);
+            }
+        }
+    }
+    //
+    // Return IO request length; the IO buffer size limited to the servers maximum.
+    //
+    std::uint32_t CSFTP::ioRequestLength(std::uint64_t maxLength) const
+    {
+        if ((maxLength != 0) && (maxLength < m_ioBufferSize))
+        {
+            return (static_cast<std::uint32_t>(maxLength));
+        }
+        return (m_ioBufferSize);
+    }
+    //
+    // Run a command on the server over an exec channel discarding any output. Returns true
+    // if it ran with an exit status of zero; false if it failed or exec is not permitted.
+    // stdout and stderr are both drained as data arrives so a command writing a lot to
+    // stderr is not stalled by a full channel window. Known directories are left alone; a
+    // caller running a command that removes or renames directories has to forget them.
+    //
+    bool CSFTP::executeRemoteCommand(const std::string &command)
+    {
+        try
+        {
+            CSSHChannel channel{m_session};
+            std::unique_ptr<std::pointer_traits<ssh_event>::element_type, decltype(&ssh_event_free)> channelEvent{ssh_event_new(), ssh_event_free};
+            int exitStatus;
+            ssh_event_add_session(channelEvent.get(), m_session.getSession());
+            try
+            {
+                channel.open();
+                channel.execute(command);
+                char *ioBuffer{channel.getIoBuffer().get()};
+                while (true)
+                {
+                    while (channel.readNonBlocking(ioBuffer, channel.getIoBufferSize()) > 0)
+                    {
+                    }
+                    while (channel.readNonBlocking(ioBuffer, channel.getIoBufferSize(), true) > 0)
+                    {
+                    }
+                    if (channel.isEndOfFile() || channel.isClosed())
+                    {
+                        break;
+                    }
+                    if (ssh_event_dopoll(channelEvent.get(), kCommandPollTimeout) == SSH_ERROR)
+                    {
+                        throw CSSHChannel::Exception(channel, __func__);
+                    }
+                }
+                exitStatus = channel.getExitStatus();
+            }
+            catch (...)
+            {
+                ssh_event_remove_session(channelEvent.get(), m_session.getSession());
+                channel.close();
+                throw;
+            }
+            ssh_event_remove_session(channelEvent.get(), m_session.getSession());
+            channel.close();
+            return (exitStatus == 0);
+        }
+        catch (const CSSHChannel::Exception &e)
+        {
+            return (false);
+        }
+    }
+    //
+    // Copy a file on the server with the copy-data extension over a separate sftp subsystem
+    // channel (libssh has no call for it), opened on first use and kept open. Returns false
+    // if the server does not support copy-data or the copy failed.
+    //
+    bool CSFTP::copyDataOnServer(const std::string &sourceFile, const std::string &destinationFile, std::uint32_t permissions)
+    {
+        if (m_copyDataUnavailable)
+        {
+            return (false);
+        }
+        try
+        {
+            if (!m_extended)
+            {
+                if (!extensionSupported("copy-data", "1"))
+                {
+                    m_copyDataUnavailable = true;
+                    return (false);
+                }
+                m_extended = std::make_unique<CSFTPExtended>(m_session);
+                m_extended->open();
+            }
+            m_extended->copyData(sourceFile, destinationFile, permissions);
+            return (true);
+        }
+        catch (const CSFTPExtended::Exception &e)
+        {
+            if ((e.sftpGetCode() == CSFTPExtended::kStatusUnsupported) || !m_extended->isOpen())
+            {
+                m_copyDataUnavailable = true;
+                m_extended.reset();
+            }
+        }
+        catch (const CSSHChannel::Exception &e)
+        {
+            m_copyDataUnavailable = true;
+            m_extended.reset();
+        }
+        return (false);
+    }
+    //
+    // Copy a file on the server by streaming it through the client; reads are pipelined and
+    // each block read is written with an asynchronous write so up to the IO pipeline depth of
+    // writes are also awaiting acknowledgement (see isWritePipelined()).
+    //
+    void CSFTP::copyFileData(const std::string &sourceFile, const std::string &destinationFile, std::uint32_t permissions)
+    {
+        std::deque<AsyncRequest> outstanding;
+        std::uint32_t pipelineDepth{isWritePipelined() ? std::max(m_ioPipelineDepth, 1U) : 1U};
+        std::uint64_t offset{0};
+        File source{openFile(sourceFile, O_RDONLY, 0)};
+        File destination{openFile(destinationFile, O_CREAT | O_WRONLY | O_TRUNC, permissions)};
+        try
+        {
+            readFileAsync(source, [this, &destination, &outstanding, &offset, pipelineDepth](const char *readBuffer, size_t bytesRead) {
+                if (outstanding.size() >= pipelineDepth)
+                {
+                    AsyncRequest request{outstanding.front()};
+                    outstanding.pop_front();
+                    waitAsyncWrite(request);
+                }
+                outstanding.push_back(beginAsyncWrite(destination, offset, readBuffer, static_cast<std::uint32_t>(bytesRead)));
+                offset += bytesRead;
+            });
+            while (!outstanding.empty())
+            {
+                AsyncRequest request{outstanding.front()};
+                outstanding.pop_front();
+                waitAsyncWrite(request);
+            }
+        }
+        catch (...)
+        {
+            cancelAsyncRequests(destination, outstanding);
+            throw;
+        }
+        closeFile(destination);
+        closeFile(source);
+    }
+    //
+    // Quote a remote path for use as a server shell command argument.
+    //
+    std::string CSFTP::quoteRemotePath(const std::string &remotePath)
+    {
+        std::string quotedPath{"'"};
+        for (auto character : remotePath)
+        {
+            quotedPath += (character == '\'') ? std::string("'\\''") : std::string(1, character);
+        }
+        return (quotedPath + "'");
+    }
     // ==============
     // PUBLIC METHODS
     // ==============
@@ -76,6 +392,7 @@ namespace Antik::SSH
             m_sftp = NULL;
             throw Exception(*this, __func__);
         }
+        negotiateLimits();
     }
     //
     // Close connection with SFTP server and free its resources.
@@ -89,6 +406,9 @@ namespace Antik::SSH
         }
         // Free IO Buffer
         m_ioBuffer.reset();
+        clearKnownDirectories();
+        m_extended.reset();
+        m_copyDataUnavailable = false;
     }
     //
     // Open a remote file for IO.
@@ -127,6 +447,128 @@ namespace Antik::SSH
         return (bytesWritten);
     }
     //
+    // Read a remote file from its current position to end of file (or for bytesToRead bytes
+    // if non-zero) keeping up to the IO pipeline depth of read requests outstanding so that
+    // throughput is not limited by the round trip time. Data is passed to the callback in file
+    // order and the total number of bytes read returned. A short read with data after it (the
+    // server is allowed to return less than asked for) is re-requested from where it stopped.
+    //
+    std::uint64_t CSFTP::readFileAsync(const File &fileHandle, const ReadCallbackFn &readCallbackFn, std::uint64_t bytesToRead)
+    {
+        std::deque<AsyncRequest> outstanding;
+        std::uint64_t offset{currentFilePostion64(fileHandle)};
+        std::uint64_t endOffset{(bytesToRead != 0) ? offset + bytesToRead : std::numeric_limits<std::uint64_t>::max()};
+        std::uint64_t bytesTotal{0};
+        bool endOfFile{false};
+        char *readBuffer{getIoBuffer().get()};
+        std::uint32_t requestLength{ioRequestLength(m_limits.maxReadLength)};
+        try
+        {
+            while (!endOfFile)
+            {
+                while ((outstanding.size() < std::max(m_ioPipelineDepth, 1U)) && (offset < endOffset))
+                {
+                    std::uint32_t length{static_cast<std::uint32_t>(std::min<std::uint64_t>(requestLength, endOffset - offset))};
+                    outstanding.push_back(beginAsyncRead(fileHandle, offset, length));
+                    offset += length;
+                }
+                if (outstanding.empty())
+                {
+                    break; // Requested range read
+                }
+                AsyncRequest request{outstanding.front()};
+                outstanding.pop_front();
+                int bytesRead{waitAsyncRead(fileHandle, request, readBuffer)};
+                if (bytesRead > 0)
+                {
+                    readCallbackFn(readBuffer, bytesRead);
+                    bytesTotal += bytesRead;
+                }
+                if (static_cast<std::uint32_t>(bytesRead) < request.length)
+                {
+                    // End of file unless any later request returned data
+                    bool moreData{false};
+                    bool laterRequests{!outstanding.empty()};
+                    while (!outstanding.empty())
+                    {
+                        moreData |= (waitAsyncRead(fileHandle, outstanding.front(), readBuffer) > 0);
+                        outstanding.pop_front();
+                    }
+                    endOfFile = ((bytesRead == 0) || (laterRequests && !moreData));
+                    if (!endOfFile)
+                    {
+                        offset = request.offset + bytesRead;
+                        seekFile64(fileHandle, offset);
+                    }
+                }
+            }
+        }
+        catch (...)
+        {
+            cancelAsyncRequests(fileHandle, outstanding);
+            throw;
+        }
+        return (bytesTotal);
+    }
+    //
+    // Write a remote file from its current position with data from the source function
+    // until it returns 0, keeping up to the IO pipeline depth of write requests awaiting
+    // acknowledgement. Returns the total number of bytes written. If any request fails
+    // the exception raised holds the file offset of the failed request. Before libssh 0.11
+    // (see isWritePipelined()) each write completes before the next is sent so the pipeline
+    // depth is 1 and throughput is that of writeFile().
+    //
+    std::uint64_t CSFTP::writeFileAsync(const File &fileHandle, const WriteSourceFn &writeSourceFn)
+    {
+        std::deque<AsyncRequest> outstanding;
+        std::uint32_t pipelineDepth{isWritePipelined() ? std::max(m_ioPipelineDepth, 1U) : 1U};
+        std::uint64_t startOffset{currentFilePostion64(fileHandle)};
+        std::uint64_t offset{startOffset};
+        bool endOfSource{false};
+        char *writeBuffer{getIoBuffer().get()};
+        std::uint32_t requestLength{ioRequestLength(m_limits.maxWriteLength)};
+        try
+        {
+            while (!endOfSource || !outstanding.empty())
+            {
+                if (!endOfSource && (outstanding.size() < pipelineDepth))
+                {
+                    size_t bytesToWrite{writeSourceFn(writeBuffer, requestLength)};
+                    if (bytesToWrite == 0)
+                    {
+                        endOfSource = true;
+                        continue;
+                    }
+                    outstanding.push_back(beginAsyncWrite(fileHandle, offset, writeBuffer, bytesToWrite));
+                    offset += bytesToWrite;
+                }
+                else
+                {
+                    AsyncRequest request{outstanding.front()};
+                    outstanding.pop_front();
+                    waitAsyncWrite(request);
+                }
+            }
+        }
+        catch (...)
+        {
+            cancelAsyncRequests(fileHandle, outstanding);
+            throw;
+        }
+        return (offset - startOffset);
+    }
+    //
+    // Return true if writeFileAsync() has more than one write request in flight.
+    //
+    bool CSFTP::isWritePipelined()
+    {
+#if LIBSSH_VERSION_INT >= SSH_VERSION_INT(0, 11, 0)
+        return (true);
+#else
+        return (false);
+#endif
+    }
+    //
     // Close a remote file.
     //
     void CSFTP::closeFile(File &fileHandle)
@@ -276,13 +718,22 @@ namespace Antik::SSH
             {
                 throw Exception(*this, __func__);
             }
+            // Only an existing directory will do (not a file of the same name)
+            FileAttributes fileAttributes;
+            getFileAttributes(directoryPath, fileAttributes);
+            if (!isADirectory(fileAttributes))
+            {
+                throw Exception("Path " + directoryPath + " exists and is not a directory.", __func__);
+            }
         }
+        addKnownDirectory(directoryPath);
     }
     //
     // Remove a remote directory.
     //
     void CSFTP::removeDirectory(const std::string &directoryPath)
     {
+        forgetKnownDirectory(directoryPath);
         if (sftp_rmdir(m_sftp, directoryPath.c_str()) < 0)
         {
             throw Exception(*this, __func__);
@@ -319,6 +770,7 @@ namespace Antik::SSH
     //
     void CSFTP::removeLink(const std::string &filePath)
     {
+        forgetKnownDirectory(filePath); // May be a link to a directory
         if (sftp_unlink(m_sftp, filePath.c_str()) < 0)
         {
             throw Exception(*this, __func__);
@@ -329,12 +781,69 @@ namespace Antik::SSH
     //
     void CSFTP::renameFile(const std::string &sourceFile, const std::string &destinationFile)
     {
+        forgetKnownDirectory(sourceFile);
+        forgetKnownDirectory(destinationFile);
         if (sftp_rename(m_sftp, sourceFile.c_str(), destinationFile.c_str()) < 0)
         {
             throw Exception(*this, __func__);
         }
     }
     //
+    // Copy a remote file on the server keeping its permissions and access/modification times
+    // (and its owner/group where the server allows). The copy-data extension is used if the
+    // server supports it; otherwise cp -p is run on the server and only if exec is not
+    // permitted (for example an sftp only account) or the cp fails is the file streamed
+    // through this client.
+    //
+    void CSFTP::copyFile(const std::string &sourceFile, const std::string &destinationFile)
+    {
+        FileAttributes fileAttributes;
+        getFileAttributes(sourceFile, fileAttributes);
+        std::uint32_t permissions{fileAttributes->permissions & 07777};
+        if (!copyDataOnServer(sourceFile, destinationFile, permissions))
+        {
+            if (executeRemoteCommand("cp -p -- " + quoteRemotePath(sourceFile) + " " + quoteRemotePath(destinationFile)))
+            {
+                return;
+            }
+            copyFileData(sourceFile, destinationFile, permissions);
+        }
+        FileAttributes copiedAttributes{preservedAttributes(fileAttributes)};
+        copiedAttributes->flags &= ~SSH_FILEXFER_ATTR_UIDGID;
+        setFileAttributes(destinationFile, copiedAttributes);
+        try
+        {
+            // Like cp -p a copy that cannot be given the source's owner/group keeps the user's
+            copiedAttributes = preservedAttributes(fileAttributes);
+            copiedAttributes->flags = SSH_FILEXFER_ATTR_UIDGID;
+            setFileAttributes(destinationFile, copiedAttributes);
+        }
+        catch (const Exception &e)
+        {
+        }
+    }
+    //
+    // Return the attributes of a file that a copy of it keeps (permissions, access/modification
+    // times and owner/group) with the flags set for setFileAttributes().
+    //
+    CSFTP::FileAttributes CSFTP::preservedAttributes(const FileAttributes &fileAttributes)
+    {
+        FileAttributes copiedAttributes{static_cast<sftp_attributes>(std::calloc(1, sizeof(sftp_attributes_struct)))};
+        if (copiedAttributes.get() == NULL)
+        {
+            throw std::bad_alloc();
+        }
+        copiedAttributes->flags = SSH_FILEXFER_ATTR_PERMISSIONS | SSH_FILEXFER_ATTR_ACMODTIME | SSH_FILEXFER_ATTR_UIDGID;
+        copiedAttributes->permissions = fileAttributes->permissions & 07777;
+        copiedAttributes->atime = fileAttributes->atime;
+        copiedAttributes->atime64 = fileAttributes->atime64;
+        copiedAttributes->mtime = fileAttributes->mtime;
+        copiedAttributes->mtime64 = fileAttributes->mtime64;
+        copiedAttributes->uid = fileAttributes->uid;
+        copiedAttributes->gid = fileAttributes->gid;
+        return (copiedAttributes);
+    }
+    //
     // Rewind a file to its start position.
     //
     void CSFTP::rewindFile(const File &fileHandle)
@@ -501,19 +1010,119 @@ namespace Antik::SSH
     {
         if (!m_ioBuffer)
         {
-            setIoBufferSize(m_ioBufferSize);
+            m_ioBuffer = std::make_unique<char[]>(m_ioBufferSize);
         }
         return m_ioBuffer;
     }
     void CSFTP::setIoBufferSize(std::uint32_t ioBufferSize)
     {
         m_ioBufferSize = ioBufferSize;
+        m_ioBufferSizeSet = true;
         m_ioBuffer = std::make_unique<char[]>(m_ioBufferSize);
     }
     std::uint32_t CSFTP::getIoBufferSize() const
     {
         return m_ioBufferSize;
     }
+    void CSFTP::setIoPipelineDepth(std::uint32_t ioPipelineDepth)
+    {
+        m_ioPipelineDepth = ioPipelineDepth;
+        m_ioPipelineDepthSet = true;
+    }
+    std::uint32_t CSFTP::getIoPipelineDepth() const
+    {
+        return m_ioPipelineDepth;
+    }
+    //
+    // Get server limits negotiated on open (negotiated == false if not supported).
+    //
+    const CSFTP::Limits &CSFTP::getLimits() const
+    {
+        return m_limits;
+    }
+    //
+    // Record a remote directory as known to exist.
+    //
+    void CSFTP::addKnownDirectory(const std::string &directoryPath)
+    {
+        m_knownDirectories.add(directoryPath);
+    }
+    //
+    // Return true if a remote directory is known to exist.
+    //
+    bool CSFTP::isKnownDirectory(const std::string &directoryPath) const
+    {
+        return (m_knownDirectories.contains(directoryPath));
+    }
+    //
+    // Forget a remote directory (and any below it) as it may no longer exist.
+    //
+    void CSFTP::forgetKnownDirectory(const std::string &directoryPath)
+    {
+        m_knownDirectories.forget(directoryPath);
+    }
+    //
+    // Clear known remote directories.
+    //
+    void CSFTP::clearKnownDirectories()
+    {
+        m_knownDirectories.clear();
+    }
+    //
+    // Known directory cache key for a path (no trailing separator).
+    //
+    std::string CSFTP::DirectoryCache::key(const std::string &directoryPath)
+    {
+        std::string directoryKey{directoryPath};
+        while ((directoryKey.size() > 1) && (directoryKey.back() == kServerPathSep))
+        {
+            directoryKey.pop_back();
+        }
+        return (directoryKey);
+    }
+    //
+    // Add a directory to the cache.
+    //
+    void CSFTP::DirectoryCache::add(const std::string &directoryPath)
+    {
+        if (!directoryPath.empty())
+        {
+            m_directories.insert(key(directoryPath));
+        }
+    }
+    //
+    // Return true if a directory is in the cache.
+    //
+    bool CSFTP::DirectoryCache::contains(const std::string &directoryPath) const
+    {
+        return (!directoryPath.empty() && (m_directories.count(key(directoryPath)) != 0));
+    }
+    //
+    // Remove a directory and any below it from the cache.
+    //
+    void CSFTP::DirectoryCache::forget(const std::string &directoryPath)
+    {
+        if (directoryPath.empty())
+        {
+            return;
+        }
+        std::string directoryKey{key(directoryPath)};
+        std::string directoryPrefix{(directoryKey.back() == kServerPathSep) ? directoryKey : directoryKey + kServerPathSep};
+        m_directories.erase(directoryKey);
+        // Directories below share the prefix so are contiguous in the ordered set
+        auto directory = m_directories.lower_bound(directoryPrefix);
+        while ((directory != m_directories.end()) && (directory->compare(0, directoryPrefix.size(), directoryPrefix) == 0))
+        {
+            directory = m_directories.erase(directory);
+        }
+    }
+    //
+    // Empty the cache.
+    //
+    void CSFTP::DirectoryCache::clear()
+    {
+        m_directories.clear();
+    }
     //
     // Get internal libssh ssh/sftp session data structure pointers.
     //
@@ -0,0 +1,540 @@
+//
+// Class: CSFTPExtended
+//
+// Description: A minimal SFTP (version 3) client run over its own sftp subsystem channel
+// on an existing session that issues the extended requests libssh has no call for
+// (check-file-name, md5-hash and copy-data). Only the handful of packet types needed
+// are implemented; everything else should go through CSFTP. Requests for a list of
+// files are pipelined so that hashing many small files is not limited by the round
+// trip time.
+//
+// Dependencies:
+//
+// C20++        - Language standard features used.
+// libssh       - Used to talk to SSH server (https://www.libssh.org/) (0.7.5)
+//
+// =================
+// CLASS DEFINITIONS
+// =================
+#include "CSFTPExtended.hpp"
+// ====================
+// CLASS IMPLEMENTATION
+// ====================
+//
+// C++ STL
+//
+#include <deque>
+#include <sstream>
+#include <iomanip>
+// =========
+// NAMESPACE
+// =========
+namespace Antik::SSH
+{
+    // ===========================
+    // PRIVATE TYPES AND CONSTANTS
+    // ===========================
+    //
+    // SFTP packet types and open flags (draft-ietf-secsh-filexfer-02).
+    //
+    static constexpr std::uint8_t kFxpInit{1};
+    static constexpr std::uint8_t kFxpVersion{2};
+    static constexpr std::uint8_t kFxpOpen{3};
+    static constexpr std::uint8_t kFxpClose{4};
+    static constexpr std::uint8_t kFxpStatus{101};
+    static constexpr std::uint8_t kFxpHandle{102};
+    static constexpr std::uint8_t kFxpExtended{200};
+    static constexpr std::uint8_t kFxpExtendedReply{201};
+    static constexpr std::uint32_t kFxfRead{0x01};
+    static constexpr std::uint32_t kFxfWrite{0x02};
+    static constexpr std::uint32_t kFxfCreat{0x08};
+    static constexpr std::uint32_t kFxfTrunc{0x10};
+    static constexpr std::uint32_t kAttrPermissions{0x04};
+    // ==========================
+    // PUBLIC TYPES AND CONSTANTS
+    // ==========================
+    // ========================
+    // PRIVATE STATIC VARIABLES
+    // ========================
+    // =======================
+    // PUBLIC STATIC VARIABLES
+    // =======================
+    // ===============
+    // PRIVATE METHODS
+    // ===============
+    //
+    // Return binary data as lower case hex.
+    //
+    static std::string toHex(std::string_view data)
+    {
+        std::ostringstream hex;
+        for (unsigned char byte : data)
+        {
+            hex << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(byte);
+        }
+        return (hex.str());
+    }
+    //
+    // Send a packet (length prefixed).
+    //
+    void CSFTPExtended::sendPacket(const Packet &packet)
+    {
+        Packet length;
+        length.putUInt32(static_cast<std::uint32_t>(packet.getData().size()));
+        std::string packetData{length.getData() + packet.getData()};
+        std::size_t bytesSent{0};
+        while (bytesSent < packetData.size())
+        {
+            bytesSent += m_channel->write(&packetData[bytesSent], static_cast<std::uint32_t>(packetData.size() - bytesSent));
+        }
+    }
+    //
+    // Receive the next packet.
+    //
+    CSFTPExtended::Packet CSFTPExtended::receivePacket()
+    {
+        auto readExactly = [this](std::size_t length) {
+            std::string data(length, '\0');
+            std::size_t bytesRead{0};
+            while (bytesRead < length)
+            {
+                int readCount{m_channel->read(&data[bytesRead], static_cast<std::uint32_t>(length - bytesRead))};
+                if (readCount <= 0)
+                {
+                    throw Exception("Server closed the SFTP channel.", "receivePacket");
+                }
+                bytesRead += readCount;
+            }
+            return (data);
+        };
+        Packet length{readExactly(sizeof(std::uint32_t))};
+        std::uint32_t packetLength{length.getUInt32()};
+        if ((packetLength == 0) || (packetLength > kMaximumPacketLength))
+        {
+            throw Exception("Invalid SFTP packet length " + std::to_string(packetLength) + ".", __func__);
+        }
+        return (Packet(readExactly(packetLength)));
+    }
+    //
+    // Send a request (type, id, arguments) and return its id.
+    //
+    std::uint32_t CSFTPExtended::sendRequest(std::uint8_t type, const Packet &arguments)
+    {
+        Packet request;
+        std::uint32_t id{m_nextId++};
+        request.putByte(type);
+        request.putUInt32(id);
+        sendPacket(Packet(request.getData() + arguments.getData()));
+        return (id);
+    }
+    //
+    // Return the reply to a request (positioned at its type); replies for other requests
+    // received first are kept until they are waited for.
+    //
+    CSFTPExtended::Packet CSFTPExtended::receiveReply(std::uint32_t id)
+    {
+        auto reply = m_replies.find(id);
+        if (reply != m_replies.end())
+        {
+            Packet packet{std::move(reply->second)};
+            m_replies.erase(reply);
+            return (packet);
+        }
+        while (true)
+        {
+            Packet packet{receivePacket()};
+            Packet header{packet};
+            header.getByte();
+            std::uint32_t replyId{header.getUInt32()};
+            if (replyId == id)
+            {
+                return (packet);
+            }
+            m_replies.emplace(replyId, std::move(packet));
+        }
+    }
+    //
+    // Throw if a status reply (positioned after its id) is not OK.
+    //
+    void CSFTPExtended::checkStatus(Packet &reply, const std::string &functionName)
+    {
+        std::uint32_t status{reply.getUInt32()};
+        if (status != kStatusOk)
+        {
+            std::string message{reply.atEnd() ? "" : reply.getString()};
+            throw Exception(message.empty() ? "SFTP status " + std::to_string(status) : message, functionName, status);
+        }
+    }
+    //
+    // Open a remote file and return its handle.
+    //
+    std::string CSFTPExtended::openHandle(const std::string &filePath, std::uint32_t flags, std::uint32_t permissions)
+    {
+        Packet arguments;
+        arguments.putString(filePath);
+        arguments.putUInt32(flags);
+        arguments.putUInt32((flags & kFxfCreat) ? kAttrPermissions : 0);
+        if (flags & kFxfCreat)
+        {
+            arguments.putUInt32(permissions);
+        }
+        Packet reply{receiveReply(sendRequest(kFxpOpen, arguments))};
+        std::uint8_t type{reply.getByte()};
+        reply.getUInt32();
+        if (type == kFxpHandle)
+        {
+            return (reply.getString());
+        }
+        if (type == kFxpStatus)
+        {
+            checkStatus(reply, __func__);
+        }
+        throw Exception("Unexpected reply to open of " + filePath + ".", __func__);
+    }
+    //
+    // Close a remote file handle.
+    //
+    void CSFTPExtended::closeHandle(const std::string &handle)
+    {
+        Packet arguments;
+        arguments.putString(handle);
+        Packet reply{receiveReply(sendRequest(kFxpClose, arguments))};
+        if (reply.getByte() != kFxpStatus)
+        {
+            throw Exception("Unexpected reply to close.", __func__);
+        }
+        reply.getUInt32();
+        checkStatus(reply, __func__);
+    }
+    //
+    // Issue an extended request for each file keeping up to kMaximumOutstanding in flight.
+    // Results are parsed from the extended replies; a file whose request failed (status
+    // reply) keeps a default constructed result.
+    //
+    template <typename Result, typename ParseFn>
+    std::vector<Result> CSFTPExtended::pipelineExtended(const std::string &request, const std::vector<std::string> &filePaths, const std::function<void(Packet &, const std::string &)> &argumentsFn, ParseFn parseFn)
+    {
+        std::vector<Result> results(filePaths.size());
+        std::deque<std::pair<std::uint32_t, std::size_t>> outstanding;
+        std::size_t fileIndex{0};
+        while ((fileIndex < filePaths.size()) || !outstanding.empty())
+        {
+            if ((fileIndex < filePaths.size()) && (outstanding.size() < kMaximumOutstanding))
+            {
+                Packet arguments;
+                arguments.putString(request);
+                argumentsFn(arguments, filePaths[fileIndex]);
+                outstanding.emplace_back(sendRequest(kFxpExtended, arguments), fileIndex++);
+                continue;
+            }
+            Packet reply{receiveReply(outstanding.front().first)};
+            std::size_t resultIndex{outstanding.front().second};
+            outstanding.pop_front();
+            std::uint8_t type{reply.getByte()};
+            reply.getUInt32();
+            if (type == kFxpExtendedReply)
+            {
+                results[resultIndex] = parseFn(reply);
+            }
+            else if (type != kFxpStatus)
+            {
+                throw Exception("Unexpected reply to " + request + ".", __func__);
+            }
+        }
+        return (results);
+    }
+    // ==============
+    // PUBLIC METHODS
+    // ==============
+    //
+    // Main CSFTPExtended object constructor. The passed in session has to be
+    // connected and authorized for the channel to be opened.
+    //
+    CSFTPExtended::CSFTPExtended(CSSHSession &session) : m_session{session}
+    {
+    }
+    //
+    // CSFTPExtended Destructor
+    //
+    CSFTPExtended::~CSFTPExtended()
+    {
+        close();
+    }
+    //
+    // Open an sftp subsystem channel and exchange versions; the server lists the
+    // extensions it supports in its version packet.
+    //
+    void CSFTPExtended::open()
+    {
+        try
+        {
+            Packet init;
+            m_channel = std::make_unique<CSSHChannel>(m_session);
+            m_channel->open();
+            m_channel->requestSubsystem("sftp");
+            init.putByte(kFxpInit);
+            init.putUInt32(kProtocolVersion);
+            sendPacket(init);
+            Packet version{receivePacket()};
+            if (version.getByte() != kFxpVersion)
+            {
+                throw Exception("Server did not send its SFTP version.", __func__);
+            }
+            version.getUInt32();
+            m_extensions.clear();
+            while (!version.atEnd())
+            {
+                std::string name{version.getString()};
+                m_extensions[name] = version.getString();
+            }
+        }
+        catch (...)
+        {
+            close();
+            throw;
+        }
+    }
+    //
+    // Close the sftp subsystem channel.
+    //
+    void CSFTPExtended::close()
+    {
+        if (m_channel)
+        {
+            m_channel->close();
+            m_channel.reset();
+        }
+        m_replies.clear();
+    }
+    //
+    // Return true if open.
+    //
+    bool CSFTPExtended::isOpen() const
+    {
+        return (m_channel != nullptr);
+    }
+    //
+    // Return true if the server advertised an extension.
+    //
+    bool CSFTPExtended::extensionSupported(const std::string &name) const
+    {
+        return (m_extensions.count(name) != 0);
+    }
+    //
+    // Hash remote files with check-file-name (see header).
+    //
+    std::vector<CSFTPExtended::FileHash> CSFTPExtended::checkFiles(const std::vector<std::string> &filePaths, const std::string &algorithms, std::uint32_t blockSize)
+    {
+        if (!extensionSupported("check-file"))
+        {
+            throw Exception("Server does not support check-file.", __func__, kStatusUnsupported);
+        }
+        auto argumentsFn = [&algorithms, blockSize](Packet &arguments, const std::string &filePath) {
+            arguments.putString(filePath);
+            arguments.putString(algorithms);
+            arguments.putUInt64(0); // Start offset
+            arguments.putUInt64(0); // Length (0 == to end of file)
+            arguments.putUInt32(blockSize);
+        };
+        return (pipelineExtended<FileHash>("check-file-name", filePaths, argumentsFn, parseCheckFileReply));
+    }
+    //
+    // Hash remote files with md5-hash (see header).
+    //
+    std::vector<std::string> CSFTPExtended::md5Hashes(const std::vector<std::string> &filePaths)
+    {
+        if (!extensionSupported("md5-hash"))
+        {
+            throw Exception("Server does not support md5-hash.", __func__, kStatusUnsupported);
+        }
+        auto argumentsFn = [](Packet &arguments, const std::string &filePath) {
+            arguments.putString(filePath);
+            arguments.putUInt64(0);  // Start offset
+            arguments.putUInt64(0);  // Length (0 == to end of file)
+            arguments.putString(""); // No quick check hash
+        };
+        return (pipelineExtended<std::string>("md5-hash", filePaths, argumentsFn, parseMd5HashReply));
+    }
+    //
+    // Return the copy-data request arguments to copy all of the source handle's file to the
+    // start of the destination handle's.
+    //
+    CSFTPExtended::Packet CSFTPExtended::copyDataArguments(const std::string &sourceHandle, const std::string &destinationHandle)
+    {
+        Packet arguments;
+        arguments.putString("copy-data");
+        arguments.putString(sourceHandle);
+        arguments.putUInt64(0); // Read from offset
+        arguments.putUInt64(0); // Read length (0 == to end of file)
+        arguments.putString(destinationHandle);
+        arguments.putUInt64(0); // Write to offset
+        return (arguments);
+    }
+    //
+    // Copy a remote file on the server with copy-data (from offset 0 to end of file).
+    //
+    void CSFTPExtended::copyData(const std::string &sourceFile, const std::string &destinationFile, std::uint32_t permissions)
+    {
+        if (!extensionSupported("copy-data"))
+        {
+            throw Exception("Server does not support copy-data.", __func__, kStatusUnsupported);
+        }
+        std::string sourceHandle{openHandle(sourceFile, kFxfRead, 0)};
+        std::string destinationHandle;
+        try
+        {
+            destinationHandle = openHandle(destinationFile, kFxfWrite | kFxfCreat | kFxfTrunc, permissions);
+            Packet reply{receiveReply(sendRequest(kFxpExtended, copyDataArguments(sourceHandle, destinationHandle)))};
+            if (reply.getByte() != kFxpStatus)
+            {
+                throw Exception("Unexpected reply to copy-data.", __func__);
+            }
+            reply.getUInt32();
+            checkStatus(reply, __func__);
+            closeHandle(destinationHandle);
+            closeHandle(sourceHandle);
+        }
+        catch (...)
+        {
+            try
+            {
+                if (!destinationHandle.empty())
+                {
+                    closeHandle(destinationHandle);
+                }
+                closeHandle(sourceHandle);
+            }
+            catch (...)
+            {
+            }
+            throw;
+        }
+    }
+    //
+    // Parse a check-file extended reply (positioned after its id) into per block hashes.
+    //
+    CSFTPExtended::FileHash CSFTPExtended::parseCheckFileReply(Packet &reply)
+    {
+        FileHash fileHash;
+        if (reply.getString() != "check-file")
+        {
+            throw Exception("Invalid check-file reply.", __func__);
+        }
+        fileHash.algorithm = reply.getString();
+        std::string hashData{reply.getRemaining()};
+        std::size_t length{hashLength(fileHash.algorithm)};
+        if ((length == 0) || (hashData.empty()) || ((hashData.size() % length) != 0))
+        {
+            throw Exception("Invalid check-file reply hash (" + fileHash.algorithm + ").", __func__);
+        }
+        for (std::size_t offset = 0; offset < hashData.size(); offset += length)
+        {
+            fileHash.hashes.push_back(toHex(std::string_view(hashData).substr(offset, length)));
+        }
+        return (fileHash);
+    }
+    //
+    // Parse a md5-hash extended reply (positioned after its id); empty if not hashed.
+    //
+    std::string CSFTPExtended::parseMd5HashReply(Packet &reply)
+    {
+        if (reply.getString() != "md5-hash")
+        {
+            throw Exception("Invalid md5-hash reply.", __func__);
+        }
+        std::string hash{reply.getString()};
+        if (!hash.empty() && (hash.size() != hashLength("md5")))
+        {
+            throw Exception("Invalid md5-hash reply hash.", __func__);
+        }
+        return (toHex(hash));
+    }
+    //
+    // Return the digest length in bytes of a check-file hash algorithm (0 == not supported).
+    //
+    std::size_t CSFTPExtended::hashLength(const std::string &algorithm)
+    {
+        static const std::map<std::string, std::size_t> kHashLengths{{"md5", 16}, {"sha1", 20}, {"sha224", 28}, {"sha256", 32}, {"sha384", 48}, {"sha512", 64}};
+        auto hashLength = kHashLengths.find(algorithm);
+        return ((hashLength != kHashLengths.end()) ? hashLength->second : 0);
+    }
+    // ==============
+    // PACKET METHODS
+    // ==============
+    CSFTPExtended::Packet::Packet(std::string data) : m_data{std::move(data)}
+    {
+    }
+    void CSFTPExtended::Packet::putByte(std::uint8_t value)
+    {
+        m_data.push_back(static_cast<char>(value));
+    }
+    void CSFTPExtended::Packet::putUInt32(std::uint32_t value)
+    {
+        for (int shift = 24; shift >= 0; shift -= 8)
+        {
+            m_data.push_back(static_cast<char>((value >> shift) & 0xff));
+        }
+    }
+    void CSFTPExtended::Packet::putUInt64(std::uint64_t value)
+    {
+        putUInt32(static_cast<std::uint32_t>(value >> 32));
+        putUInt32(static_cast<std::uint32_t>(value & 0xffffffff));
+    }
+    void CSFTPExtended::Packet::putString(std::string_view value)
+    {
+        putUInt32(static_cast<std::uint32_t>(value.size()));
+        m_data.append(value);
+    }
+    std::uint8_t CSFTPExtended::Packet::getByte()
+    {
+        need(1);
+        return (static_cast<std::uint8_t>(m_data[m_position++]));
+    }
+    std::uint32_t CSFTPExtended::Packet::getUInt32()
+    {
+        std::uint32_t value{0};
+        need(4);
+        for (int byte = 0; byte < 4; byte++)
+        {
+            value = (value << 8) | static_cast<std::uint8_t>(m_data[m_position++]);
+        }
+        return (value);
+    }
+    std::uint64_t CSFTPExtended::Packet::getUInt64()
+    {
+        std::uint64_t value{getUInt32()};
+        return ((value << 32) | getUInt32());
+    }
+    std::string CSFTPExtended::Packet::getString()
+    {
+        std::uint32_t length{getUInt32()};
+        need(length);
+        std::string value{m_data.substr(m_position, length)};
+        m_position += length;
+        return (value);
+    }
+    std::string CSFTPExtended::Packet::getRemaining()
+    {
+        std::string value{m_data.substr(m_position)};
+        m_position = m_data.size();
+        return (value);
+    }
+    bool CSFTPExtended::Packet::atEnd() const
+    {
+        return (m_position >= m_data.size());
+    }
+    const std::string &CSFTPExtended::Packet::getData() const
+    {
+        return (m_data);
+    }
+    //
+    // Throw if fewer than length bytes are left to decode.
+    //
+    void CSFTPExtended::Packet::need(std::size_t length) const
+    {
+        if ((m_data.size() - m_position) < length)
+        {
+            throw Exception("Truncated SFTP packet.", "Packet");
+        }
+    }
+} // namespace Antik::SSH
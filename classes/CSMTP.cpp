@@ -23,6 +23,11 @@
 #include <ctime>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
+//
+// Linux
+//
+#include <unistd.h>
 // =========
 // NAMESPACE
 // =========
@@ -37,17 +42,26 @@ namespace Antik::SMTP
     const char *CSMTP::kEOL{"\r\n"};
     // Valid characters for base64 encode/decode.
     const char CSMTP::kCB64[]{"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"};
+    // Mail template placeholder delimiters
+    const char *CSMTP::kPlaceholderPrefix{"{{"};
+    const char *CSMTP::kPlaceholderPostfix{"}}"};
+    // RFC 2047 encoded word prefix/postfix
+    const char *CSMTP::kEncodedWordPrefix{"=?UTF-8?B?"};
+    const char *CSMTP::kEncodedWordPostfix{"?="};
     // ==========================
     // PUBLIC TYPES AND CONSTANTS
     // ==========================
     // Supported encoding methods
     const char *CSMTP::kEncoding7Bit{"7Bit"};
     const char *CSMTP::kEncodingBase64{"base64"};
+    const char *CSMTP::kEncodingBinary{"binary"};
     // ========================
     // PRIVATE STATIC VARIABLES
     // ========================
     // curl verbosity setting
     bool CSMTP::m_curlVerbosity{false};
+    // Shared pre-encoded attachment cache
+    CSMTP::AttachmentCache CSMTP::m_attachmentCache;
     // =======================
     // PUBLIC STATIC VARIABLES
     // =======================
@@ -70,44 +84,131 @@ namespace Antik::SMTP
         return (buffer);
     }
     //
-    // Fill libcurl read request buffer.
+    // Remove any spilled encoded attachment file when last reference goes.
+    //
+    CSMTP::EncodedAttachment::~EncodedAttachment()
+    {
+        if (!spillFileName.empty())
+        {
+            std::error_code errorCode;
+            std::filesystem::remove(spillFileName, errorCode);
+        }
+    }
+    //
+    // Return total size of email payload.
+    //
+    std::uintmax_t CSMTP::MailPayload::size(void) const
+    {
+        std::uintmax_t payloadSize{0};
+        for (auto &segment : segments)
+        {
+            payloadSize += segment.attachment ? segment.attachment->encodedSize : (segment.isView ? segment.view.size() : segment.text.size());
+        }
+        return (payloadSize);
+    }
+    //
+    // Clear email payload and its read position.
+    //
+    void CSMTP::MailPayload::clear(void)
+    {
+        segments.clear();
+        segmentOffset = 0;
+        if (spillFile.is_open())
+        {
+            spillFile.close();
+        }
+    }
+    //
+    // Fill libcurl read request buffer. Segments are copied a piece at a time so
+    // that large pre-encoded attachments can be streamed straight from the cache
+    // (or its spill file) without being split into lines.
     //
     size_t CSMTP::payloadSource(char *ptr, size_t size, size_t nmemb, void *userData)
     {
-        std::deque<std::string> *mailPayload = static_cast<std::deque<std::string> *>(userData);
+        MailPayload *mailPayload = static_cast<MailPayload *>(userData);
         size_t bytesCopied{0};
         if ((size == 0) || (nmemb == 0) || ((size * nmemb) < 1))
         {
             return 0;
         }
-        while (!mailPayload->empty())
+        while (!mailPayload->segments.empty() && (bytesCopied < (size * nmemb)))
         {
-            if ((mailPayload->front().length() + bytesCopied) > (size * nmemb))
-                break;
-            mailPayload->front().copy(&static_cast<char *>(ptr)[bytesCopied], mailPayload->front().length(), 0);
-            bytesCopied += mailPayload->front().length();
-            mailPayload->pop_front();
+            PayloadSegment &segment{mailPayload->segments.front()};
+            std::string_view segmentText{segment.isView ? segment.view : std::string_view(segment.text)};
+            std::uintmax_t segmentSize{segment.attachment ? segment.attachment->encodedSize : segmentText.length()};
+            std::uintmax_t bytesToCopy{std::min<std::uintmax_t>(segmentSize - mailPayload->segmentOffset, (size * nmemb) - bytesCopied)};
+            if (!segment.attachment)
+            {
+                segmentText.copy(&ptr[bytesCopied], bytesToCopy, mailPayload->segmentOffset);
+            }
+            else if (segment.attachment->spillFileName.empty())
+            {
+                segment.attachment->encodedContents.copy(&ptr[bytesCopied], bytesToCopy, mailPayload->segmentOffset);
+            }
+            else
+            {
+                if (!mailPayload->spillFile.is_open())
+                {
+                    mailPayload->spillFile.open(segment.attachment->spillFileName, std::ios_base::in | std::ios_base::binary);
+                }
+                mailPayload->spillFile.read(&ptr[bytesCopied], bytesToCopy);
+                if (static_cast<std::uintmax_t>(mailPayload->spillFile.gcount()) != bytesToCopy)
+                {
+                    return CURL_READFUNC_ABORT;
+                }
+            }
+            bytesCopied += bytesToCopy;
+            mailPayload->segmentOffset += bytesToCopy;
+            if (mailPayload->segmentOffset == segmentSize)
+            {
+                if (mailPayload->spillFile.is_open())
+                {
+                    mailPayload->spillFile.close();
+                }
+                mailPayload->segmentOffset = 0;
+                mailPayload->segments.pop_front();
+            }
         }
         return bytesCopied;
     }
     //
-    // Encode a specified file in either 7bit or base64.
+    // Encode a specified file in either 7bit or base64 into a MIME part (headers and
+    // contents). If the encoded part is larger than the cache spill size it is written
+    // away to a temporary file.
     //
-    void CSMTP::encodeAttachment(CSMTP::EmailAttachment &attachment)
+    CSMTP::EncodedAttachmentPtr CSMTP::encodeAttachment(const CSMTP::EmailAttachment &attachment)
     {
+        std::shared_ptr<EncodedAttachment> encodedAttachment{std::make_shared<EncodedAttachment>()};
+        std::string baseFileName{attachment.fileName.substr(attachment.fileName.find_last_of(R"(/\)") + 1)};
+        std::string &encodedContents{encodedAttachment->encodedContents};
         std::string line;
+        std::error_code errorCode;
+        encodedAttachment->fileSize = std::filesystem::file_size(attachment.fileName, errorCode);
+        encodedAttachment->fileLastWriteTime = std::filesystem::last_write_time(attachment.fileName, errorCode);
+        encodedContents.append("Content-Type: " + attachment.contentTypes + ";" + kEOL);
+        encodedContents.append("Content-transfer-encoding: " + attachment.contentTransferEncoding + kEOL);
+        encodedContents.append(std::string("Content-Disposition: attachment;") + kEOL);
+        encodedContents.append(R"(     filename=")" + baseFileName + R"(")" + kEOL);
+        encodedContents.append(kEOL);
+        // Binary raw copy (native transport with BINARYMIME only)
+        if (attachment.contentTransferEncoding.compare(kEncodingBinary) == 0)
+        {
+            std::ifstream ifs{attachment.fileName, std::ios::binary};
+            encodedContents.append(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+            encodedContents.append(kEOL);
+        }
         // 7bit just copy
-        if ((attachment.contentTransferEncoding.compare(kEncodingBase64) != 0))
+        else if ((attachment.contentTransferEncoding.compare(kEncodingBase64) != 0))
         {
             std::ifstream attachmentFile(attachment.fileName);
             // As sending text file via email strip any host specific end of line and replace with <cr><lf>
             while (std::getline(attachmentFile, line))
             {
-                if (line.back() == '\n')
+                if (!line.empty() && (line.back() == '\n'))
                     line.pop_back();
-                if (line.back() == '\r')
+                if (!line.empty() && (line.back() == '\r'))
                     line.pop_back();
-                attachment.encodedContents.push_back(line + kEOL);
+                encodedContents.append(line + kEOL);
             }
             // Base64
         }
@@ -116,85 +217,519 @@ namespace Antik::SMTP
             std::ifstream ifs{attachment.fileName, std::ios::binary};
             std::string buffer(kBase64EncodeBufferSize, ' ');
             ifs.seekg(0, std::ios::beg);
+            encodedContents.reserve(encodedContents.size() + ((encodedAttachment->fileSize / kBase64EncodeBufferSize) + 1) * 80);
             while (ifs.good())
             {
                 ifs.read(&buffer[0], kBase64EncodeBufferSize);
                 encodeToBase64(buffer, line, ifs.gcount());
-                attachment.encodedContents.push_back(line + kEOL);
+                encodedContents.append(line + kEOL);
                 line.clear();
             }
         }
+        encodedContents.append(kEOL); // EMPTY LINE
+        encodedAttachment->encodedSize = encodedContents.size();
+        // Spill large encoded attachments to a temporary file
+        if (encodedAttachment->encodedSize > getAttachmentCacheSpillSize())
+        {
+            std::string spillFileName{(std::filesystem::temp_directory_path() / "CSMTPXXXXXX").string()};
+            int spillFd = ::mkstemp(&spillFileName[0]);
+            if (spillFd != -1)
+            {
+                ::close(spillFd);
+                std::ofstream spillFile{spillFileName, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc};
+                spillFile.write(encodedContents.data(), encodedContents.size());
+                spillFile.close();
+                if (spillFile)
+                {
+                    encodedAttachment->spillFileName = spillFileName;
+                    encodedContents.clear();
+                    encodedContents.shrink_to_fit();
+                }
+                else
+                {
+                    std::filesystem::remove(spillFileName, errorCode);
+                }
+            }
+        }
+        return (encodedAttachment);
     }
     //
-    // Place attachments into email payload
+    // Return encoded attachment from the shared cache. The cache is keyed on file path,
+    // content type and encoding; an entry is only reused if the files size and modification
+    // time are unchanged. Entries are evicted least recently used first to keep the total
+    // encoded bytes within the cache limit.
+    //
+    CSMTP::EncodedAttachmentPtr CSMTP::cachedAttachment(const CSMTP::EmailAttachment &attachment)
+    {
+        std::string cacheKey{attachment.fileName + '\0' + attachment.contentTypes + '\0' + attachment.contentTransferEncoding};
+        std::error_code errorCode;
+        std::uintmax_t fileSize{std::filesystem::file_size(attachment.fileName, errorCode)};
+        std::filesystem::file_time_type fileLastWriteTime{std::filesystem::last_write_time(attachment.fileName, errorCode)};
+        {
+            std::lock_guard<std::mutex> cacheGuard(m_attachmentCache.cacheLock);
+            auto cacheEntry = m_attachmentCache.entries.find(cacheKey);
+            if (cacheEntry != m_attachmentCache.entries.end())
+            {
+                if ((cacheEntry->second.attachment->fileSize == fileSize) &&
+                    (cacheEntry->second.attachment->fileLastWriteTime == fileLastWriteTime))
+                {
+                    m_attachmentCache.lruList.splice(m_attachmentCache.lruList.begin(), m_attachmentCache.lruList, cacheEntry->second.lruPosition);
+                    return (cacheEntry->second.attachment);
+                }
+                m_attachmentCache.cacheSize -= cacheEntry->second.attachment->encodedSize;
+                m_attachmentCache.lruList.erase(cacheEntry->second.lruPosition);
+                m_attachmentCache.entries.erase(cacheEntry);
+            }
+        }
+        EncodedAttachmentPtr encodedAttachment{encodeAttachment(attachment)};
+        std::lock_guard<std::mutex> cacheGuard(m_attachmentCache.cacheLock);
+        if ((encodedAttachment->encodedSize <= m_attachmentCache.cacheLimit) &&
+            (m_attachmentCache.entries.find(cacheKey) == m_attachmentCache.entries.end()))
+        {
+            evictAttachments(m_attachmentCache.cacheLimit - encodedAttachment->encodedSize);
+            m_attachmentCache.lruList.push_front(cacheKey);
+            m_attachmentCache.entries[cacheKey] = {encodedAttachment, m_attachmentCache.lruList.begin()};
+            m_attachmentCache.cacheSize += encodedAttachment->encodedSize;
+        }
+        return (encodedAttachment);
+    }
+    //
+    // Evict least recently used attachments from cache until its size is within
+    // a given limit. Note: Cache lock must be held by caller.
+    //
+    void CSMTP::evictAttachments(std::uintmax_t cacheLimit)
+    {
+        while (!m_attachmentCache.lruList.empty() && (m_attachmentCache.cacheSize > cacheLimit))
+        {
+            auto lruEntry = m_attachmentCache.entries.find(m_attachmentCache.lruList.back());
+            m_attachmentCache.cacheSize -= lruEntry->second.attachment->encodedSize;
+            m_attachmentCache.entries.erase(lruEntry);
+            m_attachmentCache.lruList.pop_back();
+        }
+    }
+    //
+    // Append static text to mail template (merging with any previous static text).
+    //
+    void CSMTP::appendTemplateText(const std::string &text)
+    {
+        if (m_mailTemplate.empty() || (m_mailTemplate.back().kind != TemplatePart::Text))
+        {
+            m_mailTemplate.push_back({TemplatePart::Text, "", nullptr});
+        }
+        m_mailTemplate.back().text.append(text);
+    }
+    //
+    // Append text that may contain {{name}} placeholders to mail template.
+    //
+    void CSMTP::appendTemplateField(const std::string &field)
+    {
+        std::size_t current{0};
+        while (current < field.size())
+        {
+            std::size_t placeholderStart{field.find(kPlaceholderPrefix, current)};
+            std::size_t placeholderEnd{std::string::npos};
+            if (placeholderStart != std::string::npos)
+            {
+                placeholderEnd = field.find(kPlaceholderPostfix, placeholderStart + std::strlen(kPlaceholderPrefix));
+            }
+            if (placeholderEnd == std::string::npos)
+            {
+                appendTemplateText(field.substr(current));
+                break;
+            }
+            appendTemplateText(field.substr(current, placeholderStart - current));
+            placeholderStart += std::strlen(kPlaceholderPrefix);
+            m_mailTemplate.push_back({TemplatePart::Placeholder, field.substr(placeholderStart, placeholderEnd - placeholderStart), nullptr});
+            current = placeholderEnd + std::strlen(kPlaceholderPostfix);
+        }
+    }
+    //
+    // Place attachments into email template
     //
     void CSMTP::buildAttachments(void)
     {
-        for (auto attachment : m_attachedFiles)
-        {
-            std::string baseFileName{attachment.fileName.substr(attachment.fileName.find_last_of(R"(/\)") + 1)};
-            encodeAttachment(attachment);
-            m_mailPayload.emplace_back(std::string("--") + kMimeBoundary + kEOL);
-            m_mailPayload.emplace_back("Content-Type: " + attachment.contentTypes + ";" + kEOL);
-            m_mailPayload.emplace_back("Content-transfer-encoding: " + attachment.contentTransferEncoding + kEOL);
-            m_mailPayload.emplace_back(std::string("Content-Disposition: attachment;") + kEOL);
-            m_mailPayload.emplace_back(R"(     filename=")" + baseFileName + R"(")" + kEOL);
-            m_mailPayload.emplace_back(kEOL);
-            // Encoded file
-            for (auto str : attachment.encodedContents)
+        for (auto &attachment : m_attachedFiles)
+        {
+            appendTemplateText(std::string("--") + kMimeBoundary + kEOL);
+            if (attachment.contentTransferEncoding.compare(kEncodingBinary) == 0)
             {
-                m_mailPayload.emplace_back(str);
+                // Binary only if transport can send it raw otherwise fall back to base64
+                if (m_binaryMIME)
+                {
+                    m_binaryPayload = true;
+                    m_mailTemplate.push_back({TemplatePart::Attachment, "", cachedAttachment(attachment)});
+                }
+                else
+                {
+                    m_mailTemplate.push_back({TemplatePart::Attachment, "", cachedAttachment({attachment.fileName, attachment.contentTypes, kEncodingBase64})});
+                }
+                continue;
             }
-            m_mailPayload.emplace_back(kEOL); // EMPTY LINE
+            m_mailTemplate.push_back({TemplatePart::Attachment, "", cachedAttachment(attachment)});
         }
     }
     //
-    // Build email message in a dqeue of std::strings to be sent.
+    // Build email template. The static parts of the message (MIME structure, boundaries and
+    // encoded attachments) are laid out once with the per message date, To address, subject
+    // and any {{name}} placeholders in the body left as parts to be filled in at send time.
     //
-    void CSMTP::buildMailPayload(void)
+    void CSMTP::buildMailTemplate(void)
     {
         bool bAttachments{!m_attachedFiles.empty()};
+        m_mailTemplate.clear();
+        m_binaryPayload = false;
         // Email header.
-        m_mailPayload.emplace_back("Date: " + currentDateAndTime() + kEOL);
-        m_mailPayload.emplace_back("To: " + m_addressTo + kEOL);
-        m_mailPayload.emplace_back("From: " + m_addressFrom + kEOL);
+        appendTemplateText("Date: ");
+        m_mailTemplate.push_back({TemplatePart::Date, "", nullptr});
+        appendTemplateText(std::string(kEOL) + "To: ");
+        m_mailTemplate.push_back({TemplatePart::ToAddress, "", nullptr});
+        appendTemplateText(kEOL);
+        appendTemplateText("From: " + encodeHeaderAddress(m_addressFrom) + kEOL);
         if (!m_addressCC.empty())
         {
-            m_mailPayload.emplace_back("cc: " + m_addressCC + kEOL);
+            appendTemplateText("cc: " + encodeHeaderAddress(m_addressCC) + kEOL);
         }
-        m_mailPayload.emplace_back("Subject: " + m_mailSubject + kEOL);
-        m_mailPayload.emplace_back(std::string("MIME-Version: 1.0") + kEOL);
+        appendTemplateText("Subject: ");
+        m_mailTemplate.push_back({TemplatePart::Subject, m_mailSubject, nullptr});
+        appendTemplateText(kEOL);
+        appendTemplateText(std::string("MIME-Version: 1.0") + kEOL);
         if (!bAttachments)
         {
-            m_mailPayload.emplace_back(std::string("Content-Type: text/plain; charset=UTF-8") + kEOL);
-            m_mailPayload.emplace_back(std::string("Content-Transfer-Encoding: 7bit") + kEOL);
+            appendTemplateText(std::string("Content-Type: text/plain; charset=UTF-8") + kEOL);
+            appendTemplateText(std::string("Content-Transfer-Encoding: 7bit") + kEOL);
         }
         else
         {
-            m_mailPayload.emplace_back(std::string("Content-Type: multipart/mixed;") + kEOL);
-            m_mailPayload.emplace_back(std::string(R"(     boundary=")") + kMimeBoundary + R"(")" + kEOL);
+            appendTemplateText(std::string("Content-Type: multipart/mixed;") + kEOL);
+            appendTemplateText(std::string(R"(     boundary=")") + kMimeBoundary + R"(")" + kEOL);
         }
-        m_mailPayload.emplace_back(kEOL); // EMPTY LINE
+        appendTemplateText(kEOL); // EMPTY LINE
         if (bAttachments)
         {
-            m_mailPayload.emplace_back(std::string("--") + kMimeBoundary + kEOL);
-            m_mailPayload.emplace_back(std::string("Content-Type: text/plain") + kEOL);
-            m_mailPayload.emplace_back(std::string("Content-Transfer-Encoding: 7bit") + kEOL);
-            m_mailPayload.emplace_back(kEOL); // EMPTY LINE
+            appendTemplateText(std::string("--") + kMimeBoundary + kEOL);
+            appendTemplateText(std::string("Content-Type: text/plain") + kEOL);
+            appendTemplateText(std::string("Content-Transfer-Encoding: 7bit") + kEOL);
+            appendTemplateText(kEOL); // EMPTY LINE
         }
         // Message body
         for (auto &str : m_mailMessage)
         {
-            m_mailPayload.emplace_back(str + kEOL);
+            appendTemplateField(str);
+            appendTemplateText(kEOL);
         }
         if (bAttachments)
         {
-            m_mailPayload.emplace_back(kEOL); // EMPTY LINE
+            appendTemplateText(kEOL); // EMPTY LINE
             buildAttachments();
-            m_mailPayload.emplace_back(std::string("--") + kMimeBoundary + "--" + kEOL);
+            appendTemplateText(std::string("--") + kMimeBoundary + "--" + kEOL);
+        }
+    }
+    //
+    // Check that a header value contains no line breaks (which would let a value add
+    // headers or end the header and start the body).
+    //
+    void CSMTP::checkHeaderValue(const std::string &value)
+    {
+        if (value.find_first_of("\r\n") != std::string::npos)
+        {
+            throw Exception("Line break in email header value.");
+        }
+    }
+    //
+    // Return header text RFC 2047 encoded (as a folded sequence of UTF-8 base64 encoded
+    // words) if it contains any non-ASCII characters; otherwise it is returned as is.
+    // Encoded words are kept within 75 characters and do not split UTF-8 sequences.
+    //
+    std::string CSMTP::encodeHeaderText(const std::string &text)
+    {
+        checkHeaderValue(text);
+        if (std::all_of(text.begin(), text.end(), [](char ch) { return (static_cast<unsigned char>(ch) < 0x80); }))
+        {
+            return (text);
+        }
+        std::string encodedText, encodedWord;
+        for (std::size_t current = 0; current < text.size();)
+        {
+            std::size_t wordLength{std::min(kEncodedWordMaxBytes, text.size() - current)};
+            while ((wordLength > 1) && (current + wordLength < text.size()) && ((static_cast<unsigned char>(text[current + wordLength]) & 0xc0) == 0x80))
+            {
+                wordLength--;
+            }
+            encodeToBase64(text.substr(current, wordLength), encodedWord, static_cast<std::uint32_t>(wordLength));
+            if (!encodedText.empty())
+            {
+                encodedText.append(std::string(kEOL) + " ");
+            }
+            encodedText.append(kEncodedWordPrefix + encodedWord + kEncodedWordPostfix);
+            current += wordLength;
+        }
+        return (encodedText);
+    }
+    //
+    // Return an address list header value with any non-ASCII display names RFC 2047
+    // encoded. Non-ASCII in an address itself cannot be encoded and is rejected.
+    //
+    std::string CSMTP::encodeHeaderAddress(const std::string &addresses)
+    {
+        checkHeaderValue(addresses);
+        if (std::all_of(addresses.begin(), addresses.end(), [](char ch) { return (static_cast<unsigned char>(ch) < 0x80); }))
+        {
+            return (addresses);
+        }
+        std::string encodedAddresses;
+        std::vector<std::string> mailboxes{""};
+        bool inQuotes{false}, inAngleAddress{false};
+        for (auto ch : addresses)
+        {
+            if (ch == '"')
+            {
+                inQuotes = !inQuotes;
+            }
+            else if (!inQuotes && (ch == '<' || ch == '>'))
+            {
+                inAngleAddress = (ch == '<');
+            }
+            else if (!inQuotes && !inAngleAddress && (ch == ','))
+            {
+                mailboxes.emplace_back();
+                continue;
+            }
+            mailboxes.back().append(1, ch);
+        }
+        for (auto &mailbox : mailboxes)
+        {
+            std::size_t angleAddress{mailbox.find('<')};
+            if (angleAddress == std::string::npos)
+            {
+                angleAddress = mailbox.size();
+            }
+            std::string address{mailbox.substr(angleAddress)};
+            if (encodeHeaderText(address) != address)
+            {
+                throw Exception("Non-ASCII character in email address.");
+            }
+            std::string displayName{mailbox.substr(0, angleAddress)};
+            displayName.erase(0, displayName.find_first_not_of(" \t"));
+            displayName.erase(displayName.find_last_not_of(" \t") + 1);
+            if ((displayName.size() >= 2) && (displayName.front() == '"') && (displayName.back() == '"'))
+            {
+                displayName = displayName.substr(1, displayName.size() - 2);
+            }
+            if (!encodedAddresses.empty())
+            {
+                encodedAddresses.append(", ");
+            }
+            if (!displayName.empty())
+            {
+                encodedAddresses.append(encodeHeaderText(displayName) + " ");
+            }
+            encodedAddresses.append(address);
+        }
+        return (encodedAddresses);
+    }
+    //
+    // Return text with any {{name}} placeholders replaced by their substitutions (those
+    // without a substitution are left in place).
+    //
+    std::string CSMTP::substitutePlaceholders(const std::string &text, const Substitutions &substitutions)
+    {
+        std::string substitutedText;
+        std::size_t current{0};
+        while (current < text.size())
+        {
+            std::size_t placeholderStart{text.find(kPlaceholderPrefix, current)};
+            std::size_t placeholderEnd{std::string::npos};
+            if (placeholderStart != std::string::npos)
+            {
+                placeholderEnd = text.find(kPlaceholderPostfix, placeholderStart + std::strlen(kPlaceholderPrefix));
+            }
+            if (placeholderEnd == std::string::npos)
+            {
+                substitutedText.append(text.substr(current));
+                break;
+            }
+            substitutedText.append(text.substr(current, placeholderStart - current));
+            auto substitution = substitutions.find(text.substr(placeholderStart + std::strlen(kPlaceholderPrefix), placeholderEnd - placeholderStart - std::strlen(kPlaceholderPrefix)));
+            current = placeholderEnd + std::strlen(kPlaceholderPostfix);
+            substitutedText.append((substitution != substitutions.end()) ? substitution->second : text.substr(placeholderStart, current - placeholderStart));
+        }
+        return (substitutedText);
+    }
+    //
+    // Build email payload for a recipient from a mail template. Static parts and substituted
+    // body values are referenced rather than copied so the template and substitutions must
+    // outlive the payload. The To address and subject are checked for line breaks and
+    // RFC 2047 encoded if they contain non-ASCII characters.
+    //
+    void CSMTP::buildMailPayload(const std::vector<TemplatePart> &mailTemplate, const std::string &addressTo, const Substitutions &substitutions)
+    {
+        m_mailPayload.clear();
+        for (auto &part : mailTemplate)
+        {
+            switch (part.kind)
+            {
+            case TemplatePart::Text:
+                m_mailPayload.segments.emplace_back(std::string_view(part.text));
+                break;
+            case TemplatePart::Date:
+                m_mailPayload.segments.emplace_back(currentDateAndTime());
+                break;
+            case TemplatePart::ToAddress:
+                m_mailPayload.segments.emplace_back(encodeHeaderAddress(addressTo));
+                break;
+            case TemplatePart::Subject:
+                m_mailPayload.segments.emplace_back(encodeHeaderText(substitutePlaceholders(part.text, substitutions)));
+                break;
+            case TemplatePart::Placeholder:
+            {
+                auto substitution = substitutions.find(part.text);
+                if (substitution != substitutions.end())
+                {
+                    m_mailPayload.segments.emplace_back(std::string_view(substitution->second));
+                }
+                else
+                {
+                    m_mailPayload.segments.emplace_back(kPlaceholderPrefix + part.text + kPlaceholderPostfix);
+                }
+                break;
+            }
+            case TemplatePart::Attachment:
+                m_mailPayload.segments.emplace_back(part.attachment);
+                break;
+            }
+        }
+    }
+    //
+    // Send current email payload to recipient (and any CC recipients) using
+    // the selected transport.
+    //
+    void CSMTP::transferMail(const std::string &addressTo)
+    {
+        if (m_transport == Transport::native)
+        {
+            transferMailNative(addressTo);
+        }
+        else
+        {
+            transferMailCurl(addressTo);
         }
     }
     //
+    // Connect native transport to server (if not already connected) and record
+    // whether binary attachments may be sent raw.
+    //
+    void CSMTP::connectNative(void)
+    {
+        if (!m_nativeClient)
+        {
+            m_nativeClient = std::make_unique<CSMTPClient>();
+        }
+        if (!m_nativeClient->isConnected())
+        {
+            m_nativeClient->setServer(m_serverURL);
+            m_nativeClient->setUserAndPassword(m_userName, m_userPassword);
+            m_nativeClient->setTLSRequired(m_tlsRequired);
+            m_nativeClient->connect();
+        }
+        m_binaryMIME = m_nativeClient->getCapabilities().chunking && m_nativeClient->getCapabilities().binaryMIME;
+    }
+    //
+    // Send current email payload using native SMTP client. The connection is kept open
+    // for any further emails but is dropped on failure.
+    //
+    void CSMTP::transferMailNative(const std::string &addressTo)
+    {
+        std::vector<std::string> recipients;
+        for (auto addresses : {addressTo, m_addressCC})
+        {
+            std::istringstream addressStream{addresses};
+            for (std::string address; std::getline(addressStream, address, ',');)
+            {
+                if (address.find_first_not_of(" \t") != std::string::npos)
+                {
+                    recipients.push_back(address);
+                }
+            }
+        }
+        try
+        {
+            connectNative();
+            m_nativeClient->sendMail(m_addressFrom, recipients, [this](char *buffer, std::size_t bufferSize) { return (payloadSource(buffer, 1, bufferSize, &m_mailPayload)); },
+                                     m_binaryPayload, m_mailPayload.size());
+        }
+        catch (const std::exception &e)
+        {
+            m_mailPayload.clear();
+            m_nativeClient.reset();
+            throw Exception(e.what());
+        }
+        // Clear sent email
+        m_mailPayload.clear();
+    }
+    //
+    // Send current email payload to recipient (and any CC recipients) using libcurl.
+    //
+    void CSMTP::transferMailCurl(const std::string &addressTo)
+    {
+        using namespace Antik::Network;
+        if (m_binaryPayload)
+        {
+            m_mailPayload.clear();
+            throw Exception("Binary attachments need native transport.");
+        }
+        m_connection.setOption<long>(CURLOPT_PROTOCOLS, (CURLPROTO_SMTP | CURLPROTO_SMTPS));
+        m_connection.setOption<const char *>(CURLOPT_USERNAME, m_userName.c_str());
+        m_connection.setOption<const char *>(CURLOPT_PASSWORD, m_userPassword.c_str());
+        m_connection.setOption<const char *>(CURLOPT_URL, m_serverURL.c_str());
+        m_connection.setOption<long>(CURLOPT_USE_SSL, m_tlsRequired ? CURLUSESSL_ALL : CURLUSESSL_TRY);
+        if (!m_mailCABundle.empty())
+        {
+            m_connection.setOption<const char *>(CURLOPT_CAINFO, m_mailCABundle.c_str());
+        }
+        m_connection.setOption<const char *>(CURLOPT_MAIL_FROM, m_addressFrom.c_str());
+        m_recipientsList = CCurl::stringListAppend(m_recipientsList, addressTo.c_str());
+        if (!m_addressCC.empty())
+        {
+            m_recipientsList = CCurl::stringListAppend(m_recipientsList, m_addressCC.c_str());
+        }
+        m_connection.setOption<CCurl::StringList>(CURLOPT_MAIL_RCPT, m_recipientsList);
+        m_connection.setOption<curl_read_callback>(CURLOPT_READFUNCTION, payloadSource);
+        m_connection.setOption<void *>(CURLOPT_READDATA, &m_mailPayload);
+        m_connection.setOption<long>(CURLOPT_UPLOAD, 1);
+        m_connection.setOption<long>(CURLOPT_VERBOSE, m_curlVerbosity);
+        m_connection.setErrorBuffer(CURL_ERROR_SIZE);
+        try
+        {
+            m_connection.transfer();
+        }
+        catch (...)
+        {
+            CCurl::stringListFree(m_recipientsList);
+            m_recipientsList = NULL;
+            m_mailPayload.clear();
+            throw;
+        }
+        CCurl::stringListFree(m_recipientsList);
+        m_recipientsList = NULL;
+        // Clear sent email
+        m_mailPayload.clear();
+    }
+    //
+    // Read whole of current email payload into a string.
+    //
+    std::string CSMTP::readMailPayload(void)
+    {
+        std::string mailMessage;
+        std::string buffer(CURL_MAX_READ_SIZE, ' ');
+        size_t bytesCopied{0};
+        while ((bytesCopied = payloadSource(&buffer[0], 1, buffer.size(), &m_mailPayload)) > 0)
+        {
+            mailMessage.append(&buffer[0], bytesCopied);
+        }
+        m_mailPayload.clear();
+        return (mailMessage);
+    }
+    //
     // Decode character to base64 index.
     //
     int CSMTP::decodeChar(char ch)
@@ -330,33 +865,44 @@ namespace Antik::SMTP
     //
     void CSMTP::postMail(void)
     {
-        using namespace Antik::Network;
-        m_connection.setOption<long>(CURLOPT_PROTOCOLS, (CURLPROTO_SMTP | CURLPROTO_SMTPS));
-        m_connection.setOption<const char *>(CURLOPT_USERNAME, m_userName.c_str());
-        m_connection.setOption<const char *>(CURLOPT_PASSWORD, m_userPassword.c_str());
-        m_connection.setOption<const char *>(CURLOPT_URL, m_serverURL.c_str());
-        m_connection.setOption<long>(CURLOPT_USE_SSL, CURLUSESSL_ALL);
-        if (!m_mailCABundle.empty())
+        if (m_transport == Transport::native)
         {
-            m_connection.setOption<const char *>(CURLOPT_CAINFO, m_mailCABundle.c_str());
+            connectNative();
         }
-        m_connection.setOption<const char *>(CURLOPT_MAIL_FROM, m_addressFrom.c_str());
-        m_recipientsList = CCurl::stringListAppend(m_recipientsList, m_addressTo.c_str());
-        if (!m_addressCC.empty())
+        buildMailTemplate();
+        buildMailPayload(m_mailTemplate, m_addressTo, {});
+        transferMail(m_addressTo);
+    }
+    //
+    // Post email built from compiled mail template to a recipient substituting
+    // any {{name}} placeholders in the subject/body from those passed in.
+    //
+    void CSMTP::postMail(const std::string &addressTo, const Substitutions &substitutions)
+    {
+        if (m_compiledTemplate.empty())
         {
-            m_recipientsList = CCurl::stringListAppend(m_recipientsList, m_addressCC.c_str());
+            throw Exception("No compiled mail template.");
         }
-        m_connection.setOption<CCurl::StringList>(CURLOPT_MAIL_RCPT, m_recipientsList);
-        buildMailPayload();
-        m_connection.setOption<curl_read_callback>(CURLOPT_READFUNCTION, payloadSource);
-        m_connection.setOption<void *>(CURLOPT_READDATA, &m_mailPayload);
-        m_connection.setOption<long>(CURLOPT_UPLOAD, 1);
-        m_connection.setOption<long>(CURLOPT_VERBOSE, m_curlVerbosity);
-        m_connection.setErrorBuffer(CURL_ERROR_SIZE);
-        m_connection.transfer();
-        CCurl::stringListFree(m_recipientsList);
-        // Clear sent email
-        m_mailPayload.clear();
+        buildMailPayload(m_compiledTemplate, addressTo, substitutions);
+        m_binaryPayload = m_compiledBinaryPayload;
+        transferMail(addressTo);
+    }
+    //
+    // Compile current email (headers, body and encoded attachments) into a template that
+    // can be posted repeatedly to different recipients. Any changes made to the email
+    // after compilation require it to be recompiled; posting the email without a
+    // recipient leaves the compiled template alone.
+    //
+    void CSMTP::compileMailTemplate(void)
+    {
+        if (m_transport == Transport::native)
+        {
+            connectNative();
+        }
+        buildMailTemplate();
+        m_compiledTemplate = std::move(m_mailTemplate);
+        m_compiledBinaryPayload = m_binaryPayload;
+        m_mailTemplate.clear();
     }
     //
     // Encode string to base64 string.
@@ -450,14 +996,96 @@ namespace Antik::SMTP
     //
     std::string CSMTP::getMailFull(void)
     {
-        std::string mailMessage;
-        buildMailPayload();
-        for (auto &line : m_mailPayload)
+        buildMailTemplate();
+        buildMailPayload(m_mailTemplate, m_addressTo, {});
+        return (readMailPayload());
+    }
+    //
+    // Get whole of email message built from compiled mail template for a recipient.
+    //
+    std::string CSMTP::getMailFull(const std::string &addressTo, const Substitutions &substitutions)
+    {
+        if (m_compiledTemplate.empty())
         {
-            mailMessage.append(line);
+            throw Exception("No compiled mail template.");
         }
-        m_mailPayload.clear();
-        return (mailMessage);
+        buildMailPayload(m_compiledTemplate, addressTo, substitutions);
+        return (readMailPayload());
+    }
+    //
+    // Set shared attachment cache size limit (evicting any entries over the new limit).
+    //
+    void CSMTP::setAttachmentCacheLimit(std::uintmax_t cacheLimit)
+    {
+        std::lock_guard<std::mutex> cacheGuard(m_attachmentCache.cacheLock);
+        m_attachmentCache.cacheLimit = cacheLimit;
+        evictAttachments(m_attachmentCache.cacheLimit);
+    }
+    //
+    // Set encoded attachment size above which it is spilled to a temporary file.
+    //
+    void CSMTP::setAttachmentCacheSpillSize(std::uintmax_t spillSize)
+    {
+        std::lock_guard<std::mutex> cacheGuard(m_attachmentCache.cacheLock);
+        m_attachmentCache.spillSize = spillSize;
+    }
+    //
+    // Get shared attachment cache size limit.
+    //
+    std::uintmax_t CSMTP::getAttachmentCacheLimit(void)
+    {
+        std::lock_guard<std::mutex> cacheGuard(m_attachmentCache.cacheLock);
+        return (m_attachmentCache.cacheLimit);
+    }
+    //
+    // Get encoded attachment size above which it is spilled to a temporary file.
+    //
+    std::uintmax_t CSMTP::getAttachmentCacheSpillSize(void)
+    {
+        std::lock_guard<std::mutex> cacheGuard(m_attachmentCache.cacheLock);
+        return (m_attachmentCache.spillSize);
+    }
+    //
+    // Get total number of encoded bytes held in shared attachment cache.
+    //
+    std::uintmax_t CSMTP::getAttachmentCacheSize(void)
+    {
+        std::lock_guard<std::mutex> cacheGuard(m_attachmentCache.cacheLock);
+        return (m_attachmentCache.cacheSize);
+    }
+    //
+    // Empty shared attachment cache. Any attachment still being sent is kept
+    // alive until its send completes.
+    //
+    void CSMTP::clearAttachmentCache(void)
+    {
+        std::lock_guard<std::mutex> cacheGuard(m_attachmentCache.cacheLock);
+        m_attachmentCache.entries.clear();
+        m_attachmentCache.lruList.clear();
+        m_attachmentCache.cacheSize = 0;
+    }
+    //
+    // Set/Get email transport (libcurl or native SMTP client).
+    //
+    void CSMTP::setTransport(Transport transport)
+    {
+        if (transport != m_transport)
+        {
+            m_nativeClient.reset();
+            m_binaryMIME = false;
+        }
+        m_transport = transport;
+    }
+    CSMTP::Transport CSMTP::getTransport(void) const
+    {
+        return (m_transport);
+    }
+    //
+    // Set whether the server connection has to be secured with TLS.
+    //
+    void CSMTP::setTLSRequired(bool tlsRequired)
+    {
+        m_tlsRequired = tlsRequired;
     }
     //
     // Main CMailSend object constructor.
@@ -0,0 +1,599 @@
+//
+// Class: CSMTPClient
+//
+// Description: Native SMTP client used as an alternative transport to libcurl by
+// class CSMTP. It talks to the server over a CSocket, parses the EHLO capabilities
+// and uses them to pipeline the MAIL/RCPT/DATA commands (PIPELINING), send the message
+// body in BDAT chunks (CHUNKING) so that binary attachments may be sent raw (BINARYMIME)
+// and upgrade the connection to TLS (STARTTLS).
+//
+// Dependencies:   C20++     - Language standard features used.
+//                 CSocket   - Used to talk to SMTP server.
+//                 CSMTP     - Base64 encoding.
+//
+// =================
+// CLASS DEFINITIONS
+// =================
+#include "CSMTPClient.hpp"
+// ====================
+// CLASS IMPLEMENTATION
+// ====================
+//
+// C++ STL
+//
+#include <cstring>
+#include <sstream>
+#include <algorithm>
+//
+// Antik classes
+//
+#include "CSMTP.hpp"
+// =========
+// NAMESPACE
+// =========
+namespace Antik::SMTP
+{
+    // ===========================
+    // PRIVATE TYPES AND CONSTANTS
+    // ===========================
+    // Line terminator
+    const char *CSMTPClient::kEOL{"\r\n"};
+    // ==========================
+    // PUBLIC TYPES AND CONSTANTS
+    // ==========================
+    // ========================
+    // PRIVATE STATIC VARIABLES
+    // ========================
+    // =======================
+    // PUBLIC STATIC VARIABLES
+    // =======================
+    // ===============
+    // PRIVATE METHODS
+    // ===============
+    //
+    // Write whole of buffer to server.
+    //
+    void CSMTPClient::writeAll(const char *buffer, std::size_t length)
+    {
+        while (length != 0)
+        {
+            std::size_t bytesWritten = m_socket.write(buffer, length);
+            buffer += bytesWritten;
+            length -= bytesWritten;
+        }
+    }
+    //
+    // Send SMTP command to server (no response read).
+    //
+    void CSMTPClient::sendCommand(const std::string &command)
+    {
+        std::string commandLine{command + kEOL};
+        writeAll(commandLine.data(), commandLine.size());
+    }
+    //
+    // Read SMTP server response (return its status code). It gathers the whole
+    // response even if it is multi-line (ie. lines start with "ddd-" and the last
+    // one starts "ddd ").
+    //
+    std::uint16_t CSMTPClient::readResponse(void)
+    {
+        m_lastResponse.clear();
+        for (;;)
+        {
+            std::size_t endOfLine{m_readBuffer.find(kEOL)};
+            if (endOfLine == std::string::npos)
+            {
+                char readBuffer[kReadBufferSize];
+                std::size_t bytesRead = m_socket.read(readBuffer, sizeof(readBuffer));
+                if (bytesRead == 0)
+                {
+                    if (m_socket.closedByRemotePeer())
+                    {
+                        m_connected = false;
+                        throw Exception("Connection closed by server.");
+                    }
+                    continue;
+                }
+                m_readBuffer.append(readBuffer, bytesRead);
+                continue;
+            }
+            std::string line{m_readBuffer.substr(0, endOfLine + std::strlen(kEOL))};
+            m_readBuffer.erase(0, line.size());
+            m_lastResponse += line;
+            if ((line.size() < 4) || (line[3] != '-'))
+            {
+                break;
+            }
+        }
+        try
+        {
+            m_lastStatusCode = static_cast<std::uint16_t>(std::stoi(m_lastResponse));
+        }
+        catch (const std::exception &e)
+        {
+            throw Exception("Invalid SMTP response status code.");
+        }
+        return (m_lastStatusCode);
+    }
+    //
+    // Send SMTP command and read its response.
+    //
+    std::uint16_t CSMTPClient::command(const std::string &command)
+    {
+        sendCommand(command);
+        return (readResponse());
+    }
+    //
+    // Send EHLO and parse the server capabilities from its response.
+    //
+    void CSMTPClient::ehlo(void)
+    {
+        std::string hostName;
+        try
+        {
+            hostName = boost::asio::ip::host_name();
+        }
+        catch (const std::exception &e)
+        {
+            hostName = "localhost";
+        }
+        if (command("EHLO " + hostName) != 250)
+        {
+            throw Exception("EHLO failed [" + m_lastResponse + "]");
+        }
+        m_capabilities = Capabilities{};
+        std::istringstream responseStream{m_lastResponse};
+        bool greetingLine{true};
+        for (std::string line; std::getline(responseStream, line);)
+        {
+            if (!line.empty() && (line.back() == '\r'))
+            {
+                line.pop_back();
+            }
+            if (greetingLine || (line.size() < 4))
+            {
+                greetingLine = false;
+                continue;
+            }
+            std::istringstream capabilityStream{line.substr(4)};
+            std::string keyword;
+            capabilityStream >> keyword;
+            std::transform(keyword.begin(), keyword.end(), keyword.begin(), ::toupper);
+            if (keyword == "PIPELINING")
+            {
+                m_capabilities.pipelining = true;
+            }
+            else if (keyword == "CHUNKING")
+            {
+                m_capabilities.chunking = true;
+            }
+            else if (keyword == "BINARYMIME")
+            {
+                m_capabilities.binaryMIME = true;
+            }
+            else if (keyword == "8BITMIME")
+            {
+                m_capabilities.eightBitMIME = true;
+            }
+            else if (keyword == "STARTTLS")
+            {
+                m_capabilities.startTLS = true;
+            }
+            else if (keyword == "SIZE")
+            {
+                m_capabilities.size = true;
+                capabilityStream >> m_capabilities.maximumSize;
+            }
+            else if (keyword == "AUTH")
+            {
+                for (std::string mechanism; capabilityStream >> mechanism;)
+                {
+                    m_capabilities.authMechanisms.push_back(mechanism);
+                }
+            }
+        }
+    }
+    //
+    // Upgrade connection to TLS and re-issue EHLO (capabilities may change).
+    //
+    void CSMTPClient::startTLS(void)
+    {
+        if (command("STARTTLS") != 220)
+        {
+            throw Exception("STARTTLS failed [" + m_lastResponse + "]");
+        }
+        m_readBuffer.clear();
+        m_socket.setSslEnabled(true);
+        m_socket.tlsHandshake();
+        ehlo();
+    }
+    //
+    // Authenticate user with server (AUTH PLAIN).
+    //
+    void CSMTPClient::authenticate(void)
+    {
+        std::string credentials{std::string(1, '\0') + m_userName + std::string(1, '\0') + m_userPassword};
+        std::string encodedCredentials;
+        if (std::find(m_capabilities.authMechanisms.begin(), m_capabilities.authMechanisms.end(), "PLAIN") == m_capabilities.authMechanisms.end())
+        {
+            throw Exception("Server does not support AUTH PLAIN.");
+        }
+        CSMTP::encodeToBase64(credentials, encodedCredentials, credentials.size());
+        if (command("AUTH PLAIN " + encodedCredentials) != 235)
+        {
+            throw Exception("Authentication failed [" + m_lastResponse + "]");
+        }
+    }
+    //
+    // Send message body with DATA; lines starting with a '.' are dot stuffed and the
+    // message terminated with a line containing a single '.'.
+    //
+    void CSMTPClient::sendData(MessageSourceFn &messageSource)
+    {
+        std::string stuffed;
+        bool startOfLine{true};
+        char lastCharacter{'\n'};
+        for (std::size_t bytesRead; (bytesRead = messageSource(m_ioBuffer.get(), m_chunkSize)) > 0;)
+        {
+            stuffed.clear();
+            for (std::size_t index = 0; index < bytesRead; index++)
+            {
+                char character{m_ioBuffer[index]};
+                if (startOfLine && (character == '.'))
+                {
+                    stuffed.append(1, '.');
+                }
+                stuffed.append(1, character);
+                startOfLine = (character == '\n');
+                lastCharacter = character;
+            }
+            writeAll(stuffed.data(), stuffed.size());
+        }
+        std::string terminator{(lastCharacter == '\n') ? "" : kEOL};
+        terminator += std::string(".") + kEOL;
+        writeAll(terminator.data(), terminator.size());
+        if (readResponse() != 250)
+        {
+            throw Exception("Message not accepted [" + m_lastResponse + "]");
+        }
+    }
+    //
+    // Send message body in BDAT chunks. Chunk commands are pipelined (if supported)
+    // with up to kMaximumOutstandingChunks awaiting a reply.
+    //
+    void CSMTPClient::sendChunks(MessageSourceFn &messageSource)
+    {
+        int outstandingChunks{0};
+        bool lastChunk{false};
+        std::uint16_t failedStatusCode{0};
+        std::string failedResponse;
+        auto readChunkResponse = [&]() {
+            if ((readResponse() != 250) && (failedStatusCode == 0))
+            {
+                failedStatusCode = m_lastStatusCode;
+                failedResponse = m_lastResponse;
+            }
+            outstandingChunks--;
+        };
+        while (!lastChunk)
+        {
+            std::size_t chunkLength{0};
+            for (std::size_t bytesRead; chunkLength < m_chunkSize; chunkLength += bytesRead)
+            {
+                if ((bytesRead = messageSource(&m_ioBuffer[chunkLength], m_chunkSize - chunkLength)) == 0)
+                {
+                    lastChunk = true;
+                    break;
+                }
+            }
+            sendCommand("BDAT " + std::to_string(chunkLength) + (lastChunk ? " LAST" : ""));
+            writeAll(m_ioBuffer.get(), chunkLength);
+            outstandingChunks++;
+            while ((outstandingChunks > 0) && (lastChunk || !m_capabilities.pipelining || (outstandingChunks >= kMaximumOutstandingChunks)))
+            {
+                readChunkResponse();
+            }
+        }
+        if (failedStatusCode != 0)
+        {
+            throw Exception("Message not accepted [" + failedResponse + "]");
+        }
+    }
+    //
+    // Return address enclosed in angle brackets (if not already).
+    //
+    std::string CSMTPClient::pathAddress(const std::string &address)
+    {
+        std::string path{address};
+        path.erase(0, path.find_first_not_of(" \t"));
+        path.erase(path.find_last_not_of(" \t") + 1);
+        if (path.empty() || (path.front() != '<'))
+        {
+            path = "<" + path + ">";
+        }
+        return (path);
+    }
+    // ==============
+    // PUBLIC METHODS
+    // ==============
+    //
+    // Main CSMTPClient object constructor.
+    //
+    CSMTPClient::CSMTPClient()
+    {
+    }
+    //
+    // CSMTPClient Destructor
+    //
+    CSMTPClient::~CSMTPClient()
+    {
+        try
+        {
+            disconnect();
+        }
+        catch (...)
+        {
+        }
+    }
+    //
+    // Set server URL; smtps:// means TLS from connect otherwise STARTTLS is used if
+    // offered. The default ports are 465 (smtps) and 25 (smtp).
+    //
+    void CSMTPClient::setServer(const std::string &serverURL)
+    {
+        m_serverURL = serverURL;
+    }
+    //
+    // Set email account details
+    //
+    void CSMTPClient::setUserAndPassword(const std::string &userName, const std::string &userPassword)
+    {
+        m_userName = userName;
+        m_userPassword = userPassword;
+    }
+    //
+    // Set whether TLS must be used on connection.
+    //
+    void CSMTPClient::setTLSRequired(bool tlsRequired)
+    {
+        m_tlsRequired = tlsRequired;
+    }
+    //
+    // Set BDAT chunk size (and DATA write size).
+    //
+    void CSMTPClient::setChunkSize(std::size_t chunkSize)
+    {
+        m_chunkSize = std::max<std::size_t>(chunkSize, 1);
+        m_ioBuffer.reset();
+    }
+    //
+    // Connect to server, read its greeting, get its capabilities, secure connection
+    // and authorize user.
+    //
+    void CSMTPClient::connect(void)
+    {
+        std::string server{m_serverURL};
+        std::string port;
+        if (m_connected)
+        {
+            throw Exception("Already connected to a server.");
+        }
+        m_implicitTLS = (server.rfind("smtps://", 0) == 0);
+        if (server.find("://") != std::string::npos)
+        {
+            server = server.substr(server.find("://") + 3);
+        }
+        server = server.substr(0, server.find('/'));
+        port = m_implicitTLS ? "465" : "25";
+        if (server.find(':') != std::string::npos)
+        {
+            port = server.substr(server.find(':') + 1);
+            server = server.substr(0, server.find(':'));
+        }
+        m_readBuffer.clear();
+        m_socket.setSslEnabled(false);
+        m_socket.setHostAddress(server);
+        m_socket.setHostPort(port);
+        m_socket.connect();
+        try
+        {
+            if (m_implicitTLS)
+            {
+                m_socket.setSslEnabled(true);
+                m_socket.tlsHandshake();
+            }
+            if (readResponse() != 220)
+            {
+                throw Exception("Server not ready [" + m_lastResponse + "]");
+            }
+            ehlo();
+            if (!m_implicitTLS)
+            {
+                if (m_capabilities.startTLS)
+                {
+                    startTLS();
+                }
+                else if (m_tlsRequired)
+                {
+                    throw Exception("Server does not support STARTTLS.");
+                }
+            }
+            if (!m_userName.empty())
+            {
+                authenticate();
+            }
+        }
+        catch (...)
+        {
+            m_socket.close();
+            throw;
+        }
+        m_connected = true;
+    }
+    //
+    // Send QUIT to server and close connection.
+    //
+    void CSMTPClient::disconnect(void)
+    {
+        if (m_connected)
+        {
+            m_connected = false;
+            try
+            {
+                command("QUIT");
+            }
+            catch (...)
+            {
+                m_socket.close();
+                throw;
+            }
+            m_socket.close();
+        }
+    }
+    //
+    // Return true if connected to server.
+    //
+    bool CSMTPClient::isConnected(void) const
+    {
+        return (m_connected);
+    }
+    //
+    // Send a message to a list of recipients. If the server supports PIPELINING then
+    // MAIL, all the RCPTs and DATA are sent together and their responses read afterwards.
+    // If CHUNKING is supported the body is sent with BDAT (no dot stuffing) which also
+    // allows a binary message body to be sent raw when BINARYMIME is available.
+    //
+    void CSMTPClient::sendMail(const std::string &addressFrom, const std::vector<std::string> &recipients,
+                               MessageSourceFn messageSource, bool binaryMessage, std::uintmax_t messageSize)
+    {
+        std::vector<std::string> commands;
+        std::string mailFrom{"MAIL FROM:" + pathAddress(addressFrom)};
+        std::size_t acceptedRecipients{0};
+        std::string failedResponse;
+        if (!m_connected)
+        {
+            throw Exception("Not connected to a server.");
+        }
+        if (recipients.empty())
+        {
+            throw Exception("No recipients.");
+        }
+        if (binaryMessage)
+        {
+            if (!m_capabilities.chunking || !m_capabilities.binaryMIME)
+            {
+                throw Exception("Server does not support BINARYMIME.");
+            }
+            mailFrom += " BODY=BINARYMIME";
+        }
+        else if (m_capabilities.eightBitMIME)
+        {
+            mailFrom += " BODY=8BITMIME";
+        }
+        if (m_capabilities.size && (messageSize != 0))
+        {
+            mailFrom += " SIZE=" + std::to_string(messageSize);
+        }
+        if (!m_ioBuffer)
+        {
+            m_ioBuffer = std::make_unique<char[]>(m_chunkSize);
+        }
+        commands.push_back(mailFrom);
+        for (auto &recipient : recipients)
+        {
+            commands.push_back("RCPT TO:" + pathAddress(recipient));
+        }
+        if (!m_capabilities.chunking)
+        {
+            commands.push_back("DATA");
+        }
+        // Pipeline commands in a single write
+        if (m_capabilities.pipelining)
+        {
+            std::string pipelined;
+            for (auto &command : commands)
+            {
+                pipelined += command + kEOL;
+            }
+            writeAll(pipelined.data(), pipelined.size());
+        }
+        for (std::size_t commandNo = 0; commandNo < commands.size(); commandNo++)
+        {
+            if (!m_capabilities.pipelining)
+            {
+                sendCommand(commands[commandNo]);
+            }
+            std::uint16_t statusCode{readResponse()};
+            if (commandNo == 0)
+            {
+                if (statusCode != 250)
+                {
+                    failedResponse = m_lastResponse;
+                }
+            }
+            else if (commandNo <= recipients.size())
+            {
+                if ((statusCode == 250) || (statusCode == 251))
+                {
+                    acceptedRecipients++;
+                }
+            }
+            else if (statusCode == 354)
+            {
+                // DATA accepted but nothing to send so end message
+                if (!failedResponse.empty() || (acceptedRecipients == 0))
+                {
+                    std::string terminator{std::string(".") + kEOL};
+                    writeAll(terminator.data(), terminator.size());
+                    readResponse();
+                }
+            }
+            else if (failedResponse.empty())
+            {
+                failedResponse = m_lastResponse;
+            }
+            if (!m_capabilities.pipelining && (!failedResponse.empty() || ((commandNo == recipients.size()) && (acceptedRecipients == 0))))
+            {
+                break;
+            }
+        }
+        if (failedResponse.empty() && (acceptedRecipients == 0))
+        {
+            failedResponse = m_lastResponse;
+        }
+        if (!failedResponse.empty())
+        {
+            command("RSET");
+            throw Exception("Message not accepted [" + failedResponse + "]");
+        }
+        if (m_capabilities.chunking)
+        {
+            sendChunks(messageSource);
+        }
+        else
+        {
+            sendData(messageSource);
+        }
+    }
+    //
+    // Get server capabilities.
+    //
+    const CSMTPClient::Capabilities &CSMTPClient::getCapabilities(void) const
+    {
+        return (m_capabilities);
+    }
+    //
+    // Get last server response.
+    //
+    std::string CSMTPClient::getLastResponse(void) const
+    {
+        return (m_lastResponse);
+    }
+    //
+    // Get last server response status code.
+    //
+    std::uint16_t CSMTPClient::getLastStatusCode(void) const
+    {
+        return (m_lastStatusCode);
+    }
+} // namespace Antik::SMTP
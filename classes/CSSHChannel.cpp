@@ -17,6 +17,10 @@
 // CLASS DEFINITIONS
 // =================
 #include "CSSHChannel.hpp"
+//
+// Libssh (accept channel open requests)
+//
+#include <libssh/server.h>
 // ====================
 // CLASS IMPLEMENTATION
 // ====================
@@ -60,11 +64,7 @@ namespace Antik::SSH
     }
     CSSHChannel::CSSHChannel(CSSHSession &session, ssh_channel channel) : m_session{session}, m_channel{channel}
     {
-        assert(session.isConnected() && session.isAuthorized());
-        if ((m_channel = ssh_channel_new(m_session.getSession())) == NULL)
-        {
-            throw Exception("Could not allocate new channel.", __func__);
-        }
+        assert(session.isConnected() && session.isAuthorized() && (channel != NULL));
     }
     //
     // CSSHChannel Destructor
@@ -193,6 +193,16 @@ namespace Antik::SSH
         }
     }
     //
+    // Request a subsystem (for example "sftp") on a channel.
+    //
+    void CSSHChannel::requestSubsystem(const std::string &subsystem)
+    {
+        if (ssh_channel_request_subsystem(m_channel, subsystem.c_str()) != SSH_OK)
+        {
+            throw Exception(*this, __func__);
+        }
+    }
+    //
     // Return true if a channel is open.
     //
     bool CSSHChannel::isOpen()
@@ -278,6 +288,20 @@ namespace Antik::SSH
         return (returnChannel);
     }
     //
+    // Accept a channel open request message received by a session message callback (for
+    // example a reverse forwarding channel); returns an empty pointer if it failed.
+    //
+    std::unique_ptr<CSSHChannel> CSSHChannel::acceptOpenRequest(CSSHSession &session, ssh_message openRequest)
+    {
+        ssh_channel openedChannel = ssh_message_channel_request_open_reply_accept(openRequest);
+        std::unique_ptr<CSSHChannel> returnChannel;
+        if (openedChannel)
+        {
+            returnChannel.reset(new CSSHChannel(session, openedChannel));
+        }
+        return (returnChannel);
+    }
+    //
     // Set/Get IO buffer parameters.
     //
     std::shared_ptr<char[]> CSSHChannel::getIoBuffer()
@@ -0,0 +1,641 @@
+//
+// Class: CSSHForwarder
+//
+// Description: A class that forwards TCP connections over an SSH session. Local forwards
+// listen on a local port and open a direct forwarding channel (CSSHChannel::openForward)
+// to a remote host/port for each connection accepted; reverse forwards ask the server to
+// listen (CSSHChannel::listenForward) and connect each forwarded-tcpip channel the server
+// opens (taken from a session message callback, for a port asked for only) to a local
+// host/port. Data for all connections, in both directions, is moved by one
+// thread from a single libssh event loop that waits on the session socket, the local
+// sockets and a wake up eventfd; nothing spins or sleeps. Each direction has backpressure:
+// a local socket is only read while its channel window is open and channel data is only
+// taken while the local socket is keeping up, so a slow reader holds back its sender
+// without buffering without limit or stalling the other connections.
+//
+// Note: Opening a channel (openForward) and connecting to a reverse forward target are
+// done synchronously from the event loop.
+//
+// Dependencies:
+//
+// C20++        - Language standard features used.
+// libssh       - Used to talk to SSH server (https://www.libssh.org/) (0.7.5)
+// Linux        - sockets, poll and eventfd.
+//
+// =================
+// CLASS DEFINITIONS
+// =================
+#include "CSSHForwarder.hpp"
+// ====================
+// CLASS IMPLEMENTATION
+// ====================
+//
+// C++ STL
+//
+#include <cstring>
+#include <cerrno>
+#include <iostream>
+#include <algorithm>
+//
+// Linux sockets/poll/eventfd
+//
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+// =========
+// NAMESPACE
+// =========
+namespace Antik::SSH
+{
+    // ===========================
+    // PRIVATE TYPES AND CONSTANTS
+    // ===========================
+    // ==========================
+    // PUBLIC TYPES AND CONSTANTS
+    // ==========================
+    // ========================
+    // PRIVATE STATIC VARIABLES
+    // ========================
+    // =======================
+    // PUBLIC STATIC VARIABLES
+    // =======================
+    // ===============
+    // PRIVATE METHODS
+    // ===============
+    //
+    // Create a non-blocking listening socket; boundPort is set to the port bound.
+    //
+    int CSSHForwarder::listenSocket(const std::string &address, int port, int &boundPort)
+    {
+        struct addrinfo hints{}, *addresses{nullptr};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = AI_PASSIVE;
+        int returnCode{getaddrinfo((address.empty()) ? nullptr : address.c_str(), std::to_string(port).c_str(), &hints, &addresses)};
+        if (returnCode != 0)
+        {
+            throw Exception(gai_strerror(returnCode), __func__);
+        }
+        int listeningSocket{-1};
+        for (auto address = addresses; address != nullptr; address = address->ai_next)
+        {
+            int reuseAddress{1};
+            if ((listeningSocket = ::socket(address->ai_family, address->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, address->ai_protocol)) == -1)
+            {
+                continue;
+            }
+            ::setsockopt(listeningSocket, SOL_SOCKET, SO_REUSEADDR, &reuseAddress, sizeof(reuseAddress));
+            if ((::bind(listeningSocket, address->ai_addr, address->ai_addrlen) == 0) && (::listen(listeningSocket, SOMAXCONN) == 0))
+            {
+                break;
+            }
+            ::close(listeningSocket);
+            listeningSocket = -1;
+        }
+        freeaddrinfo(addresses);
+        if (listeningSocket == -1)
+        {
+            throw Exception("Could not listen on " + address + ":" + std::to_string(port) + ".", __func__);
+        }
+        std::string boundAddress;
+        socketAddress(listeningSocket, false, boundAddress, boundPort);
+        return (listeningSocket);
+    }
+    //
+    // Connect a socket to a host/port and then make it non-blocking.
+    //
+    int CSSHForwarder::connectSocket(const std::string &host, int port)
+    {
+        struct addrinfo hints{}, *addresses{nullptr};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        int returnCode{getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses)};
+        if (returnCode != 0)
+        {
+            throw Exception(gai_strerror(returnCode), __func__);
+        }
+        int connectedSocket{-1};
+        for (auto address = addresses; address != nullptr; address = address->ai_next)
+        {
+            if ((connectedSocket = ::socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC, address->ai_protocol)) == -1)
+            {
+                continue;
+            }
+            if (::connect(connectedSocket, address->ai_addr, address->ai_addrlen) == 0)
+            {
+                break;
+            }
+            ::close(connectedSocket);
+            connectedSocket = -1;
+        }
+        freeaddrinfo(addresses);
+        if (connectedSocket == -1)
+        {
+            throw Exception("Could not connect to " + host + ":" + std::to_string(port) + ".", __func__);
+        }
+        ::fcntl(connectedSocket, F_SETFL, ::fcntl(connectedSocket, F_GETFL) | O_NONBLOCK);
+        return (connectedSocket);
+    }
+    //
+    // Get the local (bound) or peer address of a socket as a host/port.
+    //
+    void CSSHForwarder::socketAddress(int socket, bool peer, std::string &host, int &port)
+    {
+        struct sockaddr_storage address{};
+        socklen_t addressLength{sizeof(address)};
+        char addressName[INET6_ADDRSTRLEN]{};
+        int returnCode{(peer) ? ::getpeername(socket, reinterpret_cast<struct sockaddr *>(&address), &addressLength)
+                              : ::getsockname(socket, reinterpret_cast<struct sockaddr *>(&address), &addressLength)};
+        if (returnCode == -1)
+        {
+            throw Exception(std::strerror(errno), __func__);
+        }
+        if (address.ss_family == AF_INET6)
+        {
+            auto address6{reinterpret_cast<struct sockaddr_in6 *>(&address)};
+            inet_ntop(AF_INET6, &address6->sin6_addr, addressName, sizeof(addressName));
+            port = ntohs(address6->sin6_port);
+        }
+        else
+        {
+            auto address4{reinterpret_cast<struct sockaddr_in *>(&address)};
+            inet_ntop(AF_INET, &address4->sin_addr, addressName, sizeof(addressName));
+            port = ntohs(address4->sin_port);
+        }
+        host = addressName;
+    }
+    //
+    // Event callbacks just record what is ready; the work (which may call back into libssh)
+    // is done from the event loop once ssh_event_dopoll() has returned.
+    //
+    int CSSHForwarder::wakeEvent(socket_t fd, int, void *)
+    {
+        std::uint64_t wakeCount;
+        while (::read(fd, &wakeCount, sizeof(wakeCount)) > 0)
+        {
+        }
+        return (0);
+    }
+    int CSSHForwarder::listenerEvent(socket_t, int revents, void *userdata)
+    {
+        static_cast<Listener *>(userdata)->events |= revents;
+        return (0);
+    }
+    int CSSHForwarder::connectionEvent(socket_t, int revents, void *userdata)
+    {
+        static_cast<Connection *>(userdata)->events |= revents;
+        return (0);
+    }
+    //
+    // Channel data callback; send data straight on to the local socket and hold any that
+    // could not be sent. Returning 0 while data is held leaves it with libssh (and so
+    // stops the channel window being re-opened) until the socket has caught up.
+    //
+    int CSSHForwarder::channelData(ssh_session, ssh_channel, void *data, uint32_t len, int is_stderr, void *userdata)
+    {
+        Connection *connection{static_cast<Connection *>(userdata)};
+        if (is_stderr || connection->closed)
+        {
+            return (static_cast<int>(len));
+        }
+        if (connection->socketBufferOffset != connection->socketBuffer.size())
+        {
+            return (0);
+        }
+        ssize_t bytesSent{::send(connection->socket, data, len, MSG_NOSIGNAL | MSG_DONTWAIT)};
+        if (bytesSent == -1)
+        {
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+            {
+                connection->closed = true;
+                return (static_cast<int>(len));
+            }
+            bytesSent = 0;
+        }
+        connection->socketBuffer.assign(static_cast<char *>(data) + bytesSent, static_cast<char *>(data) + len);
+        connection->socketBufferOffset = 0;
+        return (static_cast<int>(len));
+    }
+    void CSSHForwarder::channelEndOfFile(ssh_session, ssh_channel, void *userdata)
+    {
+        static_cast<Connection *>(userdata)->channelEndOfFile = true;
+    }
+    void CSSHForwarder::channelClose(ssh_session, ssh_channel, void *userdata)
+    {
+        static_cast<Connection *>(userdata)->channelEndOfFile = true;
+    }
+    //
+    // Session message callback; accept a forwarded-tcpip channel open for one of the ports
+    // asked for (connected from the event loop) and reject any other (returning 1 has
+    // libssh send the default reply). This saves polling for them with acceptForward(),
+    // which waits on the session itself each time it is called.
+    //
+    int CSSHForwarder::sessionMessage(ssh_session, ssh_message message, void *userdata)
+    {
+        CSSHForwarder *forwarder{static_cast<CSSHForwarder *>(userdata)};
+        if ((ssh_message_type(message) != SSH_REQUEST_CHANNEL_OPEN) || (ssh_message_subtype(message) != SSH_CHANNEL_FORWARDED_TCPIP))
+        {
+            return (1);
+        }
+        int remotePort{ssh_message_channel_request_open_destination_port(message)};
+        auto remoteForward = std::find_if(forwarder->m_remoteForwards.begin(), forwarder->m_remoteForwards.end(),
+                                          [remotePort](const RemoteForward &forward) { return (forward.remotePort == remotePort); });
+        if (remoteForward == forwarder->m_remoteForwards.end())
+        {
+            std::cerr << "Forwarded channel for port " << remotePort << " not asked for rejected." << std::endl;
+            return (1);
+        }
+        auto channel{CSSHChannel::acceptOpenRequest(forwarder->m_session, message)};
+        if (channel)
+        {
+            forwarder->m_acceptedForwards.push_back({std::move(channel), static_cast<std::size_t>(remoteForward - forwarder->m_remoteForwards.begin())});
+        }
+        return (0);
+    }
+    //
+    // Accept any pending local connections and open a forwarding channel for each.
+    //
+    void CSSHForwarder::acceptLocal(Listener &listener)
+    {
+        int clientSocket;
+        while ((clientSocket = ::accept4(listener.socket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1)
+        {
+            try
+            {
+                std::string clientHost;
+                int clientPort;
+                auto channel{std::make_unique<CSSHChannel>(m_session)};
+                socketAddress(clientSocket, true, clientHost, clientPort);
+                channel->openForward(listener.remoteHost, listener.remotePort, clientHost, clientPort);
+                addConnection(clientSocket, std::move(channel));
+            }
+            catch (const CSSHChannel::Exception &e)
+            {
+                std::cerr << e.getMessage() << std::endl;
+                ::close(clientSocket);
+            }
+            catch (const Exception &e)
+            {
+                std::cerr << e.getMessage() << std::endl;
+                ::close(clientSocket);
+            }
+        }
+    }
+    //
+    // Connect each reverse forward channel accepted to its local target.
+    //
+    void CSSHForwarder::acceptRemote()
+    {
+        std::vector<AcceptedForward> acceptedForwards;
+        acceptedForwards.swap(m_acceptedForwards);
+        for (auto &acceptedForward : acceptedForwards)
+        {
+            RemoteForward &remoteForward{m_remoteForwards[acceptedForward.remoteForward]};
+            try
+            {
+                int localSocket{connectSocket(remoteForward.localHost, remoteForward.localPort)};
+                addConnection(localSocket, std::move(acceptedForward.channel));
+            }
+            catch (const Exception &e)
+            {
+                std::cerr << e.getMessage() << std::endl;
+                acceptedForward.channel->close();
+            }
+        }
+    }
+    //
+    // Add a forwarded connection; set its channel callbacks and register its socket.
+    //
+    void CSSHForwarder::addConnection(int socket, std::unique_ptr<CSSHChannel> channel)
+    {
+        auto connection{std::make_unique<Connection>()};
+        connection->socket = socket;
+        connection->channel = std::move(channel);
+        connection->callbacks.userdata = connection.get();
+        connection->callbacks.channel_data_function = channelData;
+        connection->callbacks.channel_eof_function = channelEndOfFile;
+        connection->callbacks.channel_close_function = channelClose;
+        ssh_callbacks_init(&connection->callbacks);
+        ssh_set_channel_callbacks(connection->channel->getChannel(), &connection->callbacks);
+        m_connections.push_back(std::move(connection));
+        m_connectionCount++;
+        // Pick up any data that arrived before the callbacks were set
+        socketWrite(*m_connections.back());
+    }
+    //
+    // Local socket readable; read no more than the channel window allows (so the channel
+    // write never blocks) and pass it on. End of file is passed on as channel end of file.
+    //
+    void CSSHForwarder::socketRead(Connection &connection)
+    {
+        std::uint32_t windowSize{ssh_channel_window_size(connection.channel->getChannel())};
+        if ((windowSize == 0) || connection.socketEndOfFile)
+        {
+            return;
+        }
+        ssize_t bytesRead{::recv(connection.socket, m_ioBuffer.get(), std::min(windowSize, m_ioBufferSize), 0)};
+        if (bytesRead > 0)
+        {
+            connection.channel->write(m_ioBuffer.get(), static_cast<std::uint32_t>(bytesRead));
+        }
+        else if (bytesRead == 0)
+        {
+            connection.socketEndOfFile = true;
+            connection.channel->sendEndOfFile();
+        }
+        else if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+        {
+            connection.closed = true;
+        }
+    }
+    //
+    // Local socket writable; send held channel data and, once it has all gone, any more
+    // that libssh is holding for the channel.
+    //
+    void CSSHForwarder::socketWrite(Connection &connection)
+    {
+        while (!connection.closed)
+        {
+            if (connection.socketBufferOffset == connection.socketBuffer.size())
+            {
+                int bytesRead{ssh_channel_read_nonblocking(connection.channel->getChannel(), m_ioBuffer.get(), m_ioBufferSize, 0)};
+                if (bytesRead <= 0)
+                {
+                    if (bytesRead == SSH_ERROR)
+                    {
+                        connection.closed = true;
+                    }
+                    break;
+                }
+                connection.socketBuffer.assign(m_ioBuffer.get(), m_ioBuffer.get() + bytesRead);
+                connection.socketBufferOffset = 0;
+            }
+            ssize_t bytesSent{::send(connection.socket, &connection.socketBuffer[connection.socketBufferOffset],
+                                     connection.socketBuffer.size() - connection.socketBufferOffset, MSG_NOSIGNAL | MSG_DONTWAIT)};
+            if (bytesSent == -1)
+            {
+                if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+                {
+                    connection.closed = true;
+                }
+                break;
+            }
+            connection.socketBufferOffset += static_cast<std::size_t>(bytesSent);
+            if (connection.socketBufferOffset != connection.socketBuffer.size())
+            {
+                break;
+            }
+        }
+    }
+    //
+    // Process a connection's ready events and re-register the socket for the events now
+    // wanted. Returns false when the connection has finished.
+    //
+    bool CSSHForwarder::updateConnection(Connection &connection)
+    {
+        try
+        {
+            if (connection.events & (POLLIN | POLLHUP | POLLERR))
+            {
+                socketRead(connection);
+            }
+            if (connection.events & POLLOUT)
+            {
+                socketWrite(connection);
+            }
+        }
+        catch (const CSSHChannel::Exception &)
+        {
+            connection.closed = true;
+        }
+        connection.events = 0;
+        bool socketBufferEmpty{connection.socketBufferOffset == connection.socketBuffer.size()};
+        if (connection.channelEndOfFile && socketBufferEmpty && !connection.socketShutdown)
+        {
+            ::shutdown(connection.socket, SHUT_WR);
+            connection.socketShutdown = true;
+        }
+        if (connection.closed || (ssh_channel_is_closed(connection.channel->getChannel()) && socketBufferEmpty) ||
+            (connection.socketEndOfFile && connection.socketShutdown))
+        {
+            return (false);
+        }
+        short wantedEvents{0};
+        if (!connection.socketEndOfFile && (ssh_channel_window_size(connection.channel->getChannel()) != 0))
+        {
+            wantedEvents |= POLLIN;
+        }
+        if (!socketBufferEmpty)
+        {
+            wantedEvents |= POLLOUT;
+        }
+        if (wantedEvents != connection.registeredEvents)
+        {
+            if (connection.registeredEvents != 0)
+            {
+                ssh_event_remove_fd(m_event, connection.socket);
+            }
+            if (wantedEvents != 0)
+            {
+                ssh_event_add_fd(m_event, connection.socket, wantedEvents, connectionEvent, &connection);
+            }
+            connection.registeredEvents = wantedEvents;
+        }
+        return (true);
+    }
+    //
+    // Close a connection's channel and socket.
+    //
+    void CSSHForwarder::removeConnection(Connection &connection)
+    {
+        if ((connection.registeredEvents != 0) && (m_event != nullptr))
+        {
+            ssh_event_remove_fd(m_event, connection.socket);
+        }
+        ssh_remove_channel_callbacks(connection.channel->getChannel(), &connection.callbacks);
+        connection.channel->close();
+        ::close(connection.socket);
+        m_connectionCount--;
+    }
+    // ==============
+    // PUBLIC METHODS
+    // ==============
+    //
+    // Main CSSHForwarder object constructor. The passed in session has to be connected
+    // and authorized and is then used only from the thread calling run().
+    //
+    CSSHForwarder::CSSHForwarder(CSSHSession &session) : m_session{session}
+    {
+        if ((m_wakeEvent = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1)
+        {
+            throw Exception(std::strerror(errno), __func__);
+        }
+    }
+    //
+    // CSSHForwarder Destructor
+    //
+    CSSHForwarder::~CSSHForwarder()
+    {
+        for (auto &listener : m_listeners)
+        {
+            ::close(listener->socket);
+        }
+        for (auto &remoteForward : m_remoteForwards)
+        {
+            try
+            {
+                CSSHChannel::cancelForward(m_session, remoteForward.remoteAddress, remoteForward.remotePort);
+            }
+            catch (const CSSHSession::Exception &)
+            {
+            }
+        }
+        ::close(m_wakeEvent);
+    }
+    //
+    // Listen on a local address/port and forward each connection to a remote host/port.
+    //
+    int CSSHForwarder::addLocalForward(const std::string &localAddress, int localPort, const std::string &remoteHost, int remotePort)
+    {
+        auto listener{std::make_unique<Listener>()};
+        int boundPort{0};
+        listener->socket = listenSocket(localAddress, localPort, boundPort);
+        listener->remoteHost = remoteHost;
+        listener->remotePort = remotePort;
+        m_listeners.push_back(std::move(listener));
+        return (boundPort);
+    }
+    //
+    // Ask the server to listen on a remote address/port and forward each connection to a
+    // local host/port.
+    //
+    int CSSHForwarder::addRemoteForward(const std::string &remoteAddress, int remotePort, const std::string &localHost, int localPort)
+    {
+        int boundPort{0};
+        CSSHChannel::listenForward(m_session, remoteAddress, remotePort, &boundPort);
+        if (remotePort != 0)
+        {
+            boundPort = remotePort;
+        }
+        m_remoteForwards.push_back({remoteAddress, boundPort, localHost, localPort});
+        return (boundPort);
+    }
+    //
+    // Forwarding event loop. Waits on the session, listeners and connection sockets and
+    // services whatever is ready until stop() is called or the session fails. Any
+    // connections still open when it returns are closed.
+    //
+    void CSSHForwarder::run()
+    {
+        std::exception_ptr thrownException{nullptr};
+        if (!m_ioBuffer)
+        {
+            setIoBufferSize(m_ioBufferSize);
+        }
+        m_event = ssh_event_new();
+        ssh_set_message_callback(m_session.getSession(), sessionMessage, this);
+        ssh_event_add_session(m_event, m_session.getSession());
+        ssh_event_add_fd(m_event, m_wakeEvent, POLLIN, wakeEvent, nullptr);
+        for (auto &listener : m_listeners)
+        {
+            ssh_event_add_fd(m_event, listener->socket, POLLIN, listenerEvent, listener.get());
+        }
+        try
+        {
+            while (!m_stop)
+            {
+                if ((ssh_event_dopoll(m_event, -1) == SSH_ERROR) || !m_session.isConnected())
+                {
+                    throw CSSHSession::Exception(m_session, __func__);
+                }
+                for (auto &listener : m_listeners)
+                {
+                    if (listener->events != 0)
+                    {
+                        listener->events = 0;
+                        acceptLocal(*listener);
+                    }
+                }
+                if (!m_acceptedForwards.empty())
+                {
+                    acceptRemote();
+                }
+                for (auto connection = m_connections.begin(); connection != m_connections.end();)
+                {
+                    if (updateConnection(**connection))
+                    {
+                        connection++;
+                    }
+                    else
+                    {
+                        removeConnection(**connection);
+                        connection = m_connections.erase(connection);
+                    }
+                }
+            }
+        }
+        catch (...)
+        {
+            thrownException = std::current_exception();
+        }
+        for (auto &connection : m_connections)
+        {
+            removeConnection(*connection);
+        }
+        m_connections.clear();
+        for (auto &acceptedForward : m_acceptedForwards)
+        {
+            acceptedForward.channel->close();
+        }
+        m_acceptedForwards.clear();
+        for (auto &listener : m_listeners)
+        {
+            ssh_event_remove_fd(m_event, listener->socket);
+        }
+        ssh_event_remove_fd(m_event, m_wakeEvent);
+        ssh_event_remove_session(m_event, m_session.getSession());
+        ssh_set_message_callback(m_session.getSession(), nullptr, nullptr);
+        ssh_event_free(m_event);
+        m_event = nullptr;
+        m_stop = false;
+        if (thrownException)
+        {
+            std::rethrow_exception(thrownException);
+        }
+    }
+    //
+    // Stop the event loop (safe to call from another thread).
+    //
+    void CSSHForwarder::stop()
+    {
+        std::uint64_t wakeCount{1};
+        m_stop = true;
+        while ((::write(m_wakeEvent, &wakeCount, sizeof(wakeCount)) == -1) && (errno == EINTR))
+        {
+        }
+    }
+    //
+    // Get number of forwarded connections currently open.
+    //
+    std::size_t CSSHForwarder::getConnectionCount() const
+    {
+        return (m_connectionCount);
+    }
+    //
+    // Set/Get IO buffer parameters.
+    //
+    void CSSHForwarder::setIoBufferSize(std::uint32_t ioBufferSize)
+    {
+        m_ioBufferSize = ioBufferSize;
+        m_ioBuffer = std::make_unique<char[]>(m_ioBufferSize);
+    }
+    std::uint32_t CSSHForwarder::getIoBufferSize() const
+    {
+        return (m_ioBufferSize);
+    }
+} // namespace Antik::SSH
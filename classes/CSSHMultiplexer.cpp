@@ -0,0 +1,393 @@
+//
+// Class: CSSHMultiplexer
+//
+// Description: A class that lets many threads share one connected and authorized
+// CSSHSession. libssh sessions are not thread safe so the session (and any channels or
+// SFTP session opened on it) are only ever touched by a dedicated IO thread owned by
+// the multiplexer. Other threads submit operations (open/close a channel, execute, read,
+// write, run a command, or any function of the session/shared SFTP session) which are
+// pushed onto a lock-free submission list and each returns a std::future for its result.
+// The IO thread runs operations in submission order; a channel read that has no data yet
+// is parked and retried when the session next has activity so it does not hold up other
+// operations. When there is nothing to do the IO thread waits in a libssh event on the
+// session socket and an eventfd that submissions signal.
+//
+// Note: Operations run one at a time so a long blocking operation (for example a large
+// SFTP transfer submitted with submitSFTP()) delays the operations queued behind it.
+//
+// Dependencies:
+//
+// C20++        - Language standard features used.
+// libssh       - Used to talk to SSH server (https://www.libssh.org/) (0.7.5)
+// Linux        - poll and eventfd.
+//
+// =================
+// CLASS DEFINITIONS
+// =================
+#include "CSSHMultiplexer.hpp"
+// ====================
+// CLASS IMPLEMENTATION
+// ====================
+//
+// C++ STL
+//
+#include <cstring>
+#include <cerrno>
+//
+// Linux poll/eventfd
+//
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+// =========
+// NAMESPACE
+// =========
+namespace Antik::SSH
+{
+    // ===========================
+    // PRIVATE TYPES AND CONSTANTS
+    // ===========================
+    // ==========================
+    // PUBLIC TYPES AND CONSTANTS
+    // ==========================
+    // ========================
+    // PRIVATE STATIC VARIABLES
+    // ========================
+    // =======================
+    // PUBLIC STATIC VARIABLES
+    // =======================
+    // ===============
+    // PRIVATE METHODS
+    // ===============
+    //
+    // Push an operation onto the lock-free submission list and wake the IO thread. Once
+    // the IO thread has stopped operations are failed straight away. The IO thread may
+    // stop (and drain the list for the last time) between the check and the push, so
+    // stopped is checked again afterwards and anything then on the list drained and
+    // failed here; whichever thread takes the list fails what it took, so each operation
+    // is failed exactly once. Sequentially consistent ordering on the push/stopped flag
+    // here and the stopped flag/drain on the IO thread means one of them sees the other.
+    //
+    void CSSHMultiplexer::enqueue(Operation *operation)
+    {
+        std::uint64_t wakeCount{1};
+        if (m_stopped)
+        {
+            failOperations(operation, std::make_exception_ptr(Exception("IO thread has stopped.", __func__)));
+            return;
+        }
+        operation->next = m_submitted.load(std::memory_order_relaxed);
+        while (!m_submitted.compare_exchange_weak(operation->next, operation, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+        }
+        if (m_stopped)
+        {
+            failOperations(m_submitted.exchange(nullptr), std::make_exception_ptr(Exception("IO thread has stopped.", __func__)));
+            return;
+        }
+        while ((::write(m_wakeEvent, &wakeCount, sizeof(wakeCount)) == -1) && (errno == EINTR))
+        {
+        }
+    }
+    //
+    // Reverse a (LIFO) submission list into submission order.
+    //
+    CSSHMultiplexer::Operation *CSSHMultiplexer::reverse(Operation *operations)
+    {
+        Operation *reversed{nullptr};
+        while (operations != nullptr)
+        {
+            Operation *next{operations->next};
+            operations->next = reversed;
+            reversed = operations;
+            operations = next;
+        }
+        return (reversed);
+    }
+    //
+    // Fail (and free) a list of operations.
+    //
+    void CSSHMultiplexer::failOperations(Operation *operations, std::exception_ptr exception)
+    {
+        while (operations != nullptr)
+        {
+            std::unique_ptr<Operation> operation{operations};
+            operations = operations->next;
+            operation->fail(exception);
+        }
+    }
+    //
+    // Drain the eventfd used to wake the IO thread.
+    //
+    int CSSHMultiplexer::wakeEvent(socket_t fd, int, void *)
+    {
+        std::uint64_t wakeCount;
+        while (::read(fd, &wakeCount, sizeof(wakeCount)) > 0)
+        {
+        }
+        return (0);
+    }
+    //
+    // Get an open channel from its handle.
+    //
+    CSSHChannel &CSSHMultiplexer::getChannel(ChannelId channelId)
+    {
+        auto channel = m_channels.find(channelId);
+        if (channel == m_channels.end())
+        {
+            throw Exception("Unknown channel " + std::to_string(channelId) + ".", __func__);
+        }
+        return (*channel->second);
+    }
+    //
+    // Get the shared SFTP session (opened on first use).
+    //
+    CSFTP &CSSHMultiplexer::getSFTP()
+    {
+        if (!m_sftp)
+        {
+            auto sftp{std::make_unique<CSFTP>(m_session)};
+            sftp->open();
+            m_sftp = std::move(sftp);
+        }
+        return (*m_sftp);
+    }
+    //
+    // IO thread. Run newly submitted operations in order then retry any waiting ones. Any
+    // operation run can process packets for every channel on the session, pulling data for
+    // an operation already retried in the same pass into libssh's buffers where a poll of
+    // the (now drained) socket would not see it; so passes repeat until one runs nothing new
+    // and completes nothing, and the wait for session activity or a new submission is
+    // bounded. On stopping (or a session error) outstanding operations are failed and
+    // channels closed.
+    //
+    void CSSHMultiplexer::ioThread()
+    {
+        ssh_event ioEvent{ssh_event_new()};
+        ssh_event_add_session(ioEvent, m_session.getSession());
+        ssh_event_add_fd(ioEvent, m_wakeEvent, POLLIN, wakeEvent, nullptr);
+        try
+        {
+            while (!m_stop)
+            {
+                bool progress{false};
+                for (Operation *operations = reverse(m_submitted.exchange(nullptr, std::memory_order_acquire)); operations != nullptr;)
+                {
+                    std::unique_ptr<Operation> operation{operations};
+                    operations = operations->next;
+                    if (!operation->run(*this))
+                    {
+                        m_waiting.push_back(std::move(operation));
+                    }
+                    progress = true;
+                }
+                for (auto operation = m_waiting.begin(); operation != m_waiting.end();)
+                {
+                    if ((*operation)->run(*this))
+                    {
+                        operation = m_waiting.erase(operation);
+                        progress = true;
+                    }
+                    else
+                    {
+                        operation++;
+                    }
+                }
+                if (!progress && (m_submitted.load(std::memory_order_acquire) == nullptr) && !m_stop)
+                {
+                    if ((ssh_event_dopoll(ioEvent, kPollTimeout) == SSH_ERROR) || !m_session.isConnected())
+                    {
+                        throw CSSHSession::Exception(m_session, __func__);
+                    }
+                }
+            }
+        }
+        catch (...)
+        {
+            m_thrownException = std::current_exception();
+        }
+        m_stopped = true;
+        ssh_event_remove_fd(ioEvent, m_wakeEvent);
+        ssh_event_remove_session(ioEvent, m_session.getSession());
+        ssh_event_free(ioEvent);
+        std::exception_ptr stoppedException{(m_thrownException) ? m_thrownException : std::make_exception_ptr(Exception("IO thread has stopped.", __func__))};
+        for (auto &operation : m_waiting)
+        {
+            operation->fail(stoppedException);
+        }
+        m_waiting.clear();
+        failOperations(m_submitted.exchange(nullptr), stoppedException);
+        for (auto &channel : m_channels)
+        {
+            channel.second->close();
+        }
+        m_channels.clear();
+        if (m_sftp)
+        {
+            try
+            {
+                m_sftp->close();
+            }
+            catch (const CSFTP::Exception &)
+            {
+            }
+            m_sftp.reset();
+        }
+    }
+    // ==============
+    // PUBLIC METHODS
+    // ==============
+    //
+    // Main CSSHMultiplexer object constructor. The passed in session has to be connected
+    // and authorized; from then on it must only be used through the multiplexer.
+    //
+    CSSHMultiplexer::CSSHMultiplexer(CSSHSession &session) : m_session{session}
+    {
+        assert(session.isConnected() && session.isAuthorized());
+        if ((m_wakeEvent = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1)
+        {
+            throw Exception(std::strerror(errno), __func__);
+        }
+        m_ioThread = std::thread(&CSSHMultiplexer::ioThread, this);
+    }
+    //
+    // CSSHMultiplexer Destructor
+    //
+    CSSHMultiplexer::~CSSHMultiplexer()
+    {
+        stop();
+        if (m_ioThread.joinable())
+        {
+            m_ioThread.join();
+        }
+        failOperations(m_submitted.exchange(nullptr, std::memory_order_acquire), std::make_exception_ptr(Exception("IO thread has stopped.", __func__)));
+        ::close(m_wakeEvent);
+    }
+    //
+    // Open a session channel and return its handle.
+    //
+    std::future<CSSHMultiplexer::ChannelId> CSSHMultiplexer::openChannel()
+    {
+        return (submitOperation<ChannelId>([](CSSHMultiplexer &multiplexer) {
+            auto channel{std::make_unique<CSSHChannel>(multiplexer.m_session)};
+            channel->open();
+            multiplexer.m_channels[multiplexer.m_nextChannelId] = std::move(channel);
+            return (multiplexer.m_nextChannelId++);
+        }));
+    }
+    //
+    // Close a channel and free its handle.
+    //
+    std::future<void> CSSHMultiplexer::closeChannel(ChannelId channelId)
+    {
+        return (submitOperation<void>([channelId](CSSHMultiplexer &multiplexer) {
+            multiplexer.getChannel(channelId).close();
+            multiplexer.m_channels.erase(channelId);
+        }));
+    }
+    //
+    // Execute a command on a channel.
+    //
+    std::future<void> CSSHMultiplexer::execute(ChannelId channelId, const std::string &commandToRun)
+    {
+        return (submitOperation<void>([channelId, commandToRun](CSSHMultiplexer &multiplexer) {
+            multiplexer.getChannel(channelId).execute(commandToRun);
+        }));
+    }
+    //
+    // Read from a channel (stdout or stderr). Waits (without blocking the IO thread) until
+    // some data is available; an empty string is returned at end of file.
+    //
+    std::future<std::string> CSSHMultiplexer::read(ChannelId channelId, std::uint32_t bytesToRead, bool isStdErr)
+    {
+        return (submitOperation<std::string>([channelId, bytesToRead, isStdErr](CSSHMultiplexer &multiplexer) {
+            CSSHChannel &channel{multiplexer.getChannel(channelId)};
+            std::string data(bytesToRead, '\0');
+            int bytesRead{channel.readNonBlocking(data.data(), bytesToRead, isStdErr)};
+            if (bytesRead > 0)
+            {
+                data.resize(bytesRead);
+                return (std::make_pair(true, data));
+            }
+            if ((ssh_channel_poll(channel.getChannel(), isStdErr) == SSH_EOF) || channel.isClosed())
+            {
+                return (std::make_pair(true, std::string()));
+            }
+            return (std::make_pair(false, std::string()));
+        }));
+    }
+    //
+    // Write data to a channel.
+    //
+    std::future<void> CSSHMultiplexer::write(ChannelId channelId, const std::string &data)
+    {
+        return (submitOperation<void>([channelId, buffer = std::string(data)](CSSHMultiplexer &multiplexer) mutable {
+            CSSHChannel &channel{multiplexer.getChannel(channelId)};
+            for (std::size_t bytesWritten = 0; bytesWritten < buffer.size();)
+            {
+                bytesWritten += channel.write(buffer.data() + bytesWritten, static_cast<std::uint32_t>(buffer.size() - bytesWritten));
+            }
+        }));
+    }
+    //
+    // Send end of file on a channel.
+    //
+    std::future<void> CSSHMultiplexer::sendEndOfFile(ChannelId channelId)
+    {
+        return (submitOperation<void>([channelId](CSSHMultiplexer &multiplexer) {
+            multiplexer.getChannel(channelId).sendEndOfFile();
+        }));
+    }
+    //
+    // Get exit status of the command run on a channel.
+    //
+    std::future<int> CSSHMultiplexer::getExitStatus(ChannelId channelId)
+    {
+        return (submitOperation<int>([channelId](CSSHMultiplexer &multiplexer) {
+            return (multiplexer.getChannel(channelId).getExitStatus());
+        }));
+    }
+    //
+    // Run a command on its own channel and return its exit status and output once it
+    // has finished. Output is gathered as it arrives so other operations carry on meanwhile.
+    //
+    std::future<CSSHMultiplexer::CommandResult> CSSHMultiplexer::executeCommand(const std::string &commandToRun)
+    {
+        return (submitOperation<CommandResult>([commandToRun, channel = std::unique_ptr<CSSHChannel>(), result = CommandResult()](CSSHMultiplexer &multiplexer) mutable {
+            int bytesRead;
+            if (!channel)
+            {
+                channel = std::make_unique<CSSHChannel>(multiplexer.m_session);
+                channel->open();
+                channel->execute(commandToRun);
+            }
+            char *ioBuffer{channel->getIoBuffer().get()};
+            while ((bytesRead = channel->readNonBlocking(ioBuffer, channel->getIoBufferSize(), false)) > 0)
+            {
+                result.output.append(ioBuffer, bytesRead);
+            }
+            while ((bytesRead = channel->readNonBlocking(ioBuffer, channel->getIoBufferSize(), true)) > 0)
+            {
+                result.error.append(ioBuffer, bytesRead);
+            }
+            if (!channel->isEndOfFile() && !channel->isClosed())
+            {
+                return (std::make_pair(false, CommandResult()));
+            }
+            result.exitStatus = channel->getExitStatus();
+            channel->close();
+            return (std::make_pair(true, std::move(result)));
+        }));
+    }
+    //
+    // Stop the IO thread (safe to call from any thread).
+    //
+    void CSSHMultiplexer::stop()
+    {
+        std::uint64_t wakeCount{1};
+        m_stop = true;
+        while ((::write(m_wakeEvent, &wakeCount, sizeof(wakeCount)) == -1) && (errno == EINTR))
+        {
+        }
+    }
+} // namespace Antik::SSH
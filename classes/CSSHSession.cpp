@@ -126,6 +126,13 @@ namespace Antik::SSH
         m_password = password;
     }
     //
+    // Get user password.
+    //
+    std::string CSSHSession::getUserPassword() const
+    {
+        return (m_password);
+    }
+    //
     // Connect to SSH server.
     //
     void CSSHSession::connect()
@@ -419,6 +426,10 @@ namespace Antik::SSH
         {
             throw Exception(*this, __func__);
         }
+        if (sessionOption == SSH_OPTIONS_TIMEOUT)
+        {
+            m_timeout = *static_cast<const long *>(optionValue);
+        }
     }
     //
     // Copy a sessions options to a destination session
@@ -429,6 +440,14 @@ namespace Antik::SSH
         {
             throw Exception(*this, __func__);
         }
+        m_timeout = source.m_timeout;
+    }
+    //
+    // Get session timeout (SSH_OPTIONS_TIMEOUT) last set; libssh cannot return it.
+    //
+    long CSSHSession::getTimeout() const
+    {
+        return (m_timeout);
     }
     //
     // Get session option value
@@ -479,6 +498,36 @@ namespace Antik::SSH
         return m_authorized;
     }
     //
+    // Send a keepalive to the server (libssh 0.8 onwards; before that an ignore message).
+    // The reply is not waited for; instead the message is flushed (handling any incoming
+    // packets meanwhile) for at most the keepalive timeout and the session must still be
+    // connected afterwards, so a dead connection is detected without blocking indefinitely.
+    //
+    void CSSHSession::sendKeepAlive()
+    {
+#if LIBSSH_VERSION_INT >= SSH_VERSION_INT(0, 8, 0)
+        if (ssh_send_keepalive(m_session) != SSH_OK)
+#else
+        if (ssh_send_ignore(m_session, "keepalive") != SSH_OK)
+#endif
+        {
+            throw Exception(*this, __func__);
+        }
+        switch (ssh_blocking_flush(m_session, kKeepAliveTimeout))
+        {
+        case SSH_OK:
+            break;
+        case SSH_AGAIN:
+            throw Exception("Keepalive not sent within timeout.", __func__);
+        default:
+            throw Exception(*this, __func__);
+        }
+        if (!isConnected())
+        {
+            throw Exception("Session disconnected.", __func__);
+        }
+    }
+    //
     // Return last SSH error message.
     //
     std::string CSSHSession::getError() const
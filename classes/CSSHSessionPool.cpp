@@ -0,0 +1,436 @@
+//
+// Class: CSSHSessionPool
+//
+// Description: A class that hands out connected, verified and authorized CSSHSessions so
+// that repeated jobs against the same servers do not pay for a new connection, key
+// exchange and authorization every time. Sessions are keyed by server/port/user and
+// authorization options (taken from an unconnected session whose options are copied into
+// any new session) and are leased to one thread at a time. A returned session is kept idle
+// for reuse; idle sessions are disconnected once they have been idle for longer than the
+// maximum idle time and any that have been idle longer than the health check interval are
+// sent a keepalive before reuse (dropped if it fails). The number of sessions (idle, on
+// loan or connecting) for a server/port is limited; when at the limit an idle session for
+// a different user is disconnected to make room or else acquire waits for a session to be
+// returned. Connecting is done outside of the pool lock so other threads are not held up.
+//
+// Note: Leases must be returned before the pool is destroyed.
+//
+// Dependencies:
+//
+// C20++        - Language standard features used.
+// libssh       - Used to talk to SSH server (https://www.libssh.org/) (0.7.5)
+//
+// =================
+// CLASS DEFINITIONS
+// =================
+#include "CSSHSessionPool.hpp"
+// ====================
+// CLASS IMPLEMENTATION
+// ====================
+// =========
+// NAMESPACE
+// =========
+namespace Antik::SSH
+{
+    // ===========================
+    // PRIVATE TYPES AND CONSTANTS
+    // ===========================
+    // ==========================
+    // PUBLIC TYPES AND CONSTANTS
+    // ==========================
+    // ========================
+    // PRIVATE STATIC VARIABLES
+    // ========================
+    // =======================
+    // PUBLIC STATIC VARIABLES
+    // =======================
+    // ===============
+    // PRIVATE METHODS
+    // ===============
+    //
+    // Get the pool key (server/port/user/authorization options) and host (server/port) for
+    // the sessions options. The password only goes into the key hashed.
+    //
+    void CSSHSessionPool::sessionKey(CSSHSession &options, std::string &key, std::string &host)
+    {
+        auto getOption = [&options](CSSHSession::Option sessionOption) {
+            std::string optionValue;
+            try
+            {
+                options.getOption(sessionOption, optionValue);
+            }
+            catch (const CSSHSession::Exception &)
+            {
+            }
+            return (optionValue);
+        };
+        unsigned int port{22};
+        ssh_options_get_port(options.getSession(), &port);
+        host = getOption(SSH_OPTIONS_HOST) + ":" + std::to_string(port);
+        key = host + "\n" + getOption(SSH_OPTIONS_USER) + "\n" + getOption(SSH_OPTIONS_IDENTITY) + "\n" +
+              std::to_string(std::hash<std::string>{}(options.getUserPassword()));
+    }
+    //
+    // Disconnect and free a pooled session.
+    //
+    void CSSHSessionPool::disconnect(std::unique_ptr<PooledSession> pooledSession)
+    {
+        if (pooledSession && pooledSession->session)
+        {
+            disconnectSession(*pooledSession->session);
+        }
+    }
+    //
+    // Take the most recently used idle session with a given key (if any) moving any idle
+    // sessions past their maximum idle time onto the expired list. Called with pool locked.
+    //
+    std::unique_ptr<CSSHSessionPool::PooledSession> CSSHSessionPool::takeIdle(const std::string &key, std::list<std::unique_ptr<PooledSession>> &expired)
+    {
+        std::unique_ptr<PooledSession> pooledSession;
+        auto now = std::chrono::steady_clock::now();
+        for (auto idle = m_idleSessions.begin(); idle != m_idleSessions.end();)
+        {
+            if ((now - (*idle)->lastUsed) > m_maxIdleTime)
+            {
+                if (--m_hostSessionCount[(*idle)->host] == 0)
+                {
+                    m_hostSessionCount.erase((*idle)->host);
+                }
+                expired.push_back(std::move(*idle));
+                idle = m_idleSessions.erase(idle);
+            }
+            else if (!pooledSession && ((*idle)->key == key))
+            {
+                pooledSession = std::move(*idle);
+                idle = m_idleSessions.erase(idle);
+            }
+            else
+            {
+                idle++;
+            }
+        }
+        if (!expired.empty())
+        {
+            m_sessionReleased.notify_all();
+        }
+        return (pooledSession);
+    }
+    //
+    // Make room for a new session on a host at its limit by moving its least recently used
+    // idle session onto the expired list. Called with pool locked.
+    //
+    bool CSSHSessionPool::evictIdle(const std::string &host, std::list<std::unique_ptr<PooledSession>> &expired)
+    {
+        for (auto idle = m_idleSessions.rbegin(); idle != m_idleSessions.rend(); idle++)
+        {
+            if ((*idle)->host == host)
+            {
+                m_hostSessionCount[host]--;
+                expired.push_back(std::move(*idle));
+                m_idleSessions.erase(std::next(idle).base());
+                return (true);
+            }
+        }
+        return (false);
+    }
+    //
+    // Create a new session with the passed in options and connect it.
+    //
+    void CSSHSessionPool::connect(PooledSession &pooledSession, CSSHSession &options)
+    {
+        pooledSession.session = (m_sessionFactory) ? m_sessionFactory() : std::make_unique<CSSHSession>();
+        pooledSession.session->copyOptions(options);
+        pooledSession.session->setUserPassword(options.getUserPassword());
+        connectSession(*pooledSession.session);
+    }
+    //
+    // Check that a session taken from idle is still usable; if it has been idle longer than
+    // the health check interval a keepalive is sent first.
+    //
+    bool CSSHSessionPool::isHealthy(PooledSession &pooledSession, std::chrono::seconds healthCheckInterval)
+    {
+        if (!isSessionConnected(*pooledSession.session))
+        {
+            return (false);
+        }
+        if ((std::chrono::steady_clock::now() - pooledSession.lastUsed) >= healthCheckInterval)
+        {
+            try
+            {
+                keepSessionAlive(*pooledSession.session);
+            }
+            catch (const CSSHSession::Exception &)
+            {
+                return (false);
+            }
+        }
+        return (isSessionConnected(*pooledSession.session));
+    }
+    //
+    // Return a leased session to the pool; it is kept idle if reusable and still connected
+    // otherwise it is disconnected and its host slot freed.
+    //
+    void CSSHSessionPool::release(std::unique_ptr<PooledSession> pooledSession, bool reusable)
+    {
+        std::unique_lock poolLock(m_poolMutex);
+        m_activeCount--;
+        if (reusable && pooledSession->session && isSessionConnected(*pooledSession->session))
+        {
+            pooledSession->lastUsed = std::chrono::steady_clock::now();
+            m_idleSessions.push_front(std::move(pooledSession));
+        }
+        else if (--m_hostSessionCount[pooledSession->host] == 0)
+        {
+            m_hostSessionCount.erase(pooledSession->host);
+        }
+        poolLock.unlock();
+        m_sessionReleased.notify_all();
+        disconnect(std::move(pooledSession));
+    }
+    // =================
+    // PROTECTED METHODS
+    // =================
+    //
+    // Connect a new session, verify the server and authorize the user.
+    //
+    void CSSHSessionPool::connectSession(CSSHSession &session)
+    {
+        session.connect();
+        {
+            std::scoped_lock verificationLock(m_verificationMutex);
+            if (!verifyKnownServer(session, m_verificationContext))
+            {
+                throw Exception("Unable to verify server.", __func__);
+            }
+        }
+        if (!userAuthorize(session))
+        {
+            throw Exception("Server unable to authorize client.", __func__);
+        }
+    }
+    //
+    // Is a session still connected.
+    //
+    bool CSSHSessionPool::isSessionConnected(CSSHSession &session)
+    {
+        return (session.isConnected());
+    }
+    //
+    // Send a session a keepalive (throws CSSHSession::Exception on failure).
+    //
+    void CSSHSessionPool::keepSessionAlive(CSSHSession &session)
+    {
+        session.sendKeepAlive();
+    }
+    //
+    // Disconnect a session.
+    //
+    void CSSHSessionPool::disconnectSession(CSSHSession &session)
+    {
+        session.disconnect();
+    }
+    // ==============
+    // PUBLIC METHODS
+    // ==============
+    //
+    // Lease construction/move/destruction.
+    //
+    CSSHSessionPool::Lease::Lease(CSSHSessionPool *pool, std::unique_ptr<PooledSession> pooledSession) : m_pool{pool}, m_pooledSession{std::move(pooledSession)}
+    {
+    }
+    CSSHSessionPool::Lease::Lease(Lease &&other) noexcept : m_pool{other.m_pool}, m_pooledSession{std::move(other.m_pooledSession)}, m_reusable{other.m_reusable}
+    {
+        other.m_pool = nullptr;
+    }
+    CSSHSessionPool::Lease &CSSHSessionPool::Lease::operator=(Lease &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            m_pool = other.m_pool;
+            m_pooledSession = std::move(other.m_pooledSession);
+            m_reusable = other.m_reusable;
+            other.m_pool = nullptr;
+        }
+        return (*this);
+    }
+    CSSHSessionPool::Lease::~Lease()
+    {
+        release();
+    }
+    //
+    // Leased session access.
+    //
+    CSSHSession &CSSHSessionPool::Lease::operator*() const
+    {
+        return (getSession());
+    }
+    CSSHSession *CSSHSessionPool::Lease::operator->() const
+    {
+        return (&getSession());
+    }
+    CSSHSession &CSSHSessionPool::Lease::getSession() const
+    {
+        assert(m_pooledSession);
+        return (*m_pooledSession->session);
+    }
+    CSSHSessionPool::Lease::operator bool() const
+    {
+        return (m_pooledSession != nullptr);
+    }
+    //
+    // Mark leased session as not to be reused.
+    //
+    void CSSHSessionPool::Lease::invalidate()
+    {
+        m_reusable = false;
+    }
+    //
+    // Return leased session to its pool.
+    //
+    void CSSHSessionPool::Lease::release()
+    {
+        if (m_pool && m_pooledSession)
+        {
+            m_pool->release(std::move(m_pooledSession), m_reusable);
+        }
+        m_pool = nullptr;
+        m_pooledSession.reset();
+    }
+    //
+    // Main CSSHSessionPool object constructor.
+    //
+    CSSHSessionPool::CSSHSessionPool(ServerVerificationContext &verificationContext, SessionFactory sessionFactory) : m_verificationContext{verificationContext}, m_sessionFactory{std::move(sessionFactory)}
+    {
+    }
+    //
+    // CSSHSessionPool Destructor (disconnect idle sessions).
+    //
+    CSSHSessionPool::~CSSHSessionPool()
+    {
+        assert(m_activeCount == 0);
+        for (auto &pooledSession : m_idleSessions)
+        {
+            disconnect(std::move(pooledSession));
+        }
+    }
+    //
+    // Lease a session for the passed in sessions options.
+    //
+    CSSHSessionPool::Lease CSSHSessionPool::acquire(CSSHSession &options)
+    {
+        std::string key, host;
+        std::list<std::unique_ptr<PooledSession>> expired;
+        auto disconnectExpired = [this, &expired]() {
+            for (auto &pooledSession : expired)
+            {
+                disconnect(std::move(pooledSession));
+            }
+            expired.clear();
+        };
+        sessionKey(options, key, host);
+        std::unique_lock poolLock(m_poolMutex);
+        while (true)
+        {
+            std::unique_ptr<PooledSession> pooledSession{takeIdle(key, expired)};
+            if (pooledSession)
+            {
+                auto healthCheckInterval{m_healthCheckInterval};
+                m_activeCount++;
+                poolLock.unlock();
+                disconnectExpired();
+                if (isHealthy(*pooledSession, healthCheckInterval))
+                {
+                    return (Lease(this, std::move(pooledSession)));
+                }
+                release(std::move(pooledSession), false);
+                poolLock.lock();
+            }
+            else if ((m_hostSessionCount[host] < m_maxSessionsPerHost) || evictIdle(host, expired))
+            {
+                m_hostSessionCount[host]++;
+                m_activeCount++;
+                poolLock.unlock();
+                disconnectExpired();
+                pooledSession = std::make_unique<PooledSession>();
+                pooledSession->key = key;
+                pooledSession->host = host;
+                try
+                {
+                    connect(*pooledSession, options);
+                }
+                catch (...)
+                {
+                    release(std::move(pooledSession), false);
+                    throw;
+                }
+                return (Lease(this, std::move(pooledSession)));
+            }
+            else
+            {
+                m_sessionReleased.wait(poolLock);
+            }
+        }
+    }
+    //
+    // Disconnect any idle sessions past their maximum idle time.
+    //
+    void CSSHSessionPool::prune()
+    {
+        std::list<std::unique_ptr<PooledSession>> expired;
+        {
+            std::scoped_lock poolLock(m_poolMutex);
+            takeIdle("", expired);
+        }
+        for (auto &pooledSession : expired)
+        {
+            disconnect(std::move(pooledSession));
+        }
+    }
+    //
+    // Pool status.
+    //
+    std::size_t CSSHSessionPool::getIdleCount() const
+    {
+        std::scoped_lock poolLock(m_poolMutex);
+        return (m_idleSessions.size());
+    }
+    std::size_t CSSHSessionPool::getActiveCount() const
+    {
+        std::scoped_lock poolLock(m_poolMutex);
+        return (m_activeCount);
+    }
+    //
+    // Set/get pool parameters.
+    //
+    void CSSHSessionPool::setMaxSessionsPerHost(std::size_t maxSessionsPerHost)
+    {
+        std::scoped_lock poolLock(m_poolMutex);
+        m_maxSessionsPerHost = maxSessionsPerHost;
+    }
+    std::size_t CSSHSessionPool::getMaxSessionsPerHost() const
+    {
+        std::scoped_lock poolLock(m_poolMutex);
+        return (m_maxSessionsPerHost);
+    }
+    void CSSHSessionPool::setMaxIdleTime(std::chrono::seconds maxIdleTime)
+    {
+        std::scoped_lock poolLock(m_poolMutex);
+        m_maxIdleTime = maxIdleTime;
+    }
+    std::chrono::seconds CSSHSessionPool::getMaxIdleTime() const
+    {
+        std::scoped_lock poolLock(m_poolMutex);
+        return (m_maxIdleTime);
+    }
+    void CSSHSessionPool::setHealthCheckInterval(std::chrono::seconds healthCheckInterval)
+    {
+        std::scoped_lock poolLock(m_poolMutex);
+        m_healthCheckInterval = healthCheckInterval;
+    }
+    std::chrono::seconds CSSHSessionPool::getHealthCheckInterval() const
+    {
+        std::scoped_lock poolLock(m_poolMutex);
+        return (m_healthCheckInterval);
+    }
+} // namespace Antik::SSH
@@ -0,0 +1,725 @@
+//
+// Class: CTar
+//
+// Description: Class to pack a local directory tree into a POSIX (ustar) tar
+// stream and unpack a tar stream into a local directory. Archive IO is through
+// caller supplied read/write functions so that a stream may be piped straight to
+// or from a remote tar command (for example over an SSH channel) without going
+// through an intermediate archive file. Names too long for the ustar name/prefix
+// fields are written as GNU long name entries; on unpack GNU long names, pax
+// extended headers (path, linkpath and size) and base-256 encoded sizes are also
+// understood.
+//
+// Dependencies:   C20++     - Language standard features used.
+//                 Linux     - stat/open/read/write/symlink/utimensat.
+//
+// =================
+// CLASS DEFINITIONS
+// =================
+#include "CTar.hpp"
+// ====================
+// CLASS IMPLEMENTATION
+// ====================
+//
+// C++ STL
+//
+#include <cstring>
+#include <cerrno>
+#include <cctype>
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+//
+// Linux file IO
+//
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+// =========
+// NAMESPACE
+// =========
+namespace Antik::File
+{
+    // ===========================
+    // PRIVATE TYPES AND CONSTANTS
+    // ===========================
+    //
+    // ustar header field offsets/lengths
+    //
+    namespace
+    {
+        const std::size_t kNameOffset{0};
+        const std::size_t kNameLength{100};
+        const std::size_t kModeOffset{100};
+        const std::size_t kUidOffset{108};
+        const std::size_t kGidOffset{116};
+        const std::size_t kIdLength{8};
+        const std::size_t kSizeOffset{124};
+        const std::size_t kSizeLength{12};
+        const std::size_t kTimeOffset{136};
+        const std::size_t kTimeLength{12};
+        const std::size_t kChecksumOffset{148};
+        const std::size_t kChecksumLength{8};
+        const std::size_t kTypeOffset{156};
+        const std::size_t kLinkNameOffset{157};
+        const std::size_t kMagicOffset{257};
+        const std::size_t kPrefixOffset{345};
+        const std::size_t kPrefixLength{155};
+        const char kTypeRegular{'0'};
+        const char kTypeRegularOld{'\0'};
+        const char kTypeContiguous{'7'};
+        const char kTypeSymbolicLink{'2'};
+        const char kTypeDirectory{'5'};
+        const char kTypeGNULongName{'L'};
+        const char kTypeGNULongLink{'K'};
+        const char kTypePaxExtended{'x'};
+        const char kTypePaxGlobal{'g'};
+        const char *kLongLinkName{"././@LongLink"};
+        const std::uint64_t kMaxOctalSize{077777777777ULL};
+    } // namespace
+    // ========================
+    // PRIVATE STATIC VARIABLES
+    // ========================
+    // =======================
+    // PUBLIC STATIC VARIABLES
+    // =======================
+    // ===============
+    // PRIVATE METHODS
+    // ===============
+    //
+    // Buffered archive output; writes are passed on in kIoBufferSize chunks.
+    //
+    CTar::Output::Output(const WriteFn &writeFn) : m_writeFn{writeFn}
+    {
+        m_buffer.reserve(kIoBufferSize);
+    }
+    void CTar::Output::write(const char *buffer, std::size_t length)
+    {
+        while (length != 0)
+        {
+            std::size_t bytesToCopy{std::min(length, kIoBufferSize - m_buffer.size())};
+            m_buffer.insert(m_buffer.end(), buffer, buffer + bytesToCopy);
+            buffer += bytesToCopy;
+            length -= bytesToCopy;
+            if (m_buffer.size() == kIoBufferSize)
+            {
+                flush();
+            }
+        }
+    }
+    //
+    // Pad output to the next block boundary after length bytes of data.
+    //
+    void CTar::Output::pad(std::uint64_t length)
+    {
+        static const char zeroBlock[kBlockSize]{};
+        if ((length % kBlockSize) != 0)
+        {
+            write(zeroBlock, kBlockSize - (length % kBlockSize));
+        }
+    }
+    void CTar::Output::flush()
+    {
+        if (!m_buffer.empty())
+        {
+            m_writeFn(m_buffer.data(), m_buffer.size());
+            m_buffer.clear();
+        }
+    }
+    //
+    // Buffered archive input; read() returns false on end of stream before any of
+    // length has been read and throws on a stream truncated part way through.
+    //
+    CTar::Input::Input(const ReadFn &readFn) : m_readFn{readFn}, m_buffer(kIoBufferSize)
+    {
+    }
+    bool CTar::Input::read(char *buffer, std::size_t length)
+    {
+        std::size_t bytesRead{0};
+        while (bytesRead < length)
+        {
+            if (m_position == m_length)
+            {
+                m_position = 0;
+                m_length = m_readFn(m_buffer.data(), m_buffer.size());
+                if (m_length == 0)
+                {
+                    if (bytesRead == 0)
+                    {
+                        return (false);
+                    }
+                    throw Exception("Archive stream truncated.");
+                }
+            }
+            std::size_t bytesToCopy{std::min(length - bytesRead, m_length - m_position)};
+            std::memcpy(&buffer[bytesRead], &m_buffer[m_position], bytesToCopy);
+            m_position += bytesToCopy;
+            bytesRead += bytesToCopy;
+        }
+        return (true);
+    }
+    void CTar::Input::skip(std::uint64_t length)
+    {
+        char block[kBlockSize];
+        while (length != 0)
+        {
+            std::size_t bytesToSkip{static_cast<std::size_t>(std::min<std::uint64_t>(length, kBlockSize))};
+            if (!read(block, bytesToSkip))
+            {
+                throw Exception("Archive stream truncated.");
+            }
+            length -= bytesToSkip;
+        }
+    }
+    //
+    // Read (and discard) any remaining stream after the end of archive marker.
+    //
+    void CTar::Input::drain()
+    {
+        m_position = m_length = 0;
+        while (m_readFn(m_buffer.data(), m_buffer.size()) != 0)
+        {
+        }
+    }
+    //
+    // Encode a number into a header field; octal if it fits otherwise GNU base-256.
+    //
+    void CTar::encodeNumber(char *field, std::size_t fieldLength, std::uint64_t value)
+    {
+        if ((fieldLength < 12) || (value <= kMaxOctalSize))
+        {
+            field[fieldLength - 1] = '\0';
+            for (std::size_t digit = fieldLength - 1; digit-- > 0;)
+            {
+                field[digit] = static_cast<char>('0' + (value & 7));
+                value >>= 3;
+            }
+        }
+        else
+        {
+            for (std::size_t byte = fieldLength; byte-- > 1;)
+            {
+                field[byte] = static_cast<char>(value & 0xff);
+                value >>= 8;
+            }
+            field[0] = static_cast<char>(0x80);
+        }
+    }
+    //
+    // Decode an octal or GNU base-256 header field.
+    //
+    std::uint64_t CTar::decodeNumber(const char *field, std::size_t fieldLength)
+    {
+        std::uint64_t value{0};
+        if (static_cast<unsigned char>(field[0]) & 0x80)
+        {
+            for (std::size_t byte = 1; byte < fieldLength; byte++)
+            {
+                value = (value << 8) | static_cast<unsigned char>(field[byte]);
+            }
+            return (value);
+        }
+        std::size_t digit{0};
+        while ((digit < fieldLength) && ((field[digit] == ' ') || (field[digit] == '\0')))
+        {
+            digit++;
+        }
+        for (; (digit < fieldLength) && (field[digit] >= '0') && (field[digit] <= '7'); digit++)
+        {
+            value = (value << 3) | static_cast<std::uint64_t>(field[digit] - '0');
+        }
+        return (value);
+    }
+    //
+    // Calculate header checksum (checksum field taken as spaces) and set it.
+    //
+    void CTar::setChecksum(char *header)
+    {
+        std::uint32_t checksum{0};
+        std::memset(&header[kChecksumOffset], ' ', kChecksumLength);
+        for (std::size_t byte = 0; byte < kBlockSize; byte++)
+        {
+            checksum += static_cast<unsigned char>(header[byte]);
+        }
+        encodeNumber(&header[kChecksumOffset], kChecksumLength - 1, checksum);
+    }
+    bool CTar::checksumValid(const char *header)
+    {
+        std::uint32_t checksum{0};
+        for (std::size_t byte = 0; byte < kBlockSize; byte++)
+        {
+            if ((byte >= kChecksumOffset) && (byte < kChecksumOffset + kChecksumLength))
+            {
+                checksum += ' ';
+            }
+            else
+            {
+                checksum += static_cast<unsigned char>(header[byte]);
+            }
+        }
+        return (checksum == decodeNumber(&header[kChecksumOffset], kChecksumLength));
+    }
+    //
+    // Write a GNU long name/link entry whose data is the NUL terminated name.
+    //
+    void CTar::writeLongName(Output &output, char typeFlag, const std::string &longName)
+    {
+        char header[kBlockSize]{};
+        std::strncpy(&header[kNameOffset], kLongLinkName, kNameLength);
+        encodeNumber(&header[kModeOffset], kIdLength, 0);
+        encodeNumber(&header[kUidOffset], kIdLength, 0);
+        encodeNumber(&header[kGidOffset], kIdLength, 0);
+        encodeNumber(&header[kSizeOffset], kSizeLength, longName.size() + 1);
+        encodeNumber(&header[kTimeOffset], kTimeLength, 0);
+        header[kTypeOffset] = typeFlag;
+        std::memcpy(&header[kMagicOffset], "ustar  ", 8);
+        setChecksum(header);
+        output.write(header, kBlockSize);
+        output.write(longName.c_str(), longName.size() + 1);
+        output.pad(longName.size() + 1);
+    }
+    //
+    // Write an entry header (preceded by any GNU long name/link entries needed).
+    //
+    void CTar::writeHeader(Output &output, const Entry &entry)
+    {
+        char header[kBlockSize]{};
+        std::string name{entry.name};
+        bool gnuHeader{false};
+        if (entry.type == EntryType::directory)
+        {
+            name += "/";
+        }
+        if (entry.linkName.size() > kNameLength)
+        {
+            writeLongName(output, kTypeGNULongLink, entry.linkName);
+            gnuHeader = true;
+        }
+        if (name.size() <= kNameLength)
+        {
+            std::memcpy(&header[kNameOffset], name.data(), name.size());
+        }
+        else
+        {
+            std::size_t split{name.find_last_of('/', kPrefixLength)};
+            if ((split != std::string::npos) && (split != 0) && (name.size() - split - 1 != 0) && ((name.size() - split - 1) <= kNameLength))
+            {
+                std::memcpy(&header[kPrefixOffset], name.data(), split);
+                std::memcpy(&header[kNameOffset], &name[split + 1], name.size() - split - 1);
+            }
+            else
+            {
+                writeLongName(output, kTypeGNULongName, name);
+                std::memcpy(&header[kNameOffset], name.data(), kNameLength);
+                gnuHeader = true;
+            }
+        }
+        encodeNumber(&header[kModeOffset], kIdLength, entry.mode & 07777);
+        encodeNumber(&header[kUidOffset], kIdLength, 0);
+        encodeNumber(&header[kGidOffset], kIdLength, 0);
+        encodeNumber(&header[kSizeOffset], kSizeLength, (entry.type == EntryType::regular) ? entry.size : 0);
+        encodeNumber(&header[kTimeOffset], kTimeLength, static_cast<std::uint64_t>(std::max<std::int64_t>(entry.modifiedTime, 0)));
+        switch (entry.type)
+        {
+        case EntryType::directory:
+            header[kTypeOffset] = kTypeDirectory;
+            break;
+        case EntryType::symbolicLink:
+            header[kTypeOffset] = kTypeSymbolicLink;
+            std::memcpy(&header[kLinkNameOffset], entry.linkName.data(), std::min(entry.linkName.size(), kNameLength));
+            break;
+        default:
+            header[kTypeOffset] = kTypeRegular;
+            break;
+        }
+        std::memcpy(&header[kMagicOffset], (gnuHeader) ? "ustar  " : "ustar\00000", 8);
+        setChecksum(header);
+        output.write(header, kBlockSize);
+    }
+    //
+    // Parse pax extended header records ("length keyword=value\n") for the next entry.
+    //
+    void CTar::parseExtendedHeader(const std::string &extendedHeader, Entry &entry, bool &sizeSet)
+    {
+        std::size_t recordStart{0};
+        while (recordStart < extendedHeader.size())
+        {
+            std::size_t recordLength{0};
+            std::size_t keywordStart{recordStart};
+            while ((keywordStart < extendedHeader.size()) && std::isdigit(static_cast<unsigned char>(extendedHeader[keywordStart])))
+            {
+                recordLength = (recordLength * 10) + static_cast<std::size_t>(extendedHeader[keywordStart++] - '0');
+            }
+            if ((recordLength == 0) || (recordStart + recordLength > extendedHeader.size()) ||
+                (extendedHeader[keywordStart] != ' ') || (extendedHeader[recordStart + recordLength - 1] != '\n'))
+            {
+                throw Exception("Invalid pax extended header.");
+            }
+            std::string record{extendedHeader.substr(keywordStart + 1, recordStart + recordLength - keywordStart - 2)};
+            std::size_t equals{record.find('=')};
+            if (equals != std::string::npos)
+            {
+                std::string keyword{record.substr(0, equals)};
+                if (keyword == "path")
+                {
+                    entry.name = record.substr(equals + 1);
+                }
+                else if (keyword == "linkpath")
+                {
+                    entry.linkName = record.substr(equals + 1);
+                }
+                else if (keyword == "size")
+                {
+                    entry.size = std::stoull(record.substr(equals + 1));
+                    sizeSet = true;
+                }
+            }
+            recordStart += recordLength;
+        }
+    }
+    //
+    // Read the next entry header (processing any GNU long name/pax extended headers
+    // that precede it). Returns false at end of archive.
+    //
+    bool CTar::readHeader(Input &input, Entry &entry)
+    {
+        Entry extended;
+        bool sizeSet{false};
+        char header[kBlockSize];
+        while (input.read(header, kBlockSize))
+        {
+            if (std::all_of(header, header + kBlockSize, [](char byte) { return (byte == '\0'); }))
+            {
+                return (false);
+            }
+            if (!checksumValid(header))
+            {
+                throw Exception("Invalid header checksum.");
+            }
+            std::uint64_t size{decodeNumber(&header[kSizeOffset], kSizeLength)};
+            char typeFlag{header[kTypeOffset]};
+            if ((typeFlag == kTypeGNULongName) || (typeFlag == kTypeGNULongLink) ||
+                (typeFlag == kTypePaxExtended) || (typeFlag == kTypePaxGlobal))
+            {
+                std::string data(size, '\0');
+                if (!input.read(data.data(), data.size()))
+                {
+                    throw Exception("Archive stream truncated.");
+                }
+                input.skip((kBlockSize - (size % kBlockSize)) % kBlockSize);
+                if (typeFlag == kTypeGNULongName)
+                {
+                    extended.name = data.substr(0, data.find('\0'));
+                }
+                else if (typeFlag == kTypeGNULongLink)
+                {
+                    extended.linkName = data.substr(0, data.find('\0'));
+                }
+                else if (typeFlag == kTypePaxExtended)
+                {
+                    parseExtendedHeader(data, extended, sizeSet);
+                }
+                continue;
+            }
+            entry = Entry();
+            if (!extended.name.empty())
+            {
+                entry.name = extended.name;
+            }
+            else
+            {
+                entry.name.assign(&header[kNameOffset], strnlen(&header[kNameOffset], kNameLength));
+                if ((std::memcmp(&header[kMagicOffset], "ustar\0", 6) == 0) && (header[kPrefixOffset] != '\0'))
+                {
+                    entry.name = std::string(&header[kPrefixOffset], strnlen(&header[kPrefixOffset], kPrefixLength)) + "/" + entry.name;
+                }
+            }
+            if (!extended.linkName.empty())
+            {
+                entry.linkName = extended.linkName;
+            }
+            else
+            {
+                entry.linkName.assign(&header[kLinkNameOffset], strnlen(&header[kLinkNameOffset], kNameLength));
+            }
+            entry.size = (sizeSet) ? extended.size : size;
+            entry.mode = static_cast<std::uint32_t>(decodeNumber(&header[kModeOffset], kIdLength)) & 07777;
+            entry.modifiedTime = static_cast<std::int64_t>(decodeNumber(&header[kTimeOffset], kTimeLength));
+            switch (typeFlag)
+            {
+            case kTypeRegular:
+            case kTypeRegularOld:
+            case kTypeContiguous:
+                entry.type = EntryType::regular;
+                break;
+            case kTypeDirectory:
+                entry.type = EntryType::directory;
+                break;
+            case kTypeSymbolicLink:
+                entry.type = EntryType::symbolicLink;
+                break;
+            default:
+                entry.type = EntryType::other;
+                break;
+            }
+            while (entry.name.compare(0, 2, "./") == 0)
+            {
+                entry.name.erase(0, 2);
+            }
+            while (!entry.name.empty() && (entry.name.back() == '/'))
+            {
+                entry.name.pop_back();
+            }
+            return (true);
+        }
+        return (false);
+    }
+    //
+    // Return false for absolute archive names or ones containing ".." components.
+    //
+    bool CTar::safePath(const std::string &name)
+    {
+        if (!name.empty() && (name.front() == '/'))
+        {
+            return (false);
+        }
+        for (auto &component : std::filesystem::path(name))
+        {
+            if (component == "..")
+            {
+                return (false);
+            }
+        }
+        return (true);
+    }
+    //
+    // Return true if any existing parent directory of an archive name (below the local
+    // directory being unpacked into) is a symbolic link.
+    //
+    bool CTar::throughSymbolicLink(const std::string &localDirectory, const std::string &name)
+    {
+        std::filesystem::path parentPath{localDirectory};
+        struct stat fileStat;
+        for (auto &component : std::filesystem::path(name).parent_path())
+        {
+            parentPath /= component;
+            if (::lstat(parentPath.c_str(), &fileStat) == -1)
+            {
+                return (false);
+            }
+            if (S_ISLNK(fileStat.st_mode))
+            {
+                return (true);
+            }
+        }
+        return (false);
+    }
+    // ==============
+    // PUBLIC METHODS
+    // ==============
+    //
+    // Pack a local directory tree into a tar stream. Entry names are relative to the
+    // directory; symbolic links are stored (not followed) and other special files are
+    // skipped. The completion function is called with each local file packed.
+    //
+    void CTar::pack(const std::string &localDirectory, const WriteFn &writeFn, FileCompletionFn completionFn)
+    {
+        Output output{writeFn};
+        std::vector<char> ioBuffer(kIoBufferSize);
+        std::filesystem::path root{localDirectory};
+        for (auto &directoryEntry : std::filesystem::recursive_directory_iterator{root})
+        {
+            struct stat fileStat;
+            std::string localPath{directoryEntry.path().string()};
+            if (::lstat(localPath.c_str(), &fileStat) == -1)
+            {
+                throw Exception("Could not stat file " + localPath + ": " + std::strerror(errno));
+            }
+            Entry entry;
+            entry.name = directoryEntry.path().lexically_relative(root).generic_string();
+            entry.mode = fileStat.st_mode & 07777;
+            entry.modifiedTime = fileStat.st_mtime;
+            if (S_ISDIR(fileStat.st_mode))
+            {
+                entry.type = EntryType::directory;
+                writeHeader(output, entry);
+            }
+            else if (S_ISLNK(fileStat.st_mode))
+            {
+                entry.type = EntryType::symbolicLink;
+                entry.linkName = std::filesystem::read_symlink(directoryEntry.path()).string();
+                writeHeader(output, entry);
+            }
+            else if (S_ISREG(fileStat.st_mode))
+            {
+                int localFile{::open(localPath.c_str(), O_RDONLY)};
+                if (localFile == -1)
+                {
+                    throw Exception("Could not open file " + localPath + ": " + std::strerror(errno));
+                }
+                entry.size = static_cast<std::uint64_t>(fileStat.st_size);
+                writeHeader(output, entry);
+                std::uint64_t bytesLeft{entry.size};
+                while (bytesLeft != 0)
+                {
+                    ssize_t bytesRead{::read(localFile, ioBuffer.data(), static_cast<std::size_t>(std::min<std::uint64_t>(bytesLeft, ioBuffer.size())))};
+                    if (bytesRead <= 0)
+                    {
+                        int readError{(bytesRead == 0) ? EIO : errno};
+                        ::close(localFile);
+                        throw Exception("Could not read file " + localPath + ": " + std::strerror(readError));
+                    }
+                    output.write(ioBuffer.data(), static_cast<std::size_t>(bytesRead));
+                    bytesLeft -= static_cast<std::uint64_t>(bytesRead);
+                }
+                ::close(localFile);
+                output.pad(entry.size);
+            }
+            else
+            {
+                continue;
+            }
+            if (completionFn)
+            {
+                completionFn(localPath);
+            }
+        }
+        output.pad(0);
+        static const char zeroBlock[kBlockSize]{};
+        output.write(zeroBlock, kBlockSize);
+        output.write(zeroBlock, kBlockSize);
+        output.flush();
+    }
+    //
+    // Unpack a tar stream into a local directory (created if needed). Regular files,
+    // directories and symbolic links are restored with their permissions and modified
+    // times; other entry types are skipped. Names are normalized; absolute names, names
+    // with ".." components and names with a parent that is (on disk) a symbolic link are
+    // rejected, and a directory or file replaces any symbolic link of the same name. The
+    // completion function is called with each local file unpacked.
+    //
+    void CTar::unpack(const std::string &localDirectory, const ReadFn &readFn, FileCompletionFn completionFn)
+    {
+        Input input{readFn};
+        Entry entry;
+        std::vector<std::pair<std::string, Entry>> directories;
+        std::vector<char> ioBuffer(kIoBufferSize);
+        std::filesystem::path root{localDirectory};
+        std::filesystem::create_directories(root);
+        while (readHeader(input, entry))
+        {
+            std::uint64_t dataSize{(entry.type == EntryType::regular || entry.type == EntryType::other) ? entry.size : 0};
+            if (!safePath(entry.name))
+            {
+                throw Exception("Unsafe archive path " + entry.name);
+            }
+            entry.name = std::filesystem::path(entry.name).lexically_normal().generic_string();
+            while (!entry.name.empty() && (entry.name.back() == '/'))
+            {
+                entry.name.pop_back();
+            }
+            if (entry.name.empty() || (entry.name == "."))
+            {
+                input.skip(dataSize + ((kBlockSize - (dataSize % kBlockSize)) % kBlockSize));
+                continue;
+            }
+            if (throughSymbolicLink(root.string(), entry.name))
+            {
+                throw Exception("Archive path through symbolic link " + entry.name);
+            }
+            std::filesystem::path localPath{root / entry.name};
+            std::filesystem::create_directories(localPath.parent_path());
+            if (entry.type == EntryType::directory)
+            {
+                std::error_code errorCode;
+                if (std::filesystem::is_symlink(std::filesystem::symlink_status(localPath, errorCode)))
+                {
+                    std::filesystem::remove(localPath, errorCode);
+                }
+                std::filesystem::create_directories(localPath);
+                directories.emplace_back(localPath.string(), entry);
+            }
+            else if (entry.type == EntryType::symbolicLink)
+            {
+                std::error_code errorCode;
+                std::filesystem::remove(localPath, errorCode);
+                if (::symlink(entry.linkName.c_str(), localPath.c_str()) == -1)
+                {
+                    throw Exception("Could not create symbolic link " + localPath.string() + ": " + std::strerror(errno));
+                }
+            }
+            else if (entry.type == EntryType::regular)
+            {
+                std::error_code errorCode;
+                if (std::filesystem::is_symlink(std::filesystem::symlink_status(localPath, errorCode)))
+                {
+                    std::filesystem::remove(localPath, errorCode);
+                }
+                int localFile{::open(localPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW, 0600)};
+                if (localFile == -1)
+                {
+                    throw Exception("Could not create file " + localPath.string() + ": " + std::strerror(errno));
+                }
+                std::uint64_t bytesLeft{entry.size};
+                while (bytesLeft != 0)
+                {
+                    std::size_t bytesToCopy{static_cast<std::size_t>(std::min<std::uint64_t>(bytesLeft, ioBuffer.size()))};
+                    if (!input.read(ioBuffer.data(), bytesToCopy))
+                    {
+                        ::close(localFile);
+                        throw Exception("Archive stream truncated.");
+                    }
+                    for (std::size_t bytesWritten = 0; bytesWritten < bytesToCopy;)
+                    {
+                        ssize_t written{::write(localFile, &ioBuffer[bytesWritten], bytesToCopy - bytesWritten)};
+                        if (written == -1)
+                        {
+                            int writeError{errno};
+                            ::close(localFile);
+                            throw Exception("Could not write file " + localPath.string() + ": " + std::strerror(writeError));
+                        }
+                        bytesWritten += static_cast<std::size_t>(written);
+                    }
+                    bytesLeft -= bytesToCopy;
+                }
+                input.skip((kBlockSize - (entry.size % kBlockSize)) % kBlockSize);
+                struct timespec times[2]{{0, UTIME_OMIT}, {static_cast<time_t>(entry.modifiedTime), 0}};
+                ::fchmod(localFile, entry.mode);
+                ::futimens(localFile, times);
+                ::close(localFile);
+            }
+            else
+            {
+                input.skip(dataSize + ((kBlockSize - (dataSize % kBlockSize)) % kBlockSize));
+                continue;
+            }
+            if (completionFn)
+            {
+                completionFn(localPath.string());
+            }
+        }
+        input.drain();
+        //
+        // Directory permissions/times last (deepest first) so that read-only
+        // directories and unpacking into them does not alter times. Directories are
+        // opened without following links so a directory since replaced by a symbolic
+        // link (or now reached through one) is left alone.
+        //
+        for (auto directory = directories.rbegin(); directory != directories.rend(); directory++)
+        {
+            if (throughSymbolicLink(root.string(), directory->second.name))
+            {
+                continue;
+            }
+            int localDirectoryFd{::open(directory->first.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC)};
+            if (localDirectoryFd == -1)
+            {
+                continue;
+            }
+            struct timespec times[2]{{0, UTIME_OMIT}, {static_cast<time_t>(directory->second.modifiedTime), 0}};
+            ::futimens(localDirectoryFd, times);
+            ::fchmod(localDirectoryFd, directory->second.mode);
+            ::close(localDirectoryFd);
+        }
+    }
+} // namespace Antik::File
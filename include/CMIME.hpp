@@ -4,10 +4,13 @@
 // C++ STL
 //
 #include <string>
+#include <string_view>
 #include <stdexcept>
 #include <unordered_map>
 #include <sstream>
 #include <vector>
+#include <array>
+#include <cstdint>
 //
 // Antik classes
 //
@@ -41,14 +44,10 @@ namespace Antik::File
             }
         };
         //
-        // Parsed MIME string entry
+        // Unknown MIME type and number of bytes needed to sniff a files type
         //
-        struct ParsedMIMEString
-        {
-            unsigned char type{' '}; // Type Q (Quoted Printable), B (base64), ' ' None.
-            std::string encoding;    // Encoding used
-            std::string contents;    // Contents
-        };
+        static const char *kUnknownMIMEType;
+        static const std::size_t kSniffLength{512};
         // ============
         // CONSTRUCTORS
         // ============
@@ -59,7 +58,11 @@ namespace Antik::File
         // PUBLIC METHODS
         // ==============
         static std::string getFileMIMEType(const std::string &fileName);
+        static std::string_view getExtensionMIMEType(std::string_view extension);
+        static std::string_view sniffMIMEType(std::string_view contents);
+        static std::string_view sniffFileMIMEType(const std::string &fileName);
         static std::string convertMIMEStringToASCII(const std::string &mime);
+        static std::size_t decodeMIMEString(std::string_view mime, char *decoded, std::size_t decodedSize, bool toUTF8 = false);
         // ================
         // PUBLIC VARIABLES
         // ================
@@ -73,11 +76,29 @@ namespace Antik::File
         static const char *kEncodedWordPrefix;
         static const char *kEncodedWordPostfix;
         static const char *kEncodedWordSeparator;
-        static const char *kEncodedWordASCII;
         static const char kEncodedWordTypeBase64;
         static const char kEncodedWordTypeQuoted;
-        static const char kEncodedWordTypeNone;
         static const char kQuotedPrintPrefix;
+        static const char kQuotedPrintSpace;
+        static const std::size_t kMaxCharsetLength{63};     // Longest charset name cached for iconv
+        static const std::size_t kTranscodeBufferSize{256}; // Decoded bytes transcoded at a time
+        //
+        // Encoded word (views into string being decoded) and its base64 decode state
+        //
+        struct EncodedWord
+        {
+            std::string_view charset;   // Character set (any RFC 2231 language removed)
+            char type{0};               // Type Q (Quoted Printable) or B (base64)
+            std::string_view text;      // Encoded text still to decode
+            std::size_t length{0};      // Length of whole encoded word
+            std::uint32_t bitBuffer{0}; // Base64 bits not yet output
+            int bitCount{0};            // Number of base64 bits in buffer
+        };
+        //
+        // Character decode tables (-1 == not valid)
+        //
+        static const std::array<std::int8_t, 256> kBase64DecodeTable;
+        static const std::array<std::int8_t, 256> kHexDecodeTable;
         // ===========================================
         // DISABLED CONSTRUCTORS/DESTRUCTORS/OPERATORS
         // ===========================================
@@ -89,11 +110,15 @@ namespace Antik::File
         // ===============
         // PRIVATE METHODS
         // ===============
-        static std::vector<ParsedMIMEString> parseMIMEString(const std::string &mime);
+        static constexpr std::array<std::int8_t, 256> makeBase64DecodeTable(void);
+        static constexpr std::array<std::int8_t, 256> makeHexDecodeTable(void);
+        static bool parseEncodedWord(std::string_view mime, EncodedWord &word);
+        static std::size_t decodeEncodedText(EncodedWord &word, char *decoded, std::size_t decodedSize);
+        static std::size_t decodeEncodedWord(EncodedWord &word, char *decoded, std::size_t decodedSize, bool toUTF8);
+        static bool isUTF8Compatible(std::string_view charset);
         // =================
         // PRIVATE VARIABLES
         // =================
-        static std::unordered_map<std::string, std::string> m_extToMimeType; // File extension to MIME type
     };
 } // namespace Antik::File
 #endif /* CMIME_HPP */
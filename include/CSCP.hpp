@@ -120,6 +120,8 @@ namespace Antik::SSH
         // ===========================
         // PRIVATE TYPES AND CONSTANTS
         // ===========================
+        static const std::uint32_t kDefaultIoBufferSize{256 * 1024}; // Default IO buffer size
+        static const std::size_t kIoBufferAlignment{4096};            // IO buffer alignment (page)
         // ===========================================
         // DISABLED CONSTRUCTORS/DESTRUCTORS/OPERATORS
         // ===========================================
@@ -136,9 +138,9 @@ namespace Antik::SSH
         CSSHSession &m_session; // SSH session
         ssh_scp m_scp;          // SCP connection
         //  int m_mode {};                  // SCP mode
-        std::string m_location;                      // SCP location
-        std::shared_ptr<char[]> m_ioBuffer{nullptr}; // IO buffer
-        std::uint32_t m_ioBufferSize{32 * 1024};     // IO buffer size
+        std::string m_location;                             // SCP location
+        std::shared_ptr<char[]> m_ioBuffer{nullptr};        // IO buffer
+        std::uint32_t m_ioBufferSize{kDefaultIoBufferSize}; // IO buffer size
     };
 } // namespace Antik::SSH
 #endif /* CSCP_HPP */
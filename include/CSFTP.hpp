@@ -9,6 +9,9 @@
 #include <cstring>
 #include <memory>
 #include <cassert>
+#include <functional>
+#include <deque>
+#include <set>
 //
 // Antik classes
 //
@@ -28,6 +31,7 @@
 namespace Antik::SSH
 {
     class CSSHSession;
+    class CSFTPExtended;
     // ==========================
     // PUBLIC TYPES AND CONSTANTS
     // ==========================
@@ -54,24 +58,37 @@ namespace Antik::SSH
                                                                                           m_functionName{functionName}
             {
             }
+            Exception(CSFTP &sftp, const std::string &functionName, std::uint64_t fileOffset) : Exception(sftp, functionName)
+            {
+                m_fileOffset = static_cast<std::int64_t>(fileOffset);
+            }
             int getCode() const
             {
                 return m_errorCode;
             }
             std::string getMessage() const
             {
+                if (m_fileOffset != -1)
+                {
+                    return static_cast<std::string>("CSFTP Failure: (") + m_functionName + ") [" + m_errorMessage + "] at offset " + std::to_string(m_fileOffset);
+                }
                 return static_cast<std::string>("CSFTP Failure: (") + m_functionName + ") [" + m_errorMessage + "]";
             }
             int sftpGetCode() const
             {
                 return m_sftpErrorCode;
             }
+            std::int64_t getFileOffset() const
+            {
+                return m_fileOffset;
+            }
 
         private:
             int m_errorCode{SSH_OK};        // SSH error code
             std::string m_errorMessage;     // SSH error message
             int m_sftpErrorCode{SSH_FX_OK}; // SFTP error code
             std::string m_functionName;     // Current function name
+            std::int64_t m_fileOffset{-1};  // Offset of failed file IO request (-1 == none)
         };
         //
         // Custom deleter for re-mapped libssh sftp data structures.
@@ -109,6 +126,42 @@ namespace Antik::SSH
         using FileOwner = uid_t;        // File owner (Linux specific)
         using FileGroup = gid_t;        // File group (Linux specific)
         using Time = timeval;           // Time (Needs some work).
+        //
+        // Pipelined read callback; passed each block of file data read in file order.
+        //
+        using ReadCallbackFn = std::function<void(const char *readBuffer, size_t bytesRead)>;
+        //
+        // Server limits (limits@openssh.com); 0 == not known/no limit. libssh only exposes
+        // the extension from 0.11 so before that negotiated is always false.
+        //
+        struct Limits
+        {
+            bool negotiated{false};           // == true limits returned by server
+            std::uint64_t maxPacketLength{0}; // Maximum packet length
+            std::uint64_t maxReadLength{0};   // Maximum read request length
+            std::uint64_t maxWriteLength{0};  // Maximum write request length
+        };
+        //
+        // Remote directories known to exist (saves stat round trips when creating remote
+        // paths). Paths are held without trailing separators and forgetting a directory
+        // also forgets any below it.
+        //
+        class DirectoryCache
+        {
+        public:
+            void add(const std::string &directoryPath);
+            bool contains(const std::string &directoryPath) const;
+            void forget(const std::string &directoryPath);
+            void clear();
+
+        private:
+            static std::string key(const std::string &directoryPath);
+            std::set<std::string> m_directories; // Known directories
+        };
+        //
+        // Pipelined write source; fills buffer with next block of file data and returns its size (0 == end).
+        //
+        using WriteSourceFn = std::function<size_t(char *writeBuffer, size_t bytesToWrite)>;
         // ============
         // CONSTRUCTORS
         // ============
@@ -134,6 +187,13 @@ namespace Antik::SSH
         File openFile(const std::string &fileName, int accessType, int mode);
         size_t readFile(const File &fileHandle, void *readBuffer, size_t bytesToRead);
         size_t writeFile(const File &fileHandle, void *writeBuffer, size_t bytesToWrite);
+        std::uint64_t readFileAsync(const File &fileHandle, const ReadCallbackFn &readCallbackFn, std::uint64_t bytesToRead = 0);
+        std::uint64_t writeFileAsync(const File &fileHandle, const WriteSourceFn &writeSourceFn);
+        //
+        // == true writeFileAsync() keeps write requests in flight; libssh before 0.11 has no
+        // asynchronous write so each block is then written and acknowledged in turn.
+        //
+        static bool isWritePipelined();
         void closeFile(File &fileHandle);
         void rewindFile(const File &fileHandle);
         void seekFile(const File &fileHandle, uint32_t offset);
@@ -156,9 +216,9 @@ namespace Antik::SSH
         void getFileAttributes(const std::string &filePath, FileAttributes &fileAttributes);
         void setFileAttributes(const std::string &filePath, const FileAttributes &fileAttributes);
         void getLinkAttributes(const std::string &linkPath, FileAttributes &fileAttributes);
-        bool isADirectory(const FileAttributes &fileAttributes);
-        bool isARegularFile(const FileAttributes &fileAttributes);
-        bool isASymbolicLink(const FileAttributes &fileAttributes);
+        static bool isADirectory(const FileAttributes &fileAttributes);
+        static bool isARegularFile(const FileAttributes &fileAttributes);
+        static bool isASymbolicLink(const FileAttributes &fileAttributes);
         void changeFileModificationAccessTimes(const std::string &filePath, const Time *newTimeValues);
         //
         // Create/Remove directories.
@@ -175,6 +235,16 @@ namespace Antik::SSH
         // Rename file
         //
         void renameFile(const std::string &sourceFile, const std::string &destinationFile);
+        //
+        // Copy file on server (keeping permissions and times) and the attributes a copy keeps.
+        //
+        void copyFile(const std::string &sourceFile, const std::string &destinationFile);
+        static FileAttributes preservedAttributes(const FileAttributes &fileAttributes);
+        //
+        // Run a command on the server (true == exit status zero) and quote command arguments.
+        //
+        bool executeRemoteCommand(const std::string &command);
+        static std::string quoteRemotePath(const std::string &remotePath);
         std::string canonicalizePath(const std::string &pathName);
         //
         // Get mounted volume information
@@ -202,6 +272,19 @@ namespace Antik::SSH
         std::shared_ptr<char[]> getIoBuffer();
         void setIoBufferSize(std::uint32_t ioBufferSize);
         std::uint32_t getIoBufferSize() const;
+        void setIoPipelineDepth(std::uint32_t ioPipelineDepth);
+        std::uint32_t getIoPipelineDepth() const;
+        //
+        // Get server limits negotiated on open.
+        //
+        const Limits &getLimits() const;
+        //
+        // Known remote directory cache (saves stat round trips when creating remote paths).
+        //
+        void addKnownDirectory(const std::string &directoryPath);
+        bool isKnownDirectory(const std::string &directoryPath) const;
+        void forgetKnownDirectory(const std::string &directoryPath);
+        void clearKnownDirectories();
         //
         // Get internal libssh ssh/sftp session data structure pointers.
         //
@@ -214,6 +297,25 @@ namespace Antik::SSH
         // ===========================
         // PRIVATE TYPES AND CONSTANTS
         // ===========================
+        static constexpr std::uint32_t kDefaultIoPipelineDepth{16};       // Default maximum outstanding IO requests
+        static constexpr std::uint32_t kMaximumIoPipelineDepth{64};       // Maximum auto-sized outstanding IO requests
+        static constexpr std::uint32_t kMaximumIoBufferSize{1024 * 1024}; // Maximum auto-sized IO buffer
+        static constexpr std::uint32_t kIoPipelineBytes{4 * 1024 * 1024}; // Auto-sized bytes in flight
+        static constexpr int kCommandPollTimeout{100};                    // Remote command poll timeout (milliseconds)
+        //
+        // Outstanding asynchronous read/write request
+        //
+        struct AsyncRequest
+        {
+            bool write{false};       // == true write request
+            std::uint64_t offset{0}; // File offset
+            std::uint32_t length{0}; // Bytes requested
+#if LIBSSH_VERSION_INT >= SSH_VERSION_INT(0, 11, 0)
+            sftp_aio aio{nullptr}; // libssh aio handle
+#else
+            std::uint32_t id{0}; // libssh request id
+#endif
+        };
         // ===========================================
         // DISABLED CONSTRUCTORS/DESTRUCTORS/OPERATORS
         // ===========================================
@@ -224,13 +326,38 @@ namespace Antik::SSH
         // ===============
         // PRIVATE METHODS
         // ===============
+        //
+        // Asynchronous read/write requests
+        //
+        AsyncRequest beginAsyncRead(const File &fileHandle, std::uint64_t offset, std::uint32_t length);
+        int waitAsyncRead(const File &fileHandle, AsyncRequest &request, void *readBuffer);
+        AsyncRequest beginAsyncWrite(const File &fileHandle, std::uint64_t offset, const void *writeBuffer, std::uint32_t length);
+        void waitAsyncWrite(AsyncRequest &request);
+        void cancelAsyncRequests(const File &fileHandle, std::deque<AsyncRequest> &requests);
+        //
+        // Negotiate server limits and size IO from them.
+        //
+        void negotiateLimits();
+        std::uint32_t ioRequestLength(std::uint64_t maxLength) const;
+        //
+        // Copy file on server with copy-data or by streaming it through the client.
+        //
+        bool copyDataOnServer(const std::string &sourceFile, const std::string &destinationFile, std::uint32_t permissions);
+        void copyFileData(const std::string &sourceFile, const std::string &destinationFile, std::uint32_t permissions);
         // =================
         // PRIVATE VARIABLES
         // =================
-        CSSHSession &m_session;                      // Channel session
-        sftp_session m_sftp;                         // libssh sftp structure.
-        std::shared_ptr<char[]> m_ioBuffer{nullptr}; // IO buffer
-        std::uint32_t m_ioBufferSize{32 * 1024};     // IO buffer size
+        CSSHSession &m_session;                                    // Channel session
+        sftp_session m_sftp;                                       // libssh sftp structure.
+        std::shared_ptr<char[]> m_ioBuffer{nullptr};               // IO buffer
+        std::uint32_t m_ioBufferSize{32 * 1024};                   // IO buffer size
+        std::uint32_t m_ioPipelineDepth{kDefaultIoPipelineDepth}; // Maximum outstanding IO requests
+        bool m_ioBufferSizeSet{false};                             // == true IO buffer size set by caller
+        bool m_ioPipelineDepthSet{false};                          // == true IO pipeline depth set by caller
+        Limits m_limits;                                           // Server limits
+        DirectoryCache m_knownDirectories;                         // Remote directories known to exist
+        std::unique_ptr<CSFTPExtended> m_extended;                 // copy-data session (opened on first copy)
+        bool m_copyDataUnavailable{false};                         // == true copy-data not supported/failed to open
     };
 } // namespace Antik::SSH
 #endif /* CSFTP_HPP */
@@ -0,0 +1,181 @@
+#ifndef CSFTPEXTENDED_HPP
+#define CSFTPEXTENDED_HPP
+//
+// C++ STL
+//
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+#include <cstdint>
+//
+// Antik classes
+//
+#include "CommonAntik.hpp"
+#include "CSSHSession.hpp"
+#include "CSSHChannel.hpp"
+// =========
+// NAMESPACE
+// =========
+namespace Antik::SSH
+{
+    // ================
+    // CLASS DEFINITION
+    // ================
+    class CSFTPExtended
+    {
+    public:
+        // ==========================
+        // PUBLIC TYPES AND CONSTANTS
+        // ==========================
+        //
+        // Class exception
+        //
+        struct Exception
+        {
+            Exception(const std::string &errorMessage, const std::string &functionName, std::uint32_t sftpErrorCode = kStatusFailure) : m_errorMessage{errorMessage},
+                                                                                                                                      m_functionName{functionName},
+                                                                                                                                      m_sftpErrorCode{sftpErrorCode}
+            {
+            }
+            std::string getMessage() const
+            {
+                return static_cast<std::string>("CSFTPExtended Failure: (") + m_functionName + ") [" + m_errorMessage + "]";
+            }
+            std::uint32_t sftpGetCode() const
+            {
+                return m_sftpErrorCode;
+            }
+
+        private:
+            std::string m_errorMessage;   // Error message
+            std::string m_functionName;   // Current function name
+            std::uint32_t m_sftpErrorCode; // SFTP status code (SSH_FX_*)
+        };
+        //
+        // SFTP packet body (type byte onwards) with SSH wire format encode/decode (RFC 4251).
+        //
+        class Packet
+        {
+        public:
+            Packet() = default;
+            explicit Packet(std::string data);
+            void putByte(std::uint8_t value);
+            void putUInt32(std::uint32_t value);
+            void putUInt64(std::uint64_t value);
+            void putString(std::string_view value);
+            std::uint8_t getByte();
+            std::uint32_t getUInt32();
+            std::uint64_t getUInt64();
+            std::string getString();
+            std::string getRemaining();
+            bool atEnd() const;
+            const std::string &getData() const;
+
+        private:
+            void need(std::size_t length) const;
+            std::string m_data;         // Packet data
+            std::size_t m_position{0}; // Decode position
+        };
+        //
+        // Hash of a remote file (or of each block of it) returned by check-file; hashes
+        // are lower case hex and algorithm is the OpenSSL digest name.
+        //
+        struct FileHash
+        {
+            std::string algorithm;
+            std::vector<std::string> hashes;
+        };
+        //
+        // SFTP status codes used.
+        //
+        static constexpr std::uint32_t kStatusOk{0};
+        static constexpr std::uint32_t kStatusFailure{4};
+        static constexpr std::uint32_t kStatusUnsupported{8};
+        // ============
+        // CONSTRUCTORS
+        // ============
+        //
+        // Main constructor
+        //
+        explicit CSFTPExtended(CSSHSession &session);
+        // ==========
+        // DESTRUCTOR
+        // ==========
+        virtual ~CSFTPExtended();
+        // ==============
+        // PUBLIC METHODS
+        // ==============
+        //
+        // Open/Close the extended request SFTP session (its own sftp subsystem channel).
+        //
+        void open();
+        void close();
+        bool isOpen() const;
+        //
+        // Return true if the server advertised an extension (any version).
+        //
+        bool extensionSupported(const std::string &name) const;
+        //
+        // check-file-name: hash files (whole file if blockSize == 0, else each block) with
+        // the first of a comma separated list of algorithms the server supports. Requests
+        // are pipelined; a file that could not be hashed has an empty result.
+        //
+        std::vector<FileHash> checkFiles(const std::vector<std::string> &filePaths, const std::string &algorithms, std::uint32_t blockSize = 0);
+        //
+        // md5-hash: MD5 of whole files (pipelined; an empty hash if not hashed).
+        //
+        std::vector<std::string> md5Hashes(const std::vector<std::string> &filePaths);
+        //
+        // copy-data: copy a file on the server into a new/truncated file with the given permissions.
+        //
+        void copyData(const std::string &sourceFile, const std::string &destinationFile, std::uint32_t permissions);
+        //
+        // Request encoding/reply parsing (public so it can be checked without a server).
+        //
+        static Packet copyDataArguments(const std::string &sourceHandle, const std::string &destinationHandle);
+        static FileHash parseCheckFileReply(Packet &reply);
+        static std::string parseMd5HashReply(Packet &reply);
+        static std::size_t hashLength(const std::string &algorithm);
+        // ================
+        // PUBLIC VARIABLES
+        // ================
+    private:
+        // ===========================
+        // PRIVATE TYPES AND CONSTANTS
+        // ===========================
+        static constexpr std::uint32_t kProtocolVersion{3};               // SFTP protocol version
+        static constexpr std::uint32_t kMaximumPacketLength{1024 * 1024}; // Largest reply accepted
+        static constexpr std::size_t kMaximumOutstanding{64};             // Maximum pipelined requests
+        // ===========================================
+        // DISABLED CONSTRUCTORS/DESTRUCTORS/OPERATORS
+        // ===========================================
+        CSFTPExtended() = delete;
+        CSFTPExtended(const CSFTPExtended &orig) = delete;
+        CSFTPExtended(const CSFTPExtended &&orig) = delete;
+        CSFTPExtended &operator=(CSFTPExtended other) = delete;
+        // ===============
+        // PRIVATE METHODS
+        // ===============
+        void sendPacket(const Packet &packet);
+        Packet receivePacket();
+        std::uint32_t sendRequest(std::uint8_t type, const Packet &arguments);
+        Packet receiveReply(std::uint32_t id);
+        static void checkStatus(Packet &reply, const std::string &functionName);
+        std::string openHandle(const std::string &filePath, std::uint32_t flags, std::uint32_t permissions);
+        void closeHandle(const std::string &handle);
+        template <typename Result, typename ParseFn>
+        std::vector<Result> pipelineExtended(const std::string &request, const std::vector<std::string> &filePaths, const std::function<void(Packet &, const std::string &)> &argumentsFn, ParseFn parseFn);
+        // =================
+        // PRIVATE VARIABLES
+        // =================
+        CSSHSession &m_session;                          // SSH session
+        std::unique_ptr<CSSHChannel> m_channel;          // sftp subsystem channel
+        std::map<std::string, std::string> m_extensions; // Server extensions (name, data)
+        std::map<std::uint32_t, Packet> m_replies;       // Replies received ahead of being waited for
+        std::uint32_t m_nextId{0};                       // Next request id
+    };
+} // namespace Antik::SSH
+#endif /* CSFTPEXTENDED_HPP */
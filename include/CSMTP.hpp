@@ -7,11 +7,19 @@
 #include <vector>
 #include <stdexcept>
 #include <deque>
+#include <memory>
+#include <mutex>
+#include <list>
+#include <unordered_map>
+#include <fstream>
+#include <filesystem>
+#include <string_view>
 //
 // Antik classes
 //
 #include "CommonAntik.hpp"
 #include "CCurl.hpp"
+#include "CSMTPClient.hpp"
 // =========
 // NAMESPACE
 // =========
@@ -36,9 +44,18 @@ namespace Antik::SMTP
             {
             }
         };
+        // Mail template placeholder substitutions (placeholder name to value)
+        using Substitutions = std::unordered_map<std::string, std::string>;
         // Supported contents encodings
         static const char *kEncoding7Bit;
         static const char *kEncodingBase64;
+        static const char *kEncodingBinary;
+        // Email transports
+        enum class Transport
+        {
+            libcurl = 0, // libcurl (default)
+            native       // Native SMTP client (PIPELINING, CHUNKING/BINARYMIME)
+        };
         // ============
         // CONSTRUCTORS
         // ============
@@ -58,6 +75,10 @@ namespace Antik::SMTP
         void setUserAndPassword(const std::string &userName, const std::string &userPassword);
         std::string getServer(void) const;
         std::string getUser(void) const;
+        // Set/Get email transport and whether TLS is required
+        void setTransport(Transport transport);
+        Transport getTransport(void) const;
+        void setTLSRequired(bool tlsRequired);
         // Set/Get email message header details
         void setFromAddress(const std::string &addressFrom);
         void setToAddress(const std::string &addressTo);
@@ -73,14 +94,28 @@ namespace Antik::SMTP
         std::string getMailMessage(void) const;
         // Send email
         void postMail(void);
+        // Compile email into template and send it to a recipient with placeholder substitutions
+        void compileMailTemplate(void);
+        void postMail(const std::string &addressTo, const Substitutions &substitutions);
         // Initialization and closedown processing
         static void init(bool bCurlVerbosity = false);
         static void closedown();
         // Get whole of email message
         std::string getMailFull(void);
+        std::string getMailFull(const std::string &addressTo, const Substitutions &substitutions);
         // Encode/decode bytes to base64 string
         static void encodeToBase64(const std::string &decoding, std::string &encoding, std::uint32_t numberOfBytes);
         static void decodeFromBase64(const std::string &encoding, std::string &decoding, std::uint32_t numberOfBytes);
+        // Set/Get/Clear shared pre-encoded attachment cache. A cached attachment is only
+        // revalidated against the file's size and modification time so a file rewritten
+        // with the same size within the file system's timestamp resolution is not seen
+        // as changed; clear the cache after such an update.
+        static void setAttachmentCacheLimit(std::uintmax_t cacheLimit);
+        static void setAttachmentCacheSpillSize(std::uintmax_t spillSize);
+        static std::uintmax_t getAttachmentCacheLimit(void);
+        static std::uintmax_t getAttachmentCacheSpillSize(void);
+        static std::uintmax_t getAttachmentCacheSize(void);
+        static void clearAttachmentCache(void);
         // ================
         // PUBLIC VARIABLES
         // ================
@@ -91,15 +126,86 @@ namespace Antik::SMTP
         // Attachments
         struct EmailAttachment
         {
-            std::string fileName;                       // Attached file name
-            std::string contentTypes;                   // Attached file MIME content type
-            std::string contentTransferEncoding;        // Attached file content encoding
-            std::vector<std::string> encodedContents{}; // Attached file encoded contents
+            std::string fileName;                // Attached file name
+            std::string contentTypes;            // Attached file MIME content type
+            std::string contentTransferEncoding; // Attached file content encoding
+        };
+        // Pre-encoded attachment MIME part (shared between CSMTP objects through the cache)
+        struct EncodedAttachment
+        {
+            ~EncodedAttachment();
+            std::uintmax_t fileSize{0};                          // Attached file size when encoded
+            std::filesystem::file_time_type fileLastWriteTime{}; // Attached file modification time when encoded
+            std::uintmax_t encodedSize{0};                       // Encoded MIME part size
+            std::string encodedContents;                         // Encoded MIME part (empty if spilled)
+            std::string spillFileName;                           // Temporary file holding spilled MIME part
+        };
+        using EncodedAttachmentPtr = std::shared_ptr<const EncodedAttachment>;
+        // Attachment cache entry and (LRU ordered) cache
+        struct AttachmentCacheEntry
+        {
+            EncodedAttachmentPtr attachment;               // Encoded attachment
+            std::list<std::string>::iterator lruPosition; // Position in LRU list
+        };
+        struct AttachmentCache
+        {
+            std::mutex cacheLock;                                          // Cache access mutex
+            std::unordered_map<std::string, AttachmentCacheEntry> entries; // Cache entries (keyed on path, type and encoding)
+            std::list<std::string> lruList;                                // Most recently used at front
+            std::uintmax_t cacheSize{0};                                   // Total encoded bytes cached
+            std::uintmax_t cacheLimit{kAttachmentCacheLimit};              // Maximum encoded bytes cached
+            std::uintmax_t spillSize{kAttachmentSpillSize};                // Encoded size above which spill to file
+        };
+        // Email payload segment; either owned text, a view onto text held elsewhere
+        // (mail template, recipient) or a shared pre-encoded attachment
+        struct PayloadSegment
+        {
+            PayloadSegment(const std::string &segmentText) : text{segmentText} {}
+            PayloadSegment(std::string &&segmentText) : text{std::move(segmentText)} {}
+            PayloadSegment(const char *segmentText) : text{segmentText} {}
+            PayloadSegment(std::string_view segmentView) : view{segmentView}, isView{true} {}
+            PayloadSegment(const EncodedAttachmentPtr &encodedAttachment) : attachment{encodedAttachment} {}
+            std::string text;                // Segment text
+            std::string_view view;           // Segment text view
+            bool isView{false};              // == true segment is a view
+            EncodedAttachmentPtr attachment; // Pre-encoded attachment
+        };
+        // Compiled email template part
+        struct TemplatePart
+        {
+            enum Kind
+            {
+                Text = 0,    // Static text
+                Date,        // Per message date
+                ToAddress,   // Per recipient To address
+                Subject,     // Per recipient subject (with {{name}} substitutions)
+                Placeholder, // Per recipient {{name}} substitution
+                Attachment   // Pre-encoded attachment
+            };
+            Kind kind{Text};                 // Part kind
+            std::string text;                // Static text or placeholder name
+            EncodedAttachmentPtr attachment; // Pre-encoded attachment
+        };
+        // Email payload and current read position within it
+        struct MailPayload
+        {
+            std::deque<PayloadSegment> segments; // Email payload segments
+            std::uintmax_t segmentOffset{0};     // Offset into front segment
+            std::ifstream spillFile;             // Spilled attachment being read
+            std::uintmax_t size(void) const;
+            void clear(void);
         };
         static const char *kMimeBoundary;             // Text string used for MIME boundary
         static const int kBase64EncodeBufferSize{54}; // Optimum encode buffer size (since encoded max 76 bytes)
         static const char *kEOL;                      // End of line
         static const char kCB64[];                    // Valid characters for base64 encode/decode.
+        static const char *kPlaceholderPrefix;        // Mail template placeholder prefix
+        static const char *kPlaceholderPostfix;       // Mail template placeholder postfix
+        static const char *kEncodedWordPrefix;        // RFC 2047 encoded word prefix
+        static const char *kEncodedWordPostfix;       // RFC 2047 encoded word postfix
+        static constexpr std::size_t kEncodedWordMaxBytes{45}; // Bytes per encoded word (75 characters encoded)
+        static const std::uintmax_t kAttachmentCacheLimit{64 * 1024 * 1024}; // Default attachment cache size limit
+        static const std::uintmax_t kAttachmentSpillSize{4 * 1024 * 1024};   // Default encoded size above which spill to file
         // ===========================================
         // DISABLED CONSTRUCTORS/DESTRUCTORS/OPERATORS
         // ===========================================
@@ -110,11 +216,32 @@ namespace Antik::SMTP
         // PRIVATE METHODS
         // ===============
         // Encode email attachment
-        void encodeAttachment(CSMTP::EmailAttachment &attachment);
-        // Add attachments to payload
+        static EncodedAttachmentPtr encodeAttachment(const CSMTP::EmailAttachment &attachment);
+        // Get encoded email attachment (from cache if present and unchanged)
+        static EncodedAttachmentPtr cachedAttachment(const CSMTP::EmailAttachment &attachment);
+        // Evict least recently used cached attachments until cache within a limit
+        static void evictAttachments(std::uintmax_t cacheLimit);
+        // Add text/fields with placeholders to mail template
+        void appendTemplateText(const std::string &text);
+        void appendTemplateField(const std::string &field);
+        // Add attachments to mail template
         void buildAttachments(void);
-        // Construct email payload
-        void buildMailPayload(void);
+        // Construct email template
+        void buildMailTemplate(void);
+        // Check/RFC 2047 encode header values and substitute placeholders
+        static void checkHeaderValue(const std::string &value);
+        static std::string encodeHeaderText(const std::string &text);
+        static std::string encodeHeaderAddress(const std::string &addresses);
+        static std::string substitutePlaceholders(const std::string &text, const Substitutions &substitutions);
+        // Construct email payload for a recipient from template
+        void buildMailPayload(const std::vector<TemplatePart> &mailTemplate, const std::string &addressTo, const Substitutions &substitutions);
+        // Send email payload / read it into a string
+        void transferMail(const std::string &addressTo);
+        void transferMailCurl(const std::string &addressTo);
+        void transferMailNative(const std::string &addressTo);
+        // Connect native transport
+        void connectNative(void);
+        std::string readMailPayload(void);
         // libcurl read callback for payload
         static size_t payloadSource(char *ptr, size_t size, size_t nmemb, void *userData);
         // Date and time for email
@@ -138,8 +265,17 @@ namespace Antik::SMTP
         Antik::Network::CCurl m_connection;                       // Connection handle
         Antik::Network::CCurl::StringList m_recipientsList{NULL}; // Email recipients list
         static bool m_curlVerbosity;                              // curl verbosity setting        // Curl verbosity flag.
-        std::deque<std::string> m_mailPayload;                    // Email payload
+        MailPayload m_mailPayload;                                // Email payload
+        std::vector<TemplatePart> m_mailTemplate;                 // Email template (rebuilt for each plain post)
+        std::vector<TemplatePart> m_compiledTemplate;             // Compiled email template
+        bool m_compiledBinaryPayload{false};                      // == true compiled template has raw binary attachments
+        Transport m_transport{Transport::libcurl};                // Email transport
+        bool m_tlsRequired{true};                                 // == true connection must use TLS
+        bool m_binaryMIME{false};                                 // == true transport can send binary attachments raw
+        bool m_binaryPayload{false};                              // == true payload has raw binary attachments
+        std::unique_ptr<CSMTPClient> m_nativeClient;              // Native SMTP client
         std::vector<CSMTP::EmailAttachment> m_attachedFiles;      // Attached files
+        static AttachmentCache m_attachmentCache;                 // Shared pre-encoded attachment cache
     };
 } // namespace Antik::SMTP
 #endif /* CSMTP_HPP */
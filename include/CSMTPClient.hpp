@@ -0,0 +1,143 @@
+#ifndef CSMTPCLIENT_HPP
+#define CSMTPCLIENT_HPP
+//
+// C++ STL
+//
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <functional>
+#include <memory>
+//
+// Antik classes
+//
+#include "CommonAntik.hpp"
+#include "CSocket.hpp"
+// =========
+// NAMESPACE
+// =========
+namespace Antik::SMTP
+{
+    // ================
+    // CLASS DEFINITION
+    // ================
+    class CSMTPClient
+    {
+    public:
+        // ==========================
+        // PUBLIC TYPES AND CONSTANTS
+        // ==========================
+        //
+        // Class exception
+        //
+        struct Exception : public std::runtime_error
+        {
+            explicit Exception(std::string const &message)
+                : std::runtime_error("CSMTPClient Failure: " + message)
+            {
+            }
+        };
+        //
+        // Server capabilities (from EHLO response)
+        //
+        struct Capabilities
+        {
+            bool pipelining{false};                  // PIPELINING (RFC 2920)
+            bool chunking{false};                    // CHUNKING/BDAT (RFC 3030)
+            bool binaryMIME{false};                  // BINARYMIME (RFC 3030)
+            bool eightBitMIME{false};                // 8BITMIME (RFC 6152)
+            bool startTLS{false};                    // STARTTLS (RFC 3207)
+            bool size{false};                        // SIZE (RFC 1870)
+            std::uintmax_t maximumSize{0};           // SIZE maximum (0 == no limit)
+            std::vector<std::string> authMechanisms; // AUTH mechanisms
+        };
+        //
+        // Message source function; fills buffer and returns bytes copied (0 == end of message).
+        //
+        using MessageSourceFn = std::function<std::size_t(char *buffer, std::size_t bufferSize)>;
+        // ============
+        // CONSTRUCTORS
+        // ============
+        //
+        // Main constructor
+        //
+        CSMTPClient();
+        // ==========
+        // DESTRUCTOR
+        // ==========
+        virtual ~CSMTPClient();
+        // ==============
+        // PUBLIC METHODS
+        // ==============
+        // Set server URL (smtp://host:port or smtps://host:port) and account details
+        void setServer(const std::string &serverURL);
+        void setUserAndPassword(const std::string &userName, const std::string &userPassword);
+        // Fail if the connection cannot be secured with TLS
+        void setTLSRequired(bool tlsRequired);
+        // Set BDAT chunk size
+        void setChunkSize(std::size_t chunkSize);
+        // Connect/disconnect server
+        void connect(void);
+        void disconnect(void);
+        bool isConnected(void) const;
+        // Send a message to recipients
+        void sendMail(const std::string &addressFrom, const std::vector<std::string> &recipients,
+                      MessageSourceFn messageSource, bool binaryMessage = false, std::uintmax_t messageSize = 0);
+        // Server capabilities, last response and status code
+        const Capabilities &getCapabilities(void) const;
+        std::string getLastResponse(void) const;
+        std::uint16_t getLastStatusCode(void) const;
+        // ================
+        // PUBLIC VARIABLES
+        // ================
+    private:
+        // ===========================
+        // PRIVATE TYPES AND CONSTANTS
+        // ===========================
+        static const char *kEOL;                          // End of line
+        static const std::size_t kReadBufferSize{4096};   // Response read buffer size
+        static const std::size_t kDefaultChunkSize{1024 * 1024}; // Default BDAT chunk size
+        static const int kMaximumOutstandingChunks{32};   // Maximum pipelined BDAT commands awaiting a reply
+        // ===========================================
+        // DISABLED CONSTRUCTORS/DESTRUCTORS/OPERATORS
+        // ===========================================
+        CSMTPClient(const CSMTPClient &orig) = delete;
+        CSMTPClient(const CSMTPClient &&orig) = delete;
+        CSMTPClient &operator=(CSMTPClient other) = delete;
+        // ===============
+        // PRIVATE METHODS
+        // ===============
+        // Socket write of whole buffer
+        void writeAll(const char *buffer, std::size_t length);
+        // Send command / read response
+        void sendCommand(const std::string &command);
+        std::uint16_t readResponse(void);
+        std::uint16_t command(const std::string &command);
+        // Connection setup
+        void ehlo(void);
+        void startTLS(void);
+        void authenticate(void);
+        // Message body transfer
+        void sendData(MessageSourceFn &messageSource);
+        void sendChunks(MessageSourceFn &messageSource);
+        // Angle bracket an address
+        static std::string pathAddress(const std::string &address);
+        // =================
+        // PRIVATE VARIABLES
+        // =================
+        std::string m_serverURL;                    // SMTP server URL
+        std::string m_userName;                     // Email account user name
+        std::string m_userPassword;                 // Email account user name password
+        bool m_tlsRequired{true};                   // == true TLS must be used
+        bool m_implicitTLS{false};                  // == true TLS from connect (smtps)
+        bool m_connected{false};                    // == true connected to server
+        std::size_t m_chunkSize{kDefaultChunkSize}; // BDAT chunk size
+        Capabilities m_capabilities;                // Server capabilities
+        std::string m_lastResponse;                 // Last server response
+        std::uint16_t m_lastStatusCode{0};          // Last server response status code
+        std::string m_readBuffer;                   // Buffered server response data
+        std::unique_ptr<char[]> m_ioBuffer;         // Message IO buffer
+        Antik::Network::CSocket m_socket;           // Server connection
+    };
+} // namespace Antik::SMTP
+#endif /* CSMTPCLIENT_HPP */
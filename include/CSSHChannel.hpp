@@ -85,6 +85,7 @@ namespace Antik::SSH
         void requestTerminal();
         void changeTerminalSize(int columns, int rows);
         void requestShell();
+        void requestSubsystem(const std::string &subsystem);
         void execute(const std::string &commandToRun);
         void setEnvironmentVariable(const std::string &variable, const std::string &value);
         //
@@ -103,6 +104,7 @@ namespace Antik::SSH
         static void listenForward(CSSHSession &session, const std::string &address, int port, int *boundPort);
         static void cancelForward(CSSHSession &session, const std::string &address, int port);
         static std::unique_ptr<CSSHChannel> acceptForward(CSSHSession &session, int timeout, int *port);
+        static std::unique_ptr<CSSHChannel> acceptOpenRequest(CSSHSession &session, ssh_message openRequest);
         //
         // Set IO buffer parameters.
         //
@@ -132,7 +134,7 @@ namespace Antik::SSH
         // PRIVATE METHODS
         // ===============
         //
-        // Private constructor (used to return channel from acceptForward)
+        // Private constructor (used to return channel from acceptForward/acceptOpenRequest)
         //
         explicit CSSHChannel(CSSHSession &session, ssh_channel channel);
         // =================
@@ -0,0 +1,192 @@
+#ifndef CSSHFORWARDER_HPP
+#define CSSHFORWARDER_HPP
+//
+// C++ STL
+//
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <atomic>
+#include <exception>
+//
+// Antik classes
+//
+#include "CommonAntik.hpp"
+#include "CSSHSession.hpp"
+#include "CSSHChannel.hpp"
+// =========
+// NAMESPACE
+// =========
+namespace Antik::SSH
+{
+    // ================
+    // CLASS DEFINITION
+    // ================
+    class CSSHForwarder
+    {
+    public:
+        // ==========================
+        // PUBLIC TYPES AND CONSTANTS
+        // ==========================
+        //
+        // Class exception
+        //
+        struct Exception
+        {
+            Exception(const std::string &errorMessage, const std::string &functionName) : m_errorMessage{errorMessage},
+                                                                                          m_functionName{functionName}
+            {
+            }
+            std::string getMessage() const
+            {
+                return static_cast<std::string>("CSSHForwarder Failure: (") + m_functionName + ") [" + m_errorMessage + "]";
+            }
+
+        private:
+            std::string m_errorMessage; // Error message
+            std::string m_functionName; // Current function name
+        };
+        // ============
+        // CONSTRUCTORS
+        // ============
+        //
+        // Main constructor
+        //
+        explicit CSSHForwarder(CSSHSession &session);
+        // ==========
+        // DESTRUCTOR
+        // ==========
+        virtual ~CSSHForwarder();
+        // ==============
+        // PUBLIC METHODS
+        // ==============
+        //
+        // Add local (local listen -> remote host) and reverse (remote listen -> local host)
+        // forwards; returns the port bound (useful when 0 is passed). Call before run().
+        //
+        int addLocalForward(const std::string &localAddress, int localPort, const std::string &remoteHost, int remotePort);
+        int addRemoteForward(const std::string &remoteAddress, int remotePort, const std::string &localHost, int localPort);
+        //
+        // Run event loop until stopped (stop() may be called from another thread).
+        //
+        void run();
+        void stop();
+        //
+        // Forwarding status
+        //
+        std::size_t getConnectionCount() const;
+        //
+        // Set IO buffer parameters.
+        //
+        void setIoBufferSize(std::uint32_t ioBufferSize);
+        std::uint32_t getIoBufferSize() const;
+        // ================
+        // PUBLIC VARIABLES
+        // ================
+    private:
+        // ===========================
+        // PRIVATE TYPES AND CONSTANTS
+        // ===========================
+        //
+        // Local listening socket and the remote host/port its connections forward to.
+        //
+        struct Listener
+        {
+            int socket{-1};
+            std::string remoteHost;
+            int remotePort{0};
+            short events{0};
+        };
+        //
+        // Reverse forward remote port and the local host/port its connections forward to.
+        //
+        struct RemoteForward
+        {
+            std::string remoteAddress;
+            int remotePort{0};
+            std::string localHost;
+            int localPort{0};
+        };
+        //
+        // Reverse forward channel accepted (from the message callback) awaiting connection
+        // to its local host/port.
+        //
+        struct AcceptedForward
+        {
+            std::unique_ptr<CSSHChannel> channel;
+            std::size_t remoteForward{0};
+        };
+        //
+        // Forwarded connection (local socket <-> channel). Channel data not yet written to
+        // the socket is held in socketBuffer; while it is non-empty no more is taken from
+        // the channel so the SSH window closes and the remote sender is held back.
+        // Likewise the socket is only read while the channel window is open.
+        //
+        struct Connection
+        {
+            int socket{-1};
+            std::unique_ptr<CSSHChannel> channel;
+            struct ssh_channel_callbacks_struct callbacks{};
+            std::vector<char> socketBuffer;
+            std::size_t socketBufferOffset{0};
+            bool socketEndOfFile{false};
+            bool socketShutdown{false};
+            bool channelEndOfFile{false};
+            bool closed{false};
+            short registeredEvents{0};
+            short events{0};
+        };
+        // ===========================================
+        // DISABLED CONSTRUCTORS/DESTRUCTORS/OPERATORS
+        // ===========================================
+        CSSHForwarder() = delete;
+        CSSHForwarder(const CSSHForwarder &orig) = delete;
+        CSSHForwarder(const CSSHForwarder &&orig) = delete;
+        CSSHForwarder &operator=(CSSHForwarder other) = delete;
+        // ===============
+        // PRIVATE METHODS
+        // ===============
+        //
+        // Socket helpers
+        //
+        static int listenSocket(const std::string &address, int port, int &boundPort);
+        static int connectSocket(const std::string &host, int port);
+        static void socketAddress(int socket, bool peer, std::string &host, int &port);
+        //
+        // libssh event/channel callbacks
+        //
+        static int wakeEvent(socket_t fd, int revents, void *userdata);
+        static int listenerEvent(socket_t fd, int revents, void *userdata);
+        static int connectionEvent(socket_t fd, int revents, void *userdata);
+        static int channelData(ssh_session session, ssh_channel channel, void *data, uint32_t len, int is_stderr, void *userdata);
+        static void channelEndOfFile(ssh_session session, ssh_channel channel, void *userdata);
+        static void channelClose(ssh_session session, ssh_channel channel, void *userdata);
+        static int sessionMessage(ssh_session session, ssh_message message, void *userdata);
+        //
+        // Connection handling
+        //
+        void acceptLocal(Listener &listener);
+        void acceptRemote();
+        void addConnection(int socket, std::unique_ptr<CSSHChannel> channel);
+        void socketRead(Connection &connection);
+        void socketWrite(Connection &connection);
+        bool updateConnection(Connection &connection);
+        void removeConnection(Connection &connection);
+        // =================
+        // PRIVATE VARIABLES
+        // =================
+        CSSHSession &m_session;                               // Forwarding session
+        ssh_event m_event{nullptr};                           // libssh event (valid while running)
+        int m_wakeEvent{-1};                                  // eventfd used to wake event loop
+        std::atomic<bool> m_stop{false};                      // == true stop event loop
+        std::vector<std::unique_ptr<Listener>> m_listeners;   // Local forward listeners
+        std::vector<RemoteForward> m_remoteForwards;          // Reverse forwards
+        std::vector<AcceptedForward> m_acceptedForwards;      // Reverse forward channels accepted
+        std::list<std::unique_ptr<Connection>> m_connections; // Forwarded connections
+        std::atomic<std::size_t> m_connectionCount{0};        // Forwarded connection count
+        std::unique_ptr<char[]> m_ioBuffer;                   // IO buffer
+        std::uint32_t m_ioBufferSize{32 * 1024};              // IO buffer size
+    };
+} // namespace Antik::SSH
+#endif /* CSSHFORWARDER_HPP */
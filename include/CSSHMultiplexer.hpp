@@ -0,0 +1,243 @@
+#ifndef CSSHMULTIPLEXER_HPP
+#define CSSHMULTIPLEXER_HPP
+//
+// C++ STL
+//
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <future>
+#include <exception>
+#include <type_traits>
+//
+// Antik classes
+//
+#include "CommonAntik.hpp"
+#include "CSSHSession.hpp"
+#include "CSSHChannel.hpp"
+#include "CSFTP.hpp"
+// =========
+// NAMESPACE
+// =========
+namespace Antik::SSH
+{
+    // ================
+    // CLASS DEFINITION
+    // ================
+    class CSSHMultiplexer
+    {
+    public:
+        // ==========================
+        // PUBLIC TYPES AND CONSTANTS
+        // ==========================
+        //
+        // Class exception
+        //
+        struct Exception
+        {
+            Exception(const std::string &errorMessage, const std::string &functionName) : m_errorMessage{errorMessage},
+                                                                                          m_functionName{functionName}
+            {
+            }
+            std::string getMessage() const
+            {
+                return static_cast<std::string>("CSSHMultiplexer Failure: (") + m_functionName + ") [" + m_errorMessage + "]";
+            }
+
+        private:
+            std::string m_errorMessage; // Error message
+            std::string m_functionName; // Current function name
+        };
+        //
+        // Multiplexed channel handle and remote command result
+        //
+        using ChannelId = std::uint64_t;
+        struct CommandResult
+        {
+            int exitStatus{-1};
+            std::string output;
+            std::string error;
+        };
+        // ============
+        // CONSTRUCTORS
+        // ============
+        //
+        // Main constructor
+        //
+        explicit CSSHMultiplexer(CSSHSession &session);
+        // ==========
+        // DESTRUCTOR
+        // ==========
+        virtual ~CSSHMultiplexer();
+        // ==============
+        // PUBLIC METHODS
+        // ==============
+        //
+        // Run a function with the session (or the shared SFTP session) on the IO thread.
+        //
+        template <typename Fn>
+        std::future<std::invoke_result_t<Fn, CSSHSession &>> submit(Fn fn);
+        template <typename Fn>
+        std::future<std::invoke_result_t<Fn, CSFTP &>> submitSFTP(Fn fn);
+        //
+        // Channel operations; read returns up to bytesToRead once data is available
+        // (an empty string at end of file) without holding up other operations.
+        //
+        std::future<ChannelId> openChannel();
+        std::future<void> closeChannel(ChannelId channelId);
+        std::future<void> execute(ChannelId channelId, const std::string &commandToRun);
+        std::future<std::string> read(ChannelId channelId, std::uint32_t bytesToRead, bool isStdErr = false);
+        std::future<void> write(ChannelId channelId, const std::string &data);
+        std::future<void> sendEndOfFile(ChannelId channelId);
+        std::future<int> getExitStatus(ChannelId channelId);
+        //
+        // Run a command on its own channel and return its exit status and output.
+        //
+        std::future<CommandResult> executeCommand(const std::string &commandToRun);
+        //
+        // Stop IO thread; operations not yet complete fail with an exception.
+        //
+        void stop();
+        // ================
+        // PUBLIC VARIABLES
+        // ================
+    private:
+        // ===========================
+        // PRIVATE TYPES AND CONSTANTS
+        // ===========================
+        static constexpr int kPollTimeout{100}; // Session poll timeout (milliseconds)
+        //
+        // Submitted operation. run() returns false if the operation cannot complete yet
+        // (it is then retried when the session next has activity).
+        //
+        struct Operation
+        {
+            virtual ~Operation() = default;
+            virtual bool run(CSSHMultiplexer &multiplexer) = 0;
+            virtual void fail(std::exception_ptr exception) = 0;
+            Operation *next{nullptr};
+        };
+        template <typename Result, typename Fn>
+        struct FunctionOperation : public Operation
+        {
+            explicit FunctionOperation(Fn fn) : m_fn{std::move(fn)}
+            {
+            }
+            bool run(CSSHMultiplexer &multiplexer) override;
+            void fail(std::exception_ptr exception) override
+            {
+                m_promise.set_exception(exception);
+            }
+            Fn m_fn;
+            std::promise<Result> m_promise;
+        };
+        // ===========================================
+        // DISABLED CONSTRUCTORS/DESTRUCTORS/OPERATORS
+        // ===========================================
+        CSSHMultiplexer() = delete;
+        CSSHMultiplexer(const CSSHMultiplexer &orig) = delete;
+        CSSHMultiplexer(const CSSHMultiplexer &&orig) = delete;
+        CSSHMultiplexer &operator=(CSSHMultiplexer other) = delete;
+        // ===============
+        // PRIVATE METHODS
+        // ===============
+        //
+        // Operation submission and IO thread
+        //
+        template <typename Result, typename Fn>
+        std::future<Result> submitOperation(Fn fn);
+        void enqueue(Operation *operation);
+        void ioThread();
+        void failOperations(Operation *operations, std::exception_ptr exception);
+        static Operation *reverse(Operation *operations);
+        static int wakeEvent(socket_t fd, int revents, void *userdata);
+        CSSHChannel &getChannel(ChannelId channelId);
+        CSFTP &getSFTP();
+        // =================
+        // PRIVATE VARIABLES
+        // =================
+        CSSHSession &m_session;                                      // Shared session (IO thread only)
+        std::atomic<Operation *> m_submitted{nullptr};               // Lock-free (LIFO) submission list
+        std::list<std::unique_ptr<Operation>> m_waiting;             // Operations waiting on session (IO thread only)
+        std::map<ChannelId, std::unique_ptr<CSSHChannel>> m_channels; // Open channels (IO thread only)
+        ChannelId m_nextChannelId{1};                                // Next channel handle (IO thread only)
+        std::unique_ptr<CSFTP> m_sftp;                               // Shared SFTP session (IO thread only)
+        std::atomic<bool> m_stop{false};                             // == true stop IO thread
+        std::atomic<bool> m_stopped{false};                          // == true IO thread has stopped
+        std::exception_ptr m_thrownException{nullptr};               // Exception that stopped IO thread
+        int m_wakeEvent{-1};                                         // eventfd used to wake IO thread
+        std::thread m_ioThread;                                      // IO thread
+    };
+    //
+    // Run a function operation; the result (or exception) is passed back through its promise.
+    // A function returning a std::pair<bool, Result> (channel reads) reports whether it has
+    // completed; any other function always completes.
+    //
+    template <typename Result, typename Fn>
+    bool CSSHMultiplexer::FunctionOperation<Result, Fn>::run(CSSHMultiplexer &multiplexer)
+    {
+        try
+        {
+            using FnResult = std::invoke_result_t<Fn, CSSHMultiplexer &>;
+            if constexpr (std::is_void_v<FnResult>)
+            {
+                m_fn(multiplexer);
+                m_promise.set_value();
+            }
+            else if constexpr (std::is_same_v<FnResult, std::pair<bool, Result>>)
+            {
+                auto [complete, result] = m_fn(multiplexer);
+                if (!complete)
+                {
+                    return (false);
+                }
+                m_promise.set_value(std::move(result));
+            }
+            else
+            {
+                m_promise.set_value(m_fn(multiplexer));
+            }
+        }
+        catch (...)
+        {
+            m_promise.set_exception(std::current_exception());
+        }
+        return (true);
+    }
+    //
+    // Queue an operation for the IO thread and return a future for its result.
+    //
+    template <typename Result, typename Fn>
+    std::future<Result> CSSHMultiplexer::submitOperation(Fn fn)
+    {
+        auto operation = new FunctionOperation<Result, Fn>(std::move(fn));
+        std::future<Result> result{operation->m_promise.get_future()};
+        enqueue(operation);
+        return (result);
+    }
+    //
+    // Run a function with the session on the IO thread.
+    //
+    template <typename Fn>
+    std::future<std::invoke_result_t<Fn, CSSHSession &>> CSSHMultiplexer::submit(Fn fn)
+    {
+        return (submitOperation<std::invoke_result_t<Fn, CSSHSession &>>([fn = std::move(fn)](CSSHMultiplexer &multiplexer) mutable {
+            return (fn(multiplexer.m_session));
+        }));
+    }
+    //
+    // Run a function with the shared SFTP session (opened on first use) on the IO thread.
+    //
+    template <typename Fn>
+    std::future<std::invoke_result_t<Fn, CSFTP &>> CSSHMultiplexer::submitSFTP(Fn fn)
+    {
+        return (submitOperation<std::invoke_result_t<Fn, CSFTP &>>([fn = std::move(fn)](CSSHMultiplexer &multiplexer) mutable {
+            return (fn(multiplexer.getSFTP()));
+        }));
+    }
+} // namespace Antik::SSH
+#endif /* CSSHMULTIPLEXER_HPP */
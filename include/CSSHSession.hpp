@@ -105,6 +105,7 @@ namespace Antik::SSH
         void setPort(unsigned int port);
         void setUser(const std::string &user);
         void setUserPassword(const std::string &password);
+        std::string getUserPassword() const;
         //
         // Connect/disconnect sessions
         //
@@ -162,12 +163,14 @@ namespace Antik::SSH
         int getStatus() const;
         bool isConnected() const;
         bool isAuthorized() const;
+        void sendKeepAlive();
         //
         // Get/Set option values for a session and also copy options,
         //
         void setOption(Option sessionOption, const void *optionValue);
         void getOption(Option sessionOption, std::string &optionValue);
         void copyOptions(CSSHSession &source);
+        long getTimeout() const;
         //
         // Get SSH error code and message
         //
@@ -192,6 +195,7 @@ namespace Antik::SSH
         // ===========================
         // PRIVATE TYPES AND CONSTANTS
         // ===========================
+        static constexpr int kKeepAliveTimeout{5000}; // Keepalive flush timeout (milliseconds)
         // ===========================================
         // DISABLED CONSTRUCTORS/DESTRUCTORS/OPERATORS
         // ===========================================
@@ -214,6 +218,7 @@ namespace Antik::SSH
         unsigned int m_port{22};                                        // SSH server port
         std::string m_user;                                             // SSH server login account name
         std::string m_password;                                         // SSH server login account password
+        long m_timeout{0};                                              // SSH_OPTIONS_TIMEOUT set (seconds, 0 libssh default)
         bool m_authorized{false};                                       // SSH session authorised
         std::uint32_t m_authorizarionType{UserAuthorizationType::None}; // SSH session user authorization type
     };
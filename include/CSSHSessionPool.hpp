@@ -0,0 +1,190 @@
+#ifndef CSSHSESSIONPOOL_HPP
+#define CSSHSESSIONPOOL_HPP
+//
+// C++ STL
+//
+#include <string>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <functional>
+//
+// Antik classes
+//
+#include "CommonAntik.hpp"
+#include "CSSHSession.hpp"
+#include "SSHSessionUtil.hpp"
+// =========
+// NAMESPACE
+// =========
+namespace Antik::SSH
+{
+    // ================
+    // CLASS DEFINITION
+    // ================
+    class CSSHSessionPool
+    {
+        struct PooledSession;
+
+    public:
+        // ==========================
+        // PUBLIC TYPES AND CONSTANTS
+        // ==========================
+        //
+        // Class exception
+        //
+        struct Exception
+        {
+            Exception(const std::string &errorMessage, const std::string &functionName) : m_errorMessage{errorMessage},
+                                                                                          m_functionName{functionName}
+            {
+            }
+            std::string getMessage() const
+            {
+                return static_cast<std::string>("CSSHSessionPool Failure: (") + m_functionName + ") [" + m_errorMessage + "]";
+            }
+
+        private:
+            std::string m_errorMessage; // Error message
+            std::string m_functionName; // Current function name
+        };
+        //
+        // Create a new (unconnected) session; override to use a CSSHSession derived class.
+        //
+        using SessionFactory = std::function<std::unique_ptr<CSSHSession>()>;
+        //
+        // A session on loan from the pool. It is returned to the pool when the lease is
+        // destroyed (or released); call invalidate() if the session should not be reused
+        // (for example after an error part way through a transfer).
+        //
+        class Lease
+        {
+        public:
+            Lease() = default;
+            Lease(Lease &&other) noexcept;
+            Lease &operator=(Lease &&other) noexcept;
+            ~Lease();
+            CSSHSession &operator*() const;
+            CSSHSession *operator->() const;
+            CSSHSession &getSession() const;
+            void invalidate();
+            void release();
+            explicit operator bool() const;
+
+        private:
+            friend class CSSHSessionPool;
+            Lease(CSSHSessionPool *pool, std::unique_ptr<PooledSession> pooledSession);
+            Lease(const Lease &other) = delete;
+            Lease &operator=(const Lease &other) = delete;
+            CSSHSessionPool *m_pool{nullptr};              // Owning pool
+            std::unique_ptr<PooledSession> m_pooledSession; // Session on loan
+            bool m_reusable{true};                         // == true return session for reuse
+        };
+        // ============
+        // CONSTRUCTORS
+        // ============
+        //
+        // Main constructor
+        //
+        explicit CSSHSessionPool(ServerVerificationContext &verificationContext, SessionFactory sessionFactory = nullptr);
+        // ==========
+        // DESTRUCTOR
+        // ==========
+        virtual ~CSSHSessionPool();
+        // ==============
+        // PUBLIC METHODS
+        // ==============
+        //
+        // Get a connected, verified and authorized session with the same server/port/user/
+        // authorization options as the passed in (unconnected) session. An idle pooled
+        // session is reused when there is one; otherwise a new one is created unless the
+        // host is at its session limit, in which case it waits for one to be returned.
+        //
+        Lease acquire(CSSHSession &options);
+        //
+        // Disconnect idle sessions that have been idle longer than the maximum idle time.
+        //
+        void prune();
+        //
+        // Pool status
+        //
+        std::size_t getIdleCount() const;
+        std::size_t getActiveCount() const;
+        //
+        // Set pool parameters
+        //
+        void setMaxSessionsPerHost(std::size_t maxSessionsPerHost);
+        std::size_t getMaxSessionsPerHost() const;
+        void setMaxIdleTime(std::chrono::seconds maxIdleTime);
+        std::chrono::seconds getMaxIdleTime() const;
+        void setHealthCheckInterval(std::chrono::seconds healthCheckInterval);
+        std::chrono::seconds getHealthCheckInterval() const;
+        // ================
+        // PUBLIC VARIABLES
+        // ================
+    protected:
+        // =================
+        // PROTECTED METHODS
+        // =================
+        //
+        // Session operations the pool performs; override to change how sessions are
+        // connected/verified/authorized or checked. Idle sessions left when the pool is
+        // destroyed are disconnected with disconnectSession() of this class.
+        //
+        virtual void connectSession(CSSHSession &session);
+        virtual bool isSessionConnected(CSSHSession &session);
+        virtual void keepSessionAlive(CSSHSession &session);
+        virtual void disconnectSession(CSSHSession &session);
+
+    private:
+        // ===========================
+        // PRIVATE TYPES AND CONSTANTS
+        // ===========================
+        //
+        // Pooled session; key identifies server/port/user/authorization options and host
+        // the server/port its per host limit is counted against.
+        //
+        struct PooledSession
+        {
+            std::string key;
+            std::string host;
+            std::unique_ptr<CSSHSession> session;
+            std::chrono::steady_clock::time_point lastUsed;
+        };
+        // ===========================================
+        // DISABLED CONSTRUCTORS/DESTRUCTORS/OPERATORS
+        // ===========================================
+        CSSHSessionPool() = delete;
+        CSSHSessionPool(const CSSHSessionPool &orig) = delete;
+        CSSHSessionPool(const CSSHSessionPool &&orig) = delete;
+        CSSHSessionPool &operator=(CSSHSessionPool other) = delete;
+        // ===============
+        // PRIVATE METHODS
+        // ===============
+        static void sessionKey(CSSHSession &options, std::string &key, std::string &host);
+        void disconnect(std::unique_ptr<PooledSession> pooledSession);
+        std::unique_ptr<PooledSession> takeIdle(const std::string &key, std::list<std::unique_ptr<PooledSession>> &expired);
+        bool evictIdle(const std::string &host, std::list<std::unique_ptr<PooledSession>> &expired);
+        void connect(PooledSession &pooledSession, CSSHSession &options);
+        bool isHealthy(PooledSession &pooledSession, std::chrono::seconds healthCheckInterval);
+        void release(std::unique_ptr<PooledSession> pooledSession, bool reusable);
+        // =================
+        // PRIVATE VARIABLES
+        // =================
+        ServerVerificationContext &m_verificationContext;              // Server verification
+        std::mutex m_verificationMutex;                                // Serialize server verification
+        SessionFactory m_sessionFactory;                               // New session factory
+        mutable std::mutex m_poolMutex;                                // Pool mutex
+        std::condition_variable m_sessionReleased;                     // Signalled when a host session is freed
+        std::list<std::unique_ptr<PooledSession>> m_idleSessions;      // Idle sessions (most recently used first)
+        std::map<std::string, std::size_t> m_hostSessionCount;         // Sessions (idle/active/connecting) per host
+        std::size_t m_activeCount{0};                                  // Sessions on loan
+        std::size_t m_maxSessionsPerHost{4};                           // Per host session limit
+        std::chrono::seconds m_maxIdleTime{300};                       // Idle session lifetime
+        std::chrono::seconds m_healthCheckInterval{30};                // Keepalive sessions idle longer than this
+    };
+} // namespace Antik::SSH
+#endif /* CSSHSESSIONPOOL_HPP */
@@ -0,0 +1,138 @@
+#ifndef CTAR_HPP
+#define CTAR_HPP
+//
+// C++ STL
+//
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <functional>
+#include <cstdint>
+//
+// Antik classes
+//
+#include "CommonAntik.hpp"
+#include "CommonUtil.hpp"
+// =========
+// NAMESPACE
+// =========
+namespace Antik::File
+{
+    // ================
+    // CLASS DEFINITION
+    // ================
+    class CTar
+    {
+    public:
+        // ==========================
+        // PUBLIC TYPES AND CONSTANTS
+        // ==========================
+        //
+        // Class exception
+        //
+        struct Exception : public std::runtime_error
+        {
+            explicit Exception(std::string const &message)
+                : std::runtime_error("CTar Failure: " + message)
+            {
+            }
+        };
+        //
+        // Archive entry
+        //
+        enum class EntryType
+        {
+            regular = 0,
+            directory,
+            symbolicLink,
+            other
+        };
+        struct Entry
+        {
+            std::string name;                   // Path name within archive
+            EntryType type{EntryType::regular}; // Entry type
+            std::uint64_t size{0};              // Data size (regular files)
+            std::uint32_t mode{0};              // Permissions
+            std::int64_t modifiedTime{0};       // Last modified time (seconds since epoch)
+            std::string linkName;               // Symbolic link target
+        };
+        //
+        // Archive stream IO; the read function returns bytes read (0 == end of stream).
+        //
+        using WriteFn = std::function<void(const char *buffer, std::size_t length)>;
+        using ReadFn = std::function<std::size_t(char *buffer, std::size_t length)>;
+        static constexpr std::size_t kBlockSize{512}; // Tar block size
+        // ==============
+        // PUBLIC METHODS
+        // ==============
+        //
+        // Pack a local directory tree into a tar stream / unpack a tar stream into a local directory.
+        //
+        static void pack(const std::string &localDirectory, const WriteFn &writeFn, FileCompletionFn completionFn = nullptr);
+        static void unpack(const std::string &localDirectory, const ReadFn &readFn, FileCompletionFn completionFn = nullptr);
+        // ================
+        // PUBLIC VARIABLES
+        // ================
+    private:
+        // ===========================
+        // PRIVATE TYPES AND CONSTANTS
+        // ===========================
+        static constexpr std::size_t kIoBufferSize{64 * 1024}; // Stream buffer size
+        //
+        // Buffered archive output/input
+        //
+        class Output
+        {
+        public:
+            explicit Output(const WriteFn &writeFn);
+            void write(const char *buffer, std::size_t length);
+            void pad(std::uint64_t length);
+            void flush();
+
+        private:
+            const WriteFn &m_writeFn;
+            std::vector<char> m_buffer;
+        };
+        class Input
+        {
+        public:
+            explicit Input(const ReadFn &readFn);
+            bool read(char *buffer, std::size_t length);
+            void skip(std::uint64_t length);
+            void drain();
+
+        private:
+            const ReadFn &m_readFn;
+            std::vector<char> m_buffer;
+            std::size_t m_position{0};
+            std::size_t m_length{0};
+        };
+        // ===========================================
+        // DISABLED CONSTRUCTORS/DESTRUCTORS/OPERATORS
+        // ===========================================
+        CTar() = delete;
+        CTar(const CTar &orig) = delete;
+        CTar(const CTar &&orig) = delete;
+        CTar &operator=(CTar other) = delete;
+        // ===============
+        // PRIVATE METHODS
+        // ===============
+        //
+        // Header encode/decode
+        //
+        static void encodeNumber(char *field, std::size_t fieldLength, std::uint64_t value);
+        static std::uint64_t decodeNumber(const char *field, std::size_t fieldLength);
+        static void setChecksum(char *header);
+        static bool checksumValid(const char *header);
+        static void writeLongName(Output &output, char typeFlag, const std::string &longName);
+        static void writeHeader(Output &output, const Entry &entry);
+        static bool readHeader(Input &input, Entry &entry);
+        static void parseExtendedHeader(const std::string &extendedHeader, Entry &entry, bool &sizeSet);
+        static bool safePath(const std::string &name);
+        static bool throughSymbolicLink(const std::string &localDirectory, const std::string &name);
+        // =================
+        // PRIVATE VARIABLES
+        // =================
+    };
+} // namespace Antik::File
+#endif /* CTAR_HPP */
@@ -7,6 +7,13 @@
 // C++ STL
 //
 #include <filesystem>
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <exception>
 //
 // Antik classes
 //
@@ -28,6 +35,21 @@ namespace Antik
     //
     typedef std::function<void(const std::string &)> FileFeedBackFn;
     //
+    // Aggregate statistics for a (parallel) multi-file transfer
+    //
+    struct TransferStatistics
+    {
+        std::uint64_t filesTransfered{0};    // Files transfered
+        std::uint64_t directoriesCreated{0}; // Directories created
+        std::uint64_t filesFailed{0};        // Files that failed to transfer
+        std::uint64_t bytesTransfered{0};    // Total bytes transfered
+        double elapsedSeconds{0.0};          // Elapsed time of transfer
+        double bytesPerSecond() const
+        {
+            return ((elapsedSeconds > 0.0) ? (bytesTransfered / elapsedSeconds) : 0.0);
+        }
+    };
+    //
     // Map files from to/from local/remote directories
     //
     class FileMapper
@@ -79,5 +101,61 @@ namespace Antik
             }
         }
     }
+    //
+    // Run a worker thread for each server/session in a list (libssh sessions are not thread
+    // safe so each is only used by its own worker); each takes the index of the next item to
+    // process from a shared queue and passes it with its server to the worker function.
+    // If the worker function throws (anything) no more items are started and the first
+    // exception is rethrown once every worker has finished. Returns elapsed time (seconds).
+    //
+    template <typename ServerList, typename WorkerFn>
+    static inline double runParallelWorkers(ServerList &servers, std::size_t itemCount, WorkerFn workerFn)
+    {
+        std::atomic<std::size_t> nextItem{0};
+        std::exception_ptr workerException;
+        std::mutex exceptionMutex;
+        std::vector<std::thread> workers;
+        auto start = std::chrono::steady_clock::now();
+        auto stopWorkers = [&](std::exception_ptr exception) {
+            std::scoped_lock exceptionLock(exceptionMutex);
+            if (!workerException)
+            {
+                workerException = exception;
+            }
+            nextItem = itemCount;
+        };
+        try
+        {
+            for (auto &server : servers)
+            {
+                workers.emplace_back([&, &workerServer = server.get()]() {
+                    try
+                    {
+                        for (std::size_t itemIndex; (itemIndex = nextItem++) < itemCount;)
+                        {
+                            workerFn(workerServer, itemIndex);
+                        }
+                    }
+                    catch (...)
+                    {
+                        stopWorkers(std::current_exception());
+                    }
+                });
+            }
+        }
+        catch (...)
+        {
+            stopWorkers(std::current_exception()); // Could not start a worker thread
+        }
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+        if (workerException)
+        {
+            std::rethrow_exception(workerException);
+        }
+        return (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
 } // namespace Antik
 #endif /* COMMONUTIL_HPP */
@@ -10,6 +10,7 @@
 #include <vector>
 #include <fstream>
 #include <vector>
+#include <functional>
 //
 // Boost file system, string
 //
@@ -26,9 +27,15 @@
 #include "CSCP.hpp"
 namespace Antik::SSH
 {
+    //
+    // SSH sessions used for a parallel transfer (libssh sessions are not thread safe so one per worker)
+    //
+    using SSHSessionList = std::vector<std::reference_wrapper<CSSHSession>>;
     void getFile(CSSHSession &sshSession, const std::string &sourceFile, const std::string &destinationFile);
     void putFile(CSSHSession &sshSession, const std::string &sourceFile, const std::string &destinationFile);
     FileList getFiles(CSSHSession &sshSession, FileMapper &fileMapper, FileCompletionFn completionFn = nullptr);
     FileList putFiles(CSSHSession &sshSession, FileMapper &fileMapper, FileCompletionFn completionFn = nullptr);
+    FileList getFilesParallel(SSHSessionList &sshSessions, FileMapper &fileMapper, const FileList &remoteFileList, FileCompletionFn completionFn = nullptr, TransferStatistics *statistics = nullptr);
+    FileList putFilesParallel(SSHSessionList &sshSessions, FileMapper &fileMapper, FileCompletionFn completionFn = nullptr, TransferStatistics *statistics = nullptr);
 } // namespace Antik::SSH
 #endif /* SCPUTIL_HPP */
@@ -10,6 +10,11 @@
 #include <vector>
 #include <fstream>
 #include <vector>
+#include <functional>
+#include <cstdint>
+#include <map>
+#include <tuple>
+#include <set>
 //
 // Boost file system, string
 //
@@ -26,10 +31,90 @@
 #include "CSFTP.hpp"
 namespace Antik::SSH
 {
+    //
+    // SFTP servers used for a parallel transfer (each opened on its own session)
+    //
+    using SFTPServerList = std::vector<std::reference_wrapper<CSFTP>>;
+    //
+    // Remote file entry returned by a listing (attributes from the directory read so that
+    // transfers of listed files need no further stat round trips).
+    //
+    struct RemoteFileEntry
+    {
+        enum class Type
+        {
+            regular = 0,
+            directory,
+            symbolicLink,
+            other
+        };
+        std::string path;              // Remote file path
+        Type type{Type::other};        // File type
+        std::uint64_t size{0};         // File size in bytes
+        std::uint32_t permissions{0};  // File permissions
+        std::uint64_t modifiedTime{0}; // Last modified time (seconds since epoch)
+    };
+    using RemoteFileEntryList = std::vector<RemoteFileEntry>;
+    //
+    // Error for a single path in a recursive remote tree operation
+    //
+    struct RemotePathError
+    {
+        std::string path;     // Remote path
+        int sftpErrorCode{0}; // SFTP error code (SSH_FX_*)
+        std::string message;  // Error message
+    };
+    using RemotePathErrorList = std::vector<RemotePathError>;
+    //
+    // Local file content hash cache. Hashes (SHA-256 unless another algorithm is asked for)
+    // are held per path with the device/inode/size/modified time they were taken at, so
+    // files unchanged since are not re-read; optionally persisted to a cache file. Entries
+    // for files that have since changed or gone are pruned when saved.
+    //
+    class FileHashCache
+    {
+    public:
+        explicit FileHashCache(const std::string &cacheFileName = "");
+        std::string getHash(const std::string &localFile, const std::string &algorithm = "sha256");
+        void setHash(const std::string &localFile, const std::string &fileHash, const std::string &algorithm = "sha256");
+        void prune();
+        void save();
+        std::size_t size() const;
+
+    private:
+        using FileKey = std::tuple<std::uint64_t, std::uint64_t, std::uint64_t, std::int64_t>;
+        struct CachedHashes
+        {
+            FileKey key;                               // Device, inode, size and modified time (ns)
+            std::map<std::string, std::string> hashes; // Hash for each algorithm
+        };
+        static bool fileKey(const std::string &localFile, FileKey &key);
+        std::string m_cacheFileName;
+        std::map<std::string, CachedHashes> m_fileHashes;
+        bool m_modified{false};
+    };
+    RemoteFileEntry remoteFileEntry(const std::string &filePath, const CSFTP::FileAttributes &fileAttributes);
+    std::vector<RemoteFileEntryList> remoteFileLevels(const RemoteFileEntryList &remoteFileList, const std::string &remotePath, bool includeSymbolicLinks);
+    std::vector<std::string> localFileHashes(const std::string &localFile, const std::string &algorithm = "sha256", std::uint64_t blockSize = 0);
     void listRemoteRecursive(CSFTP &sftpServer, const std::string &directoryPath, FileList &fileList, FileFeedBackFn remoteFileFeedbackFn = nullptr);
+    void listRemoteRecursive(CSFTP &sftpServer, const std::string &directoryPath, RemoteFileEntryList &fileList, FileFeedBackFn remoteFileFeedbackFn = nullptr);
     void getFile(CSFTP &sftpServer, const std::string &sourceFile, const std::string &destinationFile, FileCompletionFn completionFn = nullptr);
+    void getFile(CSFTP &sftpServer, const RemoteFileEntry &sourceFile, const std::string &destinationFile, FileCompletionFn completionFn = nullptr);
+    void getFileSegmented(SFTPServerList &sftpServers, const std::string &sourceFile, const std::string &destinationFile, std::uint64_t segmentSize = 64 * 1024 * 1024, FileCompletionFn completionFn = nullptr);
+    std::string segmentCheckpointIdentity(const CSFTP::FileAttributes &fileAttributes, std::uint64_t segmentSize);
+    std::set<std::uint64_t> readSegmentCheckpoint(const std::string &checkpointFile, const std::string &fileIdentity, std::uint64_t segmentCount);
     void putFile(CSFTP &sftpServer, const std::string &sourceFile, const std::string &destinationFile, FileCompletionFn completionFn = nullptr);
     FileList getFiles(CSFTP &sftpServer, FileMapper &fileMapper, const FileList &fileList, FileCompletionFn completionFn = nullptr, bool safe = false, char postFix = '~');
+    FileList getFiles(CSFTP &sftpServer, FileMapper &fileMapper, const RemoteFileEntryList &fileList, FileCompletionFn completionFn = nullptr, bool safe = false, char postFix = '~');
     FileList putFiles(CSFTP &sftpServer, FileMapper &fileMapper, const FileList &fileList, FileCompletionFn completionFn = nullptr, bool safe = false, char postFix = '~');
+    RemotePathErrorList removeRemoteRecursive(SFTPServerList &sftpServers, const std::string &remotePath);
+    RemotePathErrorList changePermissionsRecursive(SFTPServerList &sftpServers, const std::string &remotePath, const CSFTP::FilePermissions &filePermissions);
+    RemotePathErrorList changeOwnerGroupRecursive(SFTPServerList &sftpServers, const std::string &remotePath, const CSFTP::FileOwner &owner, const CSFTP::FileGroup &group);
+    FileList copyRemoteRecursive(CSFTP &sftpServer, const std::string &sourcePath, const std::string &destinationPath, FileCompletionFn completionFn = nullptr);
+    FileList getChangedFiles(CSFTP &sftpServer, FileMapper &fileMapper, const RemoteFileEntryList &fileList, FileHashCache &fileHashCache, FileCompletionFn completionFn = nullptr, bool safe = false, char postFix = '~');
+    FileList putChangedFiles(CSFTP &sftpServer, FileMapper &fileMapper, const FileList &fileList, FileHashCache &fileHashCache, FileCompletionFn completionFn = nullptr, bool safe = false, char postFix = '~');
+    FileList getFilesParallel(SFTPServerList &sftpServers, FileMapper &fileMapper, const FileList &fileList, FileCompletionFn completionFn = nullptr, TransferStatistics *statistics = nullptr, bool safe = false, char postFix = '~');
+    FileList getFilesParallel(SFTPServerList &sftpServers, FileMapper &fileMapper, const RemoteFileEntryList &fileList, FileCompletionFn completionFn = nullptr, TransferStatistics *statistics = nullptr, bool safe = false, char postFix = '~');
+    FileList putFilesParallel(SFTPServerList &sftpServers, FileMapper &fileMapper, const FileList &fileList, FileCompletionFn completionFn = nullptr, TransferStatistics *statistics = nullptr, bool safe = false, char postFix = '~');
 } // namespace Antik::SSH
 #endif /* SFTPUTIL_HPP */
@@ -9,6 +9,10 @@
 #include <iostream>
 #include <thread>
 #include <functional>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstring>
 //
 // Antik utility
 //
@@ -17,6 +21,7 @@
 // Antik Classes
 //
 #include "CSSHChannel.hpp"
+#include "SSHSessionUtil.hpp"
 namespace Antik::SSH
 {
     //
@@ -28,6 +33,7 @@ namespace Antik::SSH
         explicit IOContext(void *context = nullptr) : m_contextData{context}
         {
         }
+        virtual ~IOContext() = default;
         virtual void writeOutput(void *data, uint32_t size)
         {
             std::cout.write(static_cast<char *>(data), size);
@@ -36,6 +42,9 @@ namespace Antik::SSH
         {
             std::cerr.write(static_cast<char *>(data), size);
         }
+        virtual void flush()
+        {
+        }
         bool useInternalInput() const
         {
             return m_internalInput;
@@ -45,8 +54,85 @@ namespace Antik::SSH
         void *m_contextData{nullptr};
         bool m_internalInput{true};
     };
+    //
+    // IO context that splits channel output/error into lines (newline and any carriage
+    // return removed) passing each complete line to a callback; flush() passes on any
+    // unterminated last lines.
+    //
+    class LineIOContext : public IOContext
+    {
+    public:
+        using LineFn = std::function<void(const std::string &line, bool isStdErr)>;
+        explicit LineIOContext(LineFn lineFn) : m_lineFn{std::move(lineFn)}
+        {
+        }
+        void writeOutput(void *data, uint32_t size) override
+        {
+            splitLines(m_outputLine, static_cast<char *>(data), size, false);
+        }
+        void writeError(void *data, uint32_t size) override
+        {
+            splitLines(m_errorLine, static_cast<char *>(data), size, true);
+        }
+        void flush() override
+        {
+            if (!m_outputLine.empty())
+            {
+                m_lineFn(m_outputLine, false);
+                m_outputLine.clear();
+            }
+            if (!m_errorLine.empty())
+            {
+                m_lineFn(m_errorLine, true);
+                m_errorLine.clear();
+            }
+        }
+
+    private:
+        void splitLines(std::string &line, const char *data, uint32_t size, bool isStdErr)
+        {
+            for (const char *end = data + size; data != end;)
+            {
+                const char *newline = static_cast<const char *>(std::memchr(data, '\n', end - data));
+                if (newline == nullptr)
+                {
+                    line.append(data, end);
+                    break;
+                }
+                line.append(data, newline);
+                if (!line.empty() && (line.back() == '\r'))
+                {
+                    line.pop_back();
+                }
+                m_lineFn(line, isStdErr);
+                line.clear();
+                data = newline + 1;
+            }
+        }
+        LineFn m_lineFn;          // Line callback
+        std::string m_outputLine; // Partial output line
+        std::string m_errorLine;  // Partial error line
+    };
+    //
+    // Host to run a command on with executeCommandParallel(); its session is set up with the
+    // server/port/user etc. (connected by the executor if not already). Output and error go
+    // to its IO context and the command exit status (or error message) is filled in.
+    //
+    struct CommandHost
+    {
+        CSSHSession &session;
+        IOContext &ioContext;
+        int exitStatus{-1};
+        bool completed{false};
+        std::string errorMessage{};
+    };
+    using CommandHostList = std::vector<CommandHost>;
     void interactiveShell(CSSHChannel &channel, const std::string &terminalType, int columns, int rows, IOContext &ioContext);
     void executeCommand(CSSHChannel &channel, const std::string &command, IOContext &ioContext);
+    std::size_t executeCommandParallel(CommandHostList &commandHosts, const std::string &command, ServerVerificationContext &verificationContext,
+                                       std::size_t maxParallel, std::chrono::seconds deadline);
     std::thread directForwarding(CSSHChannel &forwardingChannel, const std::string &remoteHost, int remotePort, const std::string &localHost, int localPort, IOContext &ioContext);
+    FileList getFilesTar(CSSHSession &sshSession, FileMapper &fileMapper, FileCompletionFn completionFn = nullptr, bool compress = false);
+    FileList putFilesTar(CSSHSession &sshSession, FileMapper &fileMapper, FileCompletionFn completionFn = nullptr, bool compress = false);
 } // namespace Antik::SSH
 #endif /* SSHCHANNELUTIL_HPP */
@@ -0,0 +1,286 @@
+/*
+ * File:   ITCSCP.cpp
+ *
+ * Author: Robert Tizzard
+ *
+ * Created on October 24, 2016, 2:33 PM
+ *
+ * Copyright 2021.
+ *
+ */
+//
+// Program: ITCSCP
+//
+// Description: Benchmark large (multi-GB) SCP file transfers (class CSCP/SCPUtil) against an
+// SSH server. A local file (created with pseudo random contents if a size is given) is uploaded
+// to a remote directory and then downloaded back next to the original (with a .download postfix
+// which is then removed); the throughput of each is displayed. A small directory tree (with a
+// symbolic link to a file and a link loop back to its root) is then uploaded with putFiles()
+// through a single SCP session and downloaded again with getFiles() to check that the loop is
+// skipped and the files round trip. For example a 4GB file:
+//
+//     ITCSCP -s localhost -u user -p password -f /tmp/bigfile -z 4096 -r /tmp/scp
+//
+// Dependencies: C20++, Classes (CSSHSession, CSCP, CFile, CPath).
+//               Linux, Boost C++ Libraries, libssh.
+//
+// ITCSCP
+// Program Options:
+//   --help                 Print help messages
+//   -c [ --config ] arg    Config File Name
+//   -s [ --server ] arg    SSH Server
+//   -o [ --port ] arg      SSH Server port
+//   -u [ --user ] arg      Account username
+//   -p [ --password ] arg  User password
+//   -f [ --file ] arg      Local file to upload/download
+//   -z [ --size ] arg      Create local file of size (MB)
+//   -r [ --remote ] arg    Remote directory
+// =============
+// INCLUDE FILES
+// =============
+//
+// C++ STL
+//
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <random>
+#include <filesystem>
+//
+// Antik Classes
+//
+#include "CFile.hpp"
+#include "CPath.hpp"
+#include "CSSHSession.hpp"
+#include "CSCP.hpp"
+#include "SCPUtil.hpp"
+#include "SSHSessionUtil.hpp"
+using namespace Antik::SSH;
+using namespace Antik::File;
+using namespace Antik;
+//
+// Boost program options
+//
+#include <boost/program_options.hpp>
+namespace po = boost::program_options;
+// ======================
+// LOCAL TYES/DEFINITIONS
+// ======================
+// Command line parameter data
+struct ParamArgData
+{
+    std::string userName;        // SSH account user name
+    std::string userPassword;    // SSH account user name password
+    std::string serverName;      // SSH server
+    unsigned int serverPort{22}; // SSH server port
+    std::string configFileName;  // Configuration file name
+    std::string localFile;       // Local file
+    std::uint64_t fileSize{0};   // Size of local file to create in MB (0 == use existing)
+    std::string remoteDirectory; // Remote directory
+};
+// ===============
+// LOCAL FUNCTIONS
+// ===============
+//
+// Exit with error message/status
+//
+static void exitWithError(std::string errMsg)
+{
+    // Display error and exit.
+    std::cout.flush();
+    std::cerr << errMsg << std::endl;
+    exit(EXIT_FAILURE);
+}
+//
+// Add options common to both command line and config file
+//
+static void addCommonOptions(po::options_description &commonOptions, ParamArgData &argData)
+{
+    commonOptions.add_options()("server,s", po::value<std::string>(&argData.serverName)->required(), "SSH Server name")("port,o", po::value<unsigned int>(&argData.serverPort), "SSH Server port")("user,u", po::value<std::string>(&argData.userName)->required(), "Account username")("password,p", po::value<std::string>(&argData.userPassword)->required(), "User password")("file,f", po::value<std::string>(&argData.localFile)->required(), "Local file")("size,z", po::value<std::uint64_t>(&argData.fileSize), "Create local file of size (MB)")("remote,r", po::value<std::string>(&argData.remoteDirectory)->required(), "Remote directory");
+}
+//
+// Read in and process command line arguments using boost.
+//
+static void procCmdLine(int argc, char **argv, ParamArgData &argData)
+{
+    // Define and parse the program options
+    po::options_description commandLine("Program Options");
+    commandLine.add_options()("help", "Print help messages")("config,c", po::value<std::string>(&argData.configFileName), "Config File Name");
+    addCommonOptions(commandLine, argData);
+    po::options_description configFile("Config Files Options");
+    addCommonOptions(configFile, argData);
+    po::variables_map vm;
+    try
+    {
+        // Process arguments
+        po::store(po::parse_command_line(argc, argv, commandLine), vm);
+        // Display options and exit with success
+        if (vm.count("help"))
+        {
+            std::cout << "ITCSCP" << std::endl
+                      << commandLine << std::endl;
+            exit(EXIT_SUCCESS);
+        }
+        if (vm.count("config"))
+        {
+            if (CFile::exists(vm["config"].as<std::string>()))
+            {
+                std::ifstream configFileStream{vm["config"].as<std::string>()};
+                if (configFileStream)
+                {
+                    po::store(po::parse_config_file(configFileStream, configFile), vm);
+                }
+            }
+            else
+            {
+                throw po::error("Specified config file does not exist.");
+            }
+        }
+        po::notify(vm);
+    }
+    catch (po::error &e)
+    {
+        std::cerr << "ITCSCP Error: " << e.what() << std::endl
+                  << std::endl;
+        std::cerr << commandLine << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+//
+// Time a transfer function and display its throughput.
+//
+static void benchmark(const std::string &description, std::function<std::uintmax_t(void)> transferFn)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::uintmax_t bytesTransfered{transferFn()};
+    std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() - start};
+    std::cout << description << " : " << bytesTransfered << " bytes in " << elapsed.count() << "s ["
+              << ((bytesTransfered / (1024.0 * 1024.0)) / elapsed.count()) << " MB/s]" << std::endl;
+}
+//
+// Create a local file of a given size (MB) filled with pseudo random data.
+//
+static void createFile(const std::string &fileName, std::uint64_t fileSize)
+{
+    std::ofstream localFile{fileName, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc};
+    std::vector<std::uint64_t> block(1024 * 1024 / sizeof(std::uint64_t));
+    std::mt19937_64 generator;
+    for (std::uint64_t megaByte = 0; megaByte < fileSize; megaByte++)
+    {
+        for (auto &word : block)
+        {
+            word = generator();
+        }
+        localFile.write(reinterpret_cast<char *>(block.data()), block.size() * sizeof(std::uint64_t));
+    }
+    if (!localFile)
+    {
+        throw std::runtime_error("Could not create local file " + fileName + ".");
+    }
+}
+//
+// Upload a small local directory tree with putFiles() and download it again with getFiles()
+// checking each file round trips. The tree has a link to a file (uploaded as the file) and
+// a link to its own root (skipped, otherwise uploading would recurse until it failed).
+//
+static void putGetFilesTree(CSSHSession &sshSession, const std::string &localFile, const std::string &remoteDirectory)
+{
+    std::string localTree{localFile + ".tree"};
+    std::string downloadTree{localFile + ".tree.download"};
+    std::string remoteTree{remoteDirectory + kServerPathSep + CPath(localTree).fileName()};
+    FileList expectedFiles{"sub/a", "sub/deeper/b", "linkfile"};
+    std::filesystem::remove_all(localTree);
+    std::filesystem::remove_all(downloadTree);
+    std::filesystem::create_directories(localTree + "/sub/deeper");
+    std::ofstream{localTree + "/sub/a"} << "file a";
+    std::ofstream{localTree + "/sub/deeper/b"} << "file b";
+    std::filesystem::create_symlink("sub/a", localTree + "/linkfile");
+    std::filesystem::create_directory_symlink(".", localTree + "/loop");
+    FileMapper putMapper{localTree, remoteTree};
+    FileList uploadedFiles{putFiles(sshSession, putMapper)};
+    if (uploadedFiles.size() != expectedFiles.size() + 2)
+    {
+        throw std::runtime_error("putFiles uploaded " + std::to_string(uploadedFiles.size()) + " entries not " + std::to_string(expectedFiles.size() + 2) + ".");
+    }
+    FileMapper getMapper{downloadTree, remoteTree};
+    getFiles(sshSession, getMapper);
+    for (auto &expectedFile : expectedFiles)
+    {
+        std::ifstream uploaded{localTree + kServerPathSep + expectedFile}, downloaded{downloadTree + kServerPathSep + expectedFile};
+        std::string uploadedContents{std::istreambuf_iterator<char>(uploaded), {}}, downloadedContents{std::istreambuf_iterator<char>(downloaded), {}};
+        if (!downloaded || (uploadedContents != downloadedContents))
+        {
+            throw std::runtime_error("File " + expectedFile + " did not round trip.");
+        }
+    }
+    if (std::filesystem::exists(downloadTree + "/loop"))
+    {
+        throw std::runtime_error("Link loop was uploaded.");
+    }
+    std::cout << "putFiles/getFiles [" << localTree << "] : " << uploadedFiles.size() << " entries round trip" << std::endl;
+    std::filesystem::remove_all(localTree);
+    std::filesystem::remove_all(downloadTree);
+}
+// ============================
+// ===== MAIN ENTRY POint =====
+// ============================
+int main(int argc, char **argv)
+{
+    try
+    {
+        ParamArgData argData;
+        CSSHSession sshSession;
+        // Read in command line parameters and process
+        procCmdLine(argc, argv, argData);
+        std::cout << "SERVER [" << argData.serverName << "]" << std::endl;
+        std::cout << "SERVER PORT [" << argData.serverPort << "]" << std::endl;
+        std::cout << "USER [" << argData.userName << "]" << std::endl;
+        std::cout << "LOCAL FILE [" << argData.localFile << "]" << std::endl;
+        std::cout << "REMOTE DIRECTORY [" << argData.remoteDirectory << "]\n"
+                  << std::endl;
+        if (argData.fileSize != 0)
+        {
+            createFile(argData.localFile, argData.fileSize);
+        }
+        // Connect and authorize session
+        sshSession.setServer(argData.serverName);
+        sshSession.setPort(argData.serverPort);
+        sshSession.setUser(argData.userName);
+        sshSession.setUserPassword(argData.userPassword);
+        sshSession.connect();
+        if (!userAuthorize(sshSession))
+        {
+            throw std::runtime_error("Server unable to authorize client.");
+        }
+        std::string remoteFile{argData.remoteDirectory + kServerPathSep + CPath(argData.localFile).fileName()};
+        std::string downloadFile{argData.localFile + ".download"};
+        benchmark("putFile [" + argData.localFile + "]", [&]() {
+            putFile(sshSession, argData.localFile, remoteFile);
+            return (std::filesystem::file_size(argData.localFile));
+        });
+        benchmark("getFile [" + remoteFile + "]", [&]() {
+            getFile(sshSession, remoteFile, downloadFile);
+            return (std::filesystem::file_size(downloadFile));
+        });
+        if (std::filesystem::file_size(downloadFile) != std::filesystem::file_size(argData.localFile))
+        {
+            throw std::runtime_error("Downloaded file size does not match.");
+        }
+        CFile::remove(downloadFile);
+        putGetFilesTree(sshSession, argData.localFile, argData.remoteDirectory);
+        sshSession.disconnect();
+    }
+    catch (const CSCP::Exception &e)
+    {
+        exitWithError(e.getMessage());
+    }
+    catch (const CSSHSession::Exception &e)
+    {
+        exitWithError(e.getMessage());
+    }
+    catch (std::exception &e)
+    {
+        exitWithError(e.what());
+    }
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,300 @@
+/*
+ * File:   ITCSFTP.cpp
+ *
+ * Author: Robert Tizzard
+ *
+ * Created on October 24, 2016, 2:33 PM
+ *
+ * Copyright 2021.
+ *
+ */
+//
+// Program: ITCSFTP
+//
+// Description: Benchmark SFTP file transfers (class CSFTP/SFTPUtil) against an SSH server
+// for a range of IO pipeline depths. Each remote file is downloaded and then uploaded
+// back (with a .upload postfix which is then removed). Throughput with a pipeline depth of 1 is limited to
+// IO buffer size / round trip time so to see the effect of pipelining run against a local
+// sshd over a delayed loopback; for example a 50ms round trip:
+//
+//     tc qdisc add dev lo root netem delay 25ms
+//     ITCSFTP -s localhost -u user -p password -l /tmp/ -f /tmp/bigfile -d 1 4 16 64
+//     tc qdisc del dev lo root
+//
+// If a session count is given the file list is also downloaded/uploaded with getFilesParallel()/
+// putFilesParallel() and each file downloaded with getFileSegmented() using that many sessions.
+//
+// Dependencies: C20++, Classes (CSSHSession, CSFTP, CFile, CPath).
+//               Linux, Boost C++ Libraries, libssh.
+//
+// ITCSFTP
+// Program Options:
+//   --help                 Print help messages
+//   -c [ --config ] arg    Config File Name
+//   -s [ --server ] arg    SSH Server
+//   -o [ --port ] arg      SSH Server port
+//   -u [ --user ] arg      Account username
+//   -p [ --password ] arg  User password
+//   -l [ --local ] arg     Local directory
+//   -f [ --files ] arg     Remote files to download/upload
+//   -b [ --buffer ] arg    IO buffer size (default sized from server limits)
+//   -d [ --depths ] arg    Pipeline depths to benchmark
+//   -n [ --sessions ] arg  Sessions for parallel transfer benchmark
+// =============
+// INCLUDE FILES
+// =============
+//
+// C++ STL
+//
+#include <iostream>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+//
+// Antik Classes
+//
+#include "CFile.hpp"
+#include "CPath.hpp"
+#include "CSSHSession.hpp"
+#include "CSFTP.hpp"
+#include "SFTPUtil.hpp"
+#include "SSHSessionUtil.hpp"
+using namespace Antik::SSH;
+using namespace Antik::File;
+using namespace Antik;
+//
+// Boost program options
+//
+#include <boost/program_options.hpp>
+namespace po = boost::program_options;
+// ======================
+// LOCAL TYES/DEFINITIONS
+// ======================
+// Command line parameter data
+struct ParamArgData
+{
+    std::string userName;                        // SSH account user name
+    std::string userPassword;                    // SSH account user name password
+    std::string serverName;                      // SSH server
+    unsigned int serverPort{22};                 // SSH server port
+    std::string localDirectory;                  // Local directory
+    std::string configFileName;                  // Configuration file name
+    std::vector<std::string> fileList;           // Remote file list
+    std::uint32_t ioBufferSize{0};               // IO buffer size (0 == size from server limits)
+    std::vector<std::uint32_t> depths{1, 4, 16}; // Pipeline depths
+    std::uint32_t sessions{0};                   // Parallel transfer sessions (0 == none)
+};
+// ===============
+// LOCAL FUNCTIONS
+// ===============
+//
+// Exit with error message/status
+//
+static void exitWithError(std::string errMsg)
+{
+    // Display error and exit.
+    std::cout.flush();
+    std::cerr << errMsg << std::endl;
+    exit(EXIT_FAILURE);
+}
+//
+// Add options common to both command line and config file
+//
+static void addCommonOptions(po::options_description &commonOptions, ParamArgData &argData)
+{
+    commonOptions.add_options()("server,s", po::value<std::string>(&argData.serverName)->required(), "SSH Server name")("port,o", po::value<unsigned int>(&argData.serverPort), "SSH Server port")("user,u", po::value<std::string>(&argData.userName)->required(), "Account username")("password,p", po::value<std::string>(&argData.userPassword)->required(), "User password")("local,l", po::value<std::string>(&argData.localDirectory)->required(), "Local directory")("files,f", po::value<std::vector<std::string>>(&argData.fileList)->multitoken()->required(), "Remote files")("buffer,b", po::value<std::uint32_t>(&argData.ioBufferSize), "IO buffer size")("depths,d", po::value<std::vector<std::uint32_t>>(&argData.depths)->multitoken(), "Pipeline depths")("sessions,n", po::value<std::uint32_t>(&argData.sessions), "Sessions for parallel transfer");
+}
+//
+// Read in and process command line arguments using boost.
+//
+static void procCmdLine(int argc, char **argv, ParamArgData &argData)
+{
+    // Define and parse the program options
+    po::options_description commandLine("Program Options");
+    commandLine.add_options()("help", "Print help messages")("config,c", po::value<std::string>(&argData.configFileName), "Config File Name");
+    addCommonOptions(commandLine, argData);
+    po::options_description configFile("Config Files Options");
+    addCommonOptions(configFile, argData);
+    po::variables_map vm;
+    try
+    {
+        // Process arguments
+        po::store(po::parse_command_line(argc, argv, commandLine), vm);
+        // Display options and exit with success
+        if (vm.count("help"))
+        {
+            std::cout << "ITCSFTP" << std::endl
+                      << commandLine << std::endl;
+            exit(EXIT_SUCCESS);
+        }
+        if (vm.count("config"))
+        {
+            if (CFile::exists(vm["config"].as<std::string>()))
+            {
+                std::ifstream configFileStream{vm["config"].as<std::string>()};
+                if (configFileStream)
+                {
+                    po::store(po::parse_config_file(configFileStream, configFile), vm);
+                }
+            }
+            else
+            {
+                throw po::error("Specified config file does not exist.");
+            }
+        }
+        po::notify(vm);
+    }
+    catch (po::error &e)
+    {
+        std::cerr << "ITCSFTP Error: " << e.what() << std::endl
+                  << std::endl;
+        std::cerr << commandLine << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+//
+// Time a transfer function and display its throughput.
+//
+static void benchmark(const std::string &description, std::function<std::uintmax_t(void)> transferFn)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::uintmax_t bytesTransfered{transferFn()};
+    std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() - start};
+    std::cout << description << " : " << bytesTransfered << " bytes in " << elapsed.count() << "s ["
+              << ((bytesTransfered / (1024.0 * 1024.0)) / elapsed.count()) << " MB/s]" << std::endl;
+}
+//
+// Connect and authorize a session.
+//
+static void connectSession(CSSHSession &sshSession, const ParamArgData &argData)
+{
+    sshSession.setServer(argData.serverName);
+    sshSession.setPort(argData.serverPort);
+    sshSession.setUser(argData.userName);
+    sshSession.setUserPassword(argData.userPassword);
+    sshSession.connect();
+    if (!userAuthorize(sshSession))
+    {
+        throw std::runtime_error("Server unable to authorize client.");
+    }
+}
+//
+// Download and then upload the file list in parallel over the passed number of sessions.
+//
+static void benchmarkParallel(const ParamArgData &argData)
+{
+    std::vector<std::unique_ptr<CSSHSession>> sshSessions;
+    std::vector<std::unique_ptr<CSFTP>> sftpServers;
+    SFTPServerList serverList;
+    for (std::uint32_t session = 0; session < argData.sessions; session++)
+    {
+        sshSessions.push_back(std::make_unique<CSSHSession>());
+        connectSession(*sshSessions.back(), argData);
+        sftpServers.push_back(std::make_unique<CSFTP>(*sshSessions.back()));
+        sftpServers.back()->open();
+        serverList.push_back(*sftpServers.back());
+    }
+    FileMapper fileMapper{argData.localDirectory, CPath(argData.fileList.front()).parentPath().toString()};
+    TransferStatistics statistics;
+    FileList uploadList;
+    getFilesParallel(serverList, fileMapper, argData.fileList, nullptr, &statistics);
+    std::cout << "getFilesParallel sessions " << argData.sessions << " : " << statistics.filesTransfered << " files ("
+              << statistics.filesFailed << " failed) " << statistics.bytesTransfered << " bytes in " << statistics.elapsedSeconds
+              << "s [" << (statistics.bytesPerSecond() / (1024.0 * 1024.0)) << " MB/s]" << std::endl;
+    for (auto file : argData.fileList)
+    {
+        uploadList.push_back(fileMapper.toLocal(file));
+    }
+    putFilesParallel(serverList, fileMapper, uploadList, nullptr, &statistics, true, '~');
+    std::cout << "putFilesParallel sessions " << argData.sessions << " : " << statistics.filesTransfered << " files ("
+              << statistics.filesFailed << " failed) " << statistics.bytesTransfered << " bytes in " << statistics.elapsedSeconds
+              << "s [" << (statistics.bytesPerSecond() / (1024.0 * 1024.0)) << " MB/s]" << std::endl;
+    for (auto file : argData.fileList)
+    {
+        std::string localFile{argData.localDirectory + CPath(file).fileName() + ".segmented"};
+        benchmark("getFileSegmented [" + file + "] sessions " + std::to_string(argData.sessions), [&]() {
+            getFileSegmented(serverList, file, localFile);
+            return (std::filesystem::file_size(localFile));
+        });
+        CFile::remove(localFile);
+    }
+    for (auto &sftpServer : sftpServers)
+    {
+        sftpServer->close();
+    }
+    for (auto &sshSession : sshSessions)
+    {
+        sshSession->disconnect();
+    }
+}
+// ============================
+// ===== MAIN ENTRY POint =====
+// ============================
+int main(int argc, char **argv)
+{
+    try
+    {
+        ParamArgData argData;
+        CSSHSession sshSession;
+        // Read in command line parameters and process
+        procCmdLine(argc, argv, argData);
+        std::cout << "SERVER [" << argData.serverName << "]" << std::endl;
+        std::cout << "SERVER PORT [" << argData.serverPort << "]" << std::endl;
+        std::cout << "USER [" << argData.userName << "]" << std::endl;
+        std::cout << "LOCAL DIRECTORY [" << argData.localDirectory << "]" << std::endl;
+        // Connect and authorize session
+        connectSession(sshSession, argData);
+        CSFTP sftpServer{sshSession};
+        sftpServer.open();
+        if (argData.ioBufferSize != 0)
+        {
+            sftpServer.setIoBufferSize(argData.ioBufferSize);
+        }
+        if (sftpServer.getLimits().negotiated)
+        {
+            std::cout << "SERVER LIMITS [read " << sftpServer.getLimits().maxReadLength << "][write "
+                      << sftpServer.getLimits().maxWriteLength << "]" << std::endl;
+        }
+        std::cout << "IO BUFFER SIZE [" << sftpServer.getIoBufferSize() << "]" << std::endl;
+        std::cout << "IO PIPELINE DEPTH [" << sftpServer.getIoPipelineDepth() << "]\n"
+                  << std::endl;
+        // Download files at each pipeline depth
+        for (auto depth : argData.depths)
+        {
+            sftpServer.setIoPipelineDepth(depth);
+            for (auto file : argData.fileList)
+            {
+                std::string localFile{argData.localDirectory + CPath(file).fileName()};
+                benchmark("getFile [" + file + "] depth " + std::to_string(depth), [&]() {
+                    getFile(sftpServer, file, localFile);
+                    return (std::filesystem::file_size(localFile));
+                });
+                benchmark("putFile [" + file + "] depth " + std::to_string(depth), [&]() {
+                    putFile(sftpServer, localFile, file + ".upload");
+                    return (std::filesystem::file_size(localFile));
+                });
+                sftpServer.removeLink(file + ".upload");
+            }
+        }
+        sftpServer.close();
+        sshSession.disconnect();
+        // Parallel transfer over a number of sessions
+        if (argData.sessions != 0)
+        {
+            benchmarkParallel(argData);
+        }
+    }
+    catch (const CSFTP::Exception &e)
+    {
+        exitWithError(e.getMessage());
+    }
+    catch (const CSSHSession::Exception &e)
+    {
+        exitWithError(e.getMessage());
+    }
+    catch (std::exception &e)
+    {
+        exitWithError(e.what());
+    }
+    exit(EXIT_SUCCESS);
+}
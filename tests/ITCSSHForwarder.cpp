@@ -0,0 +1,339 @@
+/*
+ * File:   ITCSSHForwarder.cpp
+ *
+ * Author: Robert Tizzard
+ *
+ * Created on October 18, 2026, 4:20 PM
+ *
+ * Copyright 2021.
+ *
+ */
+//
+// Program: ITCSSHForwarder
+//
+// Description: Check and benchmark port forwarding (class CSSHForwarder) against an SSH
+// server. A local echo server is started and a reverse forward (server port -> echo server)
+// set up, with a local forward (local port -> that server port) in front of it; so data sent
+// to the local forward travels over the session twice in each direction. A number of
+// connections each send a block of pseudo random data through it and check it is echoed
+// back unchanged; the throughput is displayed. For example 4 connections of 64MB each:
+//
+//     ITCSSHForwarder -s localhost -u user -p password -n 4 -z 64
+//
+// Dependencies: C20++, Classes (CSSHSession, CSSHForwarder, CFile).
+//               Linux, Boost C++ Libraries, libssh.
+//
+// ITCSSHForwarder
+// Program Options:
+//   --help                   Print help messages
+//   -c [ --config ] arg      Config File Name
+//   -s [ --server ] arg      SSH Server
+//   -o [ --port ] arg        SSH Server port
+//   -u [ --user ] arg        Account username
+//   -p [ --password ] arg    User password
+//   -n [ --connections ] arg Concurrent connections (default 1)
+//   -z [ --size ] arg        Data sent per connection (MB, default 16)
+// =============
+// INCLUDE FILES
+// =============
+//
+// C++ STL
+//
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <cstring>
+//
+// Linux sockets
+//
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+//
+// Antik Classes
+//
+#include "CFile.hpp"
+#include "CSSHSession.hpp"
+#include "CSSHForwarder.hpp"
+#include "SSHSessionUtil.hpp"
+using namespace Antik::SSH;
+using namespace Antik::File;
+using namespace Antik;
+//
+// Boost program options
+//
+#include <boost/program_options.hpp>
+namespace po = boost::program_options;
+// ======================
+// LOCAL TYES/DEFINITIONS
+// ======================
+// Command line parameter data
+struct ParamArgData
+{
+    std::string userName;           // SSH account user name
+    std::string userPassword;       // SSH account user name password
+    std::string serverName;         // SSH server
+    unsigned int serverPort{22};    // SSH server port
+    std::string configFileName;     // Configuration file name
+    unsigned int connections{1};    // Concurrent connections
+    std::uint64_t dataSize{16};     // Data sent per connection (MB)
+};
+// ===============
+// LOCAL FUNCTIONS
+// ===============
+//
+// Exit with error message/status
+//
+static void exitWithError(std::string errMsg)
+{
+    // Display error and exit.
+    std::cout.flush();
+    std::cerr << errMsg << std::endl;
+    exit(EXIT_FAILURE);
+}
+//
+// Add options common to both command line and config file
+//
+static void addCommonOptions(po::options_description &commonOptions, ParamArgData &argData)
+{
+    commonOptions.add_options()("server,s", po::value<std::string>(&argData.serverName)->required(), "SSH Server name")("port,o", po::value<unsigned int>(&argData.serverPort), "SSH Server port")("user,u", po::value<std::string>(&argData.userName)->required(), "Account username")("password,p", po::value<std::string>(&argData.userPassword)->required(), "User password")("connections,n", po::value<unsigned int>(&argData.connections), "Concurrent connections")("size,z", po::value<std::uint64_t>(&argData.dataSize), "Data sent per connection (MB)");
+}
+//
+// Read in and process command line arguments using boost.
+//
+static void procCmdLine(int argc, char **argv, ParamArgData &argData)
+{
+    // Define and parse the program options
+    po::options_description commandLine("Program Options");
+    commandLine.add_options()("help", "Print help messages")("config,c", po::value<std::string>(&argData.configFileName), "Config File Name");
+    addCommonOptions(commandLine, argData);
+    po::options_description configFile("Config Files Options");
+    addCommonOptions(configFile, argData);
+    po::variables_map vm;
+    try
+    {
+        // Process arguments
+        po::store(po::parse_command_line(argc, argv, commandLine), vm);
+        // Display options and exit with success
+        if (vm.count("help"))
+        {
+            std::cout << "ITCSSHForwarder" << std::endl
+                      << commandLine << std::endl;
+            exit(EXIT_SUCCESS);
+        }
+        if (vm.count("config"))
+        {
+            if (CFile::exists(vm["config"].as<std::string>()))
+            {
+                std::ifstream configFileStream{vm["config"].as<std::string>()};
+                if (configFileStream)
+                {
+                    po::store(po::parse_config_file(configFileStream, configFile), vm);
+                }
+            }
+            else
+            {
+                throw po::error("Specified config file does not exist.");
+            }
+        }
+        po::notify(vm);
+    }
+    catch (po::error &e)
+    {
+        std::cerr << "ITCSSHForwarder Error: " << e.what() << std::endl
+                  << std::endl;
+        std::cerr << commandLine << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+//
+// Create a loopback socket; listening on an ephemeral port (returned in port) or
+// connected to port.
+//
+static int loopbackSocket(bool listening, int &port)
+{
+    struct sockaddr_in address{};
+    socklen_t addressLength{sizeof(address)};
+    int loopback{::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0)};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(listening ? 0 : port);
+    if ((loopback == -1) ||
+        (listening ? ((::bind(loopback, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) == -1) || (::listen(loopback, SOMAXCONN) == -1) ||
+                      (::getsockname(loopback, reinterpret_cast<struct sockaddr *>(&address), &addressLength) == -1))
+                   : (::connect(loopback, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) == -1)))
+    {
+        throw std::runtime_error(std::string("Loopback socket error: ") + std::strerror(errno));
+    }
+    port = ntohs(address.sin_port);
+    return (loopback);
+}
+//
+// Echo server; echo each connection accepted (on its own thread) until end of file.
+//
+static void echoServer(int listeningSocket)
+{
+    int connection;
+    while ((connection = ::accept(listeningSocket, nullptr, nullptr)) != -1)
+    {
+        std::thread([connection]() {
+            char buffer[64 * 1024];
+            ssize_t bytesRead;
+            while ((bytesRead = ::recv(connection, buffer, sizeof(buffer), 0)) > 0)
+            {
+                for (ssize_t bytesSent{0}, sent; bytesSent < bytesRead; bytesSent += sent)
+                {
+                    if ((sent = ::send(connection, buffer + bytesSent, bytesRead - bytesSent, MSG_NOSIGNAL)) <= 0)
+                    {
+                        bytesRead = 0;
+                        break;
+                    }
+                }
+            }
+            ::close(connection);
+        }).detach();
+    }
+}
+//
+// Send pseudo random data through a forward and check it is echoed back unchanged.
+//
+static bool echoThroughForward(int forwardPort, std::uint64_t dataSize, unsigned int seed)
+{
+    std::vector<char> sent(dataSize), received;
+    std::mt19937 generator{seed};
+    for (auto &byte : sent)
+    {
+        byte = static_cast<char>(generator());
+    }
+    int connection{loopbackSocket(false, forwardPort)};
+    std::thread sender([&]() {
+        for (std::size_t bytesSent{0}; bytesSent < sent.size();)
+        {
+            ssize_t sentNow{::send(connection, &sent[bytesSent], std::min<std::size_t>(sent.size() - bytesSent, 64 * 1024), MSG_NOSIGNAL)};
+            if (sentNow <= 0)
+            {
+                break;
+            }
+            bytesSent += sentNow;
+        }
+        ::shutdown(connection, SHUT_WR);
+    });
+    char buffer[64 * 1024];
+    ssize_t bytesRead;
+    while ((bytesRead = ::recv(connection, buffer, sizeof(buffer), 0)) > 0)
+    {
+        received.insert(received.end(), buffer, buffer + bytesRead);
+    }
+    sender.join();
+    ::close(connection);
+    return (received == sent);
+}
+// ============================
+// ===== MAIN ENTRY POint =====
+// ============================
+int main(int argc, char **argv)
+{
+    try
+    {
+        ParamArgData argData;
+        CSSHSession sshSession;
+        // Read in command line parameters and process
+        procCmdLine(argc, argv, argData);
+        std::cout << "SERVER [" << argData.serverName << "]" << std::endl;
+        std::cout << "SERVER PORT [" << argData.serverPort << "]" << std::endl;
+        std::cout << "USER [" << argData.userName << "]" << std::endl;
+        std::cout << "CONNECTIONS [" << argData.connections << "]" << std::endl;
+        std::cout << "DATA SIZE [" << argData.dataSize << " MB]\n"
+                  << std::endl;
+        // Connect and authorize session
+        sshSession.setServer(argData.serverName);
+        sshSession.setPort(argData.serverPort);
+        sshSession.setUser(argData.userName);
+        sshSession.setUserPassword(argData.userPassword);
+        sshSession.connect();
+        if (!userAuthorize(sshSession))
+        {
+            throw std::runtime_error("Server unable to authorize client.");
+        }
+        // Echo server <- reverse forward <- local forward
+        int echoPort{0};
+        int echoListener{loopbackSocket(true, echoPort)};
+        std::thread(echoServer, echoListener).detach();
+        CSSHForwarder forwarder{sshSession};
+        int remotePort{forwarder.addRemoteForward("localhost", 0, "127.0.0.1", echoPort)};
+        int localPort{forwarder.addLocalForward("127.0.0.1", 0, "localhost", remotePort)};
+        std::cout << "ECHO PORT [" << echoPort << "] REMOTE FORWARD [" << remotePort << "] LOCAL FORWARD [" << localPort << "]" << std::endl;
+        std::exception_ptr forwarderException;
+        std::thread forwarderThread([&]() {
+            try
+            {
+                forwarder.run();
+            }
+            catch (...)
+            {
+                forwarderException = std::current_exception();
+            }
+        });
+        std::atomic<unsigned int> echoFailures{0};
+        std::vector<std::thread> connections;
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned int connection = 0; connection < argData.connections; connection++)
+        {
+            connections.emplace_back([&, connection]() {
+                try
+                {
+                    if (!echoThroughForward(localPort, argData.dataSize * 1024 * 1024, connection))
+                    {
+                        echoFailures++;
+                    }
+                }
+                catch (const std::exception &e)
+                {
+                    std::cerr << e.what() << std::endl;
+                    echoFailures++;
+                }
+            });
+        }
+        for (auto &connection : connections)
+        {
+            connection.join();
+        }
+        std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() - start};
+        forwarder.stop();
+        forwarderThread.join();
+        ::close(echoListener);
+        if (forwarderException)
+        {
+            std::rethrow_exception(forwarderException);
+        }
+        if (echoFailures != 0)
+        {
+            throw std::runtime_error(std::to_string(echoFailures) + " connection(s) did not echo back correctly.");
+        }
+        std::cout << "Forwarded : " << (argData.connections * argData.dataSize) << " MB each way in " << elapsed.count() << "s ["
+                  << ((argData.connections * argData.dataSize) / elapsed.count()) << " MB/s]" << std::endl;
+        sshSession.disconnect();
+    }
+    catch (const CSSHForwarder::Exception &e)
+    {
+        exitWithError(e.getMessage());
+    }
+    catch (const CSSHChannel::Exception &e)
+    {
+        exitWithError(e.getMessage());
+    }
+    catch (const CSSHSession::Exception &e)
+    {
+        exitWithError(e.getMessage());
+    }
+    catch (std::exception &e)
+    {
+        exitWithError(e.what());
+    }
+    exit(EXIT_SUCCESS);
+}
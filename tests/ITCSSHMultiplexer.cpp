@@ -0,0 +1,316 @@
+/*
+ * File:   ITCSSHMultiplexer.cpp
+ *
+ * Author: Robert Tizzard
+ *
+ * Created on October 18, 2026, 5:10 PM
+ *
+ * Copyright 2021.
+ *
+ */
+//
+// Program: ITCSSHMultiplexer
+//
+// Description: Check sharing one SSH session between threads (class CSSHMultiplexer)
+// against an SSH server. A number of threads each run commands through the multiplexer
+// (checking their exit status and output) and stream data through a channel running cat
+// (checking it is echoed back unchanged). Then threads keep submitting operations while the
+// multiplexer is stopped; every one of them has to complete or fail rather than be left
+// waiting. For example 8 threads each running 20 commands:
+//
+//     ITCSSHMultiplexer -s localhost -u user -p password -n 8 -r 20
+//
+// Dependencies: C20++, Classes (CSSHSession, CSSHMultiplexer, CFile).
+//               Linux, Boost C++ Libraries, libssh.
+//
+// ITCSSHMultiplexer
+// Program Options:
+//   --help                   Print help messages
+//   -c [ --config ] arg      Config File Name
+//   -s [ --server ] arg      SSH Server
+//   -o [ --port ] arg        SSH Server port
+//   -u [ --user ] arg        Account username
+//   -p [ --password ] arg    User password
+//   -n [ --threads ] arg     Submitting threads (default 4)
+//   -r [ --repeat ] arg      Commands run per thread (default 10)
+// =============
+// INCLUDE FILES
+// =============
+//
+// C++ STL
+//
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <vector>
+//
+// Antik Classes
+//
+#include "CFile.hpp"
+#include "CSSHSession.hpp"
+#include "CSSHMultiplexer.hpp"
+#include "SSHSessionUtil.hpp"
+using namespace Antik::SSH;
+using namespace Antik::File;
+using namespace Antik;
+//
+// Boost program options
+//
+#include <boost/program_options.hpp>
+namespace po = boost::program_options;
+// ======================
+// LOCAL TYES/DEFINITIONS
+// ======================
+// Command line parameter data
+struct ParamArgData
+{
+    std::string userName;        // SSH account user name
+    std::string userPassword;    // SSH account user name password
+    std::string serverName;      // SSH server
+    unsigned int serverPort{22}; // SSH server port
+    std::string configFileName;  // Configuration file name
+    unsigned int threads{4};     // Submitting threads
+    unsigned int repeat{10};     // Commands run per thread
+};
+// ===============
+// LOCAL FUNCTIONS
+// ===============
+//
+// Exit with error message/status
+//
+static void exitWithError(std::string errMsg)
+{
+    // Display error and exit.
+    std::cout.flush();
+    std::cerr << errMsg << std::endl;
+    exit(EXIT_FAILURE);
+}
+//
+// Add options common to both command line and config file
+//
+static void addCommonOptions(po::options_description &commonOptions, ParamArgData &argData)
+{
+    commonOptions.add_options()("server,s", po::value<std::string>(&argData.serverName)->required(), "SSH Server name")("port,o", po::value<unsigned int>(&argData.serverPort), "SSH Server port")("user,u", po::value<std::string>(&argData.userName)->required(), "Account username")("password,p", po::value<std::string>(&argData.userPassword)->required(), "User password")("threads,n", po::value<unsigned int>(&argData.threads), "Submitting threads")("repeat,r", po::value<unsigned int>(&argData.repeat), "Commands run per thread");
+}
+//
+// Read in and process command line arguments using boost.
+//
+static void procCmdLine(int argc, char **argv, ParamArgData &argData)
+{
+    // Define and parse the program options
+    po::options_description commandLine("Program Options");
+    commandLine.add_options()("help", "Print help messages")("config,c", po::value<std::string>(&argData.configFileName), "Config File Name");
+    addCommonOptions(commandLine, argData);
+    po::options_description configFile("Config Files Options");
+    addCommonOptions(configFile, argData);
+    po::variables_map vm;
+    try
+    {
+        // Process arguments
+        po::store(po::parse_command_line(argc, argv, commandLine), vm);
+        // Display options and exit with success
+        if (vm.count("help"))
+        {
+            std::cout << "ITCSSHMultiplexer" << std::endl
+                      << commandLine << std::endl;
+            exit(EXIT_SUCCESS);
+        }
+        if (vm.count("config"))
+        {
+            if (CFile::exists(vm["config"].as<std::string>()))
+            {
+                std::ifstream configFileStream{vm["config"].as<std::string>()};
+                if (configFileStream)
+                {
+                    po::store(po::parse_config_file(configFileStream, configFile), vm);
+                }
+            }
+            else
+            {
+                throw po::error("Specified config file does not exist.");
+            }
+        }
+        po::notify(vm);
+    }
+    catch (po::error &e)
+    {
+        std::cerr << "ITCSSHMultiplexer Error: " << e.what() << std::endl
+                  << std::endl;
+        std::cerr << commandLine << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+//
+// Run commands through the multiplexer; return number of unexpected results.
+//
+static unsigned int runCommands(CSSHMultiplexer &multiplexer, unsigned int thread, unsigned int repeat)
+{
+    unsigned int failures{0};
+    for (unsigned int command = 0; command < repeat; command++)
+    {
+        std::string marker{std::to_string(thread) + "." + std::to_string(command)};
+        auto result = multiplexer.executeCommand("echo " + marker + "; echo " + marker + " 1>&2; exit " + std::to_string(command % 4)).get();
+        if ((result.output != marker + "\n") || (result.error != marker + "\n") || (result.exitStatus != static_cast<int>(command % 4)))
+        {
+            failures++;
+        }
+    }
+    return (failures);
+}
+//
+// Stream data through a channel running cat; return true if echoed back unchanged.
+//
+static bool echoThroughChannel(CSSHMultiplexer &multiplexer, unsigned int thread)
+{
+    std::string sent, received, data;
+    for (unsigned int line = 0; line < 4096; line++)
+    {
+        sent += std::to_string(thread) + ":" + std::to_string(line) + "\n";
+    }
+    auto channelId = multiplexer.openChannel().get();
+    multiplexer.execute(channelId, "cat").get();
+    auto written = multiplexer.write(channelId, sent);
+    auto endOfFile = multiplexer.sendEndOfFile(channelId);
+    while (!(data = multiplexer.read(channelId, 16 * 1024).get()).empty())
+    {
+        received += data;
+    }
+    written.get();
+    endOfFile.get();
+    multiplexer.closeChannel(channelId).get();
+    return (received == sent);
+}
+//
+// Keep submitting operations until the multiplexer stops; return the number left
+// neither completed nor failed.
+//
+static unsigned int submitUntilStopped(CSSHMultiplexer &multiplexer, std::atomic<bool> &stopped)
+{
+    std::vector<std::future<int>> submitted;
+    unsigned int stranded{0};
+    while (!stopped)
+    {
+        submitted.push_back(multiplexer.submit([](CSSHSession &session) { return (session.isConnected() ? 1 : 0); }));
+        if (submitted.size() >= 1000)
+        {
+            std::erase_if(submitted, [](auto &operation) { return (operation.wait_for(std::chrono::seconds(0)) == std::future_status::ready); });
+        }
+    }
+    for (auto &operation : submitted)
+    {
+        if (operation.wait_for(std::chrono::seconds(10)) != std::future_status::ready)
+        {
+            stranded++;
+        }
+    }
+    return (stranded);
+}
+// ============================
+// ===== MAIN ENTRY POint =====
+// ============================
+int main(int argc, char **argv)
+{
+    try
+    {
+        ParamArgData argData;
+        CSSHSession sshSession;
+        // Read in command line parameters and process
+        procCmdLine(argc, argv, argData);
+        std::cout << "SERVER [" << argData.serverName << "]" << std::endl;
+        std::cout << "SERVER PORT [" << argData.serverPort << "]" << std::endl;
+        std::cout << "USER [" << argData.userName << "]" << std::endl;
+        std::cout << "THREADS [" << argData.threads << "]" << std::endl;
+        std::cout << "REPEAT [" << argData.repeat << "]\n"
+                  << std::endl;
+        // Connect and authorize session
+        sshSession.setServer(argData.serverName);
+        sshSession.setPort(argData.serverPort);
+        sshSession.setUser(argData.userName);
+        sshSession.setUserPassword(argData.userPassword);
+        sshSession.connect();
+        if (!userAuthorize(sshSession))
+        {
+            throw std::runtime_error("Server unable to authorize client.");
+        }
+        // Commands and channel IO from many threads at once
+        {
+            CSSHMultiplexer multiplexer{sshSession};
+            std::atomic<unsigned int> failures{0};
+            std::vector<std::thread> threads;
+            auto start = std::chrono::steady_clock::now();
+            for (unsigned int thread = 0; thread < argData.threads; thread++)
+            {
+                threads.emplace_back([&, thread]() {
+                    try
+                    {
+                        failures += runCommands(multiplexer, thread, argData.repeat);
+                        failures += (echoThroughChannel(multiplexer, thread)) ? 0 : 1;
+                    }
+                    catch (const CSSHMultiplexer::Exception &e)
+                    {
+                        std::cerr << e.getMessage() << std::endl;
+                        failures++;
+                    }
+                    catch (const CSSHChannel::Exception &e)
+                    {
+                        std::cerr << e.getMessage() << std::endl;
+                        failures++;
+                    }
+                });
+            }
+            for (auto &thread : threads)
+            {
+                thread.join();
+            }
+            std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() - start};
+            if (failures != 0)
+            {
+                throw std::runtime_error(std::to_string(failures) + " multiplexed operation(s) gave unexpected results.");
+            }
+            std::cout << "Ran " << (argData.threads * argData.repeat) << " commands and " << argData.threads << " channel echoes in " << elapsed.count() << "s" << std::endl;
+        }
+        // Submissions racing stop never left waiting
+        {
+            CSSHMultiplexer multiplexer{sshSession};
+            std::atomic<bool> stopped{false};
+            std::atomic<unsigned int> stranded{0};
+            std::vector<std::thread> threads;
+            for (unsigned int thread = 0; thread < argData.threads; thread++)
+            {
+                threads.emplace_back([&]() { stranded += submitUntilStopped(multiplexer, stopped); });
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            multiplexer.stop();
+            stopped = true;
+            for (auto &thread : threads)
+            {
+                thread.join();
+            }
+            if (stranded != 0)
+            {
+                throw std::runtime_error(std::to_string(stranded) + " operation(s) submitted around stop were left waiting.");
+            }
+            std::cout << "No operations submitted around stop left waiting." << std::endl;
+        }
+        sshSession.disconnect();
+    }
+    catch (const CSSHMultiplexer::Exception &e)
+    {
+        exitWithError(e.getMessage());
+    }
+    catch (const CSSHChannel::Exception &e)
+    {
+        exitWithError(e.getMessage());
+    }
+    catch (const CSSHSession::Exception &e)
+    {
+        exitWithError(e.getMessage());
+    }
+    catch (std::exception &e)
+    {
+        exitWithError(e.what());
+    }
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,269 @@
+/*
+ * File:   ITSSHChannelUtil.cpp
+ *
+ * Author: Robert Tizzard
+ *
+ * Created on October 18, 2026, 6:30 PM
+ *
+ * Copyright 2021.
+ *
+ */
+//
+// Program: ITSSHChannelUtil
+//
+// Description: Check running a command on many hosts at once (SSHChannelUtil
+// executeCommandParallel()) against an SSH server, which stands in for each host. The
+// command writes a lot of stderr before any stdout so it stalls unless both are read as
+// they arrive; every host's output is split into lines (LineIOContext) and counted and its
+// exit status checked. A host that cannot be connected to has to fail with an error while
+// the others complete, and a command that outlasts the deadline has to fail once it has
+// passed. The server's key is accepted if it is not already known. For example 16 hosts
+// run 8 at a time:
+//
+//     ITSSHChannelUtil -s localhost -u user -p password -n 16 -m 8
+//
+// Dependencies: C20++, Classes (CSSHSession, CFile), SSHChannelUtil.
+//               Linux, Boost C++ Libraries, libssh.
+//
+// ITSSHChannelUtil
+// Program Options:
+//   --help                   Print help messages
+//   -c [ --config ] arg      Config File Name
+//   -s [ --server ] arg      SSH Server
+//   -o [ --port ] arg        SSH Server port
+//   -u [ --user ] arg        Account username
+//   -p [ --password ] arg    User password
+//   -n [ --hosts ] arg       Hosts to run command on (default 8)
+//   -m [ --parallel ] arg    Maximum hosts run at once (default 4)
+// =============
+// INCLUDE FILES
+// =============
+//
+// C++ STL
+//
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <vector>
+#include <memory>
+//
+// Antik Classes
+//
+#include "CFile.hpp"
+#include "CSSHSession.hpp"
+#include "SSHChannelUtil.hpp"
+#include "SSHSessionUtil.hpp"
+using namespace Antik::SSH;
+using namespace Antik::File;
+using namespace Antik;
+//
+// Boost program options
+//
+#include <boost/program_options.hpp>
+namespace po = boost::program_options;
+// ======================
+// LOCAL TYES/DEFINITIONS
+// ======================
+// Command line parameter data
+struct ParamArgData
+{
+    std::string userName;        // SSH account user name
+    std::string userPassword;    // SSH account user name password
+    std::string serverName;      // SSH server
+    unsigned int serverPort{22}; // SSH server port
+    std::string configFileName;  // Configuration file name
+    unsigned int hosts{8};       // Hosts to run command on
+    unsigned int parallel{4};    // Maximum hosts run at once
+};
+// Lines received from a host
+struct HostLines
+{
+    std::size_t outputLines{0};
+    std::size_t errorLines{0};
+    std::string lastOutput;
+    std::string lastError;
+};
+// Accept the server if it is not already known
+class AcceptServer : public ServerVerificationContext
+{
+public:
+    bool serverFileNotFound(std::vector<unsigned char> &) override
+    {
+        return (true);
+    }
+    bool serverNotKnown(std::vector<unsigned char> &) override
+    {
+        return (true);
+    }
+};
+// ===============
+// LOCAL CONSTANTS
+// ===============
+constexpr int kCommandLines{20000}; // Lines written to stderr then stdout
+constexpr int kExitStatus{3};       // Command exit status
+// ===============
+// LOCAL FUNCTIONS
+// ===============
+//
+// Exit with error message/status
+//
+static void exitWithError(std::string errMsg)
+{
+    // Display error and exit.
+    std::cout.flush();
+    std::cerr << errMsg << std::endl;
+    exit(EXIT_FAILURE);
+}
+//
+// Add options common to both command line and config file
+//
+static void addCommonOptions(po::options_description &commonOptions, ParamArgData &argData)
+{
+    commonOptions.add_options()("server,s", po::value<std::string>(&argData.serverName)->required(), "SSH Server name")("port,o", po::value<unsigned int>(&argData.serverPort), "SSH Server port")("user,u", po::value<std::string>(&argData.userName)->required(), "Account username")("password,p", po::value<std::string>(&argData.userPassword)->required(), "User password")("hosts,n", po::value<unsigned int>(&argData.hosts), "Hosts to run command on")("parallel,m", po::value<unsigned int>(&argData.parallel), "Maximum hosts run at once");
+}
+//
+// Read in and process command line arguments using boost.
+//
+static void procCmdLine(int argc, char **argv, ParamArgData &argData)
+{
+    // Define and parse the program options
+    po::options_description commandLine("Program Options");
+    commandLine.add_options()("help", "Print help messages")("config,c", po::value<std::string>(&argData.configFileName), "Config File Name");
+    addCommonOptions(commandLine, argData);
+    po::options_description configFile("Config Files Options");
+    addCommonOptions(configFile, argData);
+    po::variables_map vm;
+    try
+    {
+        // Process arguments
+        po::store(po::parse_command_line(argc, argv, commandLine), vm);
+        // Display options and exit with success
+        if (vm.count("help"))
+        {
+            std::cout << "ITSSHChannelUtil" << std::endl
+                      << commandLine << std::endl;
+            exit(EXIT_SUCCESS);
+        }
+        if (vm.count("config"))
+        {
+            if (CFile::exists(vm["config"].as<std::string>()))
+            {
+                std::ifstream configFileStream{vm["config"].as<std::string>()};
+                if (configFileStream)
+                {
+                    po::store(po::parse_config_file(configFileStream, configFile), vm);
+                }
+            }
+            else
+            {
+                throw po::error("Specified config file does not exist.");
+            }
+        }
+        po::notify(vm);
+    }
+    catch (po::error &e)
+    {
+        std::cerr << "ITSSHChannelUtil Error: " << e.what() << std::endl
+                  << std::endl;
+        std::cerr << commandLine << std::endl;
+        exit(EXIT_FAILURE);
+    }
+}
+//
+// Create a (not yet connected) session for the server.
+//
+static std::unique_ptr<CSSHSession> hostSession(const ParamArgData &argData, unsigned int serverPort)
+{
+    auto sshSession{std::make_unique<CSSHSession>()};
+    sshSession->setServer(argData.serverName);
+    sshSession->setPort(serverPort);
+    sshSession->setUser(argData.userName);
+    sshSession->setUserPassword(argData.userPassword);
+    return (sshSession);
+}
+// ============================
+// ===== MAIN ENTRY POint =====
+// ============================
+int main(int argc, char **argv)
+{
+    try
+    {
+        ParamArgData argData;
+        AcceptServer verificationContext;
+        // Read in command line parameters and process
+        procCmdLine(argc, argv, argData);
+        std::cout << "SERVER [" << argData.serverName << "]" << std::endl;
+        std::cout << "SERVER PORT [" << argData.serverPort << "]" << std::endl;
+        std::cout << "USER [" << argData.userName << "]" << std::endl;
+        std::cout << "HOSTS [" << argData.hosts << "]" << std::endl;
+        std::cout << "PARALLEL [" << argData.parallel << "]\n"
+                  << std::endl;
+        // Every host (plus one that cannot be connected to) runs a command writing
+        // stderr then stdout.
+        {
+            std::vector<std::unique_ptr<CSSHSession>> sessions;
+            std::vector<HostLines> hostLines(argData.hosts + 1);
+            std::vector<std::unique_ptr<LineIOContext>> ioContexts;
+            CommandHostList commandHosts;
+            for (unsigned int host = 0; host <= argData.hosts; host++)
+            {
+                sessions.push_back(hostSession(argData, (host < argData.hosts) ? argData.serverPort : 1));
+                ioContexts.push_back(std::make_unique<LineIOContext>([&lines = hostLines[host]](const std::string &line, bool isStdErr) {
+                    (isStdErr) ? lines.errorLines++ : lines.outputLines++;
+                    ((isStdErr) ? lines.lastError : lines.lastOutput) = line;
+                }));
+                commandHosts.push_back(CommandHost{*sessions.back(), *ioContexts.back()});
+            }
+            std::string command{"seq -f 'error %g' " + std::to_string(kCommandLines) + " 1>&2; seq -f 'output %g' " + std::to_string(kCommandLines) + "; exit " + std::to_string(kExitStatus)};
+            auto start = std::chrono::steady_clock::now();
+            std::size_t completedHosts{executeCommandParallel(commandHosts, command, verificationContext, argData.parallel, std::chrono::seconds(60))};
+            std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() - start};
+            if (completedHosts != argData.hosts)
+            {
+                throw std::runtime_error("Command completed on " + std::to_string(completedHosts) + " of " + std::to_string(argData.hosts) + " hosts.");
+            }
+            for (unsigned int host = 0; host < argData.hosts; host++)
+            {
+                if (!commandHosts[host].completed || (commandHosts[host].exitStatus != kExitStatus) ||
+                    (hostLines[host].outputLines != kCommandLines) || (hostLines[host].errorLines != kCommandLines) ||
+                    (hostLines[host].lastOutput != "output " + std::to_string(kCommandLines)) || (hostLines[host].lastError != "error " + std::to_string(kCommandLines)))
+                {
+                    throw std::runtime_error("Host " + std::to_string(host) + " gave unexpected results [" + commandHosts[host].errorMessage + "]");
+                }
+            }
+            if (commandHosts.back().completed || commandHosts.back().errorMessage.empty())
+            {
+                throw std::runtime_error("Host that could not be connected to did not fail.");
+            }
+            std::cout << "Command run on " << completedHosts << " hosts in " << elapsed.count() << "s; unreachable host [" << commandHosts.back().errorMessage << "]" << std::endl;
+        }
+        // A command that outlasts the deadline fails once it has passed.
+        {
+            auto sshSession{hostSession(argData, argData.serverPort)};
+            LineIOContext ioContext{[](const std::string &, bool) {}};
+            CommandHostList commandHosts{CommandHost{*sshSession, ioContext}};
+            auto start = std::chrono::steady_clock::now();
+            std::size_t completedHosts{executeCommandParallel(commandHosts, "sleep 30", verificationContext, 1, std::chrono::seconds(2))};
+            std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() - start};
+            if ((completedHosts != 0) || commandHosts[0].completed || (elapsed.count() > 10))
+            {
+                throw std::runtime_error("Command outlasting the deadline did not fail in time.");
+            }
+            std::cout << "Deadline exceeded after " << elapsed.count() << "s [" << commandHosts[0].errorMessage << "]" << std::endl;
+            sshSession->disconnect();
+        }
+    }
+    catch (const CSSHChannel::Exception &e)
+    {
+        exitWithError(e.getMessage());
+    }
+    catch (const CSSHSession::Exception &e)
+    {
+        exitWithError(e.getMessage());
+    }
+    catch (std::exception &e)
+    {
+        exitWithError(e.what());
+    }
+    exit(EXIT_SUCCESS);
+}
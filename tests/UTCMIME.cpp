@@ -0,0 +1,168 @@
+/*
+ * File:   UTCMIME.cpp
+ *
+ * Author: Robert Tizzard
+ *
+ * Created on October 24, 2016, 2:34 PM
+ *
+ * Description: Google unit tests for class CMIME.
+ *
+ * Copyright 2021.
+ *
+ */
+// =============
+// INCLUDE FILES
+// =============
+// Google test
+#include "gtest/gtest.h"
+// C++ STL
+#include <stdexcept>
+#include <chrono>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+// CMIME class
+#include "CMIME.hpp"
+using namespace Antik::File;
+// =======================
+// UNIT TEST FIXTURE CLASS
+// =======================
+class UTCMIME : public ::testing::Test
+{
+protected:
+    // Empty constructor
+    UTCMIME()
+    {
+    }
+    // Empty destructor
+    ~UTCMIME() override
+    {
+    }
+    void SetUp() override
+    {
+    }
+    void TearDown() override
+    {
+    }
+    static std::string decode(const std::string &mime, bool toUTF8 = false);
+};
+// =================
+// FIXTURE CONSTANTS
+// =================
+// ===============
+// FIXTURE METHODS
+// ===============
+//
+// Decode MIME string into a fixed buffer and return result as a string.
+//
+std::string UTCMIME::decode(const std::string &mime, bool toUTF8)
+{
+    char decoded[1024];
+    return (std::string(decoded, CMIME::decodeMIMEString(mime, decoded, sizeof(decoded), toUTF8)));
+}
+// =====================
+// TASK CLASS UNIT TESTS
+// =====================
+TEST_F(UTCMIME, FileMIMEType)
+{
+    EXPECT_STREQ("application/pdf", CMIME::getFileMIMEType("/tmp/report.pdf").c_str());
+    EXPECT_STREQ("image/jpeg", CMIME::getFileMIMEType("photo.JPG").c_str());
+    EXPECT_STREQ("model/vrml", CMIME::getFileMIMEType("world.wrl").c_str());
+    EXPECT_STREQ("application/unknown", CMIME::getFileMIMEType("noextension").c_str());
+    EXPECT_STREQ("application/unknown", CMIME::getFileMIMEType("file.notanextension").c_str());
+    EXPECT_STREQ("application/unknown", CMIME::getFileMIMEType("/tmp/dir.pdf/file").c_str());
+}
+TEST_F(UTCMIME, ExtensionMIMETypeFirstMappingWins)
+{
+    EXPECT_EQ("application/x-sh", CMIME::getExtensionMIMEType("sh"));
+    EXPECT_EQ("application/vnd.debian.binary-package", CMIME::getExtensionMIMEType("deb"));
+    EXPECT_EQ("application/andrew-inset", CMIME::getExtensionMIMEType("ez"));
+    EXPECT_EQ(CMIME::kUnknownMIMEType, CMIME::getExtensionMIMEType(""));
+}
+TEST_F(UTCMIME, SniffMIMEType)
+{
+    EXPECT_EQ("image/png", CMIME::sniffMIMEType(std::string_view("\x89PNG\r\n\x1a\n\x00\x00", 10)));
+    EXPECT_EQ("application/pdf", CMIME::sniffMIMEType("%PDF-1.7"));
+    EXPECT_EQ("application/gzip", CMIME::sniffMIMEType("\x1f\x8b\x08"));
+    EXPECT_EQ("image/jpeg", CMIME::sniffMIMEType("\xff\xd8\xff\xe0"));
+    std::string tarHeader(512, '\0');
+    tarHeader.replace(257, 5, "ustar");
+    EXPECT_EQ("application/x-tar", CMIME::sniffMIMEType(tarHeader));
+    EXPECT_EQ(CMIME::kUnknownMIMEType, CMIME::sniffMIMEType("plain text"));
+    EXPECT_EQ(CMIME::kUnknownMIMEType, CMIME::sniffMIMEType(""));
+}
+TEST_F(UTCMIME, SniffFileMIMEType)
+{
+    std::string fileName{"/tmp/utcmime.txt"};
+    std::ofstream{fileName, std::ios::binary} << "PK\x03\x04 zip contents";
+    EXPECT_EQ("application/zip", CMIME::sniffFileMIMEType(fileName));
+    std::filesystem::remove(fileName);
+    EXPECT_EQ(CMIME::kUnknownMIMEType, CMIME::sniffFileMIMEType(fileName));
+}
+TEST_F(UTCMIME, DecodePlainText)
+{
+    EXPECT_STREQ("Plain subject line", decode("Plain subject line").c_str());
+    EXPECT_STREQ("", decode("").c_str());
+}
+TEST_F(UTCMIME, DecodeBase64Word)
+{
+    EXPECT_STREQ("Hello World", decode("=?UTF-8?B?SGVsbG8gV29ybGQ=?=").c_str());
+    EXPECT_STREQ("Re: Hello World", decode("Re: =?utf-8?b?SGVsbG8gV29ybGQ=?=").c_str());
+}
+TEST_F(UTCMIME, DecodeQuotedWord)
+{
+    EXPECT_STREQ("Hello World!", decode("=?US-ASCII?Q?Hello_World=21?=").c_str());
+    EXPECT_STREQ("a=zz", decode("=?US-ASCII?q?a=zz?=").c_str());
+}
+TEST_F(UTCMIME, DecodeAdjacentWordsAndFolding)
+{
+    EXPECT_STREQ("HelloWorld", decode("=?UTF-8?Q?Hello?= =?UTF-8?Q?World?=").c_str());
+    EXPECT_STREQ("HelloWorld", decode("=?UTF-8?Q?Hello?=\r\n =?UTF-8?Q?World?=").c_str());
+    EXPECT_STREQ("Hello World", decode("=?UTF-8?Q?Hello?= World").c_str());
+    EXPECT_STREQ("Folded subject", decode("Folded\r\n subject").c_str());
+}
+TEST_F(UTCMIME, DecodeMalformedWordKept)
+{
+    EXPECT_STREQ("=?UTF-8?X?abc?=", decode("=?UTF-8?X?abc?=").c_str());
+    EXPECT_STREQ("=?UTF-8?Q?no end", decode("=?UTF-8?Q?no end").c_str());
+}
+TEST_F(UTCMIME, DecodeBufferTooSmall)
+{
+    char decoded[4];
+    EXPECT_THROW(CMIME::decodeMIMEString("Too long", decoded, sizeof(decoded)), CMIME::Exception);
+    EXPECT_THROW(CMIME::decodeMIMEString("=?UTF-8?B?SGVsbG8gV29ybGQ=?=", decoded, sizeof(decoded)), CMIME::Exception);
+}
+TEST_F(UTCMIME, DecodeToUTF8)
+{
+    EXPECT_STREQ("caf\xc3\xa9", decode("=?ISO-8859-1?Q?caf=E9?=", true).c_str());
+    EXPECT_STREQ("caf\xe9", decode("=?ISO-8859-1?Q?caf=E9?=").c_str());
+    EXPECT_STREQ("caf\xc3\xa9", decode("=?ISO-8859-1?B?Y2Fm6Q==?=", true).c_str());
+    EXPECT_STREQ("caf\xc3\xa9", decode("=?UTF-8?Q?caf=C3=A9?=", true).c_str());
+    EXPECT_STREQ("abc", decode("=?X-UNKNOWN-CHARSET?Q?abc?=", true).c_str());
+    std::string longWord{"=?ISO-8859-1?Q?"}, longDecoded;
+    for (int character = 0; character < 300; character++)
+    {
+        longWord += "=E9";
+        longDecoded += "\xc3\xa9";
+    }
+    EXPECT_EQ(longDecoded, decode(longWord + "?=", true));
+}
+TEST_F(UTCMIME, ConvertMIMEStringToASCII)
+{
+    EXPECT_STREQ("Re: Hello World", CMIME::convertMIMEStringToASCII("Re: =?UTF-8?B?SGVsbG8=?= =?UTF-8?Q?_World?=").c_str());
+}
+TEST_F(UTCMIME, DecodeThroughput)
+{
+    std::vector<std::string> headers{"=?UTF-8?B?SGVsbG8gV29ybGQ=?=", "Re: =?ISO-8859-1?Q?caf=E9_au_lait?=",
+                                     "Plain subject line with no encoding", "=?UTF-8?Q?Hello?=\r\n =?UTF-8?Q?World?="};
+    char decoded[256];
+    std::size_t decodedTotal{0};
+    auto start = std::chrono::steady_clock::now();
+    for (int iteration = 0; iteration < 250000; iteration++)
+    {
+        decodedTotal += CMIME::decodeMIMEString(headers[iteration % headers.size()], decoded, sizeof(decoded));
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    RecordProperty("DecodeMilliseconds", static_cast<int>(elapsed.count()));
+    EXPECT_NE(0u, decodedTotal);
+}
@@ -0,0 +1,107 @@
+/*
+ * File:   UTCSFTP.cpp
+ *
+ * Author: Robert Tizzard
+ *
+ * Created on October 18, 2026, 11:05 AM
+ *
+ * Description: Google unit tests for the parts of class CSFTP that do not need a
+ * server connection.
+ *
+ * Copyright 2021.
+ *
+ */
+// =============
+// INCLUDE FILES
+// =============
+// Google test
+#include "gtest/gtest.h"
+// C++ STL
+#include <cstdlib>
+// CSFTP class
+#include "CSFTP.hpp"
+using namespace Antik::SSH;
+using namespace Antik;
+// =======================
+// UNIT TEST FIXTURE CLASS
+// =======================
+class UTCSFTP : public ::testing::Test
+{
+protected:
+    // Empty constructor
+    UTCSFTP()
+    {
+    }
+    // Empty destructor
+    ~UTCSFTP() override
+    {
+    }
+    CSFTP::DirectoryCache m_knownDirectories;
+};
+// ======================
+// KNOWN DIRECTORY CACHE
+// ======================
+TEST_F(UTCSFTP, DirectoryCacheTrailingSeparators)
+{
+    m_knownDirectories.add("/home/user/");
+    EXPECT_TRUE(m_knownDirectories.contains("/home/user"));
+    EXPECT_TRUE(m_knownDirectories.contains("/home/user//"));
+    EXPECT_FALSE(m_knownDirectories.contains("/home"));
+    m_knownDirectories.add("/");
+    EXPECT_TRUE(m_knownDirectories.contains("/"));
+}
+TEST_F(UTCSFTP, DirectoryCacheEmptyPathIgnored)
+{
+    m_knownDirectories.add("");
+    EXPECT_FALSE(m_knownDirectories.contains(""));
+    m_knownDirectories.add("/home");
+    m_knownDirectories.forget("");
+    EXPECT_TRUE(m_knownDirectories.contains("/home"));
+}
+TEST_F(UTCSFTP, DirectoryCacheForgetRemovesSubtree)
+{
+    for (auto directory : {"/home", "/home/user", "/home/user/a", "/home/user/a/b", "/home/user-old", "/home/username"})
+    {
+        m_knownDirectories.add(directory);
+    }
+    m_knownDirectories.forget("/home/user/");
+    EXPECT_TRUE(m_knownDirectories.contains("/home"));
+    EXPECT_FALSE(m_knownDirectories.contains("/home/user"));
+    EXPECT_FALSE(m_knownDirectories.contains("/home/user/a"));
+    EXPECT_FALSE(m_knownDirectories.contains("/home/user/a/b"));
+    EXPECT_TRUE(m_knownDirectories.contains("/home/user-old"));
+    EXPECT_TRUE(m_knownDirectories.contains("/home/username"));
+}
+TEST_F(UTCSFTP, DirectoryCacheForgetRootAndClear)
+{
+    m_knownDirectories.add("/home");
+    m_knownDirectories.add("/tmp");
+    m_knownDirectories.forget("/");
+    EXPECT_FALSE(m_knownDirectories.contains("/home"));
+    EXPECT_FALSE(m_knownDirectories.contains("/tmp"));
+    m_knownDirectories.add("/home");
+    m_knownDirectories.clear();
+    EXPECT_FALSE(m_knownDirectories.contains("/home"));
+}
+// =========================
+// COPY FILE ATTRIBUTES KEPT
+// =========================
+TEST_F(UTCSFTP, PreservedAttributes)
+{
+    CSFTP::FileAttributes fileAttributes{static_cast<sftp_attributes>(std::calloc(1, sizeof(sftp_attributes_struct)))};
+    fileAttributes->type = SSH_FILEXFER_TYPE_REGULAR;
+    fileAttributes->size = 1234;
+    fileAttributes->permissions = 0100755;
+    fileAttributes->atime = 1700000001;
+    fileAttributes->mtime = 1700000002;
+    fileAttributes->uid = 1000;
+    fileAttributes->gid = 100;
+    CSFTP::FileAttributes copiedAttributes{CSFTP::preservedAttributes(fileAttributes)};
+    EXPECT_EQ(static_cast<std::uint32_t>(SSH_FILEXFER_ATTR_PERMISSIONS | SSH_FILEXFER_ATTR_ACMODTIME | SSH_FILEXFER_ATTR_UIDGID), copiedAttributes->flags);
+    EXPECT_EQ(0755U, copiedAttributes->permissions);
+    EXPECT_EQ(1700000001U, copiedAttributes->atime);
+    EXPECT_EQ(1700000002U, copiedAttributes->mtime);
+    EXPECT_EQ(1000U, copiedAttributes->uid);
+    EXPECT_EQ(100U, copiedAttributes->gid);
+    EXPECT_EQ(0U, copiedAttributes->size); // Size not set
+}
@@ -0,0 +1,162 @@
+/*
+ * File:   UTCSFTPExtended.cpp
+ *
+ * Author: Robert Tizzard
+ *
+ * Created on October 18, 2026, 2:20 PM
+ *
+ * Description: Google unit tests for class CSFTPExtended packet encoding and reply
+ * parsing (no server connection needed).
+ *
+ * Copyright 2021.
+ *
+ */
+// =============
+// INCLUDE FILES
+// =============
+// Google test
+#include "gtest/gtest.h"
+// CSFTPExtended class
+#include "CSFTPExtended.hpp"
+using namespace Antik::SSH;
+using namespace Antik;
+// =======================
+// UNIT TEST FIXTURE CLASS
+// =======================
+class UTCSFTPExtended : public ::testing::Test
+{
+protected:
+    // Empty constructor
+    UTCSFTPExtended()
+    {
+    }
+    // Empty destructor
+    ~UTCSFTPExtended() override
+    {
+    }
+    static std::string binary(const std::string &hex);
+    static CSFTPExtended::Packet checkFileReply(const std::string &algorithm, const std::string &hashData);
+};
+// ===============
+// FIXTURE METHODS
+// ===============
+//
+// Convert hex to binary.
+//
+std::string UTCSFTPExtended::binary(const std::string &hex)
+{
+    std::string data;
+    for (std::size_t digit = 0; digit < hex.size(); digit += 2)
+    {
+        data.push_back(static_cast<char>(std::stoi(hex.substr(digit, 2), nullptr, 16)));
+    }
+    return (data);
+}
+//
+// Create a check-file extended reply (positioned after its id).
+//
+CSFTPExtended::Packet UTCSFTPExtended::checkFileReply(const std::string &algorithm, const std::string &hashData)
+{
+    CSFTPExtended::Packet reply;
+    reply.putString("check-file");
+    reply.putString(algorithm);
+    return (CSFTPExtended::Packet(reply.getData() + hashData));
+}
+// =================
+// PACKET ENCODING
+// =================
+TEST_F(UTCSFTPExtended, PacketWireFormat)
+{
+    CSFTPExtended::Packet packet;
+    packet.putByte(200);
+    packet.putUInt32(0x01020304);
+    packet.putUInt64(0x0102030405060708);
+    packet.putString("md5-hash");
+    EXPECT_EQ(std::string("\xc8\x01\x02\x03\x04\x01\x02\x03\x04\x05\x06\x07\x08\x00\x00\x00\x08md5-hash", 25), packet.getData());
+}
+TEST_F(UTCSFTPExtended, PacketRoundTrip)
+{
+    CSFTPExtended::Packet packet;
+    packet.putByte(201);
+    packet.putUInt32(0xfffffffe);
+    packet.putUInt64(0xfffffffffffffffd);
+    packet.putString(std::string("a\0b", 3));
+    packet.putString("");
+    CSFTPExtended::Packet decode{packet.getData()};
+    EXPECT_EQ(201, decode.getByte());
+    EXPECT_EQ(0xfffffffeU, decode.getUInt32());
+    EXPECT_EQ(0xfffffffffffffffdU, decode.getUInt64());
+    EXPECT_EQ(std::string("a\0b", 3), decode.getString());
+    EXPECT_EQ("", decode.getString());
+    EXPECT_TRUE(decode.atEnd());
+}
+TEST_F(UTCSFTPExtended, PacketTruncated)
+{
+    CSFTPExtended::Packet packet;
+    packet.putUInt32(10);
+    packet.putByte('x');
+    CSFTPExtended::Packet decode{packet.getData()};
+    EXPECT_THROW(decode.getString(), CSFTPExtended::Exception);
+    CSFTPExtended::Packet shortPacket{std::string("\x01\x02", 2)};
+    EXPECT_THROW(shortPacket.getUInt32(), CSFTPExtended::Exception);
+}
+// ===============
+// REPLY PARSING
+// ===============
+TEST_F(UTCSFTPExtended, CheckFileReplyBlocks)
+{
+    std::string abcHash{"ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"};
+    std::string emptyHash{"e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"};
+    CSFTPExtended::Packet reply{checkFileReply("sha256", binary(abcHash) + binary(emptyHash))};
+    CSFTPExtended::FileHash fileHash{CSFTPExtended::parseCheckFileReply(reply)};
+    EXPECT_EQ("sha256", fileHash.algorithm);
+    ASSERT_EQ(2U, fileHash.hashes.size());
+    EXPECT_EQ(abcHash, fileHash.hashes[0]);
+    EXPECT_EQ(emptyHash, fileHash.hashes[1]);
+}
+TEST_F(UTCSFTPExtended, CheckFileReplyInvalid)
+{
+    CSFTPExtended::Packet partialHash{checkFileReply("md5", std::string(17, 'x'))};
+    EXPECT_THROW(CSFTPExtended::parseCheckFileReply(partialHash), CSFTPExtended::Exception);
+    CSFTPExtended::Packet unknownAlgorithm{checkFileReply("crc32", std::string(4, 'x'))};
+    EXPECT_THROW(CSFTPExtended::parseCheckFileReply(unknownAlgorithm), CSFTPExtended::Exception);
+    CSFTPExtended::Packet noHash{checkFileReply("sha1", "")};
+    EXPECT_THROW(CSFTPExtended::parseCheckFileReply(noHash), CSFTPExtended::Exception);
+    CSFTPExtended::Packet wrongReply;
+    wrongReply.putString("md5-hash");
+    EXPECT_THROW(CSFTPExtended::parseCheckFileReply(wrongReply), CSFTPExtended::Exception);
+}
+TEST_F(UTCSFTPExtended, Md5HashReply)
+{
+    CSFTPExtended::Packet reply;
+    reply.putString("md5-hash");
+    reply.putString(binary("900150983cd24fb0d6963f7d28e17f72"));
+    EXPECT_EQ("900150983cd24fb0d6963f7d28e17f72", CSFTPExtended::parseMd5HashReply(reply));
+    CSFTPExtended::Packet notHashed;
+    notHashed.putString("md5-hash");
+    notHashed.putString("");
+    EXPECT_EQ("", CSFTPExtended::parseMd5HashReply(notHashed));
+    CSFTPExtended::Packet badLength;
+    badLength.putString("md5-hash");
+    badLength.putString("short");
+    EXPECT_THROW(CSFTPExtended::parseMd5HashReply(badLength), CSFTPExtended::Exception);
+}
+TEST_F(UTCSFTPExtended, HashLengths)
+{
+    EXPECT_EQ(16U, CSFTPExtended::hashLength("md5"));
+    EXPECT_EQ(20U, CSFTPExtended::hashLength("sha1"));
+    EXPECT_EQ(32U, CSFTPExtended::hashLength("sha256"));
+    EXPECT_EQ(64U, CSFTPExtended::hashLength("sha512"));
+    EXPECT_EQ(0U, CSFTPExtended::hashLength("crc32"));
+}
+TEST_F(UTCSFTPExtended, CopyDataArguments)
+{
+    CSFTPExtended::Packet arguments{CSFTPExtended::copyDataArguments("H1", "H2")};
+    EXPECT_EQ("copy-data", arguments.getString());
+    EXPECT_EQ("H1", arguments.getString());
+    EXPECT_EQ(0U, arguments.getUInt64());
+    EXPECT_EQ(0U, arguments.getUInt64()); // To end of file
+    EXPECT_EQ("H2", arguments.getString());
+    EXPECT_EQ(0U, arguments.getUInt64());
+    EXPECT_TRUE(arguments.atEnd());
+}
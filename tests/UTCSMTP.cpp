@@ -17,6 +17,10 @@
 #include "gtest/gtest.h"
 // C++ STL
 #include <stdexcept>
+#include <fstream>
+#include <filesystem>
+// mkdtemp
+#include <cstdlib>
 // CSMTP class
 #include "CSMTP.hpp"
 using namespace Antik::SMTP;
@@ -36,11 +40,16 @@ protected:
     }
     void SetUp() override
     {
+        char tempDirectory[]{"/tmp/UTCSMTPXXXXXX"};
+        ASSERT_NE(nullptr, ::mkdtemp(tempDirectory));
+        m_tempDirectory = tempDirectory;
     }
     void TearDown() override
     {
+        std::filesystem::remove_all(m_tempDirectory);
     }
     CSMTP smtp{};
+    std::string m_tempDirectory; // Per test temporary directory for attachments
 };
 // =================
 // FIXTURE CONSTANTS
@@ -150,3 +159,146 @@ TEST_F(UTCSMTP, CheckForNulls)
     mailMessage = smtp.getMailFull();
     EXPECT_TRUE(mailMessage.find('\0') == std::string::npos);
 }
+TEST_F(UTCSMTP, AttachmentCachedOnRepeatedSend)
+{
+    std::string attachmentFile{m_tempDirectory + "/attachment.txt"};
+    std::string mailMessage;
+    std::ofstream{attachmentFile} << "Man is distinguished, not only by his reason\nbut by this singular passion\n";
+    CSMTP::clearAttachmentCache();
+    smtp.setToAddress("<usesr02@hotmail.com>");
+    smtp.addFileAttachment(attachmentFile, "text/plain", CSMTP::kEncodingBase64);
+    mailMessage = smtp.getMailFull();
+    EXPECT_TRUE(CSMTP::getAttachmentCacheSize() != 0);
+    std::uintmax_t cacheSize{CSMTP::getAttachmentCacheSize()};
+    CSMTP smtp2;
+    smtp2.setToAddress("<usesr02@hotmail.com>");
+    smtp2.addFileAttachment(attachmentFile, "text/plain", CSMTP::kEncodingBase64);
+    std::string mailMessage2{smtp2.getMailFull()};
+    EXPECT_EQ(cacheSize, CSMTP::getAttachmentCacheSize());
+    EXPECT_EQ(mailMessage.substr(mailMessage.find("--xxxx")), mailMessage2.substr(mailMessage2.find("--xxxx")));
+    EXPECT_TRUE(mailMessage.find("TWFuIGlzIGRpc3Rpbmd1aXNoZWQs") != std::string::npos);
+}
+TEST_F(UTCSMTP, AttachmentCacheReencodesChangedFile)
+{
+    std::string attachmentFile{m_tempDirectory + "/attachment.txt"};
+    std::string mailMessage;
+    std::ofstream{attachmentFile} << "first contents\n";
+    CSMTP::clearAttachmentCache();
+    smtp.addFileAttachment(attachmentFile, "text/plain", CSMTP::kEncoding7Bit);
+    mailMessage = smtp.getMailFull();
+    EXPECT_TRUE(mailMessage.find("first contents\r\n") != std::string::npos);
+    std::ofstream{attachmentFile} << "second longer contents\n";
+    mailMessage = smtp.getMailFull();
+    EXPECT_TRUE(mailMessage.find("second longer contents\r\n") != std::string::npos);
+    EXPECT_TRUE(mailMessage.find("first contents\r\n") == std::string::npos);
+}
+TEST_F(UTCSMTP, AttachmentCacheSpillAndLimit)
+{
+    std::string attachmentFile{m_tempDirectory + "/attachment.bin"};
+    std::string mailMessage, mailMessageSpilled;
+    std::ofstream{attachmentFile, std::ios::binary} << std::string(100000, '\x7f');
+    CSMTP::clearAttachmentCache();
+    smtp.addFileAttachment(attachmentFile, "application/octet-stream", CSMTP::kEncodingBase64);
+    mailMessage = smtp.getMailFull();
+    CSMTP::clearAttachmentCache();
+    CSMTP::setAttachmentCacheSpillSize(1024);
+    mailMessageSpilled = smtp.getMailFull();
+    EXPECT_EQ(mailMessage.substr(mailMessage.find("--xxxx")), mailMessageSpilled.substr(mailMessageSpilled.find("--xxxx")));
+    CSMTP::setAttachmentCacheLimit(1024);
+    EXPECT_EQ(0u, CSMTP::getAttachmentCacheSize());
+    mailMessage = smtp.getMailFull();
+    EXPECT_EQ(0u, CSMTP::getAttachmentCacheSize());
+    EXPECT_EQ(mailMessage.substr(mailMessage.find("--xxxx")), mailMessageSpilled.substr(mailMessageSpilled.find("--xxxx")));
+    CSMTP::setAttachmentCacheLimit(64 * 1024 * 1024);
+    CSMTP::setAttachmentCacheSpillSize(4 * 1024 * 1024);
+}
+TEST_F(UTCSMTP, MailTemplateNotCompiled)
+{
+    EXPECT_THROW(smtp.getMailFull("<user02@gmail.com>", {}), CSMTP::Exception);
+}
+TEST_F(UTCSMTP, MailTemplateSubstitution)
+{
+    std::string mailMessage;
+    smtp.setFromAddress("<user01@gmail.com>");
+    smtp.setMailSubject("Report for {{name}}");
+    smtp.setMailMessage({"Dear {{name}},",
+                         "Your balance is {{balance}} as of {{unknown}}."});
+    smtp.compileMailTemplate();
+    mailMessage = smtp.getMailFull("<user02@gmail.com>", {{"name", "Fred"}, {"balance", "42"}});
+    EXPECT_TRUE(mailMessage.find("To: <user02@gmail.com>\r\n") != std::string::npos);
+    EXPECT_TRUE(mailMessage.find("Subject: Report for Fred\r\n") != std::string::npos);
+    EXPECT_TRUE(mailMessage.find("Dear Fred,\r\nYour balance is 42 as of {{unknown}}.\r\n") != std::string::npos);
+    mailMessage = smtp.getMailFull("<user03@gmail.com>", {{"name", "Wilma"}, {"balance", "7"}});
+    EXPECT_TRUE(mailMessage.find("To: <user03@gmail.com>\r\n") != std::string::npos);
+    EXPECT_TRUE(mailMessage.find("Subject: Report for Wilma\r\n") != std::string::npos);
+    EXPECT_TRUE(mailMessage.find("Dear Wilma,\r\nYour balance is 7 as of {{unknown}}.\r\n") != std::string::npos);
+}
+TEST_F(UTCSMTP, MailTemplateMatchesFullMail)
+{
+    std::string attachmentFile{m_tempDirectory + "/attachment.txt"};
+    std::string mailMessage, templateMessage;
+    std::ofstream{attachmentFile} << "attached text\n";
+    smtp.setFromAddress("<user01@gmail.com>");
+    smtp.setToAddress("<user02@gmail.com>");
+    smtp.setCCAddress("<user03@gmail.com>");
+    smtp.setMailSubject("Message From The Grave");
+    smtp.setMailMessage({"Man is distinguished, not only by his reason"});
+    smtp.addFileAttachment(attachmentFile, "text/plain", CSMTP::kEncodingBase64);
+    mailMessage = smtp.getMailFull();
+    smtp.compileMailTemplate();
+    templateMessage = smtp.getMailFull("<user02@gmail.com>", {});
+    // Skip date header
+    EXPECT_EQ(mailMessage.substr(mailMessage.find("To:")), templateMessage.substr(templateMessage.find("To:")));
+}
+TEST_F(UTCSMTP, MailTemplateHeaderInjectionRejected)
+{
+    smtp.setFromAddress("<user01@gmail.com>");
+    smtp.setMailSubject("Report for {{name}}");
+    smtp.setMailMessage({"Dear {{name}},"});
+    smtp.compileMailTemplate();
+    EXPECT_THROW(smtp.getMailFull("<user02@gmail.com>", {{"name", "Fred\r\nBcc: <victim@gmail.com>"}}), CSMTP::Exception);
+    EXPECT_THROW(smtp.getMailFull("<user02@gmail.com>", {{"name", "Fred\n\nInjected body"}}), CSMTP::Exception);
+    EXPECT_THROW(smtp.getMailFull("<user02@gmail.com>\r\nBcc: <victim@gmail.com>", {{"name", "Fred"}}), CSMTP::Exception);
+    EXPECT_NO_THROW(smtp.getMailFull("<user02@gmail.com>", {{"name", "Fred"}}));
+}
+TEST_F(UTCSMTP, MailTemplateNonASCIIHeadersEncoded)
+{
+    std::string mailMessage;
+    smtp.setFromAddress("<user01@gmail.com>");
+    smtp.setMailSubject("Report for {{name}}");
+    smtp.setMailMessage({"Dear {{name}},"});
+    smtp.compileMailTemplate();
+    mailMessage = smtp.getMailFull("\"J\xc3\xb6rg M\xc3\xbcller\" <user02@gmail.com>", {{"name", "J\xc3\xb6rg"}});
+    EXPECT_TRUE(mailMessage.find("To: =?UTF-8?B?SsO2cmcgTcO8bGxlcg==?= <user02@gmail.com>\r\n") != std::string::npos);
+    EXPECT_TRUE(mailMessage.find("Subject: =?UTF-8?B?UmVwb3J0IGZvciBKw7ZyZw==?=\r\n") != std::string::npos);
+    EXPECT_TRUE(mailMessage.find("Dear J\xc3\xb6rg,\r\n") != std::string::npos);
+    EXPECT_THROW(smtp.getMailFull("<j\xc3\xb6rg@gmail.com>", {}), CSMTP::Exception);
+}
+TEST_F(UTCSMTP, MailTemplateLongNonASCIISubjectFolded)
+{
+    std::string mailMessage, subject;
+    for (int character = 0; character < 40; character++)
+    {
+        subject.append("\xc3\xa9");
+    }
+    smtp.setMailSubject(subject);
+    mailMessage = smtp.getMailFull();
+    std::string subjectHeader{mailMessage.substr(mailMessage.find("Subject: "))};
+    subjectHeader = subjectHeader.substr(0, subjectHeader.find("\r\nMIME-Version"));
+    EXPECT_EQ("Subject: =?UTF-8?B?w6nDqcOpw6nDqcOpw6nDqcOpw6nDqcOpw6nDqcOpw6nDqcOpw6nDqcOpw6k=?=\r\n"
+              " =?UTF-8?B?w6nDqcOpw6nDqcOpw6nDqcOpw6nDqcOpw6nDqcOpw6nDqcOp?=",
+              subjectHeader);
+}
+TEST_F(UTCSMTP, MailTemplateNotClobberedByPlainPost)
+{
+    std::string mailMessage;
+    smtp.setFromAddress("<user01@gmail.com>");
+    smtp.setToAddress("<user02@gmail.com>");
+    smtp.setMailSubject("Compiled {{name}}");
+    smtp.compileMailTemplate();
+    smtp.setMailSubject("Changed after compile");
+    mailMessage = smtp.getMailFull();
+    EXPECT_TRUE(mailMessage.find("Subject: Changed after compile\r\n") != std::string::npos);
+    mailMessage = smtp.getMailFull("<user03@gmail.com>", {{"name", "Fred"}});
+    EXPECT_TRUE(mailMessage.find("Subject: Compiled Fred\r\n") != std::string::npos);
+}
@@ -0,0 +1,304 @@
+/*
+ * File:   UTCSMTPClient.cpp
+ *
+ * Author: Robert Tizzard
+ *
+ * Created on October 24, 2016, 2:34 PM
+ *
+ * Description: Google unit tests for class CSMTPClient (run against a loopback
+ * SMTP sink).
+ *
+ * Copyright 2021.
+ *
+ */
+// =============
+// INCLUDE FILES
+// =============
+// Google test
+#include "gtest/gtest.h"
+// C++ STL
+#include <stdexcept>
+#include <fstream>
+#include <filesystem>
+#include <thread>
+#include <algorithm>
+// Boost asio
+#include <boost/asio.hpp>
+// CSMTPClient/CSMTP class
+#include "CSMTPClient.hpp"
+#include "CSMTP.hpp"
+using namespace Antik::SMTP;
+// =======================
+// UNIT TEST FIXTURE CLASS
+// =======================
+class UTCSMTPClient : public ::testing::Test
+{
+protected:
+    // Empty constructor
+    UTCSMTPClient()
+    {
+    }
+    // Empty destructor
+    ~UTCSMTPClient() override
+    {
+    }
+    void SetUp() override
+    {
+    }
+    void TearDown() override
+    {
+        if (sinkThread.joinable())
+        {
+            sinkThread.join();
+        }
+    }
+    void startSink(const std::vector<std::string> &capabilities);
+    static std::string messageSource(const std::string &message, CSMTPClient::MessageSourceFn &sourceFn);
+    boost::asio::io_service ioService;
+    boost::asio::ip::tcp::acceptor acceptor{ioService, boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0)};
+    std::thread sinkThread;
+    std::vector<std::string> sinkCommands;
+    std::vector<std::string> sinkMessages;
+    std::string serverURL;
+};
+// =================
+// FIXTURE CONSTANTS
+// =================
+// ===============
+// FIXTURE METHODS
+// ===============
+//
+// Start single connection loopback SMTP sink advertising the passed capabilities. Commands
+// received and message bodies (un-dot stuffed) are recorded for checking.
+//
+void UTCSMTPClient::startSink(const std::vector<std::string> &capabilities)
+{
+    serverURL = "smtp://127.0.0.1:" + std::to_string(acceptor.local_endpoint().port());
+    sinkThread = std::thread([this, capabilities]() {
+        boost::asio::ip::tcp::socket socket{ioService};
+        boost::asio::streambuf input;
+        boost::system::error_code error;
+        std::string message;
+        auto reply = [&](const std::string &response) { boost::asio::write(socket, boost::asio::buffer(response), error); };
+        auto readLine = [&]() {
+            std::string line;
+            boost::asio::read_until(socket, input, "\r\n", error);
+            if (!error)
+            {
+                std::istream stream(&input);
+                std::getline(stream, line);
+                line.pop_back();
+            }
+            return (line);
+        };
+        acceptor.accept(socket);
+        reply("220 sink ESMTP\r\n");
+        while (!error)
+        {
+            std::string command{readLine()};
+            if (error)
+            {
+                break;
+            }
+            sinkCommands.push_back(command);
+            if (command.starts_with("EHLO"))
+            {
+                std::string response{"250-sink\r\n"};
+                for (auto &capability : capabilities)
+                {
+                    response += "250-" + capability + "\r\n";
+                }
+                reply(response + "250 HELP\r\n");
+            }
+            else if (command.starts_with("MAIL") || command.starts_with("RSET"))
+            {
+                reply("250 OK\r\n");
+            }
+            else if (command.starts_with("RCPT"))
+            {
+                reply(command.find("reject") == std::string::npos ? "250 OK\r\n" : "550 No such user\r\n");
+            }
+            else if (command == "DATA")
+            {
+                reply("354 Go ahead\r\n");
+                for (std::string line{readLine()}; !error && (line != "."); line = readLine())
+                {
+                    message += ((line.starts_with(".")) ? line.substr(1) : line) + "\r\n";
+                }
+                sinkMessages.push_back(message);
+                message.clear();
+                reply("250 OK queued\r\n");
+            }
+            else if (command.starts_with("BDAT"))
+            {
+                std::size_t chunkLength{std::stoul(command.substr(5))};
+                if (input.size() < chunkLength)
+                {
+                    boost::asio::read(socket, input, boost::asio::transfer_exactly(chunkLength - input.size()), error);
+                }
+                message.append(boost::asio::buffers_begin(input.data()), boost::asio::buffers_begin(input.data()) + chunkLength);
+                input.consume(chunkLength);
+                if (command.ends_with("LAST"))
+                {
+                    sinkMessages.push_back(message);
+                    message.clear();
+                }
+                reply("250 OK\r\n");
+            }
+            else if (command == "QUIT")
+            {
+                reply("221 Bye\r\n");
+                break;
+            }
+            else
+            {
+                reply("502 Not implemented\r\n");
+            }
+        }
+    });
+}
+//
+// Set up message source function to read from passed string.
+//
+std::string UTCSMTPClient::messageSource(const std::string &message, CSMTPClient::MessageSourceFn &sourceFn)
+{
+    sourceFn = [message, offset = std::size_t(0)](char *buffer, std::size_t bufferSize) mutable {
+        std::size_t bytesCopied{std::min(bufferSize, message.size() - offset)};
+        message.copy(buffer, bytesCopied, offset);
+        offset += bytesCopied;
+        return (bytesCopied);
+    };
+    return (message);
+}
+// =====================
+// TASK CLASS UNIT TESTS
+// =====================
+TEST_F(UTCSMTPClient, SendMailNotConnected)
+{
+    CSMTPClient client;
+    CSMTPClient::MessageSourceFn sourceFn;
+    messageSource("Test\r\n", sourceFn);
+    EXPECT_THROW(client.sendMail("from@sink", {"to@sink"}, sourceFn), CSMTPClient::Exception);
+}
+TEST_F(UTCSMTPClient, TLSRequiredWithoutSTARTTLS)
+{
+    startSink({"PIPELINING"});
+    {
+        CSMTPClient client;
+        client.setServer(serverURL);
+        EXPECT_THROW(client.connect(), CSMTPClient::Exception);
+    }
+}
+TEST_F(UTCSMTPClient, ParseCapabilities)
+{
+    startSink({"PIPELINING", "CHUNKING", "BINARYMIME", "8BITMIME", "SIZE 1000000", "AUTH PLAIN LOGIN"});
+    CSMTPClient client;
+    client.setServer(serverURL);
+    client.setTLSRequired(false);
+    client.connect();
+    auto capabilities{client.getCapabilities()};
+    EXPECT_TRUE(capabilities.pipelining);
+    EXPECT_TRUE(capabilities.chunking);
+    EXPECT_TRUE(capabilities.binaryMIME);
+    EXPECT_TRUE(capabilities.eightBitMIME);
+    EXPECT_FALSE(capabilities.startTLS);
+    EXPECT_TRUE(capabilities.size);
+    EXPECT_EQ(1000000u, capabilities.maximumSize);
+    ASSERT_EQ(2u, capabilities.authMechanisms.size());
+    EXPECT_STREQ("PLAIN", capabilities.authMechanisms[0].c_str());
+    client.disconnect();
+    EXPECT_FALSE(client.isConnected());
+}
+TEST_F(UTCSMTPClient, SendMailDataDotStuffed)
+{
+    startSink({});
+    CSMTPClient client;
+    CSMTPClient::MessageSourceFn sourceFn;
+    std::string message{messageSource("Subject: Test\r\n\r\n.Leading dot\r\nLast line\r\n", sourceFn)};
+    client.setServer(serverURL);
+    client.setTLSRequired(false);
+    client.connect();
+    client.sendMail("from@sink", {"to@sink", "cc@sink"}, sourceFn);
+    client.disconnect();
+    sinkThread.join();
+    ASSERT_EQ(1u, sinkMessages.size());
+    EXPECT_EQ(message, sinkMessages[0]);
+    EXPECT_NE(sinkCommands.end(), std::find(sinkCommands.begin(), sinkCommands.end(), "MAIL FROM:<from@sink>"));
+    EXPECT_NE(sinkCommands.end(), std::find(sinkCommands.begin(), sinkCommands.end(), "RCPT TO:<cc@sink>"));
+    EXPECT_NE(sinkCommands.end(), std::find(sinkCommands.begin(), sinkCommands.end(), "DATA"));
+}
+TEST_F(UTCSMTPClient, SendMailPipelinedChunks)
+{
+    startSink({"PIPELINING", "CHUNKING", "8BITMIME", "SIZE"});
+    CSMTPClient client;
+    CSMTPClient::MessageSourceFn sourceFn;
+    std::string message{messageSource(std::string(10000, 'x') + "\r\n.not stuffed\r\n", sourceFn)};
+    client.setServer(serverURL);
+    client.setTLSRequired(false);
+    client.setChunkSize(1024);
+    client.connect();
+    client.sendMail("from@sink", {"to@sink"}, sourceFn, false, message.size());
+    client.disconnect();
+    sinkThread.join();
+    ASSERT_EQ(1u, sinkMessages.size());
+    EXPECT_EQ(message, sinkMessages[0]);
+    EXPECT_EQ(10, std::count_if(sinkCommands.begin(), sinkCommands.end(), [](const std::string &command) { return (command.starts_with("BDAT")); }));
+    EXPECT_NE(sinkCommands.end(), std::find(sinkCommands.begin(), sinkCommands.end(), "MAIL FROM:<from@sink> BODY=8BITMIME SIZE=" + std::to_string(message.size())));
+    EXPECT_EQ(sinkCommands.end(), std::find(sinkCommands.begin(), sinkCommands.end(), "DATA"));
+}
+TEST_F(UTCSMTPClient, SendMailRecipientRejected)
+{
+    startSink({"PIPELINING"});
+    CSMTPClient client;
+    CSMTPClient::MessageSourceFn sourceFn;
+    messageSource("Test\r\n", sourceFn);
+    client.setServer(serverURL);
+    client.setTLSRequired(false);
+    client.connect();
+    EXPECT_THROW(client.sendMail("from@sink", {"reject@sink"}, sourceFn), CSMTPClient::Exception);
+    EXPECT_EQ(250, client.getLastStatusCode());
+    client.disconnect();
+    sinkThread.join();
+    EXPECT_TRUE(sinkMessages.empty() || sinkMessages[0].empty());
+    EXPECT_NE(sinkCommands.end(), std::find(sinkCommands.begin(), sinkCommands.end(), "RSET"));
+}
+TEST_F(UTCSMTPClient, SendMailBinaryNotSupported)
+{
+    startSink({"CHUNKING"});
+    CSMTPClient client;
+    CSMTPClient::MessageSourceFn sourceFn;
+    messageSource("Test\r\n", sourceFn);
+    client.setServer(serverURL);
+    client.setTLSRequired(false);
+    client.connect();
+    EXPECT_THROW(client.sendMail("from@sink", {"to@sink"}, sourceFn, true), CSMTPClient::Exception);
+}
+TEST_F(UTCSMTPClient, CSMTPNativeTransportBinaryAttachment)
+{
+    std::string attachmentName{"/tmp/utcsmtpclient.bin"};
+    std::string contents;
+    for (int byte = 0; byte < 256; byte++)
+    {
+        contents.append(1, static_cast<char>(byte));
+    }
+    std::ofstream{attachmentName, std::ios::binary} << contents;
+    startSink({"PIPELINING", "CHUNKING", "BINARYMIME"});
+    {
+        CSMTP smtp;
+        smtp.setServer(serverURL);
+        smtp.setTransport(CSMTP::Transport::native);
+        smtp.setTLSRequired(false);
+        smtp.setFromAddress("<from@sink>");
+        smtp.setToAddress("<to@sink>");
+        smtp.setMailSubject("Binary");
+        smtp.setMailMessage({"Binary attachment."});
+        smtp.addFileAttachment(attachmentName, "application/octet-stream", CSMTP::kEncodingBinary);
+        smtp.postMail();
+    }
+    sinkThread.join();
+    std::filesystem::remove(attachmentName);
+    ASSERT_EQ(1u, sinkMessages.size());
+    EXPECT_NE(std::string::npos, sinkMessages[0].find("Content-transfer-encoding: binary"));
+    EXPECT_NE(std::string::npos, sinkMessages[0].find(contents));
+    EXPECT_NE(sinkCommands.end(), std::find(sinkCommands.begin(), sinkCommands.end(), "MAIL FROM:<from@sink> BODY=BINARYMIME"));
+}
@@ -0,0 +1,220 @@
+/*
+ * File:   UTCSSHSessionPool.cpp
+ *
+ * Author: Robert Tizzard
+ *
+ * Created on October 18, 2026, 5:40 PM
+ *
+ * Description: Google unit tests for class CSSHSessionPool session reuse, per host
+ * limits, health checks and expiry. The pool's session operations are overridden so
+ * no server connection is needed.
+ *
+ * Copyright 2021.
+ *
+ */
+// =============
+// INCLUDE FILES
+// =============
+// Google test
+#include "gtest/gtest.h"
+// C++ STL
+#include <set>
+#include <mutex>
+#include <atomic>
+#include <future>
+#include <thread>
+// CSSHSessionPool class
+#include "CSSHSessionPool.hpp"
+using namespace Antik::SSH;
+using namespace Antik;
+// ======================
+// TEST SESSION POOL CLASS
+// ======================
+//
+// Session pool whose sessions are "connected" by recording them in a set.
+//
+class TestSessionPool : public CSSHSessionPool
+{
+public:
+    explicit TestSessionPool(ServerVerificationContext &verificationContext) : CSSHSessionPool(verificationContext)
+    {
+    }
+    std::atomic<int> m_connects{0};        // Sessions connected
+    std::atomic<int> m_keepAlives{0};      // Keepalives sent
+    std::atomic<int> m_disconnects{0};     // Sessions disconnected
+    std::atomic<bool> m_failConnect{false};   // == true connect fails
+    std::atomic<bool> m_failKeepAlive{false}; // == true keepalive fails (and disconnects)
+
+protected:
+    void connectSession(CSSHSession &session) override
+    {
+        if (m_failConnect)
+        {
+            throw CSSHSession::Exception("Connect failed.", __func__);
+        }
+        std::scoped_lock connectedLock(m_connectedMutex);
+        m_connected.insert(&session);
+        m_connects++;
+    }
+    bool isSessionConnected(CSSHSession &session) override
+    {
+        std::scoped_lock connectedLock(m_connectedMutex);
+        return (m_connected.count(&session) != 0);
+    }
+    void keepSessionAlive(CSSHSession &session) override
+    {
+        m_keepAlives++;
+        if (m_failKeepAlive)
+        {
+            std::scoped_lock connectedLock(m_connectedMutex);
+            m_connected.erase(&session);
+            throw CSSHSession::Exception("Keepalive failed.", __func__);
+        }
+    }
+    void disconnectSession(CSSHSession &session) override
+    {
+        std::scoped_lock connectedLock(m_connectedMutex);
+        m_connected.erase(&session);
+        m_disconnects++;
+    }
+
+private:
+    std::mutex m_connectedMutex;          // Connected set mutex
+    std::set<CSSHSession *> m_connected; // Connected sessions
+};
+// =======================
+// UNIT TEST FIXTURE CLASS
+// =======================
+class UTCSSHSessionPool : public ::testing::Test
+{
+protected:
+    // Set up session options and pool
+    UTCSSHSessionPool() : m_pool{m_verificationContext}
+    {
+        m_options.setServer("server1");
+        m_options.setUser("user1");
+        m_options.setUserPassword("password1");
+        m_otherUserOptions.setServer("server1");
+        m_otherUserOptions.setUser("user2");
+        m_otherUserOptions.setUserPassword("password2");
+        m_pool.setHealthCheckInterval(std::chrono::seconds(3600));
+    }
+    // Empty destructor
+    ~UTCSSHSessionPool() override
+    {
+    }
+    ServerVerificationContext m_verificationContext;
+    CSSHSession m_options;
+    CSSHSession m_otherUserOptions;
+    TestSessionPool m_pool;
+};
+// =============
+// SESSION REUSE
+// =============
+TEST_F(UTCSSHSessionPool, ReturnedSessionReused)
+{
+    CSSHSession *session;
+    {
+        auto lease = m_pool.acquire(m_options);
+        session = &lease.getSession();
+        EXPECT_EQ(1U, m_pool.getActiveCount());
+        EXPECT_EQ(0U, m_pool.getIdleCount());
+    }
+    EXPECT_EQ(0U, m_pool.getActiveCount());
+    EXPECT_EQ(1U, m_pool.getIdleCount());
+    auto lease = m_pool.acquire(m_options);
+    EXPECT_EQ(session, &lease.getSession());
+    EXPECT_EQ(1, m_pool.m_connects);
+    EXPECT_EQ(0, m_pool.m_keepAlives);
+}
+TEST_F(UTCSSHSessionPool, DifferentUserNotShared)
+{
+    auto lease = m_pool.acquire(m_options);
+    lease.release();
+    EXPECT_FALSE(lease);
+    auto otherLease = m_pool.acquire(m_otherUserOptions);
+    EXPECT_EQ(2, m_pool.m_connects);
+    EXPECT_EQ(1U, m_pool.getIdleCount());
+}
+TEST_F(UTCSSHSessionPool, InvalidatedSessionNotReused)
+{
+    {
+        auto lease = m_pool.acquire(m_options);
+        lease.invalidate();
+    }
+    EXPECT_EQ(1, m_pool.m_disconnects);
+    EXPECT_EQ(0U, m_pool.getIdleCount());
+    auto lease = m_pool.acquire(m_options);
+    EXPECT_EQ(2, m_pool.m_connects);
+}
+// ===============
+// PER HOST LIMITS
+// ===============
+TEST_F(UTCSSHSessionPool, HostLimitEvictsIdleSessionOfOtherUser)
+{
+    m_pool.setMaxSessionsPerHost(1);
+    m_pool.acquire(m_options).release();
+    auto lease = m_pool.acquire(m_otherUserOptions);
+    EXPECT_EQ(2, m_pool.m_connects);
+    EXPECT_EQ(1, m_pool.m_disconnects);
+    EXPECT_EQ(0U, m_pool.getIdleCount());
+}
+TEST_F(UTCSSHSessionPool, HostLimitWaitsForReturnedSession)
+{
+    m_pool.setMaxSessionsPerHost(1);
+    auto lease = m_pool.acquire(m_options);
+    CSSHSession *session{&lease.getSession()};
+    auto waitingLease = std::async(std::launch::async, [this]() {
+        return (&m_pool.acquire(m_options).getSession());
+    });
+    EXPECT_EQ(std::future_status::timeout, waitingLease.wait_for(std::chrono::milliseconds(100)));
+    lease.release();
+    EXPECT_EQ(session, waitingLease.get());
+    EXPECT_EQ(1, m_pool.m_connects);
+}
+TEST_F(UTCSSHSessionPool, ConnectFailureFreesHostSlot)
+{
+    m_pool.setMaxSessionsPerHost(1);
+    m_pool.m_failConnect = true;
+    EXPECT_THROW(m_pool.acquire(m_options), CSSHSession::Exception);
+    EXPECT_EQ(0U, m_pool.getActiveCount());
+    m_pool.m_failConnect = false;
+    auto lease = m_pool.acquire(m_options);
+    EXPECT_TRUE(lease);
+    EXPECT_EQ(1, m_pool.m_connects);
+}
+// =============
+// HEALTH CHECKS
+// =============
+TEST_F(UTCSSHSessionPool, KeepAliveSentAfterHealthCheckInterval)
+{
+    m_pool.setHealthCheckInterval(std::chrono::seconds(0));
+    m_pool.acquire(m_options).release();
+    auto lease = m_pool.acquire(m_options);
+    EXPECT_EQ(1, m_pool.m_keepAlives);
+    EXPECT_EQ(1, m_pool.m_connects);
+}
+TEST_F(UTCSSHSessionPool, FailedKeepAliveReplacesSession)
+{
+    m_pool.setHealthCheckInterval(std::chrono::seconds(0));
+    m_pool.acquire(m_options).release();
+    m_pool.m_failKeepAlive = true;
+    auto lease = m_pool.acquire(m_options);
+    EXPECT_EQ(1, m_pool.m_keepAlives);
+    EXPECT_EQ(2, m_pool.m_connects);
+    EXPECT_EQ(1U, m_pool.getActiveCount());
+}
+// ======
+// EXPIRY
+// ======
+TEST_F(UTCSSHSessionPool, PruneDisconnectsExpiredSessions)
+{
+    m_pool.acquire(m_options).release();
+    m_pool.prune();
+    EXPECT_EQ(1U, m_pool.getIdleCount());
+    m_pool.setMaxIdleTime(std::chrono::seconds(0));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    m_pool.prune();
+    EXPECT_EQ(0U, m_pool.getIdleCount());
+    EXPECT_EQ(1, m_pool.m_disconnects);
+}
@@ -0,0 +1,250 @@
+/*
+ * File:   UTCTar.cpp
+ *
+ * Author: Robert Tizzard
+ *
+ * Created on October 24, 2016, 2:34 PM
+ *
+ * Description: Google unit tests for class CTar.
+ *
+ * Copyright 2021.
+ *
+ */
+// =============
+// INCLUDE FILES
+// =============
+// Google test
+#include "gtest/gtest.h"
+// C++ STL
+#include <stdexcept>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <cstring>
+#include <cstdlib>
+// stat
+#include <sys/stat.h>
+// CTar class
+#include "CTar.hpp"
+using namespace Antik::File;
+using namespace Antik;
+// =======================
+// UNIT TEST FIXTURE CLASS
+// =======================
+class UTCTar : public ::testing::Test
+{
+protected:
+    // Empty constructor
+    UTCTar()
+    {
+    }
+    // Empty destructor
+    ~UTCTar() override
+    {
+    }
+    void SetUp() override
+    {
+        char tempDirectory[]{"/tmp/UTCTarXXXXXX"};
+        ASSERT_NE(nullptr, ::mkdtemp(tempDirectory));
+        m_tempDirectory = tempDirectory;
+        m_sourceDirectory = m_tempDirectory + "/source";
+        m_destinationDirectory = m_tempDirectory + "/destination";
+        std::filesystem::create_directories(m_sourceDirectory);
+    }
+    void TearDown() override
+    {
+        std::filesystem::remove_all(m_tempDirectory);
+    }
+    static void createFile(const std::string &fileName, const std::string &contents);
+    static std::string readFile(const std::string &fileName);
+    static std::string header(const std::string &name, char typeFlag, std::size_t size, const std::string &linkName = "");
+    static std::string data(const std::string &contents);
+    static std::string pack(const std::string &localDirectory);
+    static void unpack(const std::string &archive, const std::string &localDirectory, FileCompletionFn completionFn = nullptr);
+    std::string m_tempDirectory;        // Per test temporary directory
+    std::string m_sourceDirectory;      // Directory packed
+    std::string m_destinationDirectory; // Directory unpacked into
+};
+// ===============
+// FIXTURE METHODS
+// ===============
+//
+// Create/read a local file.
+//
+void UTCTar::createFile(const std::string &fileName, const std::string &contents)
+{
+    std::filesystem::create_directories(std::filesystem::path(fileName).parent_path());
+    std::ofstream{fileName, std::ios::binary} << contents;
+}
+std::string UTCTar::readFile(const std::string &fileName)
+{
+    std::ifstream fileStream{fileName, std::ios::binary};
+    std::ostringstream contents;
+    contents << fileStream.rdbuf();
+    return (contents.str());
+}
+//
+// Build a ustar header block by hand (with checksum) for decode tests.
+//
+std::string UTCTar::header(const std::string &name, char typeFlag, std::size_t size, const std::string &linkName)
+{
+    std::string block(CTar::kBlockSize, '\0');
+    char field[13];
+    block.replace(0, name.size(), name);
+    block.replace(100, 7, "0000644");
+    std::snprintf(field, sizeof(field), "%011zo", size);
+    block.replace(124, 11, field);
+    block.replace(136, 11, "00000000000");
+    block[156] = typeFlag;
+    block.replace(157, linkName.size(), linkName);
+    block.replace(257, 8, std::string("ustar\0" "00", 8));
+    unsigned int checksum{8 * ' '};
+    for (auto byte : block)
+    {
+        checksum += static_cast<unsigned char>(byte);
+    }
+    std::snprintf(field, sizeof(field), "%06o", checksum);
+    block.replace(148, 7, field, 7);
+    block[155] = ' ';
+    return (block);
+}
+//
+// Data padded to a block boundary.
+//
+std::string UTCTar::data(const std::string &contents)
+{
+    return (contents + std::string((CTar::kBlockSize - (contents.size() % CTar::kBlockSize)) % CTar::kBlockSize, '\0'));
+}
+//
+// Pack a directory into/unpack a directory from an in memory archive.
+//
+std::string UTCTar::pack(const std::string &localDirectory)
+{
+    std::string archive;
+    CTar::pack(localDirectory, [&archive](const char *buffer, std::size_t length) { archive.append(buffer, length); });
+    return (archive);
+}
+void UTCTar::unpack(const std::string &archive, const std::string &localDirectory, FileCompletionFn completionFn)
+{
+    std::size_t offset{0};
+    CTar::unpack(localDirectory, [&](char *buffer, std::size_t length) {
+        std::size_t bytesCopied{archive.copy(buffer, std::min<std::size_t>(length, 1000), offset)};
+        offset += bytesCopied;
+        return (bytesCopied);
+    },
+                 completionFn);
+}
+// =====================
+// TASK CLASS UNIT TESTS
+// =====================
+TEST_F(UTCTar, PackUnpackRoundTrip)
+{
+    std::string largeContents;
+    for (int byte = 0; byte < 200000; byte++)
+    {
+        largeContents.append(1, static_cast<char>(byte * 7));
+    }
+    createFile(m_sourceDirectory + "/small.txt", "small file");
+    createFile(m_sourceDirectory + "/empty.txt", "");
+    createFile(m_sourceDirectory + "/sub/dir/large.bin", largeContents);
+    std::filesystem::create_directories(m_sourceDirectory + "/emptydir");
+    std::filesystem::permissions(m_sourceDirectory + "/small.txt", std::filesystem::perms::owner_read | std::filesystem::perms::owner_write | std::filesystem::perms::owner_exec);
+    std::filesystem::create_symlink("small.txt", m_sourceDirectory + "/link.txt");
+    std::string archive{pack(m_sourceDirectory)};
+    EXPECT_EQ(0u, archive.size() % CTar::kBlockSize);
+    std::vector<std::string> unpacked;
+    unpack(archive, m_destinationDirectory, [&unpacked](const std::string &fileName) { unpacked.push_back(fileName); });
+    EXPECT_EQ(7u, unpacked.size());
+    EXPECT_EQ("small file", readFile(m_destinationDirectory + "/small.txt"));
+    EXPECT_EQ("", readFile(m_destinationDirectory + "/empty.txt"));
+    EXPECT_EQ(largeContents, readFile(m_destinationDirectory + "/sub/dir/large.bin"));
+    EXPECT_TRUE(std::filesystem::is_directory(m_destinationDirectory + "/emptydir"));
+    EXPECT_TRUE(std::filesystem::is_symlink(m_destinationDirectory + "/link.txt"));
+    EXPECT_EQ("small.txt", std::filesystem::read_symlink(m_destinationDirectory + "/link.txt").string());
+    EXPECT_EQ(std::filesystem::perms::owner_all, std::filesystem::status(m_destinationDirectory + "/small.txt").permissions());
+    struct stat sourceStat, destinationStat;
+    ASSERT_EQ(0, ::stat((m_sourceDirectory + "/sub/dir/large.bin").c_str(), &sourceStat));
+    ASSERT_EQ(0, ::stat((m_destinationDirectory + "/sub/dir/large.bin").c_str(), &destinationStat));
+    EXPECT_EQ(sourceStat.st_mtime, destinationStat.st_mtime);
+}
+TEST_F(UTCTar, PackUnpackLongNames)
+{
+    std::string longDirectory(120, 'd'), longFile(150, 'f');
+    std::string splitName{longDirectory + "/" + std::string(90, 's')};
+    createFile(m_sourceDirectory + "/" + longFile, "long file name");
+    createFile(m_sourceDirectory + "/" + splitName, "prefix split name");
+    std::filesystem::create_symlink(std::string(140, 'l'), m_sourceDirectory + "/longlink");
+    unpack(pack(m_sourceDirectory), m_destinationDirectory);
+    EXPECT_EQ("long file name", readFile(m_destinationDirectory + "/" + longFile));
+    EXPECT_EQ("prefix split name", readFile(m_destinationDirectory + "/" + splitName));
+    EXPECT_EQ(std::string(140, 'l'), std::filesystem::read_symlink(m_destinationDirectory + "/longlink").string());
+}
+TEST_F(UTCTar, UnpackRemoteTarStyleNames)
+{
+    std::string archive{header("./", '5', 0) + header("./dir/", '5', 0) + header("./dir/file.txt", '0', 5) + data("hello")};
+    unpack(archive + std::string(10240, '\0'), m_destinationDirectory);
+    EXPECT_EQ("hello", readFile(m_destinationDirectory + "/dir/file.txt"));
+}
+TEST_F(UTCTar, UnpackPaxAndGNUHeaders)
+{
+    std::string paxRecord{"31 path=pax/long/path/name.txt\n"};
+    std::string archive{header("PaxHeaders/x", 'x', paxRecord.size()) + data(paxRecord) + header("short", '0', 3) + data("pax")};
+    std::string gnuName{std::string(110, 'g') + ".txt"};
+    archive += header("././@LongLink", 'L', gnuName.size() + 1) + data(gnuName + std::string(1, '\0')) + header("truncated", '0', 3) + data("gnu");
+    unpack(archive, m_destinationDirectory);
+    EXPECT_EQ("pax", readFile(m_destinationDirectory + "/pax/long/path/name.txt"));
+    EXPECT_EQ("gnu", readFile(m_destinationDirectory + "/" + gnuName));
+    EXPECT_FALSE(std::filesystem::exists(m_destinationDirectory + "/short"));
+}
+TEST_F(UTCTar, UnpackBase256Size)
+{
+    std::string block{header("base256.txt", '0', 0)};
+    std::string size(12, '\0');
+    size[0] = static_cast<char>(0x80);
+    size[11] = 4;
+    block.replace(124, 12, size);
+    unsigned int checksum{8 * ' '};
+    for (std::size_t byte = 0; byte < block.size(); byte++)
+    {
+        checksum += ((byte >= 148) && (byte < 156)) ? 0 : static_cast<unsigned char>(block[byte]);
+    }
+    char field[8];
+    std::snprintf(field, sizeof(field), "%06o", checksum);
+    block.replace(148, 7, field, 7);
+    unpack(block + data("2561"), m_destinationDirectory);
+    EXPECT_EQ("2561", readFile(m_destinationDirectory + "/base256.txt"));
+}
+TEST_F(UTCTar, UnpackUnsafePathsRejected)
+{
+    EXPECT_THROW(unpack(header("../escape.txt", '0', 1) + data("x"), m_destinationDirectory), CTar::Exception);
+    EXPECT_THROW(unpack(header("dir/../../escape.txt", '0', 1) + data("x"), m_destinationDirectory), CTar::Exception);
+    EXPECT_THROW(unpack(header(m_tempDirectory + "/escape.txt", '0', 1) + data("x"), m_destinationDirectory), CTar::Exception);
+    EXPECT_THROW(unpack(header("link", '2', 0, m_tempDirectory) + header("link/escape.txt", '0', 1) + data("x"), m_destinationDirectory), CTar::Exception);
+    EXPECT_FALSE(std::filesystem::exists(m_tempDirectory + "/escape.txt"));
+}
+TEST_F(UTCTar, UnpackNonNormalLinkPathRejected)
+{
+    std::filesystem::create_directory(m_tempDirectory + "/outside");
+    EXPECT_THROW(unpack(header("x/./y", '2', 0, m_tempDirectory + "/outside") + header("x/y/escape.txt", '0', 1) + data("x"), m_destinationDirectory), CTar::Exception);
+    EXPECT_THROW(unpack(header("x//y/escape.txt", '0', 1) + data("x"), m_destinationDirectory), CTar::Exception);
+    EXPECT_FALSE(std::filesystem::exists(m_tempDirectory + "/outside/escape.txt"));
+}
+TEST_F(UTCTar, UnpackDirectoryReplacesLink)
+{
+    std::string outsideDirectory{m_tempDirectory + "/outside"};
+    std::filesystem::create_directory(outsideDirectory);
+    std::filesystem::permissions(outsideDirectory, std::filesystem::perms::owner_all);
+    auto outsideModified{std::filesystem::last_write_time(outsideDirectory)};
+    unpack(header("d", '2', 0, outsideDirectory) + header("d/", '5', 0), m_destinationDirectory);
+    EXPECT_FALSE(std::filesystem::is_symlink(m_destinationDirectory + "/d"));
+    EXPECT_TRUE(std::filesystem::is_directory(m_destinationDirectory + "/d"));
+    EXPECT_EQ(std::filesystem::perms::owner_all, std::filesystem::status(outsideDirectory).permissions());
+    EXPECT_EQ(outsideModified, std::filesystem::last_write_time(outsideDirectory));
+}
+TEST_F(UTCTar, UnpackInvalidArchive)
+{
+    std::string block{header("file.txt", '0', 10)};
+    block[0] = 'F';
+    EXPECT_THROW(unpack(block + data("0123456789"), m_destinationDirectory), CTar::Exception);
+    EXPECT_THROW(unpack(header("file.txt", '0', 1000) + "short", m_destinationDirectory), CTar::Exception);
+}
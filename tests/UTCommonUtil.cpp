@@ -0,0 +1,105 @@
+/*
+ * File:   UTCommonUtil.cpp
+ *
+ * Author: Robert Tizzard
+ *
+ * Created on October 18, 2026, 3:40 PM
+ *
+ * Description: Google unit tests for the common utility functions shared by the
+ * file transfer utilities.
+ *
+ * Copyright 2021.
+ *
+ */
+// =============
+// INCLUDE FILES
+// =============
+// Google test
+#include "gtest/gtest.h"
+// C++ STL
+#include <functional>
+#include <vector>
+#include <atomic>
+#include <stdexcept>
+// Common utility functions
+#include "CommonUtil.hpp"
+using namespace Antik;
+// =======================
+// UNIT TEST FIXTURE CLASS
+// =======================
+class UTCommonUtil : public ::testing::Test
+{
+protected:
+    // Stand in for a server/session; counts the items its worker processed
+    struct Server
+    {
+        std::size_t itemsProcessed{0};
+    };
+    // Empty constructor
+    UTCommonUtil()
+    {
+    }
+    // Empty destructor
+    ~UTCommonUtil() override
+    {
+    }
+    void SetUp() override
+    {
+        for (auto &server : m_servers)
+        {
+            m_serverList.push_back(std::ref(server));
+        }
+    }
+    Server m_servers[4];
+    std::vector<std::reference_wrapper<Server>> m_serverList;
+};
+// ================
+// PARALLEL WORKERS
+// ================
+TEST_F(UTCommonUtil, ParallelWorkersProcessEachItemOnce)
+{
+    std::vector<std::atomic<int>> itemCounts(1000);
+    double elapsedSeconds{runParallelWorkers(m_serverList, itemCounts.size(), [&](Server &server, std::size_t itemIndex) {
+        server.itemsProcessed++;
+        itemCounts[itemIndex]++;
+    })};
+    EXPECT_GE(elapsedSeconds, 0.0);
+    std::size_t itemsProcessed{0};
+    for (auto &server : m_servers)
+    {
+        itemsProcessed += server.itemsProcessed;
+    }
+    EXPECT_EQ(itemCounts.size(), itemsProcessed);
+    for (auto &itemCount : itemCounts)
+    {
+        EXPECT_EQ(1, itemCount);
+    }
+}
+TEST_F(UTCommonUtil, ParallelWorkersNoItemsOrServers)
+{
+    std::vector<std::reference_wrapper<Server>> noServers;
+    EXPECT_NO_THROW(runParallelWorkers(m_serverList, 0, [](Server &, std::size_t) { throw 1; }));
+    EXPECT_NO_THROW(runParallelWorkers(noServers, 10, [](Server &, std::size_t) { throw 1; }));
+}
+TEST_F(UTCommonUtil, ParallelWorkersRethrowStdException)
+{
+    EXPECT_THROW(runParallelWorkers(m_serverList, 100, [](Server &, std::size_t itemIndex) {
+                     if (itemIndex == 50)
+                     {
+                         throw std::runtime_error("Worker failed.");
+                     }
+                 }),
+                 std::runtime_error);
+}
+TEST_F(UTCommonUtil, ParallelWorkersRethrowNonStdExceptionAndStop)
+{
+    std::atomic<std::size_t> itemsStarted{0};
+    EXPECT_THROW(runParallelWorkers(m_serverList, 100000, [&](Server &, std::size_t) {
+                     if (itemsStarted++ == 10)
+                     {
+                         throw 42;
+                     }
+                 }),
+                 int);
+    EXPECT_LT(itemsStarted, 100000U); // Remaining items abandoned
+}
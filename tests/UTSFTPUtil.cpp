@@ -0,0 +1,258 @@
+/*
+ * File:   UTSFTPUtil.cpp
+ *
+ * Author: Robert Tizzard
+ *
+ * Created on October 18, 2026, 10:12 AM
+ *
+ * Description: Google unit tests for the SFTP utility functions that do not need
+ * a server connection.
+ *
+ * Copyright 2021.
+ *
+ */
+// =============
+// INCLUDE FILES
+// =============
+// Google test
+#include "gtest/gtest.h"
+// C++ STL
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+// SFTP utility functions
+#include "SFTPUtil.hpp"
+using namespace Antik::SSH;
+using namespace Antik;
+// =======================
+// UNIT TEST FIXTURE CLASS
+// =======================
+class UTSFTPUtil : public ::testing::Test
+{
+protected:
+    // Empty constructor
+    UTSFTPUtil()
+    {
+    }
+    // Empty destructor
+    ~UTSFTPUtil() override
+    {
+    }
+    void SetUp() override
+    {
+        char directoryTemplate[]{"/tmp/UTSFTPUtilXXXXXX"};
+        ASSERT_NE(::mkdtemp(directoryTemplate), nullptr);
+        m_tempDirectory = directoryTemplate;
+    }
+    void TearDown() override
+    {
+        std::filesystem::remove_all(m_tempDirectory);
+    }
+    static CSFTP::FileAttributes fileAttributes(std::uint8_t type, std::uint64_t size, std::uint32_t mtime, std::uint64_t mtime64 = 0);
+    static void createFile(const std::string &fileName, const std::string &contents);
+    std::string m_tempDirectory;
+};
+// ===============
+// FIXTURE METHODS
+// ===============
+//
+// Create remote file attributes as returned by a server (freed by sftp_attributes_free()
+// so allocated with calloc()).
+//
+CSFTP::FileAttributes UTSFTPUtil::fileAttributes(std::uint8_t type, std::uint64_t size, std::uint32_t mtime, std::uint64_t mtime64)
+{
+    CSFTP::FileAttributes attributes{static_cast<sftp_attributes>(std::calloc(1, sizeof(sftp_attributes_struct)))};
+    attributes->type = type;
+    attributes->size = size;
+    attributes->permissions = 0644;
+    attributes->mtime = mtime;
+    attributes->mtime64 = mtime64;
+    return (attributes);
+}
+//
+// Create a local file.
+//
+void UTSFTPUtil::createFile(const std::string &fileName, const std::string &contents)
+{
+    std::filesystem::create_directories(std::filesystem::path(fileName).parent_path());
+    std::ofstream{fileName, std::ios::binary} << contents;
+}
+// =====================
+// REMOTE LISTING ENTRY
+// =====================
+TEST_F(UTSFTPUtil, RemoteFileEntryVersion3Attributes)
+{
+    RemoteFileEntry remoteFile{remoteFileEntry("/home/user/file.txt", fileAttributes(SSH_FILEXFER_TYPE_REGULAR, 1234, 1700000000))};
+    EXPECT_EQ("/home/user/file.txt", remoteFile.path);
+    EXPECT_EQ(RemoteFileEntry::Type::regular, remoteFile.type);
+    EXPECT_EQ(1234U, remoteFile.size);
+    EXPECT_EQ(0644U, remoteFile.permissions);
+    EXPECT_EQ(1700000000U, remoteFile.modifiedTime);
+}
+TEST_F(UTSFTPUtil, RemoteFileEntry64BitTime)
+{
+    RemoteFileEntry remoteFile{remoteFileEntry("/home/user/file.txt", fileAttributes(SSH_FILEXFER_TYPE_REGULAR, 1, 1700000000, 5000000000))};
+    EXPECT_EQ(5000000000U, remoteFile.modifiedTime);
+}
+TEST_F(UTSFTPUtil, RemoteFileEntryTypes)
+{
+    EXPECT_EQ(RemoteFileEntry::Type::directory, remoteFileEntry("/home/user", fileAttributes(SSH_FILEXFER_TYPE_DIRECTORY, 0, 1)).type);
+    EXPECT_EQ(RemoteFileEntry::Type::symbolicLink, remoteFileEntry("/home/link", fileAttributes(SSH_FILEXFER_TYPE_SYMLINK, 0, 1)).type);
+    EXPECT_EQ(RemoteFileEntry::Type::other, remoteFileEntry("/dev/null", fileAttributes(0, 0, 1)).type);
+}
+// ==========================
+// RECURSIVE OPERATION LEVELS
+// ==========================
+TEST_F(UTSFTPUtil, RemoteFileLevelsDeepestFirst)
+{
+    RemoteFileEntryList remoteFileList{remoteFileEntry("/a/b/c/d", fileAttributes(SSH_FILEXFER_TYPE_DIRECTORY, 0, 1)),
+                                       remoteFileEntry("/a/b/c/d/file", fileAttributes(SSH_FILEXFER_TYPE_REGULAR, 1, 1)),
+                                       remoteFileEntry("/a/b/c", fileAttributes(SSH_FILEXFER_TYPE_DIRECTORY, 0, 1)),
+                                       remoteFileEntry("/a/b/link", fileAttributes(SSH_FILEXFER_TYPE_SYMLINK, 0, 1)),
+                                       remoteFileEntry("/a/b/e", fileAttributes(SSH_FILEXFER_TYPE_DIRECTORY, 0, 1)),
+                                       remoteFileEntry("/a/b", fileAttributes(SSH_FILEXFER_TYPE_DIRECTORY, 0, 1))};
+    auto levelPaths = [](const RemoteFileEntryList &levelFileList) {
+        std::vector<std::string> paths;
+        for (auto &remoteFile : levelFileList)
+        {
+            paths.push_back(remoteFile.path);
+        }
+        return (paths);
+    };
+    for (auto rootPath : {"/a/b", "/a/b/", "/a/b//"})
+    {
+        std::vector<RemoteFileEntryList> fileLevels{remoteFileLevels(remoteFileList, rootPath, true)};
+        ASSERT_EQ(4U, fileLevels.size()) << rootPath;
+        EXPECT_EQ((std::vector<std::string>{"/a/b/c/d/file", "/a/b/link"}), levelPaths(fileLevels[0]));
+        EXPECT_EQ((std::vector<std::string>{"/a/b/c/d"}), levelPaths(fileLevels[1]));
+        EXPECT_EQ((std::vector<std::string>{"/a/b/c", "/a/b/e"}), levelPaths(fileLevels[2]));
+        EXPECT_EQ((std::vector<std::string>{"/a/b"}), levelPaths(fileLevels[3]));
+    }
+    EXPECT_EQ((std::vector<std::string>{"/a/b/c/d/file"}), levelPaths(remoteFileLevels(remoteFileList, "/a/b", false)[0]));
+}
+TEST_F(UTSFTPUtil, RemoteFileLevelsServerRoot)
+{
+    RemoteFileEntryList remoteFileList{remoteFileEntry("/a", fileAttributes(SSH_FILEXFER_TYPE_DIRECTORY, 0, 1)),
+                                       remoteFileEntry("/", fileAttributes(SSH_FILEXFER_TYPE_DIRECTORY, 0, 1))};
+    std::vector<RemoteFileEntryList> fileLevels{remoteFileLevels(remoteFileList, "/", true)};
+    ASSERT_EQ(3U, fileLevels.size());
+    EXPECT_TRUE(fileLevels[0].empty());
+    EXPECT_EQ("/a", fileLevels[1].front().path);
+    EXPECT_EQ("/", fileLevels[2].front().path);
+}
+// ==============================
+// SEGMENTED DOWNLOAD CHECKPOINT
+// ==============================
+TEST_F(UTSFTPUtil, CheckpointIdentityUsesVersion3Time)
+{
+    EXPECT_EQ("1000 1700000000 64", segmentCheckpointIdentity(fileAttributes(SSH_FILEXFER_TYPE_REGULAR, 1000, 1700000000), 64));
+}
+TEST_F(UTSFTPUtil, CheckpointCompletedSegments)
+{
+    std::string checkpointFile{m_tempDirectory + "/file.checkpoint"};
+    createFile(checkpointFile, "1000 1700000000 64\n0\n3\n15\n1");
+    EXPECT_EQ((std::set<std::uint64_t>{0, 3, 15}), readSegmentCheckpoint(checkpointFile, "1000 1700000000 64", 16));
+}
+TEST_F(UTSFTPUtil, CheckpointIdentityMismatch)
+{
+    std::string checkpointFile{m_tempDirectory + "/file.checkpoint"};
+    createFile(checkpointFile, "1000 1700000000 64\n0\n");
+    EXPECT_TRUE(readSegmentCheckpoint(checkpointFile, "1000 1700000001 64", 16).empty());
+    EXPECT_TRUE(readSegmentCheckpoint(m_tempDirectory + "/missing.checkpoint", "1000 1700000000 64", 16).empty());
+}
+TEST_F(UTSFTPUtil, CheckpointCorruptIgnored)
+{
+    std::string checkpointFile{m_tempDirectory + "/file.checkpoint"};
+    for (auto segments : {"0\nX1\n", "0\n\n2\n", "0\n-1\n", "0\n16\n", "0\n99999999999999999999999\n"})
+    {
+        createFile(checkpointFile, std::string("1000 1700000000 64\n") + segments);
+        EXPECT_TRUE(readSegmentCheckpoint(checkpointFile, "1000 1700000000 64", 16).empty()) << segments;
+    }
+}
+// =================
+// LOCAL FILE HASHES
+// =================
+TEST_F(UTSFTPUtil, LocalFileHashes)
+{
+    std::string localFile{m_tempDirectory + "/abc.txt"};
+    createFile(localFile, "abc");
+    EXPECT_EQ(std::vector<std::string>{"ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"}, localFileHashes(localFile));
+    EXPECT_EQ(std::vector<std::string>{"900150983cd24fb0d6963f7d28e17f72"}, localFileHashes(localFile, "md5"));
+    EXPECT_THROW(localFileHashes(localFile, "nohash"), std::invalid_argument);
+    createFile(localFile, "");
+    EXPECT_EQ(std::vector<std::string>{"e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"}, localFileHashes(localFile));
+}
+TEST_F(UTSFTPUtil, LocalFileBlockHashes)
+{
+    std::string localFile{m_tempDirectory + "/blocks.txt"};
+    std::string abcHash{"ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"};
+    createFile(localFile, "abcabcabc");
+    EXPECT_EQ((std::vector<std::string>{abcHash, abcHash, abcHash}), localFileHashes(localFile, "sha256", 3));
+    std::vector<std::string> blockHashes{localFileHashes(localFile, "sha256", 4)};
+    ASSERT_EQ(3U, blockHashes.size());
+    EXPECT_NE(abcHash, blockHashes[0]);
+    EXPECT_EQ("2e7d2c03a9507ae265ecf5b5356885a53393a2029d241394997265a1a25aefc6", blockHashes[2]); // "c"
+    // Blocks spanning reads of the hash buffer
+    createFile(localFile, std::string(200 * 1024, 'a'));
+    blockHashes = localFileHashes(localFile, "sha256", 100 * 1024);
+    ASSERT_EQ(2U, blockHashes.size());
+    EXPECT_EQ(blockHashes[0], blockHashes[1]);
+}
+// =====================
+// LOCAL FILE HASH CACHE
+// =====================
+TEST_F(UTSFTPUtil, HashCacheRehashesChangedFile)
+{
+    std::string localFile{m_tempDirectory + "/abc.txt"};
+    FileHashCache fileHashCache;
+    createFile(localFile, "abc");
+    EXPECT_EQ("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", fileHashCache.getHash(localFile));
+    EXPECT_EQ("900150983cd24fb0d6963f7d28e17f72", fileHashCache.getHash(localFile, "md5"));
+    createFile(localFile, "abcd");
+    EXPECT_EQ("88d4266fd4e6338d13b845fcf289579d209c897823b9217da3e161936f031589", fileHashCache.getHash(localFile));
+    EXPECT_EQ(1U, fileHashCache.size());
+}
+TEST_F(UTSFTPUtil, HashCachePersisted)
+{
+    std::string localFile{m_tempDirectory + "/abc.txt"};
+    std::string cacheFile{m_tempDirectory + "/hashes.cache"};
+    createFile(localFile, "abc");
+    {
+        FileHashCache fileHashCache{cacheFile};
+        fileHashCache.setHash(localFile, "cachedhash");
+        fileHashCache.save();
+    }
+    FileHashCache fileHashCache{cacheFile};
+    EXPECT_EQ(1U, fileHashCache.size());
+    EXPECT_EQ("cachedhash", fileHashCache.getHash(localFile)); // Not re-read as unchanged
+}
+TEST_F(UTSFTPUtil, HashCachePrunedOnSave)
+{
+    std::string localFile{m_tempDirectory + "/abc.txt"};
+    std::string keptFile{m_tempDirectory + "/kept.txt"};
+    std::string cacheFile{m_tempDirectory + "/hashes.cache"};
+    createFile(localFile, "abc");
+    createFile(keptFile, "kept");
+    {
+        FileHashCache fileHashCache{cacheFile};
+        fileHashCache.getHash(localFile);
+        fileHashCache.getHash(keptFile);
+        fileHashCache.save();
+    }
+    std::filesystem::remove(localFile);
+    {
+        FileHashCache fileHashCache{cacheFile};
+        EXPECT_EQ(2U, fileHashCache.size());
+        fileHashCache.save();
+        EXPECT_EQ(1U, fileHashCache.size());
+    }
+    FileHashCache fileHashCache{cacheFile};
+    EXPECT_EQ(1U, fileHashCache.size());
+}
+TEST_F(UTSFTPUtil, HashCacheOldFormatIgnored)
+{
+    std::string cacheFile{m_tempDirectory + "/hashes.cache"};
+    createFile(cacheFile, "1234 3 1700000000000000000 ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad\n");
+    FileHashCache fileHashCache{cacheFile};
+    EXPECT_EQ(0U, fileHashCache.size());
+}
@@ -0,0 +1,90 @@
+/*
+ * File:   UTSSHChannelUtil.cpp
+ *
+ * Author: Robert Tizzard
+ *
+ * Created on October 18, 2026, 6:05 PM
+ *
+ * Description: Google unit tests for the SSH channel utility IO contexts that do not
+ * need a server connection.
+ *
+ * Copyright 2021.
+ *
+ */
+// =============
+// INCLUDE FILES
+// =============
+// Google test
+#include "gtest/gtest.h"
+// C++ STL
+#include <vector>
+#include <utility>
+// SSH channel utility functions
+#include "SSHChannelUtil.hpp"
+using namespace Antik::SSH;
+using namespace Antik;
+// =======================
+// UNIT TEST FIXTURE CLASS
+// =======================
+class UTSSHChannelUtil : public ::testing::Test
+{
+protected:
+    // Line IO context recording lines passed on
+    UTSSHChannelUtil() : m_lineIOContext{[this](const std::string &line, bool isStdErr) { m_lines.emplace_back(line, isStdErr); }}
+    {
+    }
+    // Empty destructor
+    ~UTSSHChannelUtil() override
+    {
+    }
+    void writeOutput(std::string data)
+    {
+        m_lineIOContext.writeOutput(data.data(), static_cast<uint32_t>(data.size()));
+    }
+    void writeError(std::string data)
+    {
+        m_lineIOContext.writeError(data.data(), static_cast<uint32_t>(data.size()));
+    }
+    std::vector<std::pair<std::string, bool>> m_lines;
+    LineIOContext m_lineIOContext;
+};
+// ===============
+// LINE IO CONTEXT
+// ===============
+TEST_F(UTSSHChannelUtil, LineIOContextSplitsLines)
+{
+    writeOutput("one\ntwo\r\n\nthree\n");
+    std::vector<std::pair<std::string, bool>> expected{{"one", false}, {"two", false}, {"", false}, {"three", false}};
+    EXPECT_EQ(expected, m_lines);
+}
+TEST_F(UTSSHChannelUtil, LineIOContextJoinsLinesAcrossWrites)
+{
+    writeOutput("par");
+    writeOutput("tial li");
+    EXPECT_TRUE(m_lines.empty());
+    writeOutput("ne\r");
+    writeOutput("\nnext");
+    std::vector<std::pair<std::string, bool>> expected{{"partial line", false}};
+    EXPECT_EQ(expected, m_lines);
+}
+TEST_F(UTSSHChannelUtil, LineIOContextKeepsStreamsApart)
+{
+    writeOutput("out");
+    writeError("err");
+    writeOutput("put\n");
+    writeError("or\n");
+    std::vector<std::pair<std::string, bool>> expected{{"output", false}, {"error", true}};
+    EXPECT_EQ(expected, m_lines);
+}
+TEST_F(UTSSHChannelUtil, LineIOContextFlushPassesUnterminatedLines)
+{
+    m_lineIOContext.flush();
+    EXPECT_TRUE(m_lines.empty());
+    writeOutput("last output");
+    writeError("last error");
+    m_lineIOContext.flush();
+    std::vector<std::pair<std::string, bool>> expected{{"last output", false}, {"last error", true}};
+    EXPECT_EQ(expected, m_lines);
+    m_lineIOContext.flush();
+    EXPECT_EQ(expected, m_lines);
+}
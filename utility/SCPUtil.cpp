@@ -19,6 +19,15 @@
 #include <iostream>
 #include <system_error>
 #include <filesystem>
+#include <algorithm>
+#include <mutex>
+#include <chrono>
+#include <map>
+//
+// Linux
+//
+#include <fcntl.h>
+#include <unistd.h>
 //
 // SCP utility definitions
 //
@@ -52,48 +61,254 @@ namespace Antik ::SSH
         }
     }
     //
+    // Write a buffer to a local file descriptor.
+    //
+    static void writeAll(int localFile, const char *writeBuffer, std::size_t bytesToWrite)
+    {
+        while (bytesToWrite != 0)
+        {
+            ssize_t bytesWritten{::write(localFile, writeBuffer, bytesToWrite)};
+            if (bytesWritten == -1)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                throw std::system_error(errno, std::system_category());
+            }
+            writeBuffer += bytesWritten;
+            bytesToWrite -= bytesWritten;
+        }
+    }
+    //
     // Download the currently requested file from SCP server and write to local directory.
+    // The local file is preallocated to the (64 bit) size of the remote file and written
+    // sequentially from the SCP IO buffer. If the transfer ends early the local file is
+    // truncated to the data received (so the preallocation does not make it look complete)
+    // and an exception thrown.
     //
     static void downloadFile(CSCP &scpServer, const std::string &destinationFile)
     {
-        std::ofstream localFile;
         CSCP::FilePermissions filePermissions;
         char *ioBuffer = scpServer.getIoBuffer().get();
         size_t ioBufferSize = scpServer.getIoBufferSize();
         int bytesRead{0};
-        int fileSize{0};
+        std::uint64_t fileSize{0};
+        std::uint64_t bytesWritten{0};
         filePermissions = scpServer.requestFilePermissions();
-        fileSize = scpServer.requestFileSize();
+        fileSize = scpServer.requestFileSize64();
         scpServer.acceptRequest();
         if (!std::filesystem::exists(std::filesystem::path(destinationFile).parent_path()))
         {
             std::filesystem::create_directories(std::filesystem::path(destinationFile).parent_path());
         }
-        localFile.open(destinationFile, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
-        if (!localFile)
+        int localFile{::open(destinationFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600)};
+        if (localFile == -1)
         {
             throw std::system_error(errno, std::system_category());
         }
-        for (;;)
+        try
         {
-            bytesRead = scpServer.read(ioBuffer, ioBufferSize);
-            if (bytesRead)
+            // Preallocate (not supported by all file systems so failure ignored) and hint sequential access
+            if (fileSize != 0)
             {
-                localFile.write(ioBuffer, bytesRead);
-                if (!localFile)
+                ::fallocate(localFile, 0, 0, fileSize);
+            }
+            ::posix_fadvise(localFile, 0, 0, POSIX_FADV_SEQUENTIAL);
+            while (fileSize != 0)
+            {
+                bytesRead = scpServer.read(ioBuffer, std::min<std::uint64_t>(ioBufferSize, fileSize));
+                if (bytesRead == 0)
                 {
-                    throw std::system_error(errno, std::system_category());
+                    throw CSCP::Exception("Transfer ended with " + std::to_string(fileSize) + " bytes of " + destinationFile + " not received.", __func__);
                 }
+                writeAll(localFile, ioBuffer, bytesRead);
+                bytesWritten += bytesRead;
                 fileSize -= bytesRead;
             }
-            if ((fileSize <= 0) || (bytesRead == 0))
+        }
+        catch (...)
+        {
+            if (::ftruncate(localFile, bytesWritten) == -1)
             {
-                break;
+                // Already failing so truncate error ignored
             }
+            ::close(localFile);
+            throw;
+        }
+        if (::close(localFile) == -1)
+        {
+            throw std::system_error(errno, std::system_category());
         }
-        localFile.close();
         std::filesystem::permissions(destinationFile, static_cast<std::filesystem::perms>(filePermissions));
     }
+    //
+    // Upload a local file as the next file in the current remote directory of an SCP session
+    // (64 bit size; read sequentially into the SCP IO buffer).
+    //
+    static void uploadFile(CSCP &scpServer, const std::string &sourceFile, const std::string &remoteFileName)
+    {
+        char *ioBuffer = scpServer.getIoBuffer().get();
+        size_t ioBufferSize = scpServer.getIoBufferSize();
+        int localFile{::open(sourceFile.c_str(), O_RDONLY)};
+        if (localFile == -1)
+        {
+            throw std::system_error(errno, std::system_category());
+        }
+        try
+        {
+            ::posix_fadvise(localFile, 0, 0, POSIX_FADV_SEQUENTIAL);
+            scpServer.pushFile64(remoteFileName, std::filesystem::file_size(sourceFile), (CSCP::FilePermissions)std::filesystem::status(sourceFile).permissions());
+            for (;;)
+            {
+                ssize_t bytesRead{::read(localFile, ioBuffer, ioBufferSize)};
+                if (bytesRead == -1)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+                    throw std::system_error(errno, std::system_category());
+                }
+                if (bytesRead == 0)
+                {
+                    break;
+                }
+                scpServer.write(ioBuffer, bytesRead);
+            }
+        }
+        catch (...)
+        {
+            ::close(localFile);
+            throw;
+        }
+        ::close(localFile);
+    }
+    //
+    // Upload a local directory tree depth first into the current remote directory of an SCP
+    // session; entering (pushing) and leaving each sub-directory as it goes. As with
+    // listLocalRecursive() symbolic links to directories are not followed (so a link loop
+    // cannot recurse forever) while a link to a file uploads the file it points to.
+    //
+    static void uploadDirectory(CSCP &scpServer, FileMapper &fileMapper, const std::filesystem::path &localDirectory, FileList &successList, FileCompletionFn &completionFn)
+    {
+        for (auto &directoryEntry : std::filesystem::directory_iterator(localDirectory))
+        {
+            if (std::filesystem::is_directory(directoryEntry.symlink_status()))
+            {
+                scpServer.pushDirectory(directoryEntry.path().filename().string(), (CSCP::FilePermissions)directoryEntry.status().permissions());
+                successList.push_back(fileMapper.toRemote(directoryEntry.path().string()));
+                if (completionFn)
+                {
+                    completionFn(successList.back());
+                }
+                uploadDirectory(scpServer, fileMapper, directoryEntry.path(), successList, completionFn);
+                scpServer.leaveDirectory();
+            }
+            else if (directoryEntry.is_regular_file())
+            {
+                uploadFile(scpServer, directoryEntry.path().string(), directoryEntry.path().filename().string());
+                successList.push_back(fileMapper.toRemote(directoryEntry.path().string()));
+                if (completionFn)
+                {
+                    completionFn(successList.back());
+                }
+            }
+        }
+    }
+    //
+    // Upload a local file to a remote path through an SCP session rooted at "/"; entering its
+    // remote directory path and then leaving it again so the session can be reused.
+    //
+    static void uploadFileToPath(CSCP &scpServer, const std::string &sourceFile, const std::string &destinationFile)
+    {
+        std::vector<std::string> pathComponents;
+        std::filesystem::path remoteDirectory{std::filesystem::path(destinationFile).parent_path()};
+        boost::split(pathComponents, remoteDirectory.string(), boost::is_any_of(std::string(1, kServerPathSep)));
+        pathComponents.erase(std::remove(pathComponents.begin(), pathComponents.end(), ""), pathComponents.end());
+        makeRemotePath(scpServer, remoteDirectory.string(), (CSCP::FilePermissions)std::filesystem::status(std::filesystem::path(sourceFile).parent_path()).permissions());
+        uploadFile(scpServer, sourceFile, std::filesystem::path(destinationFile).filename().string());
+        for (std::size_t component = 0; component < pathComponents.size(); component++)
+        {
+            scpServer.leaveDirectory();
+        }
+    }
+    //
+    // Transfer files in parallel with runParallelWorkers(); a worker for each SSH session passed
+    // in takes the next file and passes it with its session (and any SCP session it keeps open)
+    // to the transfer function, which returns the file created and its size. Transfer function
+    // errors are reported and counted and completed files recorded (both serialized). Returns
+    // the success list and fills in statistics if passed.
+    //
+    static FileList runParallelTransfer(SSHSessionList &sshSessions, const FileList &fileList, FileCompletionFn &completionFn, TransferStatistics *statistics,
+                                        std::function<std::string(CSSHSession &sshSession, std::unique_ptr<CSCP> &scpServer, const std::string &file, std::uintmax_t &fileSize)> transferFn)
+    {
+        FileList successList;
+        TransferStatistics transferStatistics;
+        std::mutex completionMutex;
+        std::map<CSSHSession *, std::unique_ptr<CSCP>> scpServers; // Each only used by its session's worker
+        auto closeSCP = [](std::unique_ptr<CSCP> &scpServer) {
+            if (scpServer)
+            {
+                scpServer->close();
+                scpServer.reset();
+            }
+        };
+        for (CSSHSession &sshSession : sshSessions)
+        {
+            scpServers[&sshSession];
+        }
+        try
+        {
+            transferStatistics.elapsedSeconds = runParallelWorkers(sshSessions, fileList.size(), [&](CSSHSession &sshSession, std::size_t fileIndex) {
+                std::unique_ptr<CSCP> &scpServer{scpServers.at(&sshSession)};
+                try
+                {
+                    std::uintmax_t fileSize{0};
+                    std::string transferedFile{transferFn(sshSession, scpServer, fileList[fileIndex], fileSize)};
+                    std::scoped_lock completionLock(completionMutex);
+                    transferStatistics.filesTransfered++;
+                    transferStatistics.bytesTransfered += fileSize;
+                    successList.push_back(transferedFile);
+                    if (completionFn)
+                    {
+                        completionFn(successList.back());
+                    }
+                }
+                catch (const CSCP::Exception &e)
+                {
+                    closeSCP(scpServer); // SCP session state unknown so start a new one
+                    std::scoped_lock completionLock(completionMutex);
+                    transferStatistics.filesFailed++;
+                    std::cerr << e.getMessage() << std::endl;
+                }
+                catch (const std::exception &e)
+                {
+                    closeSCP(scpServer);
+                    std::scoped_lock completionLock(completionMutex);
+                    transferStatistics.filesFailed++;
+                    std::cerr << e.what() << std::endl;
+                }
+            });
+        }
+        catch (...)
+        {
+            for (auto &[sshSession, scpServer] : scpServers)
+            {
+                closeSCP(scpServer);
+            }
+            throw;
+        }
+        for (auto &[sshSession, scpServer] : scpServers)
+        {
+            closeSCP(scpServer);
+        }
+        if (statistics)
+        {
+            *statistics = transferStatistics;
+        }
+        return (successList);
+    }
     // ================
     // PUBLIC FUNCTIONS
     // ================
@@ -125,12 +340,10 @@ namespace Antik ::SSH
     //
     void putFile(CSSHSession &sshSession, const std::string &sourceFile, const std::string &destinationFile)
     {
-        std::ifstream localFile;
         std::filesystem::file_status fileStatus;
-        localFile.open(sourceFile, std::ios_base::in | std::ios_base::binary);
-        if (!localFile)
+        if (!std::filesystem::exists(sourceFile))
         {
-            throw std::system_error(errno, std::system_category());
+            throw std::system_error(ENOENT, std::system_category());
         }
         fileStatus = std::filesystem::status(std::filesystem::path(sourceFile).parent_path().string());
         CSCP scpServer{sshSession, SSH_SCP_WRITE | SSH_SCP_RECURSIVE, std::string(1, kServerPathSep)};
@@ -142,19 +355,7 @@ namespace Antik ::SSH
         else if (std::filesystem::is_regular_file(sourceFile))
         {
             makeRemotePath(scpServer, std::filesystem::path(destinationFile).parent_path().string(), (CSCP::FilePermissions)fileStatus.permissions());
-            fileStatus = std::filesystem::status(std::filesystem::path(sourceFile));
-            scpServer.pushFile(std::filesystem::path(destinationFile).filename().string(), std::filesystem::file_size(sourceFile), (CSCP::FilePermissions)fileStatus.permissions());
-            for (;;)
-            {
-                localFile.read(scpServer.getIoBuffer().get(), scpServer.getIoBufferSize());
-                if (localFile.gcount())
-                {
-                    scpServer.write(scpServer.getIoBuffer().get(), localFile.gcount());
-                }
-                if (!localFile)
-                    break;
-            }
-            localFile.close();
+            uploadFile(scpServer, sourceFile, std::filesystem::path(destinationFile).filename().string());
         }
         scpServer.close();
     }
@@ -228,25 +429,21 @@ namespace Antik ::SSH
     }
     //
     // Take local directory and upload all its files to server;  recreating
-    // any local directory structure in situ on the server. Returns a list of successfully
-    // uploaded files and directories created.
+    // any local directory structure in situ on the server. The tree is walked once and streamed
+    // depth first through a single SCP session. Returns a list of successfully uploaded files and
+    // directories created.
     //
     FileList putFiles(CSSHSession &sshSession, FileMapper &fileMapper, FileCompletionFn completionFn)
     {
         FileList successList;
         try
         {
-            FileList localFileList;
-            listLocalRecursive(fileMapper.getLocalDirectory(), localFileList);
-            for (auto localFile : localFileList)
-            {
-                putFile(sshSession, localFile, fileMapper.toRemote(localFile));
-                successList.push_back(fileMapper.toRemote(localFile));
-                if (completionFn)
-                {
-                    completionFn(successList.back());
-                }
-            }
+            // Stream whole tree through one SCP session rooted at the remote directory
+            CSCP scpServer{sshSession, SSH_SCP_WRITE | SSH_SCP_RECURSIVE, std::string(1, kServerPathSep)};
+            scpServer.open();
+            makeRemotePath(scpServer, fileMapper.getRemoteDirectory(), (CSCP::FilePermissions)std::filesystem::status(fileMapper.getLocalDirectory()).permissions());
+            uploadDirectory(scpServer, fileMapper, fileMapper.getLocalDirectory(), successList, completionFn);
+            scpServer.close();
             // On exception report and return with files that where successfully uploaded.
         }
         catch (const CSCP::Exception &e)
@@ -259,4 +456,59 @@ namespace Antik ::SSH
         }
         return (successList);
     }
+    //
+    // Download a list of remote files in parallel; files are taken from a work queue by a worker
+    // for each SSH session passed in (each file is a separate SCP read as SCP cannot list a remote
+    // directory). Any local directories needed are created. The completion function is called
+    // (serialized) as each file completes and a failed file is reported and skipped rather than
+    // ending the transfer. Returns a list of files downloaded and fills in statistics if passed.
+    //
+    FileList getFilesParallel(SSHSessionList &sshSessions, FileMapper &fileMapper, const FileList &remoteFileList, FileCompletionFn completionFn, TransferStatistics *statistics)
+    {
+        return (runParallelTransfer(sshSessions, remoteFileList, completionFn, statistics, [&fileMapper](CSSHSession &sshSession, std::unique_ptr<CSCP> &, const std::string &remoteFile, std::uintmax_t &fileSize) {
+            std::string localFile{fileMapper.toLocal(remoteFile)};
+            getFile(sshSession, remoteFile, localFile);
+            fileSize = std::filesystem::file_size(localFile);
+            return (localFile);
+        }));
+    }
+    //
+    // Upload a local directory tree in parallel; its files are taken from a work queue by a worker
+    // for each SSH session passed in, each of which streams its files through one recursive SCP
+    // session (remote directories being created as needed). The completion function is called
+    // (serialized) as each file completes and a failed file is reported and skipped rather than
+    // ending the transfer. Returns a list of files uploaded and fills in statistics if passed.
+    //
+    FileList putFilesParallel(SSHSessionList &sshSessions, FileMapper &fileMapper, FileCompletionFn completionFn, TransferStatistics *statistics)
+    {
+        FileList localFileList;
+        FileList filesToTransfer;
+        try
+        {
+            listLocalRecursive(fileMapper.getLocalDirectory(), localFileList);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << std::endl;
+            return (FileList{});
+        }
+        for (auto &localFile : localFileList)
+        {
+            if (std::filesystem::is_regular_file(localFile))
+            {
+                filesToTransfer.push_back(localFile);
+            }
+        }
+        return (runParallelTransfer(sshSessions, filesToTransfer, completionFn, statistics, [&fileMapper](CSSHSession &sshSession, std::unique_ptr<CSCP> &scpServer, const std::string &localFile, std::uintmax_t &fileSize) {
+            std::string remoteFile{fileMapper.toRemote(localFile)};
+            if (!scpServer)
+            {
+                scpServer = std::make_unique<CSCP>(sshSession, SSH_SCP_WRITE | SSH_SCP_RECURSIVE, std::string(1, kServerPathSep));
+                scpServer->open();
+            }
+            uploadFileToPath(*scpServer, localFile, remoteFile);
+            fileSize = std::filesystem::file_size(localFile);
+            return (remoteFile);
+        }));
+    }
 } // namespace Antik::SSH
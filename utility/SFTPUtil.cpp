@@ -20,6 +20,29 @@
 //
 #include <iostream>
 #include <system_error>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <exception>
+#include <stdexcept>
+#include <limits>
+#include <cctype>
+#include <unordered_map>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <map>
+//
+// Linux
+//
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+//
+// OpenSSL (SHA-256)
+//
+#include <openssl/evp.h>
 //
 // SFTP utility definitions
 //
@@ -29,6 +52,12 @@
 //
 #include "CFile.hpp"
 #include "CPath.hpp"
+#include "CSSHChannel.hpp"
+#include "CSFTPExtended.hpp"
+//
+// SSH channel utility (remote command execution)
+//
+#include "SSHChannelUtil.hpp"
 // =========
 // NAMESPACE
 // =========
@@ -40,6 +69,16 @@ namespace Antik::SSH
     // =======
     using namespace Antik::File;
     // ===============
+    // LOCAL CONSTANTS
+    // ===============
+    static const char *kCheckpointPostfix{".checkpoint"}; // Segmented download checkpoint file postfix
+    static const std::size_t kMaxHashCommandLength{32 * 1024}; // Maximum remote hash command length
+    static const std::size_t kHashReadBufferSize{64 * 1024};   // Local file hash read buffer size
+    static const char *kCheckFileAlgorithms{"sha256,sha1,md5"};   // check-file hash algorithms (preferred first)
+    static constexpr std::uint64_t kChangedBlockSize{1024 * 1024};          // Smallest block compared when only changed blocks are transferred
+    static constexpr std::uint64_t kChangedBlocksMaximum{16 * 1024};        // Most blocks compared for one file
+    static constexpr std::uint64_t kChangedBlocksMinimumFileSize{4 * 1024 * 1024}; // Smallest file compared block by block
+    // ===============
     // LOCAL FUNCTIONS
     // ===============
     //
@@ -63,6 +102,36 @@ namespace Antik::SSH
         return (false);
     }
     //
+    // Return true if a given remote directory exists. The sessions known directory cache is
+    // checked first and directories found on the server are added to it (a path that exists
+    // but is not a directory returns false and is not cached).
+    //
+    static bool remoteDirectoryExists(CSFTP &sftpServer, const std::string &remotePath)
+    {
+        if (sftpServer.isKnownDirectory(remotePath))
+        {
+            return (true);
+        }
+        try
+        {
+            CSFTP::FileAttributes fileAttributes;
+            sftpServer.getFileAttributes(remotePath, fileAttributes);
+            if (sftpServer.isADirectory(fileAttributes))
+            {
+                sftpServer.addKnownDirectory(remotePath);
+                return (true);
+            }
+        }
+        catch (CSFTP::Exception &e)
+        {
+            if (e.sftpGetCode() != SSH_FX_NO_SUCH_FILE)
+            {
+                throw;
+            }
+        }
+        return (false);
+    }
+    //
     // Break path into its component directories and create path structure on
     // remote FTP server.
     //
@@ -70,18 +139,30 @@ namespace Antik::SSH
     {
         std::vector<std::string> pathComponents;
         CPath currentPath{""};
+        if (sftpServer.isKnownDirectory(remotePath))
+        {
+            return;
+        }
         boost::split(pathComponents, remotePath, boost::is_any_of(std::string(1, kServerPathSep)));
-        for (auto directory : pathComponents)
+        try
         {
-            currentPath.join(directory);
-            if (!directory.empty())
+            for (auto directory : pathComponents)
             {
-                if (!fileExists(sftpServer, currentPath.toString()))
+                currentPath.join(directory);
+                if (!directory.empty())
                 {
-                    sftpServer.createDirectory(currentPath.toString(), permissions);
+                    if (!remoteDirectoryExists(sftpServer, currentPath.toString()))
+                    {
+                        sftpServer.createDirectory(currentPath.toString(), permissions);
+                    }
                 }
             }
         }
+        catch (const CSFTP::Exception &e)
+        {
+            sftpServer.forgetKnownDirectory(remotePath);
+            throw;
+        }
     }
     //
     // Return true if a given remote path is a directory.
@@ -101,339 +182,1647 @@ namespace Antik::SSH
         sftpServer.getFileAttributes(remotePath, fileAttributes);
         return (sftpServer.isARegularFile(fileAttributes));
     }
-    // ================
-    // PUBLIC FUNCTIONS
-    // ================
     //
-    // Upload a file from remote SFTP server assigning it the same permissions as the remote file.
-    // SFTP does not directly support file upload/download so this function is not part of the
-    // CSFTP class.
+    // Remote file path/type of a file list entry (a path needs a stat round trip, a listing
+    // entry carries its type).
     //
-    void getFile(CSFTP &sftpServer, const std::string &sourceFile, const std::string &destinationFile, FileCompletionFn completionFn)
+    static const std::string &remoteFilePath(const std::string &remoteFile)
     {
-        CSFTP::File remoteFile;
-        std::ofstream localFile;
-        try
+        return (remoteFile);
+    }
+    static const std::string &remoteFilePath(const RemoteFileEntry &remoteFile)
+    {
+        return (remoteFile.path);
+    }
+    static RemoteFileEntry::Type remoteFileType(CSFTP &sftpServer, const std::string &remoteFile)
+    {
+        if (isRegularFile(sftpServer, remoteFile))
         {
-            CSFTP::FileAttributes fileAttributes;
-            int bytesRead{0}, bytesWritten{0};
-            remoteFile = sftpServer.openFile(sourceFile, O_RDONLY, 0);
-            sftpServer.getFileAttributes(remoteFile, fileAttributes);
-            if (sftpServer.isARegularFile(fileAttributes))
-            {
-                if (!CFile::exists(CPath(destinationFile).parentPath()))
-                {
-                    CFile::createDirectory(CPath(destinationFile).parentPath());
-                }
-                localFile.open(destinationFile, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
-                if (!localFile)
-                {
-                    throw std::system_error(errno, std::system_category());
-                }
-                for (;;)
-                {
-                    bytesRead = sftpServer.readFile(remoteFile, sftpServer.getIoBuffer().get(), sftpServer.getIoBufferSize());
-                    if (bytesRead == 0)
-                    {
-                        break; // EOF
-                    }
-                    localFile.write(sftpServer.getIoBuffer().get(), bytesRead);
-                    bytesWritten += bytesRead;
-                    if (bytesWritten != localFile.tellp())
-                    {
-                        throw CSFTP::Exception(sftpServer, __func__);
-                    }
-                }
-                localFile.close();
-                CFile::setPermissions(destinationFile, static_cast<CFile::Permissions>(fileAttributes->permissions));
-                if (completionFn)
-                {
-                    completionFn(destinationFile);
-                }
-            }
-            else if (sftpServer.isADirectory(fileAttributes))
-            {
-                if (!CFile::exists(CPath(destinationFile)))
-                {
-                    CFile::createDirectory(CPath(destinationFile));
-                }
-                if (completionFn)
-                {
-                    completionFn(destinationFile);
-                }
-            }
-            sftpServer.closeFile(remoteFile);
+            return (RemoteFileEntry::Type::regular);
         }
-        catch (const CSFTP::Exception &e)
+        else if (isDirectory(sftpServer, remoteFile))
         {
-            throw;
+            return (RemoteFileEntry::Type::directory);
         }
-        catch (const std::system_error &e)
+        return (RemoteFileEntry::Type::other);
+    }
+    static RemoteFileEntry::Type remoteFileType(CSFTP &, const RemoteFileEntry &remoteFile)
+    {
+        return (remoteFile.type);
+    }
+    //
+    // Return the modified time from remote file attributes. Only SFTP v4+ servers send a 64 bit
+    // time (mtime64); OpenSSH (v3) sends the 32 bit mtime and leaves mtime64 zero.
+    //
+    static std::uint64_t remoteModifiedTime(const CSFTP::FileAttributes &fileAttributes)
+    {
+        if (fileAttributes->mtime64 != 0)
         {
-            throw;
+            return (fileAttributes->mtime64);
         }
+        return (fileAttributes->mtime);
     }
     //
-    // Download a file to remote SFTP server assigning it the same permissions as the local file.
-    // It will be created with the owner and group of the currently logged in SSH account.
-    // SFTP does not directly support file upload/download so this function is not part of the
-    // CSFTP class.
+    // Download an opened remote file to a local file and give it the passed permissions.
     //
-    void putFile(CSFTP &sftpServer, const std::string &sourceFile, const std::string &destinationFile, FileCompletionFn completionFn)
+    static void downloadFile(CSFTP &sftpServer, const CSFTP::File &remoteFile, const std::string &destinationFile, std::uint32_t permissions)
     {
-        CSFTP::File remoteFile;
-        std::ifstream localFile;
-        try
+        std::ofstream localFile;
+        if (!CFile::exists(CPath(destinationFile).parentPath()))
         {
-            std::string remoteFilePath;
-            CFile::Status fileStatus;
-            int bytesWritten{0};
-            bool transferFile{false};
-            if (CFile::isDirectory(sourceFile))
+            CFile::createDirectory(CPath(destinationFile).parentPath());
+        }
+        localFile.open(destinationFile, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+        if (!localFile)
+        {
+            throw std::system_error(errno, std::system_category());
+        }
+        // Pipelined read (window set by the IO pipeline depth)
+        sftpServer.readFileAsync(remoteFile, [&localFile](const char *readBuffer, size_t bytesRead) {
+            localFile.write(readBuffer, bytesRead);
+            if (!localFile)
             {
-                remoteFilePath = destinationFile;
-                fileStatus = CFile::fileStatus(sourceFile);
+                throw std::system_error(errno, std::system_category());
             }
-            else if (CFile::isFile(sourceFile))
+        });
+        localFile.close();
+        CFile::setPermissions(destinationFile, static_cast<CFile::Permissions>(permissions));
+    }
+    //
+    // Download a remote file/directory in a file list to its mapped local path. Returns
+    // true if a file was downloaded or directory created (false == not a file or directory).
+    //
+    template <typename RemoteFile>
+    static bool getMappedFile(CSFTP &sftpServer, FileMapper &fileMapper, const RemoteFile &remoteFile, bool safe, char postFix, std::string &localFilePath)
+    {
+        localFilePath = fileMapper.toLocal(remoteFilePath(remoteFile));
+        RemoteFileEntry::Type fileType{remoteFileType(sftpServer, remoteFile)};
+        if (fileType == RemoteFileEntry::Type::regular)
+        {
+            std::string destinationFileName{localFilePath + postFix};
+            if (!CFile::exists(CPath(localFilePath).parentPath()))
             {
-                remoteFilePath = CPath(destinationFile).parentPath().toString();
-                fileStatus = CFile::fileStatus(CPath(sourceFile).parentPath());
-                transferFile = true;
+                CFile::createDirectory(CPath(localFilePath).parentPath());
             }
-            else
+            if (!safe)
             {
-                return; // Not valid for transfer NEXT FILE!
+                destinationFileName.pop_back();
             }
-            if (!fileExists(sftpServer, remoteFilePath))
+            getFile(sftpServer, remoteFile, destinationFileName);
+            if (safe)
             {
-                makeRemotePath(sftpServer, remoteFilePath, static_cast<CSFTP::FilePermissions>(fileStatus.permissions()));
-                if (!transferFile && completionFn)
-                {
-                    completionFn(remoteFilePath);
-                }
+                CFile::rename(destinationFileName, localFilePath);
             }
-            if (transferFile)
+        }
+        else if (fileType == RemoteFileEntry::Type::directory)
+        {
+            if (!CFile::exists(localFilePath))
             {
-                localFile.open(sourceFile, std::ios_base::in | std::ios_base::binary);
-                if (!localFile)
-                {
-                    throw std::system_error(errno, std::system_category());
-                }
-                fileStatus = CFile::fileStatus(sourceFile);
-                remoteFile = sftpServer.openFile(destinationFile, O_CREAT | O_WRONLY | O_TRUNC, (int)fileStatus.permissions());
-                for (;;)
-                {
-                    localFile.read(sftpServer.getIoBuffer().get(), sftpServer.getIoBufferSize());
-                    if (localFile.gcount())
-                    {
-                        bytesWritten = sftpServer.writeFile(remoteFile, sftpServer.getIoBuffer().get(), localFile.gcount());
-                        if ((bytesWritten < 0) || (bytesWritten != localFile.gcount()))
-                        {
-                            throw CSFTP::Exception(sftpServer, __func__);
-                        }
-                    }
-                    if (!localFile)
-                        break;
-                }
-                sftpServer.closeFile(remoteFile);
-                localFile.close();
-                if (completionFn)
-                {
-                    completionFn(destinationFile);
-                }
+                CFile::createDirectory(localFilePath);
             }
         }
-        catch (const CSFTP::Exception &e)
+        else
         {
-            throw;
+            return (false);
         }
-        catch (const std::system_error &e)
+        return (true);
+    }
+    //
+    // Upload a local file in a file list to its mapped remote path (its remote directory
+    // must already exist).
+    //
+    static void putMappedFile(CSFTP &sftpServer, FileMapper &fileMapper, const std::string &localFile, bool safe, char postFix, std::string &remoteFilePath)
+    {
+        remoteFilePath = fileMapper.toRemote(localFile);
+        std::string destinationFilePath{remoteFilePath + postFix};
+        if (!safe)
         {
-            throw;
+            destinationFilePath.pop_back();
+        }
+        putFile(sftpServer, localFile, destinationFilePath);
+        if (safe)
+        {
+            if (fileExists(sftpServer, remoteFilePath))
+            {
+                sftpServer.removeLink(remoteFilePath);
+            }
+            sftpServer.renameFile(destinationFilePath, remoteFilePath);
         }
     }
     //
-    // Recursively parse a remote server path passed in and pass back a list of directories/files found.
-    // If a feedback function has been passed in then it is called for each file found.
+    // Write a buffer to a local file at a given offset.
     //
-    void listRemoteRecursive(CSFTP &sftpServer, const std::string &directoryPath, FileList &remoteFileList, FileFeedBackFn remoteFileFeedbackFn)
+    static void writeAt(int localFile, const char *writeBuffer, std::size_t bytesToWrite, std::uint64_t offset)
     {
-        try
+        while (bytesToWrite != 0)
         {
-            CSFTP::Directory directoryHandle;
-            CSFTP::FileAttributes fileAttributes;
-            std::string filePath;
-            directoryHandle = sftpServer.openDirectory(directoryPath);
-            while (sftpServer.readDirectory(directoryHandle, fileAttributes))
+            ssize_t bytesWritten{::pwrite(localFile, writeBuffer, bytesToWrite, offset)};
+            if (bytesWritten == -1)
             {
-                if ((static_cast<std::string>(fileAttributes->name) != ".") && (static_cast<std::string>(fileAttributes->name) != ".."))
+                if (errno == EINTR)
                 {
-                    std::string filePath{directoryPath};
-                    if (filePath.back() == kServerPathSep)
-                        filePath.pop_back();
-                    filePath += std::string(1, kServerPathSep) + fileAttributes->name;
-                    if (sftpServer.isADirectory(fileAttributes))
-                    {
-                        listRemoteRecursive(sftpServer, filePath, remoteFileList, remoteFileFeedbackFn);
-                    }
-                    remoteFileList.push_back(filePath);
-                    if (remoteFileFeedbackFn)
-                    {
-                        remoteFileFeedbackFn(remoteFileList.back());
-                    }
+                    continue;
                 }
+                throw std::system_error(errno, std::system_category());
             }
-            if (!sftpServer.endOfDirectory(directoryHandle))
+            writeBuffer += bytesWritten;
+            bytesToWrite -= bytesWritten;
+            offset += bytesWritten;
+        }
+    }
+    //
+    // IO context that captures remote command output.
+    //
+    class CommandOutput : public IOContext
+    {
+    public:
+        void writeOutput(void *data, uint32_t size) override
+        {
+            m_output.append(static_cast<char *>(data), size);
+        }
+        void writeError(void *, uint32_t) override
+        {
+        }
+        std::string &getOutput()
+        {
+            return (m_output);
+        }
+
+    private:
+        std::string m_output;
+    };
+    //
+    // Remote file content hash and the algorithm (OpenSSL digest name) it was taken with.
+    //
+    struct RemoteHash
+    {
+        std::string algorithm;
+        std::string hash;
+    };
+    using RemoteHashMap = std::unordered_map<std::string, RemoteHash>;
+    //
+    // Return true if the server lists an extension (any version) in its SFTP version packet.
+    //
+    static bool serverExtension(CSFTP &sftpServer, const std::string &name)
+    {
+        for (int extension = 0; extension < sftpServer.getExtensionCount(); extension++)
+        {
+            if (sftpServer.getExtensionName(extension) == name)
             {
-                sftpServer.closeDirectory(directoryHandle);
-                throw CSFTP::Exception(sftpServer, __func__);
+                return (true);
             }
-            sftpServer.closeDirectory(directoryHandle);
         }
-        catch (const CSFTP::Exception &e)
+        return (false);
+    }
+    //
+    // Open an extended request session if the server has a hash extension libssh cannot
+    // issue (check-file/md5-hash). It is left closed (and so not used) if there is none or
+    // the server will not start another sftp subsystem.
+    //
+    static void openHashExtensions(CSFTP &sftpServer, CSFTPExtended &extendedServer)
+    {
+        if (serverExtension(sftpServer, "check-file") || serverExtension(sftpServer, "md5-hash"))
         {
-            throw;
+            try
+            {
+                extendedServer.open();
+            }
+            catch (const CSFTPExtended::Exception &e)
+            {
+            }
+            catch (const CSSHChannel::Exception &e)
+            {
+            }
         }
     }
     //
-    // Download all files passed in file list from server to the local directory passed in; recreating any server directory
-    // structure in situ. If safe == true then the file is downloaded to a filename with a postfix then the file is renamed
-    // to its correct value on success. Returns a list of successfully downloaded files and directories created in the local
-    // directory.
+    // Return the hashes of a list of remote files keyed by path. The check-file (or failing
+    // that md5-hash) extension is used when the server has it; any files still not hashed have
+    // sha256sum run on the server over an exec channel, with files batched to keep the command
+    // length bounded. Files that could not be hashed (missing, unreadable or no sha256sum) have
+    // no entry.
     //
-    FileList getFiles(CSFTP &sftpServer, FileMapper &fileMapper, const FileList &remoteFileList, FileCompletionFn completionFn, bool safe, char postFix)
+    static RemoteHashMap remoteFileHashes(CSFTP &sftpServer, CSFTPExtended &extendedServer, const FileList &remoteFileList)
     {
-        FileList successList;
-        try
+        RemoteHashMap fileHashes;
+        FileList unhashedFileList;
+        if (extendedServer.isOpen() && extendedServer.extensionSupported("check-file"))
         {
-            for (auto remoteFile : remoteFileList)
+            auto checkFileHashes{extendedServer.checkFiles(remoteFileList, kCheckFileAlgorithms)};
+            for (std::size_t fileIndex = 0; fileIndex < remoteFileList.size(); fileIndex++)
             {
-                std::string localFilePath{fileMapper.toLocal(remoteFile)};
-                if (isRegularFile(sftpServer, remoteFile))
-                {
-                    std::string destinationFileName{localFilePath + postFix};
-                    if (!CFile::exists(CPath(localFilePath).parentPath()))
-                    {
-                        CFile::createDirectory(CPath(localFilePath).parentPath());
-                    }
-                    if (!safe)
-                    {
-                        destinationFileName.pop_back();
-                    }
-                    getFile(sftpServer, remoteFile, destinationFileName);
-                    if (safe)
-                    {
-                        CFile::rename(destinationFileName, localFilePath);
-                    }
-                }
-                else if (isDirectory(sftpServer, remoteFile))
-                {
-                    if (!CFile::exists(localFilePath))
-                    {
-                        CFile::createDirectory(localFilePath);
-                    }
-                }
-                else
+                if (checkFileHashes[fileIndex].hashes.size() == 1)
                 {
-                    continue;
+                    fileHashes[remoteFileList[fileIndex]] = {checkFileHashes[fileIndex].algorithm, checkFileHashes[fileIndex].hashes.front()};
                 }
-                successList.push_back(localFilePath);
-                if (completionFn)
+            }
+        }
+        else if (extendedServer.isOpen() && extendedServer.extensionSupported("md5-hash"))
+        {
+            auto md5Hashes{extendedServer.md5Hashes(remoteFileList)};
+            for (std::size_t fileIndex = 0; fileIndex < remoteFileList.size(); fileIndex++)
+            {
+                if (!md5Hashes[fileIndex].empty())
                 {
-                    completionFn(successList.back());
+                    fileHashes[remoteFileList[fileIndex]] = {"md5", md5Hashes[fileIndex]};
                 }
             }
-            // On exception report and return with files that where successfully downloaded.
         }
-        catch (const CSFTP::Exception &e)
+        for (auto &remoteFile : remoteFileList)
+        {
+            if (fileHashes.count(remoteFile) == 0)
+            {
+                unhashedFileList.push_back(remoteFile);
+            }
+        }
+        for (auto remoteFile = unhashedFileList.begin(); remoteFile != unhashedFileList.end();)
+        {
+            std::string command{"sha256sum --"};
+            while ((remoteFile != unhashedFileList.end()) && ((command.size() < kMaxHashCommandLength) || (command == "sha256sum --")))
+            {
+                command += " " + CSFTP::quoteRemotePath(*remoteFile++);
+            }
+            CSSHChannel channel{sftpServer.getSession()};
+            CommandOutput commandOutput;
+            channel.open();
+            executeCommand(channel, command, commandOutput);
+            channel.close();
+            std::istringstream hashLines{commandOutput.getOutput()};
+            for (std::string hashLine; std::getline(hashLines, hashLine);)
+            {
+                // "<hash>  <path>" ('*' before path in binary mode; escaped names start with a backslash and are skipped)
+                if ((hashLine.size() > 66) && (hashLine[0] != '\\') && (hashLine[64] == ' '))
+                {
+                    fileHashes[hashLine.substr(66)] = {"sha256", hashLine.substr(0, 64)};
+                }
+            }
+        }
+        return (fileHashes);
+    }
+    //
+    // Return the block size a file is compared in when only changed blocks are transferred
+    // (0 == too small or too large to compare by block).
+    //
+    static std::uint64_t changedBlockSize(std::uint64_t fileSize)
+    {
+        std::uint64_t blockSize{kChangedBlockSize};
+        if (fileSize < kChangedBlocksMinimumFileSize)
+        {
+            return (0);
+        }
+        while (((fileSize + blockSize - 1) / blockSize) > kChangedBlocksMaximum)
+        {
+            blockSize *= 2;
+        }
+        return ((blockSize <= std::numeric_limits<std::uint32_t>::max()) ? blockSize : 0);
+    }
+    //
+    // Return the hash of each block of a remote file (no hashes if they could not be taken).
+    // check-file is used when the server has it, otherwise the file is read once by (GNU)
+    // split on the server over an exec channel and each block it cuts piped to sha256sum;
+    // without split --filter there are no hashes so the whole file is transferred.
+    //
+    static CSFTPExtended::FileHash remoteBlockHashes(CSFTP &sftpServer, CSFTPExtended &extendedServer, const std::string &remoteFile, std::uint64_t fileSize, std::uint64_t blockSize)
+    {
+        CSFTPExtended::FileHash blockHashes;
+        std::uint64_t blockCount{(fileSize + blockSize - 1) / blockSize};
+        try
+        {
+            if (extendedServer.isOpen() && extendedServer.extensionSupported("check-file"))
+            {
+                blockHashes = extendedServer.checkFiles({remoteFile}, kCheckFileAlgorithms, static_cast<std::uint32_t>(blockSize)).front();
+            }
+            else
+            {
+                CSSHChannel channel{sftpServer.getSession()};
+                CommandOutput commandOutput;
+                channel.open();
+                executeCommand(channel, "split -b " + std::to_string(blockSize) + " --filter=sha256sum -- " + CSFTP::quoteRemotePath(remoteFile) + " 2>/dev/null || exit 1", commandOutput);
+                channel.close();
+                blockHashes.algorithm = "sha256";
+                std::istringstream hashLines{commandOutput.getOutput()};
+                for (std::string hashLine; std::getline(hashLines, hashLine);)
+                {
+                    blockHashes.hashes.push_back(hashLine.substr(0, 64));
+                }
+            }
+        }
+        catch (const CSFTPExtended::Exception &e)
+        {
+            blockHashes.hashes.clear();
+        }
+        catch (const CSSHChannel::Exception &e)
+        {
+            blockHashes.hashes.clear();
+        }
+        if (blockHashes.hashes.size() != blockCount)
+        {
+            blockHashes.hashes.clear();
+        }
+        return (blockHashes);
+    }
+    //
+    // Bring a local copy of a remote file of the same size up to date by downloading only the
+    // blocks whose hashes differ (into a copy renamed over it in safe mode). Returns false if
+    // the file is not compared by block, block hashes could not be taken or the result does not
+    // match the remote file hash (changed since), when the whole file should be downloaded.
+    //
+    static bool getChangedBlocks(CSFTP &sftpServer, CSFTPExtended &extendedServer, const RemoteFileEntry &remoteFile, const std::string &localFilePath, const RemoteHash &remoteHash,
+                                 FileHashCache &fileHashCache, bool safe, char postFix)
+    {
+        struct stat fileStatus;
+        std::uint64_t blockSize{changedBlockSize(remoteFile.size)};
+        if ((blockSize == 0) || (::stat(localFilePath.c_str(), &fileStatus) == -1) || !S_ISREG(fileStatus.st_mode) || (static_cast<std::uint64_t>(fileStatus.st_size) != remoteFile.size))
+        {
+            return (false);
+        }
+        auto remoteBlocks{remoteBlockHashes(sftpServer, extendedServer, remoteFile.path, remoteFile.size, blockSize)};
+        if (remoteBlocks.hashes.empty())
+        {
+            return (false);
+        }
+        std::string workingFilePath{localFilePath};
+        if (safe)
+        {
+            workingFilePath += postFix;
+            if (CFile::exists(workingFilePath))
+            {
+                CFile::remove(workingFilePath);
+            }
+            CFile::copy(localFilePath, workingFilePath);
+        }
+        auto localBlocks{localFileHashes(workingFilePath, remoteBlocks.algorithm, blockSize)};
+        int localFile{::open(workingFilePath.c_str(), O_WRONLY)};
+        if (localFile == -1)
+        {
+            throw std::system_error(errno, std::system_category());
+        }
+        bool blocksRead{true};
+        try
+        {
+            CSFTP::File remoteFileHandle{sftpServer.openFile(remoteFile.path, O_RDONLY, 0)};
+            for (std::size_t block = 0; (block < remoteBlocks.hashes.size()) && blocksRead; block++)
+            {
+                if (localBlocks[block] != remoteBlocks.hashes[block])
+                {
+                    std::uint64_t blockOffset{block * blockSize};
+                    std::uint64_t blockLength{std::min(blockSize, remoteFile.size - blockOffset)};
+                    std::uint64_t writeOffset{blockOffset};
+                    sftpServer.seekFile64(remoteFileHandle, blockOffset);
+                    blocksRead = (sftpServer.readFileAsync(remoteFileHandle, [&](const char *readBuffer, size_t bytesRead) {
+                        writeAt(localFile, readBuffer, bytesRead, writeOffset);
+                        writeOffset += bytesRead;
+                    },
+                                                           blockLength) == blockLength);
+                }
+            }
+            sftpServer.closeFile(remoteFileHandle);
+        }
+        catch (...)
+        {
+            ::close(localFile);
+            throw;
+        }
+        if (::close(localFile) == -1)
+        {
+            throw std::system_error(errno, std::system_category());
+        }
+        if (!blocksRead || (fileHashCache.getHash(workingFilePath, remoteHash.algorithm) != remoteHash.hash))
+        {
+            if (safe)
+            {
+                CFile::remove(workingFilePath);
+            }
+            return (false);
+        }
+        if (safe)
+        {
+            CFile::rename(workingFilePath, localFilePath);
+        }
+        CFile::setPermissions(localFilePath, static_cast<CFile::Permissions>(remoteFile.permissions));
+        return (true);
+    }
+    //
+    // Bring a remote copy of a local file of the same size up to date by uploading only the
+    // blocks whose hashes differ (written in place so not used in safe mode). Returns false if
+    // the file is not compared by block, block hashes could not be taken or the patched remote
+    // file hash does not match the local file (either changed since), when the whole file
+    // should be uploaded.
+    //
+    static bool putChangedBlocks(CSFTP &sftpServer, CSFTPExtended &extendedServer, const std::string &localFilePath, const std::string &remoteFilePath, FileHashCache &fileHashCache)
+    {
+        struct stat fileStatus;
+        CSFTP::FileAttributes remoteFileAttributes;
+        if (::stat(localFilePath.c_str(), &fileStatus) == -1)
+        {
+            throw std::system_error(errno, std::system_category());
+        }
+        std::uint64_t fileSize{static_cast<std::uint64_t>(fileStatus.st_size)};
+        std::uint64_t blockSize{changedBlockSize(fileSize)};
+        if (blockSize == 0)
+        {
+            return (false);
+        }
+        sftpServer.getFileAttributes(remoteFilePath, remoteFileAttributes);
+        if (!sftpServer.isARegularFile(remoteFileAttributes) || (remoteFileAttributes->size != fileSize))
+        {
+            return (false);
+        }
+        auto remoteBlocks{remoteBlockHashes(sftpServer, extendedServer, remoteFilePath, fileSize, blockSize)};
+        if (remoteBlocks.hashes.empty())
+        {
+            return (false);
+        }
+        auto localBlocks{localFileHashes(localFilePath, remoteBlocks.algorithm, blockSize)};
+        std::ifstream localFile{localFilePath, std::ios_base::in | std::ios_base::binary};
+        if (!localFile)
+        {
+            throw std::system_error(errno, std::system_category());
+        }
+        CSFTP::File remoteFile{sftpServer.openFile(remoteFilePath, O_WRONLY, 0)};
+        for (std::size_t block = 0; block < localBlocks.size(); block++)
+        {
+            if (localBlocks[block] != remoteBlocks.hashes[block])
+            {
+                std::uint64_t blockOffset{block * blockSize};
+                std::uint64_t bytesLeft{std::min(blockSize, fileSize - blockOffset)};
+                localFile.clear();
+                localFile.seekg(blockOffset);
+                sftpServer.seekFile64(remoteFile, blockOffset);
+                sftpServer.writeFileAsync(remoteFile, [&localFile, &bytesLeft](char *writeBuffer, size_t bytesToWrite) {
+                    localFile.read(writeBuffer, std::min<std::uint64_t>(bytesToWrite, bytesLeft));
+                    if (localFile.bad())
+                    {
+                        throw std::system_error(errno, std::system_category());
+                    }
+                    bytesLeft -= localFile.gcount();
+                    return (static_cast<size_t>(localFile.gcount()));
+                });
+            }
+        }
+        sftpServer.closeFile(remoteFile);
+        auto patchedHashes{remoteFileHashes(sftpServer, extendedServer, {remoteFilePath})};
+        auto patchedHash{patchedHashes.find(remoteFilePath)};
+        return ((patchedHash != patchedHashes.end()) && (fileHashCache.getHash(localFilePath, patchedHash->second.algorithm) == patchedHash->second.hash));
+    }
+    //
+    // Remove any trailing separators from a remote path (other than from the root).
+    //
+    static std::string trimRemotePath(const std::string &remotePath)
+    {
+        std::string trimmedPath{remotePath};
+        while ((trimmedPath.size() > 1) && (trimmedPath.back() == kServerPathSep))
+        {
+            trimmedPath.pop_back();
+        }
+        return (trimmedPath);
+    }
+    //
+    // Apply an operation to every entry of a remote tree bottom up so that each directory is
+    // only processed after everything below it (see remoteFileLevels()). libssh has no
+    // asynchronous form of these requests so the entries of each level are spread over a
+    // worker per SFTP server and only requests on different sessions are outstanding at once;
+    // with a single server the operation is applied to one entry at a time. Errors are
+    // collected per path and do not stop the operation.
+    //
+    static RemotePathErrorList applyRemoteRecursive(SFTPServerList &sftpServers, const std::string &remotePath, bool includeSymbolicLinks,
+                                                    std::function<void(CSFTP &sftpServer, const RemoteFileEntry &remoteFile)> operationFn)
+    {
+        RemotePathErrorList errorList;
+        RemoteFileEntryList remoteFileList;
+        std::string rootPath{trimRemotePath(remotePath)};
+        std::mutex errorMutex;
+        if (sftpServers.empty())
+        {
+            return (errorList);
+        }
+        CSFTP &sftpServer{sftpServers.front().get()};
+        CSFTP::FileAttributes fileAttributes;
+        sftpServer.getLinkAttributes(rootPath, fileAttributes);
+        if (sftpServer.isADirectory(fileAttributes))
+        {
+            listRemoteRecursive(sftpServer, rootPath, remoteFileList);
+        }
+        remoteFileList.push_back(remoteFileEntry(rootPath, fileAttributes));
+        for (auto &levelFileList : remoteFileLevels(remoteFileList, rootPath, includeSymbolicLinks))
+        {
+            runParallelWorkers(sftpServers, levelFileList.size(), [&](CSFTP &levelServer, std::size_t fileIndex) {
+                try
+                {
+                    operationFn(levelServer, levelFileList[fileIndex]);
+                }
+                catch (const CSFTP::Exception &e)
+                {
+                    std::scoped_lock errorLock(errorMutex);
+                    errorList.push_back({levelFileList[fileIndex].path, e.sftpGetCode(), e.getMessage()});
+                }
+            });
+        }
+        return (errorList);
+    }
+    //
+    // Download a list of remote files/listing entries (see getFiles()).
+    //
+    template <typename RemoteFileList>
+    static FileList getFileList(CSFTP &sftpServer, FileMapper &fileMapper, const RemoteFileList &remoteFileList, FileCompletionFn completionFn, bool safe, char postFix)
+    {
+        FileList successList;
+        try
+        {
+            for (auto remoteFile : remoteFileList)
+            {
+                std::string localFilePath;
+                if (!getMappedFile(sftpServer, fileMapper, remoteFile, safe, postFix, localFilePath))
+                {
+                    continue;
+                }
+                successList.push_back(localFilePath);
+                if (completionFn)
+                {
+                    completionFn(successList.back());
+                }
+            }
+            // On exception report and return with files that where successfully downloaded.
+        }
+        catch (const CSFTP::Exception &e)
+        {
+            std::cerr << e.getMessage() << std::endl;
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << std::endl;
+        }
+        return (successList);
+    }
+    //
+    // Parallel download of a list of remote files/listing entries (see getFilesParallel()).
+    //
+    template <typename RemoteFileList>
+    static FileList getFileListParallel(SFTPServerList &sftpServers, FileMapper &fileMapper, const RemoteFileList &remoteFileList, FileCompletionFn completionFn, TransferStatistics *statistics, bool safe, char postFix)
+    {
+        FileList successList;
+        TransferStatistics transferStatistics;
+        std::mutex completionMutex;
+        transferStatistics.elapsedSeconds = runParallelWorkers(sftpServers, remoteFileList.size(), [&](CSFTP &sftpServer, std::size_t fileIndex) {
+            try
+            {
+                std::string localFilePath;
+                if (getMappedFile(sftpServer, fileMapper, remoteFileList[fileIndex], safe, postFix, localFilePath))
+                {
+                    bool regularFile{CFile::isFile(localFilePath)};
+                    std::uintmax_t fileSize{regularFile ? std::filesystem::file_size(localFilePath) : 0};
+                    std::scoped_lock completionLock(completionMutex);
+                    (regularFile ? transferStatistics.filesTransfered : transferStatistics.directoriesCreated)++;
+                    transferStatistics.bytesTransfered += fileSize;
+                    successList.push_back(localFilePath);
+                    if (completionFn)
+                    {
+                        completionFn(successList.back());
+                    }
+                }
+            }
+            catch (const CSFTP::Exception &e)
+            {
+                std::scoped_lock completionLock(completionMutex);
+                transferStatistics.filesFailed++;
+                std::cerr << e.getMessage() << std::endl;
+            }
+            catch (const std::exception &e)
+            {
+                std::scoped_lock completionLock(completionMutex);
+                transferStatistics.filesFailed++;
+                std::cerr << e.what() << std::endl;
+            }
+        });
+        if (statistics)
+        {
+            *statistics = transferStatistics;
+        }
+        return (successList);
+    }
+    // ================
+    // PUBLIC FUNCTIONS
+    // ================
+    //
+    // Convert remote file attributes to a listing entry.
+    //
+    RemoteFileEntry remoteFileEntry(const std::string &filePath, const CSFTP::FileAttributes &fileAttributes)
+    {
+        RemoteFileEntry remoteFile;
+        remoteFile.path = filePath;
+        if (CSFTP::isARegularFile(fileAttributes))
+        {
+            remoteFile.type = RemoteFileEntry::Type::regular;
+        }
+        else if (CSFTP::isADirectory(fileAttributes))
+        {
+            remoteFile.type = RemoteFileEntry::Type::directory;
+        }
+        else if (CSFTP::isASymbolicLink(fileAttributes))
+        {
+            remoteFile.type = RemoteFileEntry::Type::symbolicLink;
+        }
+        remoteFile.size = fileAttributes->size;
+        remoteFile.permissions = fileAttributes->permissions;
+        remoteFile.modifiedTime = remoteModifiedTime(fileAttributes);
+        return (remoteFile);
+    }
+    //
+    // Return the hash (lower case hex) of a local file, or of each block of it if a block size
+    // is given, with an OpenSSL digest (sha256, sha1, md5 ...).
+    //
+    std::vector<std::string> localFileHashes(const std::string &localFile, const std::string &algorithm, std::uint64_t blockSize)
+    {
+        const EVP_MD *digest{EVP_get_digestbyname(algorithm.c_str())};
+        if (digest == nullptr)
+        {
+            throw std::invalid_argument("Unsupported hash algorithm " + algorithm + ".");
+        }
+        std::ifstream file{localFile, std::ios_base::in | std::ios_base::binary};
+        std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> hashContext{EVP_MD_CTX_new(), EVP_MD_CTX_free};
+        std::unique_ptr<char[]> readBuffer{new char[kHashReadBufferSize]};
+        std::vector<std::string> fileHashes;
+        std::uint64_t blockBytes{0};
+        if (!file)
+        {
+            throw std::system_error(errno, std::system_category());
+        }
+        if (!hashContext || (EVP_DigestInit_ex(hashContext.get(), digest, nullptr) != 1))
+        {
+            throw std::runtime_error("Could not initialise " + algorithm + " hash.");
+        }
+        auto finishHash = [&]() {
+            unsigned char hash[EVP_MAX_MD_SIZE];
+            unsigned int hashLength{0};
+            std::ostringstream fileHash;
+            EVP_DigestFinal_ex(hashContext.get(), hash, &hashLength);
+            for (unsigned int byte = 0; byte < hashLength; byte++)
+            {
+                fileHash << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(hash[byte]);
+            }
+            fileHashes.push_back(fileHash.str());
+            EVP_DigestInit_ex(hashContext.get(), digest, nullptr);
+            blockBytes = 0;
+        };
+        while (file.read(readBuffer.get(), kHashReadBufferSize) || (file.gcount() != 0))
+        {
+            const char *hashData{readBuffer.get()};
+            std::uint64_t bytesLeft{static_cast<std::uint64_t>(file.gcount())};
+            while (bytesLeft != 0)
+            {
+                std::uint64_t hashBytes{(blockSize != 0) ? std::min(bytesLeft, blockSize - blockBytes) : bytesLeft};
+                EVP_DigestUpdate(hashContext.get(), hashData, hashBytes);
+                hashData += hashBytes;
+                bytesLeft -= hashBytes;
+                blockBytes += hashBytes;
+                if (blockBytes == blockSize)
+                {
+                    finishHash();
+                }
+            }
+        }
+        if (file.bad())
+        {
+            throw std::system_error(errno, std::system_category());
+        }
+        // Whole file, last part block or empty file
+        if ((blockBytes != 0) || fileHashes.empty())
+        {
+            finishHash();
+        }
+        return (fileHashes);
+    }
+    //
+    // Upload a file from remote SFTP server assigning it the same permissions as the remote file.
+    // SFTP does not directly support file upload/download so this function is not part of the
+    // CSFTP class.
+    //
+    void getFile(CSFTP &sftpServer, const std::string &sourceFile, const std::string &destinationFile, FileCompletionFn completionFn)
+    {
+        CSFTP::File remoteFile;
+        try
+        {
+            CSFTP::FileAttributes fileAttributes;
+            remoteFile = sftpServer.openFile(sourceFile, O_RDONLY, 0);
+            sftpServer.getFileAttributes(remoteFile, fileAttributes);
+            if (sftpServer.isARegularFile(fileAttributes))
+            {
+                downloadFile(sftpServer, remoteFile, destinationFile, fileAttributes->permissions);
+                if (completionFn)
+                {
+                    completionFn(destinationFile);
+                }
+            }
+            else if (sftpServer.isADirectory(fileAttributes))
+            {
+                if (!CFile::exists(CPath(destinationFile)))
+                {
+                    CFile::createDirectory(CPath(destinationFile));
+                }
+                if (completionFn)
+                {
+                    completionFn(destinationFile);
+                }
+            }
+            sftpServer.closeFile(remoteFile);
+        }
+        catch (const CSFTP::Exception &e)
+        {
+            throw;
+        }
+        catch (const std::system_error &e)
+        {
+            throw;
+        }
+    }
+    //
+    // Upload a file from remote SFTP server using the attributes in its listing entry (so no
+    // stat round trip is needed).
+    //
+    void getFile(CSFTP &sftpServer, const RemoteFileEntry &sourceFile, const std::string &destinationFile, FileCompletionFn completionFn)
+    {
+        try
+        {
+            if (sourceFile.type == RemoteFileEntry::Type::regular)
+            {
+                CSFTP::File remoteFile{sftpServer.openFile(sourceFile.path, O_RDONLY, 0)};
+                downloadFile(sftpServer, remoteFile, destinationFile, sourceFile.permissions);
+                sftpServer.closeFile(remoteFile);
+            }
+            else if (sourceFile.type == RemoteFileEntry::Type::directory)
+            {
+                if (!CFile::exists(CPath(destinationFile)))
+                {
+                    CFile::createDirectory(CPath(destinationFile));
+                }
+            }
+            else
+            {
+                return;
+            }
+            if (completionFn)
+            {
+                completionFn(destinationFile);
+            }
+        }
+        catch (const CSFTP::Exception &e)
+        {
+            throw;
+        }
+        catch (const std::system_error &e)
+        {
+            throw;
+        }
+    }
+    //
+    // Return the identity recorded at the start of a segmented download checkpoint; the
+    // download only resumes if the remote file size/modified time and segment size match.
+    //
+    std::string segmentCheckpointIdentity(const CSFTP::FileAttributes &fileAttributes, std::uint64_t segmentSize)
+    {
+        return (std::to_string(fileAttributes->size) + " " + std::to_string(remoteModifiedTime(fileAttributes)) + " " + std::to_string(segmentSize));
+    }
+    //
+    // Read a segmented download checkpoint. The first line identifies the remote file being
+    // downloaded and each following line is a completed segment number. If the identity does
+    // not match nothing is returned; an incomplete last line (interrupted write) is ignored.
+    // Any other line that is not a segment number below the segment count means the file is
+    // corrupt so it is treated as no checkpoint (the download restarts).
+    //
+    std::set<std::uint64_t> readSegmentCheckpoint(const std::string &checkpointFile, const std::string &fileIdentity, std::uint64_t segmentCount)
+    {
+        std::set<std::uint64_t> completedSegments;
+        std::ifstream checkpoint{checkpointFile};
+        std::string line;
+        if (checkpoint && std::getline(checkpoint, line) && (line == fileIdentity))
+        {
+            while (std::getline(checkpoint, line) && !checkpoint.eof())
+            {
+                if (line.empty() || !std::all_of(line.begin(), line.end(), [](unsigned char ch) { return (std::isdigit(ch)); }) ||
+                    (line.size() > std::numeric_limits<std::uint64_t>::digits10) || (std::stoull(line) >= segmentCount))
+                {
+                    return (std::set<std::uint64_t>());
+                }
+                completedSegments.insert(std::stoull(line));
+            }
+        }
+        return (completedSegments);
+    }
+    //
+    // Download a large remote file in segments of a given size; a worker for each SFTP server
+    // passed in (each opened on its own session) opens the remote file and reads the segments it
+    // takes from a work queue with pipelined reads, writing them in place into a preallocated local
+    // file. Completed segments are recorded in a checkpoint file alongside the local file so that a
+    // failed or interrupted download resumes from where it stopped when called again (provided
+    // the remote file size/modified time are unchanged). Any segment error is thrown once all
+    // workers have stopped.
+    //
+    void getFileSegmented(SFTPServerList &sftpServers, const std::string &sourceFile, const std::string &destinationFile, std::uint64_t segmentSize, FileCompletionFn completionFn)
+    {
+        if (sftpServers.empty())
+        {
+            return;
+        }
+        if (segmentSize == 0)
+        {
+            throw std::invalid_argument("Segment size must be greater than zero.");
+        }
+        CSFTP &sftpServer{sftpServers.front().get()};
+        CSFTP::FileAttributes fileAttributes;
+        sftpServer.getFileAttributes(sourceFile, fileAttributes);
+        if (!sftpServer.isARegularFile(fileAttributes))
+        {
+            getFile(sftpServer, sourceFile, destinationFile, completionFn);
+            return;
+        }
+        std::uint64_t fileSize{fileAttributes->size};
+        std::uint64_t segmentCount{(fileSize + segmentSize - 1) / segmentSize};
+        std::string checkpointFile{destinationFile + kCheckpointPostfix};
+        std::string fileIdentity{segmentCheckpointIdentity(fileAttributes, segmentSize)};
+        std::set<std::uint64_t> completedSegments;
+        if (CFile::exists(destinationFile) && CFile::exists(checkpointFile))
+        {
+            completedSegments = readSegmentCheckpoint(checkpointFile, fileIdentity, segmentCount);
+        }
+        if (!CFile::exists(CPath(destinationFile).parentPath()))
+        {
+            CFile::createDirectory(CPath(destinationFile).parentPath());
+        }
+        // Open local file and preallocate (or at least size) it; kept if resuming
+        int localFile{::open(destinationFile.c_str(), O_WRONLY | O_CREAT | (completedSegments.empty() ? O_TRUNC : 0), 0600)};
+        if (localFile == -1)
+        {
+            throw std::system_error(errno, std::system_category());
+        }
+        if ((fileSize != 0) && (::fallocate(localFile, 0, 0, fileSize) == -1) && (::ftruncate(localFile, fileSize) == -1))
+        {
+            int error{errno};
+            ::close(localFile);
+            throw std::system_error(error, std::system_category());
+        }
+        std::ofstream checkpoint{checkpointFile, completedSegments.empty() ? std::ios_base::trunc : std::ios_base::app};
+        if (!checkpoint)
+        {
+            ::close(localFile);
+            throw std::system_error(errno, std::system_category());
+        }
+        if (completedSegments.empty())
+        {
+            checkpoint << fileIdentity << std::endl;
+        }
+        // Download remaining segments
+        std::vector<std::uint64_t> pendingSegments;
+        for (std::uint64_t segment = 0; segment < segmentCount; segment++)
+        {
+            if (completedSegments.count(segment) == 0)
+            {
+                pendingSegments.push_back(segment);
+            }
+        }
+        std::mutex checkpointMutex;
+        std::exception_ptr segmentError;
+        std::atomic<bool> segmentFailed{false};
+        runParallelWorkers(sftpServers, pendingSegments.size(), [&](CSFTP &segmentServer, std::size_t segmentIndex) {
+            if (segmentFailed)
+            {
+                return;
+            }
+            try
+            {
+                std::uint64_t segmentOffset{pendingSegments[segmentIndex] * segmentSize};
+                std::uint64_t segmentLength{std::min(segmentSize, fileSize - segmentOffset)};
+                std::uint64_t writeOffset{segmentOffset};
+                CSFTP::File remoteFile{segmentServer.openFile(sourceFile, O_RDONLY, 0)};
+                segmentServer.seekFile64(remoteFile, segmentOffset);
+                auto writeSegmentFn = [&](const char *readBuffer, size_t bytesRead) {
+                    writeAt(localFile, readBuffer, bytesRead, writeOffset);
+                    writeOffset += bytesRead;
+                };
+                std::uint64_t segmentBytesRead{segmentServer.readFileAsync(remoteFile, writeSegmentFn, segmentLength)};
+                segmentServer.closeFile(remoteFile);
+                if (segmentBytesRead != segmentLength)
+                {
+                    throw std::runtime_error("Remote file " + sourceFile + " changed size during download.");
+                }
+                // Segment data must be on disk before it is recorded as complete
+                if (::fdatasync(localFile) == -1)
+                {
+                    throw std::system_error(errno, std::system_category());
+                }
+                std::scoped_lock checkpointLock(checkpointMutex);
+                checkpoint << pendingSegments[segmentIndex] << std::endl;
+            }
+            catch (...)
+            {
+                std::scoped_lock checkpointLock(checkpointMutex);
+                if (!segmentError)
+                {
+                    segmentError = std::current_exception();
+                }
+                segmentFailed = true;
+            }
+        });
+        ::close(localFile);
+        checkpoint.close();
+        if (segmentError)
+        {
+            std::rethrow_exception(segmentError);
+        }
+        CFile::setPermissions(destinationFile, static_cast<CFile::Permissions>(fileAttributes->permissions));
+        CFile::remove(checkpointFile);
+        if (completionFn)
+        {
+            completionFn(destinationFile);
+        }
+    }
+    //
+    // Download a file to remote SFTP server assigning it the same permissions as the local file.
+    // It will be created with the owner and group of the currently logged in SSH account.
+    // SFTP does not directly support file upload/download so this function is not part of the
+    // CSFTP class.
+    //
+    void putFile(CSFTP &sftpServer, const std::string &sourceFile, const std::string &destinationFile, FileCompletionFn completionFn)
+    {
+        CSFTP::File remoteFile;
+        std::ifstream localFile;
+        try
+        {
+            std::string remoteFilePath;
+            CFile::Status fileStatus;
+            bool transferFile{false};
+            if (CFile::isDirectory(sourceFile))
+            {
+                remoteFilePath = destinationFile;
+                fileStatus = CFile::fileStatus(sourceFile);
+            }
+            else if (CFile::isFile(sourceFile))
+            {
+                remoteFilePath = CPath(destinationFile).parentPath().toString();
+                fileStatus = CFile::fileStatus(CPath(sourceFile).parentPath());
+                transferFile = true;
+            }
+            else
+            {
+                return; // Not valid for transfer NEXT FILE!
+            }
+            if (!remoteDirectoryExists(sftpServer, remoteFilePath))
+            {
+                makeRemotePath(sftpServer, remoteFilePath, static_cast<CSFTP::FilePermissions>(fileStatus.permissions()));
+                if (!transferFile && completionFn)
+                {
+                    completionFn(remoteFilePath);
+                }
+            }
+            if (transferFile)
+            {
+                localFile.open(sourceFile, std::ios_base::in | std::ios_base::binary);
+                if (!localFile)
+                {
+                    throw std::system_error(errno, std::system_category());
+                }
+                fileStatus = CFile::fileStatus(sourceFile);
+                remoteFile = sftpServer.openFile(destinationFile, O_CREAT | O_WRONLY | O_TRUNC, (int)fileStatus.permissions());
+                // Pipelined write (window set by the IO pipeline depth; serial before libssh 0.11)
+                sftpServer.writeFileAsync(remoteFile, [&localFile](char *writeBuffer, size_t bytesToWrite) {
+                    localFile.read(writeBuffer, bytesToWrite);
+                    if (localFile.bad())
+                    {
+                        throw std::system_error(errno, std::system_category());
+                    }
+                    return (static_cast<size_t>(localFile.gcount()));
+                });
+                sftpServer.closeFile(remoteFile);
+                localFile.close();
+                if (completionFn)
+                {
+                    completionFn(destinationFile);
+                }
+            }
+        }
+        catch (const CSFTP::Exception &e)
+        {
+            // Remote directory may have been removed so no longer known
+            sftpServer.forgetKnownDirectory(CPath(destinationFile).parentPath().toString());
+            throw;
+        }
+        catch (const std::system_error &e)
+        {
+            throw;
+        }
+    }
+    //
+    // Split the entries of a remote tree rooted at remotePath into the levels an operation
+    // is applied to them in bottom up: all non directories (symbolic links only if asked
+    // for) then directories deepest first, depth being the number of path components below
+    // the root (so trailing separators on the root do not matter).
+    //
+    std::vector<RemoteFileEntryList> remoteFileLevels(const RemoteFileEntryList &remoteFileList, const std::string &remotePath, bool includeSymbolicLinks)
+    {
+        std::string rootPath{trimRemotePath(remotePath)};
+        std::string rootPrefix{(!rootPath.empty() && (rootPath.back() == kServerPathSep)) ? rootPath : rootPath + kServerPathSep};
+        std::map<std::size_t, RemoteFileEntryList, std::greater<std::size_t>> directoryLevels;
+        std::vector<RemoteFileEntryList> fileLevels(1);
+        for (auto &remoteFile : remoteFileList)
+        {
+            if (remoteFile.type == RemoteFileEntry::Type::directory)
+            {
+                std::size_t depth{0};
+                if (trimRemotePath(remoteFile.path) != rootPath)
+                {
+                    std::string relativePath{(remoteFile.path.compare(0, rootPrefix.size(), rootPrefix) == 0) ? remoteFile.path.substr(rootPrefix.size()) : remoteFile.path};
+                    depth = 1 + std::count(relativePath.begin(), relativePath.end(), kServerPathSep);
+                }
+                directoryLevels[depth].push_back(remoteFile);
+            }
+            else if (includeSymbolicLinks || (remoteFile.type != RemoteFileEntry::Type::symbolicLink))
+            {
+                fileLevels.front().push_back(remoteFile);
+            }
+        }
+        for (auto &[depth, levelFileList] : directoryLevels)
+        {
+            fileLevels.push_back(std::move(levelFileList));
+        }
+        return (fileLevels);
+    }
+    //
+    // Recursively parse a remote server path passed in and pass back a list of directories/files found.
+    // If a feedback function has been passed in then it is called for each file found.
+    //
+    void listRemoteRecursive(CSFTP &sftpServer, const std::string &directoryPath, FileList &remoteFileList, FileFeedBackFn remoteFileFeedbackFn)
+    {
+        try
+        {
+            CSFTP::Directory directoryHandle;
+            CSFTP::FileAttributes fileAttributes;
+            std::string filePath;
+            directoryHandle = sftpServer.openDirectory(directoryPath);
+            sftpServer.addKnownDirectory(directoryPath);
+            while (sftpServer.readDirectory(directoryHandle, fileAttributes))
+            {
+                if ((static_cast<std::string>(fileAttributes->name) != ".") && (static_cast<std::string>(fileAttributes->name) != ".."))
+                {
+                    std::string filePath{directoryPath};
+                    if (filePath.back() == kServerPathSep)
+                        filePath.pop_back();
+                    filePath += std::string(1, kServerPathSep) + fileAttributes->name;
+                    if (sftpServer.isADirectory(fileAttributes))
+                    {
+                        listRemoteRecursive(sftpServer, filePath, remoteFileList, remoteFileFeedbackFn);
+                    }
+                    remoteFileList.push_back(filePath);
+                    if (remoteFileFeedbackFn)
+                    {
+                        remoteFileFeedbackFn(remoteFileList.back());
+                    }
+                }
+            }
+            if (!sftpServer.endOfDirectory(directoryHandle))
+            {
+                sftpServer.closeDirectory(directoryHandle);
+                throw CSFTP::Exception(sftpServer, __func__);
+            }
+            sftpServer.closeDirectory(directoryHandle);
+        }
+        catch (const CSFTP::Exception &e)
+        {
+            throw;
+        }
+    }
+    //
+    // Recursively parse a remote server path passed in and pass back a list of entries found carrying
+    // the attributes returned by the directory read. If a feedback function has been passed in then it
+    // is called for each file found.
+    //
+    void listRemoteRecursive(CSFTP &sftpServer, const std::string &directoryPath, RemoteFileEntryList &remoteFileList, FileFeedBackFn remoteFileFeedbackFn)
+    {
+        try
+        {
+            CSFTP::Directory directoryHandle;
+            CSFTP::FileAttributes fileAttributes;
+            directoryHandle = sftpServer.openDirectory(directoryPath);
+            sftpServer.addKnownDirectory(directoryPath);
+            while (sftpServer.readDirectory(directoryHandle, fileAttributes))
+            {
+                if ((static_cast<std::string>(fileAttributes->name) != ".") && (static_cast<std::string>(fileAttributes->name) != ".."))
+                {
+                    std::string filePath{directoryPath};
+                    if (filePath.back() == kServerPathSep)
+                        filePath.pop_back();
+                    filePath += std::string(1, kServerPathSep) + fileAttributes->name;
+                    if (sftpServer.isADirectory(fileAttributes))
+                    {
+                        listRemoteRecursive(sftpServer, filePath, remoteFileList, remoteFileFeedbackFn);
+                    }
+                    remoteFileList.push_back(remoteFileEntry(filePath, fileAttributes));
+                    if (remoteFileFeedbackFn)
+                    {
+                        remoteFileFeedbackFn(remoteFileList.back().path);
+                    }
+                }
+            }
+            if (!sftpServer.endOfDirectory(directoryHandle))
+            {
+                sftpServer.closeDirectory(directoryHandle);
+                throw CSFTP::Exception(sftpServer, __func__);
+            }
+            sftpServer.closeDirectory(directoryHandle);
+        }
+        catch (const CSFTP::Exception &e)
+        {
+            throw;
+        }
+    }
+    //
+    // Download all files passed in file list from server to the local directory passed in; recreating any server directory
+    // structure in situ. If safe == true then the file is downloaded to a filename with a postfix then the file is renamed
+    // to its correct value on success. Returns a list of successfully downloaded files and directories created in the local
+    // directory.
+    //
+    FileList getFiles(CSFTP &sftpServer, FileMapper &fileMapper, const FileList &remoteFileList, FileCompletionFn completionFn, bool safe, char postFix)
+    {
+        return (getFileList(sftpServer, fileMapper, remoteFileList, completionFn, safe, postFix));
+    }
+    //
+    // Download all files in a remote listing (see getFiles()); using the listing attributes
+    // removes the stat round trips otherwise needed for each file.
+    //
+    FileList getFiles(CSFTP &sftpServer, FileMapper &fileMapper, const RemoteFileEntryList &remoteFileList, FileCompletionFn completionFn, bool safe, char postFix)
+    {
+        return (getFileList(sftpServer, fileMapper, remoteFileList, completionFn, safe, postFix));
+    }
+    //
+    // Take local directory, file list and upload all files to server;  recreating
+    // any local directory structure in situ on the server. Returns a list of successfully
+    // uploaded files and directories created.If safe == true then the file is uploaded to a
+    // filename with a postfix then the file is renamed to its correct value on success.
+    //
+    FileList putFiles(CSFTP &sftpServer, FileMapper &fileMapper, const FileList &localFileList, FileCompletionFn completionFn, bool safe, char postFix)
+    {
+        FileList successList;
+        try
+        {
+            CSFTP::FileAttributes remoteDirectoryAttributes;
+            // Create any directories using root path permissions
+            sftpServer.getFileAttributes(fileMapper.getRemoteDirectory(), remoteDirectoryAttributes);
+            // Process file/directory list
+            for (auto localFile : localFileList)
+            {
+                if (CFile::exists(localFile))
+                {
+                    std::string remoteFilePath;
+                    bool transferFile{false};
+                    // Create remote full remote path and set file to be transfered flag
+                    if (CFile::isDirectory(localFile))
+                    {
+                        remoteFilePath = fileMapper.toRemote(localFile);
+                    }
+                    else if (CFile::isFile(localFile))
+                    {
+                        remoteFilePath = fileMapper.toRemote(CPath(localFile).parentPath().toString());
+                        transferFile = true;
+                    }
+                    else
+                    {
+                        continue; // Not valid for transfer NEXT FILE!
+                    }
+                    if (!remoteDirectoryExists(sftpServer, remoteFilePath))
+                    {
+                        makeRemotePath(sftpServer, remoteFilePath, remoteDirectoryAttributes->permissions);
+                        successList.push_back(remoteFilePath);
+                        if (!transferFile && completionFn)
+                        {
+                            completionFn(successList.back());
+                        }
+                    }
+                    // Transfer file
+                    if (transferFile)
+                    {
+                        putMappedFile(sftpServer, fileMapper, localFile, safe, postFix, remoteFilePath);
+                        successList.push_back(remoteFilePath);
+                        if (completionFn)
+                        {
+                            completionFn(successList.back());
+                        }
+                    }
+                }
+            }
+            // On exception report and return with files that where successfully uploaded.
+        }
+        catch (const CSFTP::Exception &e)
+        {
+            std::cerr << e.getMessage() << std::endl;
+        }
+        catch (const CFile::Exception &e)
+        {
+            std::cerr << e.what() << std::endl;
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << std::endl;
+        }
+        return (successList);
+    }
+    //
+    // Parallel version of getFiles(). Files are taken from a work queue by a worker for each
+    // SFTP server passed in; each server must be opened on its own session (libssh sessions
+    // are not thread safe). The completion function is called (serialized) as each file
+    // completes and a failed file is reported and skipped rather than ending the transfer.
+    // If passed, statistics are filled in with aggregate counts and throughput.
+    //
+    FileList getFilesParallel(SFTPServerList &sftpServers, FileMapper &fileMapper, const FileList &remoteFileList, FileCompletionFn completionFn, TransferStatistics *statistics, bool safe, char postFix)
+    {
+        return (getFileListParallel(sftpServers, fileMapper, remoteFileList, completionFn, statistics, safe, postFix));
+    }
+    //
+    // Parallel download of all files in a remote listing (see getFilesParallel()).
+    //
+    FileList getFilesParallel(SFTPServerList &sftpServers, FileMapper &fileMapper, const RemoteFileEntryList &remoteFileList, FileCompletionFn completionFn, TransferStatistics *statistics, bool safe, char postFix)
+    {
+        return (getFileListParallel(sftpServers, fileMapper, remoteFileList, completionFn, statistics, safe, postFix));
+    }
+    //
+    // Parallel version of putFiles(). Any remote directories needed are created first (on the
+    // first server) and then files are taken from a work queue by a worker for each SFTP server
+    // passed in; each server must be opened on its own session (libssh sessions are not thread
+    // safe). The completion function is called (serialized) as each file completes and a failed
+    // file is reported and skipped rather than ending the transfer. If passed, statistics are
+    // filled in with aggregate counts and throughput.
+    //
+    FileList putFilesParallel(SFTPServerList &sftpServers, FileMapper &fileMapper, const FileList &localFileList, FileCompletionFn completionFn, TransferStatistics *statistics, bool safe, char postFix)
+    {
+        FileList successList;
+        FileList filesToTransfer;
+        TransferStatistics transferStatistics;
+        std::mutex completionMutex;
+        if (sftpServers.empty())
+        {
+            return (successList);
+        }
+        try
+        {
+            CSFTP &sftpServer{sftpServers.front().get()};
+            CSFTP::FileAttributes remoteDirectoryAttributes;
+            std::set<std::string> remoteDirectories;
+            auto start = std::chrono::steady_clock::now();
+            // Create any directories using root path permissions
+            sftpServer.getFileAttributes(fileMapper.getRemoteDirectory(), remoteDirectoryAttributes);
+            for (auto localFile : localFileList)
+            {
+                if (CFile::isDirectory(localFile))
+                {
+                    remoteDirectories.insert(fileMapper.toRemote(localFile));
+                }
+                else if (CFile::isFile(localFile))
+                {
+                    remoteDirectories.insert(fileMapper.toRemote(CPath(localFile).parentPath().toString()));
+                    filesToTransfer.push_back(localFile);
+                }
+            }
+            for (auto &remoteDirectory : remoteDirectories)
+            {
+                if (!remoteDirectoryExists(sftpServer, remoteDirectory))
+                {
+                    makeRemotePath(sftpServer, remoteDirectory, remoteDirectoryAttributes->permissions);
+                    transferStatistics.directoriesCreated++;
+                    successList.push_back(remoteDirectory);
+                    if (completionFn)
+                    {
+                        completionFn(successList.back());
+                    }
+                }
+            }
+            transferStatistics.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        catch (const CSFTP::Exception &e)
         {
             std::cerr << e.getMessage() << std::endl;
+            return (successList);
         }
         catch (const std::exception &e)
         {
             std::cerr << e.what() << std::endl;
+            return (successList);
+        }
+        transferStatistics.elapsedSeconds += runParallelWorkers(sftpServers, filesToTransfer.size(), [&](CSFTP &sftpServer, std::size_t fileIndex) {
+            try
+            {
+                std::string remoteFilePath;
+                putMappedFile(sftpServer, fileMapper, filesToTransfer[fileIndex], safe, postFix, remoteFilePath);
+                std::uintmax_t fileSize{std::filesystem::file_size(filesToTransfer[fileIndex])};
+                std::scoped_lock completionLock(completionMutex);
+                transferStatistics.filesTransfered++;
+                transferStatistics.bytesTransfered += fileSize;
+                successList.push_back(remoteFilePath);
+                if (completionFn)
+                {
+                    completionFn(successList.back());
+                }
+            }
+            catch (const CSFTP::Exception &e)
+            {
+                std::scoped_lock completionLock(completionMutex);
+                transferStatistics.filesFailed++;
+                std::cerr << e.getMessage() << std::endl;
+            }
+            catch (const std::exception &e)
+            {
+                std::scoped_lock completionLock(completionMutex);
+                transferStatistics.filesFailed++;
+                std::cerr << e.what() << std::endl;
+            }
+        });
+        if (statistics)
+        {
+            *statistics = transferStatistics;
         }
         return (successList);
     }
     //
-    // Take local directory, file list and upload all files to server;  recreating
-    // any local directory structure in situ on the server. Returns a list of successfully
-    // uploaded files and directories created.If safe == true then the file is uploaded to a
-    // filename with a postfix then the file is renamed to its correct value on success.
+    // Recursively remove a remote directory tree (or a single file/link); see applyRemoteRecursive().
+    // Returns any paths that could not be removed.
     //
-    FileList putFiles(CSFTP &sftpServer, FileMapper &fileMapper, const FileList &localFileList, FileCompletionFn completionFn, bool safe, char postFix)
+    RemotePathErrorList removeRemoteRecursive(SFTPServerList &sftpServers, const std::string &remotePath)
+    {
+        return (applyRemoteRecursive(sftpServers, remotePath, true, [](CSFTP &sftpServer, const RemoteFileEntry &remoteFile) {
+            if (remoteFile.type == RemoteFileEntry::Type::directory)
+            {
+                sftpServer.removeDirectory(remoteFile.path);
+            }
+            else
+            {
+                sftpServer.removeLink(remoteFile.path);
+            }
+        }));
+    }
+    //
+    // Recursively change the permissions of a remote directory tree (symbolic links are skipped
+    // as the change would apply to their target); see applyRemoteRecursive(). Returns any paths
+    // that could not be changed.
+    //
+    RemotePathErrorList changePermissionsRecursive(SFTPServerList &sftpServers, const std::string &remotePath, const CSFTP::FilePermissions &filePermissions)
+    {
+        return (applyRemoteRecursive(sftpServers, remotePath, false, [&filePermissions](CSFTP &sftpServer, const RemoteFileEntry &remoteFile) {
+            sftpServer.changePermissions(remoteFile.path, filePermissions);
+        }));
+    }
+    //
+    // Recursively change the owner/group of a remote directory tree (symbolic links are skipped
+    // as the change would apply to their target); see applyRemoteRecursive(). Returns any paths
+    // that could not be changed.
+    //
+    RemotePathErrorList changeOwnerGroupRecursive(SFTPServerList &sftpServers, const std::string &remotePath, const CSFTP::FileOwner &owner, const CSFTP::FileGroup &group)
+    {
+        return (applyRemoteRecursive(sftpServers, remotePath, false, [&owner, &group](CSFTP &sftpServer, const RemoteFileEntry &remoteFile) {
+            sftpServer.changeOwnerGroup(remoteFile.path, owner, group);
+        }));
+    }
+    //
+    // Recursively copy a remote directory (or a single file) to another path on the same server.
+    // If exec is permitted the whole tree is copied with one cp run on the server; otherwise the
+    // directories are created and each file copied with CSFTP::copyFile(). Returns a list of the
+    // destination directories/files.
+    //
+    FileList copyRemoteRecursive(CSFTP &sftpServer, const std::string &sourcePath, const std::string &destinationPath, FileCompletionFn completionFn)
+    {
+        FileList successList;
+        RemoteFileEntryList sourceFileList;
+        std::map<std::string, CSFTP::FilePermissions> sourceDirectories;
+        CSFTP::FileAttributes fileAttributes;
+        std::string sourceRoot{sourcePath};
+        std::string destinationRoot{destinationPath};
+        sftpServer.getFileAttributes(sourcePath, fileAttributes);
+        if (!sftpServer.isADirectory(fileAttributes))
+        {
+            sftpServer.copyFile(sourcePath, destinationPath);
+            successList.push_back(destinationPath);
+            if (completionFn)
+            {
+                completionFn(successList.back());
+            }
+            return (successList);
+        }
+        while ((sourceRoot.size() > 1) && (sourceRoot.back() == kServerPathSep))
+        {
+            sourceRoot.pop_back();
+        }
+        while ((destinationRoot.size() > 1) && (destinationRoot.back() == kServerPathSep))
+        {
+            destinationRoot.pop_back();
+        }
+        listRemoteRecursive(sftpServer, sourceRoot, sourceFileList);
+        if (sftpServer.executeRemoteCommand("mkdir -p -- " + CSFTP::quoteRemotePath(destinationRoot) + " && cp -pR -- " +
+                                            CSFTP::quoteRemotePath(sourceRoot + kServerPathSep + ".") + " " + CSFTP::quoteRemotePath(destinationRoot)))
+        {
+            for (auto &sourceFile : sourceFileList)
+            {
+                successList.push_back(destinationRoot + sourceFile.path.substr(sourceRoot.size()));
+                if (sourceFile.type == RemoteFileEntry::Type::directory)
+                {
+                    sftpServer.addKnownDirectory(successList.back());
+                }
+                if (completionFn)
+                {
+                    completionFn(successList.back());
+                }
+            }
+            return (successList);
+        }
+        // No exec (or the copy failed part way) so create directories (sorted so parents
+        // first and any already created taken as made) then copy files
+        makeRemotePath(sftpServer, destinationRoot, fileAttributes->permissions);
+        for (auto &sourceFile : sourceFileList)
+        {
+            if (sourceFile.type == RemoteFileEntry::Type::directory)
+            {
+                sourceDirectories[sourceFile.path] = sourceFile.permissions;
+            }
+        }
+        for (auto &[sourceDirectory, permissions] : sourceDirectories)
+        {
+            successList.push_back(destinationRoot + sourceDirectory.substr(sourceRoot.size()));
+            try
+            {
+                sftpServer.createDirectory(successList.back(), permissions);
+            }
+            catch (const CSFTP::Exception &e)
+            {
+                if (!remoteDirectoryExists(sftpServer, successList.back()))
+                {
+                    throw;
+                }
+            }
+            if (completionFn)
+            {
+                completionFn(successList.back());
+            }
+        }
+        for (auto &sourceFile : sourceFileList)
+        {
+            if (sourceFile.type == RemoteFileEntry::Type::regular)
+            {
+                successList.push_back(destinationRoot + sourceFile.path.substr(sourceRoot.size()));
+                sftpServer.copyFile(sourceFile.path, successList.back());
+                if (completionFn)
+                {
+                    completionFn(successList.back());
+                }
+            }
+        }
+        return (successList);
+    }
+    //
+    // Download the files in a remote listing whose content differs from the local copy (see
+    // getFiles()). Remote file hashes are fetched in batches (see remoteFileHashes()) and
+    // compared against local hashes from the passed cache, which is saved. A changed file that
+    // is large enough and the same size as the local copy is compared block by block and only
+    // the changed blocks downloaded (see getChangedBlocks()). Returns a list of files downloaded
+    // and directories created.
+    //
+    FileList getChangedFiles(CSFTP &sftpServer, FileMapper &fileMapper, const RemoteFileEntryList &remoteFileList, FileHashCache &fileHashCache, FileCompletionFn completionFn, bool safe, char postFix)
+    {
+        FileList successList;
+        try
+        {
+            CSFTPExtended extendedServer{sftpServer.getSession()};
+            FileList remoteFiles;
+            for (auto &remoteFile : remoteFileList)
+            {
+                if (remoteFile.type == RemoteFileEntry::Type::regular)
+                {
+                    remoteFiles.push_back(remoteFile.path);
+                }
+            }
+            openHashExtensions(sftpServer, extendedServer);
+            auto remoteHashes{remoteFileHashes(sftpServer, extendedServer, remoteFiles)};
+            for (auto &remoteFile : remoteFileList)
+            {
+                std::string localFilePath{fileMapper.toLocal(remoteFile.path)};
+                auto remoteHash{remoteHashes.find(remoteFile.path)};
+                bool remoteHashed{(remoteFile.type == RemoteFileEntry::Type::regular) && (remoteHash != remoteHashes.end())};
+                if (remoteHashed && CFile::isFile(localFilePath) &&
+                    (fileHashCache.getHash(localFilePath, remoteHash->second.algorithm) == remoteHash->second.hash))
+                {
+                    continue; // Unchanged
+                }
+                if ((remoteFile.type == RemoteFileEntry::Type::directory) && CFile::exists(localFilePath))
+                {
+                    continue; // Already exists
+                }
+                // The remote hash was taken before the download so the local hash is left to be
+                // taken from the downloaded file when next needed (the remote file may have changed).
+                if (!(remoteHashed && getChangedBlocks(sftpServer, extendedServer, remoteFile, localFilePath, remoteHash->second, fileHashCache, safe, postFix)) &&
+                    !getMappedFile(sftpServer, fileMapper, remoteFile, safe, postFix, localFilePath))
+                {
+                    continue;
+                }
+                successList.push_back(localFilePath);
+                if (completionFn)
+                {
+                    completionFn(successList.back());
+                }
+            }
+            fileHashCache.save();
+            // On exception report and return with files that where successfully downloaded.
+        }
+        catch (const CSFTP::Exception &e)
+        {
+            std::cerr << e.getMessage() << std::endl;
+        }
+        catch (const CSFTPExtended::Exception &e)
+        {
+            std::cerr << e.getMessage() << std::endl;
+        }
+        catch (const CSSHChannel::Exception &e)
+        {
+            std::cerr << e.getMessage() << std::endl;
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << std::endl;
+        }
+        return (successList);
+    }
+    //
+    // Upload the files in a local file list whose content differs from the remote copy (see
+    // putFiles()). Remote file hashes are fetched in batches (see remoteFileHashes()) and
+    // compared against local hashes from the passed cache, which is updated and saved. Unless
+    // in safe mode a changed file that is large enough and the same size as the remote copy is
+    // compared block by block and only the changed blocks uploaded (see putChangedBlocks()).
+    // Returns a list of files uploaded and directories created.
+    //
+    FileList putChangedFiles(CSFTP &sftpServer, FileMapper &fileMapper, const FileList &localFileList, FileHashCache &fileHashCache, FileCompletionFn completionFn, bool safe, char postFix)
     {
         FileList successList;
         try
         {
+            CSFTPExtended extendedServer{sftpServer.getSession()};
             CSFTP::FileAttributes remoteDirectoryAttributes;
+            std::set<std::string> remoteDirectories;
+            FileList localFiles;
+            FileList remoteFiles;
             // Create any directories using root path permissions
             sftpServer.getFileAttributes(fileMapper.getRemoteDirectory(), remoteDirectoryAttributes);
-            // Process file/directory list
             for (auto localFile : localFileList)
             {
-                if (CFile::exists(localFile))
+                if (CFile::isDirectory(localFile))
                 {
-                    std::string remoteFilePath;
-                    bool transferFile{false};
-                    // Create remote full remote path and set file to be transfered flag
-                    if (CFile::isDirectory(localFile))
-                    {
-                        remoteFilePath = fileMapper.toRemote(localFile);
-                    }
-                    else if (CFile::isFile(localFile))
-                    {
-                        remoteFilePath = fileMapper.toRemote(CPath(localFile).parentPath().toString());
-                        transferFile = true;
-                    }
-                    else
-                    {
-                        continue; // Not valid for transfer NEXT FILE!
-                    }
-                    if (!fileExists(sftpServer, remoteFilePath))
-                    {
-                        makeRemotePath(sftpServer, remoteFilePath, remoteDirectoryAttributes->permissions);
-                        successList.push_back(remoteFilePath);
-                        if (!transferFile && completionFn)
-                        {
-                            completionFn(successList.back());
-                        }
-                    }
-                    remoteFilePath = fileMapper.toRemote(localFile);
-                    // Transfer file
-                    if (transferFile)
+                    remoteDirectories.insert(fileMapper.toRemote(localFile));
+                }
+                else if (CFile::isFile(localFile))
+                {
+                    remoteDirectories.insert(fileMapper.toRemote(CPath(localFile).parentPath().toString()));
+                    localFiles.push_back(localFile);
+                    remoteFiles.push_back(fileMapper.toRemote(localFile));
+                }
+            }
+            for (auto &remoteDirectory : remoteDirectories)
+            {
+                if (!remoteDirectoryExists(sftpServer, remoteDirectory))
+                {
+                    makeRemotePath(sftpServer, remoteDirectory, remoteDirectoryAttributes->permissions);
+                    successList.push_back(remoteDirectory);
+                    if (completionFn)
                     {
-                        std::string destinationFilePath{remoteFilePath + postFix};
-                        if (!safe)
-                        {
-                            destinationFilePath.pop_back();
-                        }
-                        putFile(sftpServer, localFile, destinationFilePath);
-                        if (safe)
-                        {
-                            if (fileExists(sftpServer, remoteFilePath))
-                            {
-                                sftpServer.removeLink(remoteFilePath);
-                            }
-                            sftpServer.renameFile(destinationFilePath, remoteFilePath);
-                        }
-                        successList.push_back(remoteFilePath);
-                        if (completionFn)
-                        {
-                            completionFn(successList.back());
-                        }
+                        completionFn(successList.back());
                     }
                 }
             }
+            // Transfer files whose remote hash is missing or different
+            openHashExtensions(sftpServer, extendedServer);
+            auto remoteHashes{remoteFileHashes(sftpServer, extendedServer, remoteFiles)};
+            for (std::size_t fileIndex = 0; fileIndex < localFiles.size(); fileIndex++)
+            {
+                auto remoteHash{remoteHashes.find(remoteFiles[fileIndex])};
+                if ((remoteHash != remoteHashes.end()) && (fileHashCache.getHash(localFiles[fileIndex], remoteHash->second.algorithm) == remoteHash->second.hash))
+                {
+                    continue; // Unchanged
+                }
+                std::string remoteFilePath{remoteFiles[fileIndex]};
+                if (safe || (remoteHash == remoteHashes.end()) || !putChangedBlocks(sftpServer, extendedServer, localFiles[fileIndex], remoteFilePath, fileHashCache))
+                {
+                    putMappedFile(sftpServer, fileMapper, localFiles[fileIndex], safe, postFix, remoteFilePath);
+                }
+                successList.push_back(remoteFilePath);
+                if (completionFn)
+                {
+                    completionFn(successList.back());
+                }
+            }
+            fileHashCache.save();
             // On exception report and return with files that where successfully uploaded.
         }
         catch (const CSFTP::Exception &e)
         {
             std::cerr << e.getMessage() << std::endl;
         }
-        catch (const CFile::Exception &e)
+        catch (const CSFTPExtended::Exception &e)
         {
-            std::cerr << e.what() << std::endl;
+            std::cerr << e.getMessage() << std::endl;
+        }
+        catch (const CSSHChannel::Exception &e)
+        {
+            std::cerr << e.getMessage() << std::endl;
         }
         catch (const std::exception &e)
         {
@@ -441,4 +1830,152 @@ namespace Antik::SSH
         }
         return (successList);
     }
+    // ==============================
+    // LOCAL FILE HASH CACHE METHODS
+    // ==============================
+    //
+    // Construct cache; loading any persisted hashes ("<device> <inode> <size> <mtime> <algorithm>
+    // <hash> <path>" lines; any other lines are ignored).
+    //
+    FileHashCache::FileHashCache(const std::string &cacheFileName) : m_cacheFileName{cacheFileName}
+    {
+        if (!m_cacheFileName.empty())
+        {
+            std::ifstream cacheFile{m_cacheFileName};
+            for (std::string cacheLine; std::getline(cacheFile, cacheLine);)
+            {
+                std::istringstream cacheFields{cacheLine};
+                FileKey key;
+                std::string algorithm;
+                std::string fileHash;
+                std::string filePath;
+                if ((cacheFields >> std::get<0>(key) >> std::get<1>(key) >> std::get<2>(key) >> std::get<3>(key) >> algorithm >> fileHash) &&
+                    (cacheFields.get() == ' ') && std::getline(cacheFields, filePath) && !filePath.empty())
+                {
+                    auto &cachedHashes{m_fileHashes[filePath]};
+                    if (cachedHashes.key != key)
+                    {
+                        cachedHashes.key = key;
+                        cachedHashes.hashes.clear();
+                    }
+                    cachedHashes.hashes[algorithm] = fileHash;
+                }
+            }
+        }
+    }
+    //
+    // Get cache key (device, inode, size, modified time in nanoseconds) for a local file;
+    // false if it cannot be stat'ed.
+    //
+    bool FileHashCache::fileKey(const std::string &localFile, FileKey &key)
+    {
+        struct stat fileStatus;
+        if (::stat(localFile.c_str(), &fileStatus) == -1)
+        {
+            return (false);
+        }
+        key = FileKey{fileStatus.st_dev, fileStatus.st_ino, fileStatus.st_size, (static_cast<std::int64_t>(fileStatus.st_mtim.tv_sec) * 1000000000) + fileStatus.st_mtim.tv_nsec};
+        return (true);
+    }
+    //
+    // Return a local files hash; only hashing its contents if not cached for its current
+    // key. A file that changes while being hashed is not cached.
+    //
+    std::string FileHashCache::getHash(const std::string &localFile, const std::string &algorithm)
+    {
+        FileKey key;
+        FileKey hashedKey;
+        if (!fileKey(localFile, key))
+        {
+            throw std::system_error(errno, std::system_category());
+        }
+        auto cachedHashes{m_fileHashes.find(localFile)};
+        if ((cachedHashes != m_fileHashes.end()) && (cachedHashes->second.key == key))
+        {
+            auto cachedHash{cachedHashes->second.hashes.find(algorithm)};
+            if (cachedHash != cachedHashes->second.hashes.end())
+            {
+                return (cachedHash->second);
+            }
+        }
+        std::string fileHash{localFileHashes(localFile, algorithm).front()};
+        if (fileKey(localFile, hashedKey) && (hashedKey == key))
+        {
+            setHash(localFile, fileHash, algorithm);
+        }
+        return (fileHash);
+    }
+    //
+    // Set a local files hash (when known from elsewhere).
+    //
+    void FileHashCache::setHash(const std::string &localFile, const std::string &fileHash, const std::string &algorithm)
+    {
+        FileKey key;
+        if (!fileKey(localFile, key))
+        {
+            throw std::system_error(errno, std::system_category());
+        }
+        auto &cachedHashes{m_fileHashes[localFile]};
+        if (cachedHashes.key != key)
+        {
+            cachedHashes.key = key;
+            cachedHashes.hashes.clear();
+        }
+        cachedHashes.hashes[algorithm] = fileHash;
+        m_modified = true;
+    }
+    //
+    // Remove cached hashes for files that no longer exist or have changed.
+    //
+    void FileHashCache::prune()
+    {
+        for (auto cachedHashes = m_fileHashes.begin(); cachedHashes != m_fileHashes.end();)
+        {
+            FileKey key;
+            if (!fileKey(cachedHashes->first, key) || (key != cachedHashes->second.key))
+            {
+                cachedHashes = m_fileHashes.erase(cachedHashes);
+                m_modified = true;
+            }
+            else
+            {
+                cachedHashes++;
+            }
+        }
+    }
+    //
+    // Save cached hashes to cache file (if any and modified) after pruning.
+    //
+    void FileHashCache::save()
+    {
+        prune();
+        if (!m_cacheFileName.empty() && m_modified)
+        {
+            std::ofstream cacheFile{m_cacheFileName, std::ios_base::trunc};
+            for (auto &[filePath, cachedHashes] : m_fileHashes)
+            {
+                if (filePath.find('\n') != std::string::npos)
+                {
+                    continue; // Cannot be saved one per line
+                }
+                for (auto &[algorithm, fileHash] : cachedHashes.hashes)
+                {
+                    cacheFile << std::get<0>(cachedHashes.key) << " " << std::get<1>(cachedHashes.key) << " " << std::get<2>(cachedHashes.key) << " "
+                              << std::get<3>(cachedHashes.key) << " " << algorithm << " " << fileHash << " " << filePath << "\n";
+                }
+            }
+            if (!cacheFile)
+            {
+                throw std::system_error(errno, std::system_category());
+            }
+            m_modified = false;
+        }
+    }
+    //
+    // Return number of files with cached hashes.
+    //
+    std::size_t FileHashCache::size() const
+    {
+        return (m_fileHashes.size());
+    }
 } // namespace Antik::SSH
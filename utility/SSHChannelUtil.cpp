@@ -2,11 +2,15 @@
 // Module: SSHChannelUtil
 //
 // Description: SSH CHannel utility functions for the Antik class SSHChannel.
+// Includes a bulk transfer mode that moves a whole directory tree as a single
+// tar stream (optionally gzip compressed) over one channel, avoiding per file
+// protocol round trips for trees of many small files.
 //
 // Dependencies:
 //
 // C20++              : Use of C20++ features.
-// Antik classes      : CSSHChannel
+// Antik classes      : CSSHSession, CSSHChannel, CTar
+// zlib               : gzip compression of tar streams.
 //
 // =============
 // INCLUDE FILES
@@ -18,15 +22,24 @@
 #include <memory>
 #include <thread>
 #include <chrono>
-#include <atomic>
 #include <system_error>
+#include <vector>
+#include <atomic>
 #include <mutex>
-// POSIX terminal control definitions
+#include <algorithm>
+// POSIX terminal control/poll definitions
 #include <termios.h>
+#include <poll.h>
+#include <unistd.h>
+// libssh event callbacks
+#include <libssh/callbacks.h>
+// zlib
+#include <zlib.h>
 //
 // SSH Channel utility definitions
 //
 #include "SSHChannelUtil.hpp"
+#include "CTar.hpp"
 // =========
 // NAMESPACE
 // =========
@@ -35,51 +48,383 @@ namespace Antik::SSH
     // =======
     // IMPORTS
     // =======
+    using namespace Antik::File;
+    // ===============
+    // LOCAL CONSTANTS
+    // ===============
+    //
+    // zlib window bits for gzip encode/(gzip or zlib) decode and stream buffer size
+    //
+    static const int kGzipEncodeWindowBits{MAX_WBITS + 16};
+    static const int kGzipDecodeWindowBits{MAX_WBITS + 32};
+    static const std::size_t kZlibBufferSize{64 * 1024};
+    //
+    // Interactive shell terminal read size
+    //
+    static const std::size_t kShellInputBufferSize{4096};
+    //
+    // Longest wait (milliseconds) for channel activity when streaming command output
+    //
+    static const int kCommandPollTimeout{1000};
+    //
+    // Most remote tar error output kept for an exception message
+    //
+    static const std::size_t kTarErrorOutputLimit{16 * 1024};
     // ===============
     // LOCAL FUNCTIONS
     // ===============
     //
-    // Function run on a separate thread and used to read characters that are to be sent down a SSH chanel with an associated shell.
+    // Inflate a gzip compressed tar stream read from a channel.
     //
-    static void readShellInput(std::vector<char> &keyBuffer, std::mutex &keyBuffferLock, std::atomic<bool> &stopShellInput, std::exception_ptr &thrownException)
+    class TarInflater
     {
-        try
+    public:
+        explicit TarInflater(const CTar::ReadFn &readFn) : m_readFn{readFn}, m_input(kZlibBufferSize)
         {
-            struct termios terminalSettings, savedTerminalSettings;
-            std::vector<char> terminalBuffer;
-            if (tcgetattr(0, &terminalSettings) == -1)
+            int inflateResult{inflateInit2(&m_zStream, kGzipDecodeWindowBits)};
+            if (inflateResult != Z_OK)
             {
-                throw std::system_error(errno, std::system_category(), __func__);
+                throw std::runtime_error("inflateInit2() Error = " + std::to_string(inflateResult));
             }
-            savedTerminalSettings = terminalSettings;
-            cfmakeraw(&terminalSettings);
-            terminalSettings.c_cc[VMIN] = 0;
-            terminalSettings.c_cc[VTIME] = 0;
-            if (tcsetattr(0, TCSANOW, &terminalSettings) == -1)
+        }
+        ~TarInflater()
+        {
+            inflateEnd(&m_zStream);
+        }
+        std::size_t read(char *buffer, std::size_t length)
+        {
+            m_zStream.next_out = reinterpret_cast<Bytef *>(buffer);
+            m_zStream.avail_out = static_cast<uInt>(length);
+            while (!m_streamEnd && (m_zStream.avail_out == length))
             {
-                throw std::system_error(errno, std::system_category(), __func__);
+                if (m_zStream.avail_in == 0)
+                {
+                    std::size_t bytesRead{m_readFn(m_input.data(), m_input.size())};
+                    if (bytesRead == 0)
+                    {
+                        throw std::runtime_error("Compressed tar stream truncated.");
+                    }
+                    m_zStream.next_in = reinterpret_cast<Bytef *>(m_input.data());
+                    m_zStream.avail_in = static_cast<uInt>(bytesRead);
+                }
+                int inflateResult{inflate(&m_zStream, Z_NO_FLUSH)};
+                if (inflateResult == Z_STREAM_END)
+                {
+                    m_streamEnd = true;
+                }
+                else if (inflateResult != Z_OK)
+                {
+                    throw std::runtime_error("inflate() Error = " + std::to_string(inflateResult));
+                }
+            }
+            return (length - m_zStream.avail_out);
+        }
+
+    private:
+        const CTar::ReadFn &m_readFn;
+        std::vector<char> m_input;
+        z_stream m_zStream{};
+        bool m_streamEnd{false};
+    };
+    //
+    // Gzip compress a tar stream written to a channel.
+    //
+    class TarDeflater
+    {
+    public:
+        explicit TarDeflater(const CTar::WriteFn &writeFn) : m_writeFn{writeFn}, m_output(kZlibBufferSize)
+        {
+            int deflateResult{deflateInit2(&m_zStream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, kGzipEncodeWindowBits, 8, Z_DEFAULT_STRATEGY)};
+            if (deflateResult != Z_OK)
+            {
+                throw std::runtime_error("deflateInit2() Error = " + std::to_string(deflateResult));
+            }
+        }
+        ~TarDeflater()
+        {
+            deflateEnd(&m_zStream);
+        }
+        void write(const char *buffer, std::size_t length)
+        {
+            m_zStream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(buffer));
+            m_zStream.avail_in = static_cast<uInt>(length);
+            deflateStream(Z_NO_FLUSH);
+        }
+        void finish()
+        {
+            deflateStream(Z_FINISH);
+        }
+
+    private:
+        void deflateStream(int flush)
+        {
+            int deflateResult;
+            do
+            {
+                m_zStream.next_out = reinterpret_cast<Bytef *>(m_output.data());
+                m_zStream.avail_out = static_cast<uInt>(m_output.size());
+                deflateResult = deflate(&m_zStream, flush);
+                if (deflateResult == Z_STREAM_ERROR)
+                {
+                    throw std::runtime_error("deflate() Error = " + std::to_string(deflateResult));
+                }
+                if (m_zStream.avail_out != m_output.size())
+                {
+                    m_writeFn(m_output.data(), m_output.size() - m_zStream.avail_out);
+                }
+            } while ((m_zStream.avail_out == 0) || ((flush == Z_FINISH) && (deflateResult != Z_STREAM_END)));
+        }
+        const CTar::WriteFn &m_writeFn;
+        std::vector<char> m_output;
+        z_stream m_zStream{};
+    };
+    //
+    // Remote tar command channel. Its stderr is collected whenever its stdout is read or its
+    // stdin written (and while waiting on the session for either) so that a tar reporting
+    // many errors cannot stall the transfer on a full stderr window; finish() drains what is
+    // left and throws with the error output if the tar failed.
+    //
+    class RemoteTar
+    {
+    public:
+        explicit RemoteTar(CSSHChannel &channel) : m_channel{channel}, m_event{ssh_event_new(), ssh_event_free}
+        {
+            if (!m_event || (ssh_event_add_session(m_event.get(), m_channel.getSession().getSession()) == SSH_ERROR))
+            {
+                throw CSSHChannel::Exception("Could not create channel event.", __func__);
+            }
+        }
+        ~RemoteTar()
+        {
+            ssh_event_remove_session(m_event.get(), m_channel.getSession().getSession());
+        }
+        std::size_t read(char *buffer, std::size_t length)
+        {
+            while (true)
+            {
+                int bytesRead{m_channel.readNonBlocking(buffer, static_cast<uint32_t>(length))};
+                if (bytesRead > 0)
+                {
+                    return (static_cast<std::size_t>(bytesRead));
+                }
+                readErrors();
+                if (m_channel.isEndOfFile() || m_channel.isClosed())
+                {
+                    return (static_cast<std::size_t>(std::max(m_channel.readNonBlocking(buffer, static_cast<uint32_t>(length)), 0)));
+                }
+                wait();
+            }
+        }
+        void write(const char *buffer, std::size_t length)
+        {
+            while (length != 0)
+            {
+                readErrors();
+                std::size_t window{ssh_channel_window_size(m_channel.getChannel())};
+                if (window == 0)
+                {
+                    if (m_channel.isEndOfFile() || m_channel.isClosed())
+                    {
+                        finish();
+                        throw std::runtime_error("Remote tar ended before all data was sent.");
+                    }
+                    wait();
+                    continue;
+                }
+                int bytesWritten{m_channel.write(const_cast<char *>(buffer), static_cast<uint32_t>(std::min(length, window)))};
+                if (bytesWritten <= 0)
+                {
+                    throw CSSHChannel::Exception("Channel write failed.", __func__);
+                }
+                buffer += bytesWritten;
+                length -= static_cast<std::size_t>(bytesWritten);
             }
-            while (!stopShellInput)
+        }
+        void finish()
+        {
+            char *ioBuffer = m_channel.getIoBuffer().get();
+            uint32_t ioBufferSize = m_channel.getIoBufferSize();
+            while (true)
             {
-                for (char singleChar; (singleChar = std::getchar()) != EOF; terminalBuffer.push_back(singleChar))
-                    ;
-                if (!terminalBuffer.empty())
+                while (m_channel.readNonBlocking(ioBuffer, ioBufferSize) > 0)
                 {
-                    std::lock_guard<std::mutex> keyBufferGuard(keyBuffferLock);
-                    copy(terminalBuffer.begin(), terminalBuffer.end(), std::back_inserter(keyBuffer));
-                    terminalBuffer.clear();
                 }
-                std::this_thread::sleep_for(std::chrono::microseconds(5));
+                readErrors();
+                if (m_channel.isEndOfFile() || m_channel.isClosed())
+                {
+                    break;
+                }
+                wait();
+            }
+            int exitStatus{m_channel.getExitStatus()};
+            if (exitStatus != 0)
+            {
+                throw std::runtime_error("Remote tar failed (exit status " + std::to_string(exitStatus) + "): " + m_errorOutput);
             }
-            if (tcsetattr(0, TCSANOW, &savedTerminalSettings) == -1)
+        }
+
+    private:
+        void readErrors()
+        {
+            int bytesRead;
+            char *ioBuffer = m_channel.getIoBuffer().get();
+            while ((bytesRead = m_channel.readNonBlocking(ioBuffer, m_channel.getIoBufferSize(), true)) > 0)
+            {
+                m_errorOutput.append(ioBuffer, std::min(static_cast<std::size_t>(bytesRead), kTarErrorOutputLimit - m_errorOutput.size()));
+            }
+        }
+        void wait()
+        {
+            if (ssh_event_dopoll(m_event.get(), kCommandPollTimeout) == SSH_ERROR)
+            {
+                throw CSSHChannel::Exception(m_channel, __func__);
+            }
+        }
+        CSSHChannel &m_channel;
+        std::unique_ptr<std::pointer_traits<ssh_event>::element_type, decltype(&ssh_event_free)> m_event;
+        std::string m_errorOutput;
+    };
+    //
+    // Put the terminal (standard input) into raw mode for the lifetime of the object.
+    //
+    class TerminalRawMode
+    {
+    public:
+        TerminalRawMode()
+        {
+            struct termios terminalSettings;
+            if (tcgetattr(STDIN_FILENO, &m_savedTerminalSettings) == -1)
+            {
+                throw std::system_error(errno, std::system_category(), __func__);
+            }
+            terminalSettings = m_savedTerminalSettings;
+            cfmakeraw(&terminalSettings);
+            if (tcsetattr(STDIN_FILENO, TCSANOW, &terminalSettings) == -1)
             {
                 throw std::system_error(errno, std::system_category(), __func__);
             }
         }
+        ~TerminalRawMode()
+        {
+            tcsetattr(STDIN_FILENO, TCSANOW, &m_savedTerminalSettings);
+        }
+
+    private:
+        struct termios m_savedTerminalSettings;
+    };
+    //
+    // Limit a session's timeout to the time left before a deadline; the session's own
+    // timeout is put back by restore() or when the object is destroyed.
+    //
+    class DeadlineTimeout
+    {
+    public:
+        DeadlineTimeout(CSSHSession &session, std::chrono::steady_clock::time_point deadline) : m_session{session}, m_deadline{deadline}, m_savedTimeout{session.getTimeout()}
+        {
+        }
+        ~DeadlineTimeout()
+        {
+            try
+            {
+                restore();
+            }
+            catch (const CSSHSession::Exception &)
+            {
+            }
+        }
+        void limit()
+        {
+            auto timeLeft = m_deadline - std::chrono::steady_clock::now();
+            if (timeLeft <= std::chrono::steady_clock::duration::zero())
+            {
+                throw CSSHSession::Exception("Deadline exceeded.", __func__);
+            }
+            long timeout{static_cast<long>(std::chrono::duration_cast<std::chrono::seconds>(timeLeft).count()) + 1};
+            m_session.setOption(SSH_OPTIONS_TIMEOUT, &timeout);
+            m_limited = true;
+        }
+        void restore()
+        {
+            if (m_limited)
+            {
+                m_limited = false;
+                m_session.setOption(SSH_OPTIONS_TIMEOUT, &m_savedTimeout);
+            }
+        }
+
+    private:
+        CSSHSession &m_session;
+        std::chrono::steady_clock::time_point m_deadline;
+        long m_savedTimeout;
+        bool m_limited{false};
+    };
+    //
+    // Interactive shell state passed to the libssh event/channel callbacks. Exceptions
+    // are caught and saved so that they are not thrown back through libssh.
+    //
+    struct ShellContext
+    {
+        CSSHChannel &channel;
+        IOContext &ioContext;
+        bool inputEndOfFile{false};
+        std::exception_ptr thrownException{nullptr};
+    };
+    //
+    // Channel data callback; pass shell stdout/stderr on to the IO context.
+    //
+    static int shellChannelData(ssh_session, ssh_channel, void *data, uint32_t len, int is_stderr, void *userdata)
+    {
+        ShellContext *shellContext{static_cast<ShellContext *>(userdata)};
+        try
+        {
+            if (is_stderr)
+            {
+                shellContext->ioContext.writeError(data, len);
+            }
+            else
+            {
+                shellContext->ioContext.writeOutput(data, len);
+            }
+        }
         catch (...)
         {
-            thrownException = std::current_exception();
+            shellContext->thrownException = std::current_exception();
         }
+        return (static_cast<int>(len));
+    }
+    //
+    // Terminal readable event callback; send any characters typed down the channel
+    // (end of file on the terminal is passed on as channel end of file).
+    //
+    static int shellTerminalInput(socket_t fd, int revents, void *userdata)
+    {
+        ShellContext *shellContext{static_cast<ShellContext *>(userdata)};
+        try
+        {
+            if (revents & (POLLIN | POLLHUP))
+            {
+                char keyBuffer[kShellInputBufferSize];
+                ssize_t bytesRead{::read(fd, keyBuffer, sizeof(keyBuffer))};
+                if (bytesRead > 0)
+                {
+                    shellContext->channel.write(keyBuffer, static_cast<uint32_t>(bytesRead));
+                }
+                else if (bytesRead == 0)
+                {
+                    shellContext->inputEndOfFile = true;
+                    shellContext->channel.sendEndOfFile();
+                }
+                else if ((errno != EINTR) && (errno != EAGAIN))
+                {
+                    throw std::system_error(errno, std::system_category(), __func__);
+                }
+            }
+        }
+        catch (...)
+        {
+            shellContext->thrownException = std::current_exception();
+        }
+        return (0);
     }
     //
     // Function run on a separate thread that reads data from a direct forwarded SSH channel and passed to
@@ -97,23 +442,137 @@ namespace Antik::SSH
             std::this_thread::sleep_for(std::chrono::microseconds(5));
         }
     }
+    //
+    // Quote a remote path for use in a shell command.
+    //
+    static std::string quoteRemotePath(const std::string &remotePath)
+    {
+        std::string quotedPath{"'"};
+        for (auto character : remotePath)
+        {
+            quotedPath += (character == '\'') ? std::string("'\\''") : std::string(1, character);
+        }
+        return (quotedPath + "'");
+    }
+    //
+    // Stream a running command's stdout and stderr to an IO context as data arrives on
+    // either until end of file. Both are drained each time round so a command writing a
+    // lot to stderr is not stalled by a full channel window. The IO context is flushed at
+    // the end; if the deadline passes first an exception is thrown.
+    //
+    static void streamCommandOutput(CSSHChannel &channel, IOContext &ioContext, std::chrono::steady_clock::time_point deadline)
+    {
+        int bytesRead;
+        char *ioBuffer = channel.getIoBuffer().get();
+        uint32_t ioBufferSize = channel.getIoBufferSize();
+        std::unique_ptr<std::pointer_traits<ssh_event>::element_type, decltype(&ssh_event_free)> channelEvent{ssh_event_new(), ssh_event_free};
+        ssh_event_add_session(channelEvent.get(), channel.getSession().getSession());
+        try
+        {
+            while (true)
+            {
+                while ((bytesRead = channel.readNonBlocking(ioBuffer, ioBufferSize)) > 0)
+                {
+                    ioContext.writeOutput(ioBuffer, bytesRead);
+                }
+                while ((bytesRead = channel.readNonBlocking(ioBuffer, ioBufferSize, true)) > 0)
+                {
+                    ioContext.writeError(ioBuffer, bytesRead);
+                }
+                if (channel.isEndOfFile() || channel.isClosed())
+                {
+                    break;
+                }
+                auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+                if (timeout <= 0)
+                {
+                    throw CSSHChannel::Exception("Deadline exceeded.", __func__);
+                }
+                if (ssh_event_dopoll(channelEvent.get(), static_cast<int>(std::min<decltype(timeout)>(timeout, kCommandPollTimeout))) == SSH_ERROR)
+                {
+                    throw CSSHChannel::Exception(channel, __func__);
+                }
+            }
+        }
+        catch (...)
+        {
+            ssh_event_remove_session(channelEvent.get(), channel.getSession().getSession());
+            try
+            {
+                ioContext.flush();
+            }
+            catch (...)
+            {
+                // Keep the original exception; a flush failure would replace it
+            }
+            throw;
+        }
+        ssh_event_remove_session(channelEvent.get(), channel.getSession().getSession());
+        ioContext.flush();
+    }
+    //
+    // Connect (if needed), verify and authorize a host's session then run a command on it
+    // streaming its output to the host's IO context and recording its exit status. Until
+    // the command has started the session timeout is limited to the time left (checked
+    // before each step) so a dead or stalled host cannot outlast the deadline; the
+    // session's own timeout is put back afterwards.
+    //
+    static void runHostCommand(CommandHost &commandHost, const std::string &command, ServerVerificationContext &verificationContext, std::mutex &verificationMutex,
+                               std::chrono::steady_clock::time_point deadline)
+    {
+        CSSHSession &sshSession{commandHost.session};
+        DeadlineTimeout deadlineTimeout{sshSession, deadline};
+        if (!sshSession.isConnected())
+        {
+            deadlineTimeout.limit();
+            sshSession.connect();
+            deadlineTimeout.limit();
+            {
+                std::scoped_lock verificationLock(verificationMutex);
+                if (!verifyKnownServer(sshSession, verificationContext))
+                {
+                    throw CSSHSession::Exception("Unable to verify server.", __func__);
+                }
+            }
+            deadlineTimeout.limit();
+            if (!userAuthorize(sshSession))
+            {
+                throw CSSHSession::Exception("Server unable to authorize client.", __func__);
+            }
+        }
+        CSSHChannel channel{sshSession};
+        try
+        {
+            deadlineTimeout.limit();
+            channel.open();
+            deadlineTimeout.limit();
+            channel.execute(command);
+            deadlineTimeout.restore();
+            streamCommandOutput(channel, commandHost.ioContext, deadline);
+            commandHost.exitStatus = channel.getExitStatus();
+            commandHost.completed = true;
+        }
+        catch (...)
+        {
+            channel.close();
+            throw;
+        }
+        channel.close();
+    }
     // ================
     // PUBLIC FUNCTIONS
     // ================
     //
     // Create an interactive shell on a channel, send commands and receive output back.
+    // The session socket and terminal are waited on with a libssh event (poll) so the
+    // loop is idle until there is shell output or terminal input to process.
     //
     void interactiveShell(CSSHChannel &channel, const std::string &terminalType, int columns, int rows, IOContext &ioContext)
     {
-        int bytesRead;
-        bool standardError = false;
-        char *ioBuffer = channel.getIoBuffer().get();
-        uint32_t ioBufferSize = channel.getIoBufferSize();
-        std::unique_ptr<std::thread> shellInputThread;
-        std::atomic<bool> stopShellInput{false};
-        std::exception_ptr thrownException{nullptr};
-        std::mutex keyBuffferLock;
-        std::vector<char> keyBuffer;
+        ShellContext shellContext{channel, ioContext};
+        struct ssh_channel_callbacks_struct channelCallbacks{};
+        std::unique_ptr<TerminalRawMode> terminalRawMode;
+        bool terminalInput{false};
         if (!terminalType.empty())
         {
             channel.requestTerminalOfTypeSize(terminalType, columns, rows);
@@ -123,61 +582,111 @@ namespace Antik::SSH
             channel.requestTerminal();
             channel.changeTerminalSize(columns, rows);
         }
-        channel.requestShell();
-        if (ioContext.useInternalInput())
-        {
-            shellInputThread = std::make_unique<std::thread>(readShellInput, std::ref(keyBuffer), std::ref(keyBuffferLock), std::ref(stopShellInput), std::ref(thrownException));
-        }
-        while (channel.isOpen() && !channel.isEndOfFile())
+        channelCallbacks.userdata = &shellContext;
+        channelCallbacks.channel_data_function = shellChannelData;
+        ssh_callbacks_init(&channelCallbacks);
+        ssh_set_channel_callbacks(channel.getChannel(), &channelCallbacks);
+        ssh_event shellEvent{ssh_event_new()};
+        try
         {
-            if ((bytesRead = channel.readNonBlocking(ioBuffer, ioBufferSize, standardError)) > 0)
+            channel.requestShell();
+            ssh_event_add_session(shellEvent, channel.getSession().getSession());
+            if (ioContext.useInternalInput())
             {
-                ioContext.writeOutput(ioBuffer, bytesRead);
+                terminalRawMode = std::make_unique<TerminalRawMode>();
+                ssh_event_add_fd(shellEvent, STDIN_FILENO, POLLIN, shellTerminalInput, &shellContext);
+                terminalInput = true;
             }
-            standardError = !standardError;
-            if (!stopShellInput)
+            while (channel.isOpen() && !channel.isEndOfFile() && !shellContext.thrownException)
             {
-                std::lock_guard<std::mutex> keyBufferGuard(keyBuffferLock);
-                if (!keyBuffer.empty())
+                if (ssh_event_dopoll(shellEvent, -1) == SSH_ERROR)
                 {
-                    channel.write(&keyBuffer[0], keyBuffer.size());
-                    keyBuffer.clear();
+                    throw CSSHChannel::Exception(channel, __func__);
+                }
+                if (terminalInput && shellContext.inputEndOfFile)
+                {
+                    ssh_event_remove_fd(shellEvent, STDIN_FILENO);
+                    terminalInput = false;
                 }
-            }
-            std::this_thread::sleep_for(std::chrono::microseconds(100));
-            if (thrownException)
-            {
-                break;
             }
         }
-        if (shellInputThread)
+        catch (...)
+        {
+            shellContext.thrownException = std::current_exception();
+        }
+        if (terminalInput)
         {
-            stopShellInput = true;
-            shellInputThread->join();
+            ssh_event_remove_fd(shellEvent, STDIN_FILENO);
         }
-        if (thrownException)
+        ssh_event_remove_session(shellEvent, channel.getSession().getSession());
+        ssh_event_free(shellEvent);
+        ssh_remove_channel_callbacks(channel.getChannel(), &channelCallbacks);
+        terminalRawMode.reset();
+        if (shellContext.thrownException)
         {
-            std::rethrow_exception(thrownException);
+            std::rethrow_exception(shellContext.thrownException);
         }
     }
     //
-    // Send a shell command down a channel to be executed and read any output
-    // produced.
+    // Send a shell command down a channel to be executed and pass its output and
+    // error to the IO context as they arrive (neither stream can stall the other).
     //
     void executeCommand(CSSHChannel &channel, const std::string &command, IOContext &ioContext)
     {
-        int bytesRead;
-        char *ioBuffer = channel.getIoBuffer().get();
-        uint32_t ioBufferSize = channel.getIoBufferSize();
         channel.execute(command.c_str());
-        while ((bytesRead = channel.read(ioBuffer, ioBufferSize)) > 0)
+        streamCommandOutput(channel, ioContext, std::chrono::steady_clock::time_point::max());
+    }
+    //
+    // Run a command on many hosts at once. Up to maxParallel worker threads each take the
+    // next host (libssh sessions are not thread safe so a host's session is only used by
+    // the worker running it), connect/authorize its session if not already connected and
+    // run the command; stdout and stderr are streamed concurrently to the host's IO context
+    // and its exit status recorded. Hosts not finished by the deadline are abandoned with
+    // an error message. Returns the number of hosts on which the command completed.
+    //
+    std::size_t executeCommandParallel(CommandHostList &commandHosts, const std::string &command, ServerVerificationContext &verificationContext,
+                                       std::size_t maxParallel, std::chrono::seconds deadline)
+    {
+        std::atomic<std::size_t> nextHost{0};
+        std::atomic<std::size_t> completedHosts{0};
+        std::mutex verificationMutex;
+        std::vector<std::thread> workers;
+        auto deadlineTime = std::chrono::steady_clock::now() + deadline;
+        for (std::size_t worker = 0; worker < std::min(std::max<std::size_t>(maxParallel, 1), commandHosts.size()); worker++)
         {
-            ioContext.writeOutput(ioBuffer, bytesRead);
+            workers.emplace_back([&]() {
+                for (std::size_t hostIndex; (hostIndex = nextHost++) < commandHosts.size();)
+                {
+                    CommandHost &commandHost{commandHosts[hostIndex]};
+                    try
+                    {
+                        if (std::chrono::steady_clock::now() >= deadlineTime)
+                        {
+                            throw std::runtime_error("Deadline exceeded before command started.");
+                        }
+                        runHostCommand(commandHost, command, verificationContext, verificationMutex, deadlineTime);
+                        completedHosts++;
+                    }
+                    catch (const CSSHSession::Exception &e)
+                    {
+                        commandHost.errorMessage = e.getMessage();
+                    }
+                    catch (const CSSHChannel::Exception &e)
+                    {
+                        commandHost.errorMessage = e.getMessage();
+                    }
+                    catch (const std::exception &e)
+                    {
+                        commandHost.errorMessage = e.what();
+                    }
+                }
+            });
         }
-        while ((bytesRead = channel.read(ioBuffer, ioBufferSize, true)) > 0)
+        for (auto &worker : workers)
         {
-            ioContext.writeError(ioBuffer, bytesRead);
+            worker.join();
         }
+        return (completedHosts);
     }
     //
     // Set up a channel to be direct forwarded and specify a write callback for any output received on the channel.
@@ -188,4 +697,104 @@ namespace Antik::SSH
         std::thread channelReadThread{readChannelThread, std::ref(forwardingChannel), std::ref(ioContext)};
         return (channelReadThread);
     }
+    //
+    // Download a remote directory tree as a single tar stream (remote "tar -c", gzip
+    // compressed if requested) and unpack it in situ under the local directory. Returns
+    // a list of local files and directories unpacked; on an error they are the ones
+    // unpacked before it.
+    //
+    FileList getFilesTar(CSSHSession &sshSession, FileMapper &fileMapper, FileCompletionFn completionFn, bool compress)
+    {
+        FileList successList;
+        try
+        {
+            CSSHChannel channel{sshSession};
+            channel.open();
+            channel.execute("tar -C " + quoteRemotePath(fileMapper.getRemoteDirectory()) + ((compress) ? " -czf - ." : " -cf - ."));
+            RemoteTar remoteTar{channel};
+            CTar::ReadFn channelReadFn = [&remoteTar](char *buffer, std::size_t length) { return (remoteTar.read(buffer, length)); };
+            FileCompletionFn unpackedFn = [&successList, &completionFn](const std::string &localFile) {
+                successList.push_back(localFile);
+                if (completionFn)
+                {
+                    completionFn(successList.back());
+                }
+            };
+            if (compress)
+            {
+                TarInflater inflater{channelReadFn};
+                CTar::unpack(fileMapper.getLocalDirectory(), [&inflater](char *buffer, std::size_t length) { return (inflater.read(buffer, length)); }, unpackedFn);
+            }
+            else
+            {
+                CTar::unpack(fileMapper.getLocalDirectory(), channelReadFn, unpackedFn);
+            }
+            remoteTar.finish();
+            channel.close();
+            // On exception report and return with files that where successfully unpacked.
+        }
+        catch (const CSSHChannel::Exception &e)
+        {
+            std::cerr << e.getMessage() << std::endl;
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << std::endl;
+        }
+        return (successList);
+    }
+    //
+    // Upload a local directory tree as a single tar stream (gzip compressed if requested)
+    // unpacked in situ by a remote "tar -x"; the remote directory is created if needed.
+    // The completion function is called as each file is packed (progress) but the list
+    // of remote files returned is only filled once the remote tar has succeeded.
+    //
+    FileList putFilesTar(CSSHSession &sshSession, FileMapper &fileMapper, FileCompletionFn completionFn, bool compress)
+    {
+        FileList successList;
+        try
+        {
+            FileList packedList;
+            std::string remoteDirectory{quoteRemotePath(fileMapper.getRemoteDirectory())};
+            CSSHChannel channel{sshSession};
+            channel.open();
+            channel.execute("mkdir -p -- " + remoteDirectory + " && tar -C " + remoteDirectory + ((compress) ? " -xzf -" : " -xf -"));
+            RemoteTar remoteTar{channel};
+            CTar::WriteFn channelWriteFn = [&remoteTar](const char *buffer, std::size_t length) { remoteTar.write(buffer, length); };
+            FileCompletionFn packedFn = [&packedList, &completionFn](const std::string &localFile) {
+                packedList.push_back(localFile);
+                if (completionFn)
+                {
+                    completionFn(localFile);
+                }
+            };
+            if (compress)
+            {
+                TarDeflater deflater{channelWriteFn};
+                CTar::pack(fileMapper.getLocalDirectory(), [&deflater](const char *buffer, std::size_t length) { deflater.write(buffer, length); }, packedFn);
+                deflater.finish();
+            }
+            else
+            {
+                CTar::pack(fileMapper.getLocalDirectory(), channelWriteFn, packedFn);
+            }
+            channel.sendEndOfFile();
+            remoteTar.finish();
+            channel.close();
+            for (auto &localFile : packedList)
+            {
+                successList.push_back(fileMapper.toRemote(localFile));
+            }
+            // On exception report and return with files that where successfully uploaded.
+        }
+        catch (const CSSHChannel::Exception &e)
+        {
+            std::cerr << e.getMessage() << std::endl;
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << std::endl;
+        }
+        return (successList);
+    }
 } // namespace Antik::SSH